@@ -14,6 +14,7 @@ import sys
 
 from ctypes import Structure, CDLL, POINTER, CFUNCTYPE
 from ctypes import c_bool, c_double, c_float, c_int, c_size_t, c_uint, c_uint32
+from ctypes import c_uint64
 from ctypes import c_char, c_char_p, c_void_p
 from ctypes import byref
 
@@ -179,6 +180,7 @@ plugin_class_get_label           = _lib.lilv_plugin_class_get_label
 plugin_class_get_children        = _lib.lilv_plugin_class_get_children
 plugin_instantiate               = _lib.lilv_plugin_instantiate
 instance_free                    = _lib.lilv_instance_free
+instance_run_blocks              = _lib.lilv_instance_run_blocks
 plugin_get_uis                   = _lib.lilv_plugin_get_uis
 ui_get_uri                       = _lib.lilv_ui_get_uri
 ui_get_classes                   = _lib.lilv_ui_get_classes
@@ -1178,7 +1180,7 @@ class World(Structure):
 
 class Instance(Structure):
     """Plugin instance."""
-    __slots__ = [ 'lv2_descriptor', 'lv2_handle', 'pimpl', 'plugin', 'rate', 'instance' ]
+    __slots__ = [ 'lv2_descriptor', 'lv2_handle', 'pimpl', 'plugin', 'rate', 'instance', 'buffers' ]
     _fields_  = [
         ('lv2_descriptor', POINTER(LV2_Descriptor)),
         ('lv2_handle', LV2_Handle),
@@ -1189,6 +1191,7 @@ class Instance(Structure):
         self.plugin   = plugin
         self.rate     = rate
         self.instance = plugin_instantiate(plugin.plugin, rate, features)
+        self.buffers  = {}
 
     def get_uri(self):
         """Get the URI of the plugin which `instance` is an instance of.
@@ -1197,25 +1200,78 @@ class Instance(Structure):
         """
         return self.get_descriptor().URI
 
+    @staticmethod
+    def _check_buffer(data):
+        """Return `data` if it can be connected to a port without copying."""
+        import numpy
+        if type(data) != numpy.ndarray:
+            raise Exception("Unsupported data type")
+        elif data.dtype != numpy.float32:
+            raise ValueError("Port buffers must have dtype float32")
+        elif not data.flags['C_CONTIGUOUS'] or not data.flags['WRITEABLE']:
+            raise ValueError("Port buffers must be contiguous and writeable")
+        return data
+
     def connect_port(self, port_index, data):
         """Connect a port to a data location.
 
+           The port is connected directly to the memory of `data`, which must
+           be a contiguous and writeable numpy array of float32, so nothing is
+           copied when the plugin is run.  A reference to `data` is kept until
+           the port is connected elsewhere, so it remains valid for as long as
+           the plugin may access it.
+
            This may be called regardless of whether the plugin is activated,
            activation and deactivation does not destroy port connections.
         """
-        import numpy
         if data is None:
             self.get_descriptor().connect_port(
                 self.get_handle(),
                 port_index,
                 data)
-        elif type(data) == numpy.ndarray:
+            self.buffers.pop(port_index, None)
+        else:
             self.get_descriptor().connect_port(
                 self.get_handle(),
                 port_index,
-                data.ctypes.data_as(POINTER(c_float)))
-        else:
-            raise Exception("Unsupported data type")
+                self._check_buffer(data).ctypes.data_as(POINTER(c_float)))
+            self.buffers[port_index] = data
+
+    def run_blocks(self, inputs, outputs, block_size):
+        """Run the plugin over whole buffers, one block at a time.
+
+           `inputs` and `outputs` are dictionaries that map the index of an
+           audio or CV port to a numpy array of float32, which must all have
+           the same length.  The block loop runs in C, so processing long
+           buffers has no per-block Python overhead.  Other ports, such as
+           controls, must be connected with connect_port() beforehand.
+
+           Returns `outputs`.
+        """
+        buffers = dict(inputs)
+        buffers.update(outputs)
+        if not buffers:
+            return outputs
+
+        n_frames = None
+        for data in buffers.values():
+            self._check_buffer(data)
+            if n_frames is None:
+                n_frames = len(data)
+            elif len(data) != n_frames:
+                raise ValueError("Port buffers must have the same length")
+
+        indices   = sorted(buffers.keys())
+        c_ports   = (c_uint32 * len(indices))(*indices)
+        c_buffers = (POINTER(c_float) * len(indices))(
+            *[buffers[i].ctypes.data_as(POINTER(c_float)) for i in indices])
+
+        instance_run_blocks(self.instance, len(indices), c_ports, c_buffers,
+                            n_frames, block_size)
+
+        # Ports are left connected to the buffers
+        self.buffers.update(buffers)
+        return outputs
 
     def activate(self):
         """Activate a plugin instance.
@@ -1726,6 +1782,9 @@ plugin_instantiate.restype = POINTER(Instance)
 instance_free.argtypes = [POINTER(Instance)]
 instance_free.restype = None
 
+instance_run_blocks.argtypes = [POINTER(Instance), c_uint32, POINTER(c_uint32), POINTER(POINTER(c_float)), c_uint64, c_uint32]
+instance_run_blocks.restype = None
+
 plugin_get_uis.argtypes = [POINTER(Plugin)]
 plugin_get_uis.restype = POINTER(UIs)
 
@@ -7,16 +7,18 @@ import sys
 import wave
 import numpy
 
+BLOCK_SIZE = 4096
+
 class WavFile(object):
     """Helper class for accessing wav file data. Should work on the most common
     formats (8 bit unsigned, 16 bit signed, 32 bit signed). Audio data is
     converted to float32."""
 
-    # (struct format code, is_signedtype) for each sample width:
+    # (numpy sample type, is_signedtype) for each sample width:
     WAV_SPECS = {
-        1: ("B", False),
-        2: ("h", True),
-        4: ("l", True),
+        1: (numpy.uint8, False),
+        2: (numpy.int16, True),
+        4: (numpy.int32, True),
     }
 
     def __init__(self, wav_in_path):
@@ -26,25 +28,22 @@ class WavFile(object):
         self.nchannels = self.wav_in.getnchannels()
         self.sampwidth = self.wav_in.getsampwidth()
         wav_spec = self.WAV_SPECS[self.sampwidth]
-        self.struct_fmt_code, self.signed = wav_spec
+        self.dtype, self.signed = wav_spec
         self.range = 2 ** (8*self.sampwidth)
 
     def read(self):
         """Read data from an open wav file. Return a list of channels, where each
-        channel is a list of floats."""
+        channel is a contiguous float32 array."""
         raw_bytes = self.wav_in.readframes(self.nframes)
-        struct_fmt = "%u%s" % (len(raw_bytes) / self.sampwidth, self.struct_fmt_code)
-        data = wave.struct.unpack(struct_fmt, raw_bytes)
+        data = numpy.frombuffer(raw_bytes, self.dtype).astype(numpy.float32)
         if self.signed:
-            data = [i / float(self.range/2) for i in data]
+            data /= float(self.range/2)
         else:
-            data = [(i - float(range/2)) / float(range/2) for i in data]
-
-        channels = []
-        for i in range(self.nchannels):
-            channels.append([data[j] for j in range(0, len(data), self.nchannels) ])
+            data = (data - float(self.range/2)) / float(self.range/2)
 
-        return channels
+        frames = data.reshape(-1, self.nchannels)
+        return [numpy.ascontiguousarray(frames[:, i])
+                for i in range(self.nchannels)]
 
     def close(self):
         self.wav_in.close()
@@ -108,18 +107,17 @@ def main():
     channels = wav_in.read()
     wav_in.close()
 
-    # Connect all ports to buffers. NB if we fail to connect any buffer, lilv
-    # will segfault.
-    audio_input_buffers    = []
-    audio_output_buffers   = []
+    # Connect control ports to buffers, and collect audio buffers to run in
+    # blocks. NB if we fail to connect any buffer, lilv will segfault.
+    audio_inputs           = {}
+    audio_outputs          = {}
     control_input_buffers  = []
     control_output_buffers = []
     for index in range(plugin.get_num_ports()):
         port = plugin.get_port_by_index(index)
         if port.is_a(ns.lv2.InputPort):
             if port.is_a(ns.lv2.AudioPort):
-                audio_input_buffers.append(numpy.array(channels[len(audio_input_buffers)], numpy.float32))
-                instance.connect_port(index, audio_input_buffers[-1])
+                audio_inputs[index] = channels[len(audio_inputs)]
             elif port.is_a(ns.lv2.ControlPort):
                 default = float(port.get(ns.lv2.default))
                 control_input_buffers.append(numpy.array([default], numpy.float32))
@@ -128,19 +126,20 @@ def main():
                 raise ValueError("Unhandled port type")
         elif port.is_a(ns.lv2.OutputPort):
             if port.is_a(ns.lv2.AudioPort):
-                audio_output_buffers.append(numpy.array([0] * wav_in.nframes, numpy.float32))
-                instance.connect_port(index, audio_output_buffers[-1])
+                audio_outputs[index] = numpy.zeros(wav_in.nframes, numpy.float32)
             elif port.is_a(ns.lv2.ControlPort):
                 control_output_buffers.append(numpy.array([0], numpy.float32))
                 instance.connect_port(index, control_output_buffers[-1])
             else:
                 raise ValueError("Unhandled port type")
 
-    # Run the plugin:
-    instance.run(wav_in.nframes)
+    # Run the plugin over the whole file directly on the buffers:
+    instance.activate()
+    instance.run_blocks(audio_inputs, audio_outputs, BLOCK_SIZE)
+    instance.deactivate()
 
     # Interleave output buffers:
-    data = numpy.dstack(audio_output_buffers).flatten()
+    data = numpy.dstack([audio_outputs[i] for i in sorted(audio_outputs)]).flatten()
 
     # Return to original int range:
     if wav_in.signed:
@@ -148,10 +147,8 @@ def main():
     else:
         data = (data + 1) * float(wav_in.range/2)
 
-    # Write output file in chunks to stop memory usage getting out of hand:
-    CHUNK_SIZE = 8192
-    for chunk in numpy.array_split(data, CHUNK_SIZE):
-        wav_out.writeframes(wave.struct.pack("%u%s" % (len(chunk), wav_in.struct_fmt_code), *chunk.astype(int)))
+    # Write output file:
+    wav_out.writeframes(data.astype(wav_in.dtype).tobytes())
     wav_out.close()
 
 
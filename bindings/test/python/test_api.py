@@ -254,16 +254,37 @@ class InstanceTests(unittest.TestCase):
     def testRun(self):
         import numpy
         n_samples = 100
-        buf = numpy.zeros(n_samples)
+        buf = numpy.zeros(n_samples, numpy.float32)
         with self.assertRaises(Exception):
             self.instance.connect_port(0, "hello")
+        with self.assertRaises(ValueError):
+            self.instance.connect_port(2, numpy.zeros(n_samples))
+        with self.assertRaises(ValueError):
+            self.instance.connect_port(2, numpy.zeros(2 * n_samples, numpy.float32)[::2])
         self.instance.connect_port(0, None)
         self.instance.connect_port(0, None)
         self.instance.connect_port(2, buf)
         self.instance.connect_port(3, buf)
+        self.assertIs(self.instance.buffers[2], buf)
         self.instance.activate()
         self.instance.run(n_samples)
         self.instance.deactivate()
+        self.instance.connect_port(2, None)
+        self.assertNotIn(2, self.instance.buffers)
+
+    def testRunBlocks(self):
+        import numpy
+        n_samples = 1000
+        control   = numpy.array([0.5], numpy.float32)
+        inputs    = { 2: numpy.ones(n_samples, numpy.float32) }
+        outputs   = { 3: numpy.zeros(n_samples, numpy.float32) }
+        self.instance.connect_port(0, control)
+        self.instance.activate()
+        self.assertIs(self.instance.run_blocks(inputs, outputs, 64), outputs)
+        self.instance.deactivate()
+        self.assertIs(self.instance.buffers[3], outputs[3])
+        with self.assertRaises(ValueError):
+            self.instance.run_blocks(inputs, { 3: numpy.zeros(10, numpy.float32) }, 64)
 
 class UITests(unittest.TestCase):
     def setUp(self):
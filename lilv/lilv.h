@@ -84,7 +84,15 @@ typedef struct LilvUIImpl          LilvUI;           /**< Plugin UI. */
 typedef struct LilvNodeImpl        LilvNode;         /**< Typed Value. */
 typedef struct LilvWorldImpl       LilvWorld;        /**< Lilv World. */
 typedef struct LilvInstanceImpl    LilvInstance;     /**< Plugin instance. */
+typedef struct LilvInstanceGroupImpl LilvInstanceGroup; /**< Instance group. */
+typedef struct LilvGraphImpl       LilvGraph;        /**< Instance graph. */
+typedef struct LilvInstancePoolImpl LilvInstancePool; /**< Instance pool. */
+typedef struct LilvPortBuffersImpl LilvPortBuffers;  /**< Port buffers. */
 typedef struct LilvStateImpl       LilvState;        /**< Plugin state. */
+typedef struct LilvPreparedStateImpl LilvPreparedState; /**< Prepared state. */
+typedef struct LilvURIDMapImpl     LilvURIDMap;      /**< URID map. */
+typedef struct LilvSearchIndexImpl LilvSearchIndex;  /**< Plugin search index. */
+typedef struct LilvWatcherImpl     LilvWatcher;      /**< Bundle watcher. */
 
 typedef void LilvIter;           /**< Collection iterator */
 typedef void LilvPluginClasses;  /**< set<PluginClass>. */
@@ -524,24 +532,211 @@ lilv_world_new(void);
 */
 #define LILV_OPTION_FILTER_LANG "http://drobilla.net/ns/lilv#filter-lang"
 
+/**
+   Set the language used for language filtering.
+   The value is a string language tag like "en-ca".  By default, the
+   language is taken from the LANG environment variable when the world is
+   created.  An empty string selects untranslated values.  The names of
+   plugins and ports are chosen for this language when they are loaded.
+*/
+#define LILV_OPTION_LANG "http://drobilla.net/ns/lilv#lang"
+
 /**
    Enable/disable dynamic manifest support.
    Dynamic manifest data will only be loaded if this option is true.
 */
 #define LILV_OPTION_DYN_MANIFEST "http://drobilla.net/ns/lilv#dyn-manifest"
 
+/**
+   Set the number of threads used to parse bundle manifests.
+   If this is an integer greater than 1, lilv_world_load_all() parses the
+   manifest of every discovered bundle concurrently on a pool of this many
+   threads, then adds the results to the world in the same order as a serial
+   load, so the resulting world is identical.  The default, 0, loads every
+   bundle serially on the calling thread.
+*/
+#define LILV_OPTION_LOAD_THREADS "http://drobilla.net/ns/lilv#load-threads"
+
+/**
+   Enable/disable the discovery cache.
+   If this is true, lilv_world_load_all() keeps the parsed contents of bundle
+   manifests and specification data files in a cache file under
+   $XDG_CACHE_HOME/lilv, so they do not need to be parsed again when the world
+   is next loaded.  The value may also be a string, which is used as the path
+   of the cache file.  Cached data is only used while the size and
+   modification time of the original file are unchanged, and cached data for a
+   bundle is discarded when it is unloaded.  The cache is disabled by default.
+*/
+#define LILV_OPTION_CACHE "http://drobilla.net/ns/lilv#cache"
+
+/**
+   Enable/disable the state copy index.
+   If this is true, lilv_state_new_from_instance() keeps an index of the
+   files in the copy directory, with a hash of their contents and the size and
+   modification time of the file each was copied from.  A file that has not
+   changed since it was last copied reuses that copy without being read.
+   Otherwise, only copies with the same hash and size are compared to the
+   file byte by byte, and one with the same contents is reused instead of
+   making a new copy.  The index is disabled by default.
+*/
+#define LILV_OPTION_STATE_COPY_INDEX "http://drobilla.net/ns/lilv#state-copy-index"
+
+/**
+   Enable/disable the query cache.
+   If this is true, the results of lilv_world_find_nodes(), lilv_world_ask(),
+   lilv_world_get(), and the similar queries lilv makes internally, are
+   recorded by pattern, so asking the same query again is a single lookup.
+   Recorded results are discarded whenever the data in the world changes, for
+   example when a bundle is loaded or unloaded, or a plugin's data is loaded
+   by the first query about it.  The cache is disabled by default.
+*/
+#define LILV_OPTION_QUERY_CACHE "http://drobilla.net/ns/lilv#query-cache"
+
+/**
+   Enable/disable selective loading of plugin data.
+   If this is true, the first call to lilv_plugin_get_name(),
+   lilv_plugin_get_class(), lilv_plugin_get_library_uri(), or a function that
+   only needs the plugin's ports and their symbols, names, types and ranges,
+   reads the plugin's data files but keeps only the statements about the
+   plugin and its ports, without their scale points.  The rest of the data is
+   loaded by the first query that needs it.  Until then, queries made directly
+   on the world see only this summary.  Plugins with prototypes or dynamic
+   manifests are always loaded fully.  Selective loading is disabled by
+   default.
+*/
+#define LILV_OPTION_SELECTIVE_LOAD "http://drobilla.net/ns/lilv#selective-load"
+
+/**
+   Enable/disable loading of documentation.
+   If this is false, statements with predicates that are only used for
+   documentation, like rdfs:comment, lv2:documentation, doap:description, and
+   doap:release with its change log, are dropped while data is loaded, so they
+   never use any memory.  Documentation is loaded by default.
+*/
+#define LILV_OPTION_DOCUMENTATION "http://drobilla.net/ns/lilv#documentation"
+
 /**
    Set an option option for `world`.
 
    Currently recognized options:
    @ref LILV_OPTION_FILTER_LANG
+   @ref LILV_OPTION_LANG
    @ref LILV_OPTION_DYN_MANIFEST
+   @ref LILV_OPTION_LOAD_THREADS
+   @ref LILV_OPTION_CACHE
+   @ref LILV_OPTION_STATE_COPY_INDEX
+   @ref LILV_OPTION_QUERY_CACHE
+   @ref LILV_OPTION_SELECTIVE_LOAD
+   @ref LILV_OPTION_DOCUMENTATION
 */
 LILV_API void
 lilv_world_set_option(LilvWorld*      world,
                       const char*     uri,
                       const LilvNode* value);
 
+/**
+   A kind of operation reported to a LilvTraceFunc.
+*/
+typedef enum {
+	LILV_TRACE_LOAD_BUNDLE,    ///< lilv_world_load_bundle(), uri is the bundle
+	LILV_TRACE_LOAD_FILE,      ///< Parsing a data file, uri is the file
+	LILV_TRACE_LOAD_PLUGIN,    ///< Loading a plugin's data, uri is the plugin
+	LILV_TRACE_OPEN_LIBRARY,   ///< Opening a plugin library, uri is the library
+	LILV_TRACE_INSTANTIATE,    ///< lilv_plugin_instantiate(), uri is the plugin
+	LILV_TRACE_SAVE_STATE,     ///< lilv_state_save(), uri is the state
+	LILV_TRACE_RESTORE_STATE   ///< lilv_state_restore(), uri is the state
+} LilvTraceSpanType;
+
+/**
+   A timed operation reported to a LilvTraceFunc.
+*/
+typedef struct {
+	LilvTraceSpanType type;          ///< Kind of operation
+	const char*       uri;           ///< Subject of operation, or NULL
+	uint64_t          begin;         ///< Start time in nanoseconds
+	uint64_t          end;           ///< End time in nanoseconds
+	size_t            n_statements;  ///< Statements added, for LOAD_FILE
+} LilvTraceSpan;
+
+/**
+   Function called by lilv after every traced operation.
+*/
+typedef void (*LilvTraceFunc)(void* handle, const LilvTraceSpan* span);
+
+/**
+   Set a function to be called with the timing of expensive operations.
+
+   This is meant for profiling startup on real systems, by passing the spans
+   on to a host's own tracing or logging facility.  Times are from a
+   monotonic clock, and are zero if it is not supported on this platform.
+   Spans nest, for example a plugin's files are loaded within a load of
+   that plugin, and an inner span is reported before the one containing it.
+
+   The function must be thread-safe, and must not call lilv functions that
+   use `world` itself.  It is usually called from threads that call lilv
+   functions with `world`, but libraries opened by the preload thread of
+   lilv_world_preload_libraries() and instances made by the worker thread of
+   an instance pool are reported from those threads, concurrently with any
+   other span.  Files parsed by lilv's own loading threads are reported with
+   the time they were parsed once they are added to the world, so their spans
+   do not nest within the span of their bundle.  When no function is set,
+   tracing costs nothing but a check.
+
+   @param world The world to trace.
+   @param func Function called after every traced operation, or NULL.
+   @param handle Opaque user data passed to `func`.
+*/
+LILV_API void
+lilv_world_set_trace_func(LilvWorld* world, LilvTraceFunc func, void* handle);
+
+/**
+   Counts of the data held by a world, from lilv_world_get_memory_stats().
+*/
+typedef struct {
+	size_t n_statements;      ///< Statements in the model
+	size_t n_rdf_nodes;       ///< Distinct RDF nodes in the model
+	size_t n_nodes;           ///< LilvNodes in use
+	size_t n_interned_nodes;  ///< LilvNodes shared between owners
+	size_t node_bytes;        ///< Bytes allocated for LilvNodes
+	size_t n_plugins;         ///< Plugins, including unloaded ones
+	size_t n_loaded_plugins;  ///< Plugins with all their data loaded
+	size_t n_libraries;       ///< Open plugin libraries
+	size_t n_files;           ///< Data files loaded
+	size_t n_specs;           ///< Specifications
+} LilvMemoryStats;
+
+/**
+   Get counts of the data held by `world`.
+
+   This is meant for finding leaks and growth in long-running hosts.  It walks
+   some internal lists, so it is not free, but does not walk the model.
+*/
+LILV_API void
+lilv_world_get_memory_stats(LilvWorld* world, LilvMemoryStats* stats);
+
+/**
+   Counts of the data loaded from a bundle, from lilv_world_get_bundle_stats().
+*/
+typedef struct {
+	size_t n_statements;   ///< Statements in the bundle's graph
+	size_t literal_bytes;  ///< Bytes of literal text in those statements
+} LilvBundleStats;
+
+/**
+   Get counts of the data loaded from a bundle.
+
+   This counts the statements that lilv_world_unload_bundle() would remove,
+   so hosts can decide which bundles to unload to stay within a memory
+   budget.  Literals, like descriptions and labels, are usually not shared
+   with other bundles and are most of the size of a bundle's data.  This
+   visits every statement in the bundle.
+   @return Zero on success, or non-zero if `bundle_uri` is not a URI.
+*/
+LILV_API int
+lilv_world_get_bundle_stats(LilvWorld*       world,
+                            const LilvNode*  bundle_uri,
+                            LilvBundleStats* stats);
+
 /**
    Destroy the world, mwahaha.
    It is safe to call this function on NULL.
@@ -562,10 +757,71 @@ lilv_world_free(LilvWorld* world);
    Hosts should use this function rather than explicitly load bundles, except
    in special circumstances (e.g. development utilities, or hosts that ship
    with special plugin bundles which are installed to a known location).
+
+   Specifications are indexed by URI, but only the one that defines lv2:Plugin
+   is loaded, for the plugin classes.  Other specifications are not read
+   until the first call to lilv_world_get_plugin_classes() or
+   lilv_plugin_get_class(), which loads those that declare plugin classes.
+   The data of any other specification is loaded the first time
+   lilv_world_find_nodes(), lilv_world_get(), or lilv_world_ask() is called
+   with that specification or a term in its namespace, or when the world is
+   frozen.
 */
 LILV_API void
 lilv_world_load_all(LilvWorld* world);
 
+/**
+   Load only the bundle that contains a plugin.
+
+   This is an alternative to lilv_world_load_all() for hosts that only need a
+   few plugins.  The first time it is called, the manifest of every installed
+   bundle is scanned (using the discovery cache and load threads if enabled)
+   to build an index of plugin URIs, but nothing is added to the world.  Only
+   the bundle of the requested plugin (the first one in LV2_PATH that
+   describes it) is then loaded with lilv_world_load_bundle().
+
+   Specifications and plugin classes are not loaded, call
+   lilv_world_load_specifications() and lilv_world_load_plugin_classes() if
+   they are needed.  The index is not updated when bundles are installed, so
+   hosts that need to see new plugins should use a new world.
+
+   @return The plugin, or NULL if no installed bundle describes `uri`.
+*/
+LILV_API const LilvPlugin*
+lilv_world_load_plugin(LilvWorld* world, const LilvNode* uri);
+
+/**
+   Freeze the world so it may be queried from several threads at once.
+
+   All lazily loaded data (plugin ports, classes, and libraries, and
+   specifications) is loaded immediately, after which the world data is never
+   modified.  Any query function may then be called concurrently from several
+   threads without external locking.  Creating, duplicating, and freeing
+   nodes is internally serialized, as is instantiating plugins.
+
+   Once frozen, the world can not be thawed: functions that load or unload
+   data, such as lilv_world_load_bundle() and lilv_world_unload_resource(),
+   print an error and fail.  State functions are not covered by this
+   guarantee and must not be called concurrently.
+*/
+LILV_API void
+lilv_world_freeze(LilvWorld* world);
+
+/**
+   Open the library of every plugin in the world ahead of time.
+
+   This calls lilv_plugin_preload() for every plugin.  If the world is frozen
+   and lilv is built with thread support, the libraries are opened on a
+   background thread and this function returns immediately.  Plugins may be
+   instantiated meanwhile, a plugin whose library is not yet open simply
+   opens it as usual.  Otherwise, every library is opened before returning.
+
+   `features` must remain valid until the world is freed.
+*/
+LILV_API void
+lilv_world_preload_libraries(LilvWorld*               world,
+                             const LV2_Feature*const* features);
+
 /**
    Load a specific bundle.
    `bundle_uri` must be a fully qualified URI to the bundle directory,
@@ -585,9 +841,10 @@ lilv_world_load_bundle(LilvWorld*      world,
 /**
    Load all specifications from currently loaded bundles.
 
-   This is for hosts that explicitly load specific bundles, its use is not
-   necessary when using lilv_world_load_all().  This function parses the
-   specifications and adds them to the model.
+   This is for hosts that explicitly load specific bundles, or that need the
+   data of every specification at once.  Its use is not necessary otherwise,
+   since specifications are loaded lazily by queries.  This function parses
+   the specifications that are not already loaded and adds them to the model.
 */
 LILV_API void
 lilv_world_load_specifications(LilvWorld* world);
@@ -595,9 +852,12 @@ lilv_world_load_specifications(LilvWorld* world);
 /**
    Load all plugin classes from currently loaded specifications.
 
-   Must be called after lilv_world_load_specifications().  This is for hosts
-   that explicitly load specific bundles, its use is not necessary when using
-   lilv_world_load_all().
+   This loads the specification that defines lv2:Plugin if necessary, and
+   any other specification that declares a subclass of it.  Specifications
+   that are not loaded yet are parsed to find these, but only those that
+   declare plugin classes are added to the model.  This is
+   for hosts that explicitly load specific bundles, its use is not necessary
+   when using lilv_world_load_all().
 */
 LILV_API void
 lilv_world_load_plugin_classes(LilvWorld* world);
@@ -613,6 +873,71 @@ lilv_world_load_plugin_classes(LilvWorld* world);
 LILV_API int
 lilv_world_unload_bundle(LilvWorld* world, const LilvNode* bundle_uri);
 
+/**
+   A change to a bundle in the LV2 path.
+*/
+typedef enum {
+	LILV_BUNDLE_ADDED,    ///< A new bundle was loaded
+	LILV_BUNDLE_CHANGED,  ///< A bundle's files changed and it was reloaded
+	LILV_BUNDLE_REMOVED   ///< A bundle was removed and unloaded
+} LilvBundleChange;
+
+/**
+   Function called by lilv_watcher_update() after every bundle change.
+*/
+typedef void (*LilvBundleFunc)(void*            handle,
+                               const LilvNode*  bundle_uri,
+                               LilvBundleChange change);
+
+/**
+   Watch the bundles in the LV2 path for changes.
+
+   The bundles currently in the LV2 path are assumed to be loaded, typically
+   by lilv_world_load_all().  Changes are applied to `world` only when
+   lilv_watcher_update() is called, so hosts can choose when the world may
+   safely be modified.  Inotify is used where available, elsewhere every
+   bundle is checked on each update.
+
+   @param world The world to keep up to date.
+   @param func Function called for every changed bundle, or NULL.
+   @param handle Opaque user data passed to `func`.
+*/
+LILV_API LilvWatcher*
+lilv_watcher_new(LilvWorld* world, LilvBundleFunc func, void* handle);
+
+/**
+   Free a bundle watcher.
+
+   This does not unload any bundles.
+*/
+LILV_API void
+lilv_watcher_free(LilvWatcher* watcher);
+
+/**
+   Return a file descriptor which becomes readable when bundles change.
+
+   Hosts can wait on this with poll() or an event loop, and call
+   lilv_watcher_update() when it is readable.  Returns -1 if changes are not
+   signalled, in which case the host must call lilv_watcher_update()
+   periodically.
+*/
+LILV_API int
+lilv_watcher_get_fd(const LilvWatcher* watcher);
+
+/**
+   Apply any changes to the bundles in the LV2 path to the world.
+
+   All changes since the last update are applied at once.  Only bundles
+   whose files have been added, removed, or modified are loaded or unloaded,
+   and the watcher function is called for each.  Since unloaded plugins only
+   become zombies (see lilv_world_unload_bundle()), pointers to them remain
+   valid.
+
+   @return The number of changed bundles, or -1 on error.
+*/
+LILV_API int
+lilv_watcher_update(LilvWatcher* watcher);
+
 /**
    Load all the data associated with the given `resource`.
    @param world The world.
@@ -638,6 +963,25 @@ LILV_API int
 lilv_world_unload_resource(LilvWorld*      world,
                            const LilvNode* resource);
 
+/**
+   Remove all statements from the world except those with given predicates.
+   @param world The world.
+   @param predicates NULL terminated array of predicates to keep, or NULL.
+   @return The number of statements removed, or -1 on error.
+
+   This is for long-lived hosts that want to free the memory used by data they
+   never query, once everything they need is loaded.  Statements are kept if
+   their predicate is used by lilv to implement its API, or is in
+   `predicates`.  The descriptions of presets are kept entirely, so they can
+   still be loaded with lilv_state_new_from_world().  Removed data is not
+   available to any later query, and files that were loaded are not loaded
+   again.  Data loaded later, for example when a plugin is first queried, is
+   not affected, see @ref LILV_OPTION_DOCUMENTATION to avoid loading
+   documentation at all.
+*/
+LILV_API int
+lilv_world_compact(LilvWorld* world, const LilvNode* const* predicates);
+
 /**
    Get the parent of all other plugin classes, lv2:Plugin.
 */
@@ -647,6 +991,8 @@ lilv_world_get_plugin_class(const LilvWorld* world);
 /**
    Return a list of all found plugin classes.
    Returned list is owned by world and must not be freed by the caller.
+   Specifications that declare plugin classes are loaded by the first call
+   after a bundle is loaded or unloaded, unless the world is frozen.
 */
 LILV_API const LilvPluginClasses*
 lilv_world_get_plugin_classes(const LilvWorld* world);
@@ -908,6 +1254,87 @@ lilv_plugin_get_port_ranges_float(const LilvPlugin* p,
                                   float*            max_values,
                                   float*            def_values);
 
+/**
+   Port type flags, set in LilvPortTable::types.
+*/
+typedef enum {
+	LILV_PORT_INPUT   = 1 << 0,  ///< lv2:InputPort
+	LILV_PORT_OUTPUT  = 1 << 1,  ///< lv2:OutputPort
+	LILV_PORT_AUDIO   = 1 << 2,  ///< lv2:AudioPort
+	LILV_PORT_CONTROL = 1 << 3,  ///< lv2:ControlPort
+	LILV_PORT_CV      = 1 << 4,  ///< lv2:CVPort
+	LILV_PORT_ATOM    = 1 << 5,  ///< atom:AtomPort
+	LILV_PORT_EVENT   = 1 << 6   ///< ev:EventPort
+} LilvPortType;
+
+/**
+   Port property flags, set in LilvPortTable::properties.
+*/
+typedef enum {
+	LILV_PORT_CONNECTION_OPTIONAL = 1 << 0,  ///< lv2:connectionOptional
+	LILV_PORT_INTEGER             = 1 << 1,  ///< lv2:integer
+	LILV_PORT_ENUMERATION         = 1 << 2,  ///< lv2:enumeration
+	LILV_PORT_TOGGLED             = 1 << 3,  ///< lv2:toggled
+	LILV_PORT_SAMPLE_RATE         = 1 << 4,  ///< lv2:sampleRate
+	LILV_PORT_REPORTS_LATENCY     = 1 << 5   ///< lv2:reportsLatency
+} LilvPortProperty;
+
+/**
+   Precomputed description of all ports on a plugin.
+   Each array has `n_ports` elements, indexed by port index.  Range values are
+   NAN if the port does not have a numeric minimum, maximum, or default.
+*/
+typedef struct {
+	uint32_t        n_ports;     ///< Number of ports
+	const uint32_t* types;       ///< LilvPortType flags for each port
+	const uint32_t* properties;  ///< LilvPortProperty flags for each port
+	const float*    min_values;  ///< lv2:minimum of each port
+	const float*    max_values;  ///< lv2:maximum of each port
+	const float*    def_values;  ///< lv2:default of each port
+} LilvPortTable;
+
+/**
+   Get the port table of a plugin.
+
+   The table is built once when the plugin's ports are loaded, so hosts can
+   check the type, common properties, and range of every port without
+   querying the data model.  The returned table is owned by `plugin` and must
+   not be freed.  Returns NULL if the plugin's ports are invalid.
+*/
+LILV_API const LilvPortTable*
+lilv_plugin_get_port_table(const LilvPlugin* plugin);
+
+/**
+   Destination arrays for lilv_plugin_get_port_metadata().
+
+   Each array that is not NULL must have room for
+   lilv_plugin_get_num_ports() elements, and is filled in by port index.
+   Any array may be NULL, in which case that field is not extracted.
+*/
+typedef struct {
+	float*           min_values;       ///< lv2:minimum, or NAN
+	float*           max_values;       ///< lv2:maximum, or NAN
+	float*           def_values;       ///< lv2:default, or NAN
+	const LilvNode** symbols;          ///< lv2:symbol
+	const LilvNode** designations;     ///< lv2:designation, or NULL
+	uint32_t*        properties;       ///< LilvPortProperty flags
+	uint32_t*        n_scale_points;   ///< Number of lv2:scalePoint
+	bool*            reports_latency;  ///< True if port reports latency
+} LilvPortMetadata;
+
+/**
+   Get metadata for every port of a plugin in a single call.
+
+   This is equivalent to calling lilv_port_get_range(),
+   lilv_port_get_symbol(), and so on for every port, but does not allocate or
+   search the data model.  Returned nodes are owned by `plugin` and must not
+   be freed.  A port reports latency if it has the lv2:reportsLatency
+   property or the lv2:latency designation.
+*/
+LILV_API void
+lilv_plugin_get_port_metadata(const LilvPlugin*       plugin,
+                              const LilvPortMetadata* metadata);
+
 /**
    Get the number of ports on this plugin that are members of some class(es).
    Note that this is a varargs function so ports fitting any type 'profile'
@@ -1064,6 +1491,40 @@ lilv_plugin_write_manifest_entry(LilvWorld*        world,
 LILV_API LilvNodes*
 lilv_plugin_get_related(const LilvPlugin* plugin, const LilvNode* type);
 
+/**
+   A summary of a preset, from the data loaded so far.
+*/
+typedef struct {
+	LilvNode* uri;     ///< Preset URI
+	LilvNode* plugin;  ///< URI of the plugin the preset applies to
+	LilvNode* label;   ///< Preset rdfs:label, or NULL
+	LilvNode* bank;    ///< Preset pset:bank, or NULL
+} LilvPresetInfo;
+
+/**
+   Get a summary of every preset of `plugin`.
+
+   This is equivalent to calling lilv_plugin_get_related() with pset:Preset
+   and querying the label and bank of each result, but without loading the
+   data of each preset.  The label and bank are taken from the data already
+   in the world, which usually comes from the manifest of the bundle
+   containing the preset (or the discovery cache, if enabled).  Load the full
+   preset with lilv_state_new_from_world() only when it is actually needed.
+
+   @param plugin The plugin to get the presets of.
+   @param n_presets Set to the number of presets returned.
+   @return An array of presets sorted by URI which must be freed with
+   lilv_preset_infos_free(), or NULL if the plugin has no presets.
+*/
+LILV_API LilvPresetInfo*
+lilv_plugin_get_presets(const LilvPlugin* plugin, unsigned* n_presets);
+
+/**
+   Free an array of presets returned by lilv_plugin_get_presets().
+*/
+LILV_API void
+lilv_preset_infos_free(LilvPresetInfo* presets, unsigned n_presets);
+
 /**
    @}
    @name Port
@@ -1205,6 +1666,44 @@ LILV_API LilvScalePoints*
 lilv_port_get_scale_points(const LilvPlugin* plugin,
                            const LilvPort*   port);
 
+/**
+   A scale point with a numeric value, from lilv_port_get_scale_point_infos().
+*/
+typedef struct {
+	float       value;  ///< rdf:value
+	const char* label;  ///< rdfs:label in the world language
+} LilvScalePointInfo;
+
+/**
+   Get the scale points of a port that have numeric values, sorted by value.
+
+   Unlike lilv_port_get_scale_points(), this allocates nothing.  The scale
+   points of every port of the plugin are built once on the first call, into
+   a single array.  This makes it cheap to draw a generic UI for ports with
+   many scale points.  Scale points with the same value are in the order
+   they were found in the data.
+
+   @param plugin The plugin that `port` belongs to.
+   @param port The port to get the scale points of.
+   @param n_points Set to the number of scale points returned.
+   @return An array owned by `plugin`, or NULL if the port has no numeric
+   scale points.  It remains valid until the plugin is reloaded or the world
+   language changes.
+*/
+LILV_API const LilvScalePointInfo*
+lilv_port_get_scale_point_infos(const LilvPlugin* plugin,
+                                const LilvPort*   port,
+                                uint32_t*         n_points);
+
+/**
+   Return the label of the scale point with value `value`, or NULL.
+   This is a binary search of lilv_port_get_scale_point_infos().
+*/
+LILV_API const char*
+lilv_port_get_scale_point_label(const LilvPlugin* plugin,
+                                const LilvPort*   port,
+                                float             value);
+
 /**
    @}
    @name Plugin State
@@ -1254,6 +1753,39 @@ lilv_state_new_from_string(LilvWorld*    world,
                            LV2_URID_Map* map,
                            const char*   str);
 
+/**
+   Returned by a LilvStateSource that failed to read.
+*/
+#define LILV_STATE_SOURCE_ERROR ((size_t)-1)
+
+/**
+   Function to read serialised state, like fread().
+   @param buf The buffer to read into.
+   @param len The size of `buf` in bytes.
+   @param stream The stream passed to lilv_state_new_from_stream().
+   @return The number of bytes read, which is zero at the end of the stream,
+   or @ref LILV_STATE_SOURCE_ERROR on error.
+*/
+typedef size_t (*LilvStateSource)(void* buf, size_t len, void* stream);
+
+/**
+   Load a state snapshot from a stream written by lilv_state_write_stream().
+
+   The stream is parsed a page at a time as it is read, so it does not need
+   to be in memory at once, and the first statements are parsed before the
+   rest arrive.  No state is returned if the source fails, or if the stream
+   ends in the middle of a statement.  A stream that ends cleanly between
+   statements can not be told apart from a complete one, so a source must
+   return @ref LILV_STATE_SOURCE_ERROR rather than zero if it fails.
+   @return A new LilvState which must be freed with lilv_state_free(), or
+   NULL if no state was read.
+*/
+LILV_API LilvState*
+lilv_state_new_from_stream(LilvWorld*      world,
+                           LV2_URID_Map*   map,
+                           LilvStateSource source,
+                           void*           stream);
+
 /**
    Function to get a port value.
    @param port_symbol The symbol of the port.
@@ -1359,6 +1891,40 @@ lilv_state_free(LilvState* state);
 LILV_API bool
 lilv_state_equals(const LilvState* a, const LilvState* b);
 
+/**
+   Create a new state with only the changes from `from` to `to`.
+
+   The returned state has the port values and properties of `to` which are
+   not present in `from` or have a different value.  It is a normal state
+   which may be saved like any other, or combined with `from` again with
+   lilv_state_new_merged().  Properties present in `from` but removed in `to`
+   are not recorded.
+
+   The returned state is an incomplete description of the plugin state, so
+   restoring it directly with lilv_state_restore() only sets the changed port
+   values and passes the changed properties to the plugin, which may or may
+   not reset other properties.
+
+   @return A new state which must be freed with lilv_state_free(), or NULL if
+   the states are for different plugins.
+*/
+LILV_API LilvState*
+lilv_state_new_delta(const LilvState* from, const LilvState* to);
+
+/**
+   Create a new state by applying the changes in `delta` to `base`.
+
+   Port values and properties in `delta` replace those with the same symbol or
+   key in `base`, others are copied from `base`.  If `delta` was made by
+   lilv_state_new_delta() with `base` as the original state, this reconstructs
+   the changed state.
+
+   @return A new state which must be freed with lilv_state_free(), or NULL if
+   the states are for different plugins.
+*/
+LILV_API LilvState*
+lilv_state_new_merged(const LilvState* base, const LilvState* delta);
+
 /**
    Return the number of properties in `state`.
 */
@@ -1475,6 +2041,68 @@ lilv_state_restore(const LilvState*           state,
                    uint32_t                   flags,
                    const LV2_Feature *const * features);
 
+/**
+   Function to set a port value by index.
+   @param port_index The index of the port.
+   @param user_data The user_data passed to lilv_prepared_state_apply().
+   @param size The size of `value`.
+   @param type The URID of the type of `value`.
+   @param value A pointer to the port value.
+*/
+typedef void (*LilvSetPortIndexValueFunc)(uint32_t    port_index,
+                                          void*       user_data,
+                                          const void* value,
+                                          uint32_t    size,
+                                          uint32_t    type);
+
+/**
+   Prepare a state to be restored to instances of a plugin in real time.
+
+   This does all the work of lilv_state_restore() that allocates or searches:
+   port symbols are resolved to indices, and the feature array passed to the
+   plugin is built.  The prepared state can then be applied any number of
+   times with lilv_prepared_state_apply().
+
+   @param state The state to prepare, which must outlive the prepared state.
+   @param plugin The plugin that the state will be restored to.
+   @param instance An instance of `plugin` used to find its state interface.
+   @param features Features to pass LV2_State_Interface.restore().
+   @return A new prepared state which must be freed with
+   lilv_prepared_state_free().
+*/
+LILV_API LilvPreparedState*
+lilv_state_prepare(const LilvState*           state,
+                   const LilvPlugin*          plugin,
+                   const LilvInstance*        instance,
+                   const LV2_Feature *const * features);
+
+/**
+   Restore a prepared state to a plugin instance.
+
+   This is equivalent to lilv_state_restore(), but port values are passed to
+   `set_value` by index, and Lilv does not allocate memory or take locks.
+   Whether this is realtime safe as a whole depends on the plugin's
+   LV2_State_Interface.restore(), see the LV2 state extension for details.
+
+   @param prepared The prepared state to restore.
+   @param instance An instance of the plugin the state was prepared for.
+   @param set_value Function to set port values, may be NULL.
+   @param user_data User data to pass to `set_value`.
+   @param flags Bitwise OR of LV2_State_Flags values.
+*/
+LILV_API void
+lilv_prepared_state_apply(const LilvPreparedState*  prepared,
+                          LilvInstance*             instance,
+                          LilvSetPortIndexValueFunc set_value,
+                          void*                     user_data,
+                          uint32_t                  flags);
+
+/**
+   Free a prepared state.
+*/
+LILV_API void
+lilv_prepared_state_free(LilvPreparedState* prepared);
+
 /**
    Save state to a file.
    @param world The world.
@@ -1501,6 +2129,52 @@ lilv_state_save(LilvWorld*                 world,
                 const char*                dir,
                 const char*                filename);
 
+/**
+   A request to save a state to a file, for lilv_state_save_batch().
+   The fields have the same meaning as the parameters of lilv_state_save().
+*/
+typedef struct {
+	const LilvState* state;     ///< State to save
+	const char*      uri;       ///< URI of state, may be NULL
+	const char*      dir;       ///< Path of the bundle directory to save into
+	const char*      filename;  ///< Path of the state file relative to `dir`
+} LilvStateSaveRequest;
+
+/**
+   Function called when a state in a batch has been saved.
+   @param state The state which was saved.
+   @param status Zero on success, or the error lilv_state_save() would return.
+   @param user_data The user_data passed to lilv_state_save_batch().
+*/
+typedef void (*LilvStateSavedFunc)(const LilvState* state,
+                                   int              status,
+                                   void*            user_data);
+
+/**
+   Save many states to files at once.
+
+   This is equivalent to calling lilv_state_save() for every request, but
+   much faster for large numbers of states.  State files are written by up to
+   `n_threads` threads in parallel, including the calling thread, and the
+   manifest of each bundle is updated only once.  This function returns when
+   all states have been saved, after calling `saved` for each in the calling
+   thread.
+
+   If `n_threads` is greater than 1, `map` and `unmap` must be safe to call
+   from several threads at once.
+
+   @return The number of states which failed to save.
+*/
+LILV_API unsigned
+lilv_state_save_batch(LilvWorld*                  world,
+                      LV2_URID_Map*               map,
+                      LV2_URID_Unmap*             unmap,
+                      const LilvStateSaveRequest* requests,
+                      size_t                      n_requests,
+                      unsigned                    n_threads,
+                      LilvStateSavedFunc          saved,
+                      void*                       user_data);
+
 /**
    Save state to a string.  This function does not use the filesystem.
 
@@ -1521,6 +2195,69 @@ lilv_state_to_string(LilvWorld*       world,
                      const char*      uri,
                      const char*      base_uri);
 
+/**
+   Function to write serialised state.
+   @param buf The data to write.
+   @param len The size of `buf` in bytes.
+   @param stream The stream passed to lilv_state_write_stream().
+   @return The number of bytes written, which is less than `len` on error.
+*/
+typedef size_t (*LilvStateSink)(const void* buf, size_t len, void* stream);
+
+/**
+   Save state to a stream, in the same format as lilv_state_to_string().
+
+   Data is passed to `sink` as it is generated, so the document is never in
+   memory at once, and the first bytes may be sent before the rest is
+   written.  This is useful for sending large states over a socket or pipe.
+   The parameters are the same as for lilv_state_to_string().
+   @return Zero on success, or non-zero if `sink` failed.
+*/
+LILV_API int
+lilv_state_write_stream(LilvWorld*       world,
+                        LV2_URID_Map*    map,
+                        LV2_URID_Unmap*  unmap,
+                        const LilvState* state,
+                        const char*      uri,
+                        const char*      base_uri,
+                        LilvStateSink    sink,
+                        void*            stream);
+
+/**
+   Save state to a binary file.
+
+   This is like lilv_state_save(), but writes a compact binary file which is
+   much faster to load with lilv_state_new_from_binary().  The file is
+   specific to Lilv and the byte order of this machine, and is not added to
+   the bundle manifest, so Turtle should be used for presets or any state
+   that is shared with other hosts.  Non-POD properties are not saved.
+
+   @param world The world.
+   @param unmap URID unmapper.
+   @param state State to save.
+   @param uri URI of state, may be NULL.
+   @param dir Path of the bundle directory to save into.
+   @param filename Path of the state file relative to `dir`.
+   @return Zero on success.
+*/
+LILV_API int
+lilv_state_save_binary(LilvWorld*       world,
+                       LV2_URID_Unmap*  unmap,
+                       const LilvState* state,
+                       const char*      uri,
+                       const char*      dir,
+                       const char*      filename);
+
+/**
+   Load a state snapshot from a file made by lilv_state_save_binary().
+   The file is memory-mapped if possible.
+   @return A new state, or NULL if the file could not be read or is invalid.
+*/
+LILV_API LilvState*
+lilv_state_new_from_binary(LilvWorld*    world,
+                           LV2_URID_Map* map,
+                           const char*   path);
+
 /**
    Unload a state from the world and delete all associated files.
    @param world The world.
@@ -1588,12 +2325,29 @@ LILV_API const LilvNode*
 lilv_plugin_class_get_label(const LilvPluginClass* plugin_class);
 
 /**
-   Get the subclasses of this plugin class.
+   Get the direct subclasses of this plugin class.
    Returned value must be freed by caller with lilv_plugin_classes_free().
 */
 LILV_API LilvPluginClasses*
 lilv_plugin_class_get_children(const LilvPluginClass* plugin_class);
 
+/**
+   Return true iff `plugin_class` is `ancestor` or a descendant of it.
+
+   The class hierarchy is indexed when classes are loaded, so this takes
+   constant time, for example to filter many plugins by category.
+*/
+LILV_API bool
+lilv_plugin_class_is_subclass_of(const LilvPluginClass* plugin_class,
+                                 const LilvPluginClass* ancestor);
+
+/**
+   Get the number of ancestors of this plugin class.
+   This is 0 for lv2:Plugin and classes whose parent is not loaded.
+*/
+LILV_API unsigned
+lilv_plugin_class_get_depth(const LilvPluginClass* plugin_class);
+
 /**
    @}
    @name Plugin Instance
@@ -1636,17 +2390,108 @@ lilv_plugin_instantiate(const LilvPlugin*        plugin,
                         const LV2_Feature*const* features);
 
 /**
-   Free a plugin instance.
-   It is safe to call this function on NULL.
-   `instance` is invalid after this call.
-*/
-LILV_API void
-lilv_instance_free(LilvInstance* instance);
+   Instantiate a plugin in a separate process.
 
-#ifndef LILV_INTERNAL
+   The returned instance is used exactly like one returned by
+   lilv_plugin_instantiate(), but the plugin runs in a child process, so if
+   it crashes, only the instance is affected.  Ports are connected to buffers
+   shared with the child, which are copied to and from the host's buffers in
+   lilv_instance_run().  Only audio, CV, control, and atom ports are copied,
+   and lilv_instance_get_extension_data() always returns NULL.
 
-/**
-   Get the URI of the plugin which `instance` is an instance of.
+   If the child crashes, or does not respond to a call within 10 seconds, it
+   is killed and lilv_instance_has_crashed() returns true.  From then on,
+   lilv_instance_run() sets audio and CV outputs to zero and does nothing
+   else.
+
+   The child is a fork of the calling process, so `features` are used by a
+   copy of the host that does not communicate with it afterwards.  In
+   particular, URIDs mapped after instantiation are not shared.  Since only
+   the calling thread exists in the child, no other thread may hold a lock
+   the plugin needs, such as one in a URID map, while this is called.
+
+   @param plugin The plugin to instantiate.
+   @param sample_rate Sample rate to run at.
+   @param features Features the host supports, or NULL.
+   @param max_block_length The maximum sample count that will be run.
+   @return NULL if instantiation failed, or is not supported on this system.
+*/
+LILV_API LilvInstance*
+lilv_plugin_instantiate_isolated(const LilvPlugin*        plugin,
+                                 double                   sample_rate,
+                                 const LV2_Feature*const* features,
+                                 uint32_t                 max_block_length);
+
+/**
+   Return true if `instance` was created by lilv_plugin_instantiate_isolated().
+*/
+LILV_API bool
+lilv_instance_is_isolated(const LilvInstance* instance);
+
+/**
+   Return true if the process of an isolated instance has died.
+
+   A crashed instance does nothing when run, and its output buffers are left
+   unchanged.  It must still be freed with lilv_instance_free().
+*/
+LILV_API bool
+lilv_instance_has_crashed(const LilvInstance* instance);
+
+/**
+   Open the library of a plugin ahead of time.
+
+   Opening a plugin library may be slow, because of symbol relocation and
+   static initialisers in the library.  This opens the library and resolves
+   its descriptor function now, and keeps it open until the world is freed,
+   so lilv_plugin_instantiate() only needs to instantiate the plugin.
+
+   `features` is passed to lv2_lib_descriptor() if the library has one, and
+   must remain valid as long as the library is open.
+
+   @return Zero on success, or non-zero if the library could not be opened.
+*/
+LILV_API int
+lilv_plugin_preload(const LilvPlugin*        plugin,
+                    const LV2_Feature*const* features);
+
+/**
+   Free a plugin instance.
+   It is safe to call this function on NULL.
+   `instance` is invalid after this call.
+*/
+LILV_API void
+lilv_instance_free(LilvInstance* instance);
+
+/**
+   Run `instance` over whole buffers, one block at a time.
+
+   Each of the `n_ports` ports in `ports` is connected to the corresponding
+   buffer in `buffers`, which holds `n_frames` samples, advanced by
+   `block_size` samples for every block.  This is how offline hosts can
+   process long buffers with plugins that have a maximum block length,
+   without a function call per block from a slow language.  Other ports, such
+   as controls, must be connected beforehand.  When this returns, the ports
+   are still connected to the last block of their buffers.
+
+   @param instance The instance to run.
+   @param n_ports The number of elements in `ports` and `buffers`.
+   @param ports Indices of the audio or CV ports to connect.
+   @param buffers Buffers for each port with `n_frames` samples.
+   @param n_frames Total number of samples to process.
+   @param block_size Maximum number of samples to process per run.
+*/
+LILV_API void
+lilv_instance_run_blocks(LilvInstance*   instance,
+                         uint32_t        n_ports,
+                         const uint32_t* ports,
+                         float* const*   buffers,
+                         uint64_t        n_frames,
+                         uint32_t        block_size);
+
+#ifndef LILV_INTERNAL
+
+/**
+   Get the URI of the plugin which `instance` is an instance of.
    Returned string is shared and must not be modified or deleted.
 */
 static inline const char*
@@ -1749,6 +2594,363 @@ lilv_instance_get_handle(const LilvInstance* instance)
 
 #endif /* LILV_INTERNAL */
 
+/**
+   Create a new empty instance group.
+
+   A group runs many instances with a single call, which is faster than
+   calling lilv_instance_run() for each when there are many instances.
+   Instances of the same plugin are run consecutively, so the plugin code
+   stays in the cache.  The group does not own its instances, which must
+   outlive it or be removed before being freed.
+*/
+LILV_API LilvInstanceGroup*
+lilv_instance_group_new(void);
+
+/**
+   Free an instance group.
+   The instances in the group are not freed.
+*/
+LILV_API void
+lilv_instance_group_free(LilvInstanceGroup* group);
+
+/**
+   Add an instance to a group.
+
+   Instances are numbered in the order they were added, starting at zero,
+   which is the order of data locations for
+   lilv_instance_group_connect_port().  This function allocates memory and
+   is not realtime safe.
+   @return Zero on success, or non-zero if `instance` is already in `group`.
+*/
+LILV_API int
+lilv_instance_group_add(LilvInstanceGroup* group, LilvInstance* instance);
+
+/**
+   Remove an instance from a group.
+   Instances added after `instance` are renumbered to fill the gap.
+   @return Zero on success, or non-zero if `instance` is not in `group`.
+*/
+LILV_API int
+lilv_instance_group_remove(LilvInstanceGroup* group, LilvInstance* instance);
+
+/**
+   Return the number of instances in a group.
+*/
+LILV_API uint32_t
+lilv_instance_group_size(const LilvInstanceGroup* group);
+
+/**
+   Connect the same port of every instance in a group.
+   `data_locations` must have lilv_instance_group_size() elements, indexed by
+   the order instances were added.  This function is realtime safe.
+*/
+LILV_API void
+lilv_instance_group_connect_port(LilvInstanceGroup* group,
+                                 uint32_t           port_index,
+                                 void* const*       data_locations);
+
+/**
+   Activate every instance in a group.
+*/
+LILV_API void
+lilv_instance_group_activate(LilvInstanceGroup* group);
+
+/**
+   Run every instance in a group for `sample_count` frames.
+   This function is realtime safe if every plugin in the group is
+   lv2:hardRTCapable.
+*/
+LILV_API void
+lilv_instance_group_run(LilvInstanceGroup* group, uint32_t sample_count);
+
+/**
+   Deactivate every instance in a group.
+*/
+LILV_API void
+lilv_instance_group_deactivate(LilvInstanceGroup* group);
+
+/**
+   @}
+   @name Instance Graph
+   @{
+*/
+
+/**
+   Create a new empty instance graph.
+
+   A graph runs a set of instances each cycle in dependency order, using a
+   fixed pool of `n_threads` worker threads in addition to the thread that
+   calls lilv_graph_run().  Independent instances run in parallel.  If
+   threads are not supported, the graph runs serially in the calling thread.
+
+   If `realtime` is true, worker threads are given real-time priority where
+   possible, and only plugins which are lv2:hardRTCapable may be added.
+
+   The graph does not own its instances, which must outlive it.
+*/
+LILV_API LilvGraph*
+lilv_graph_new(unsigned n_threads, bool realtime);
+
+/**
+   Free an instance graph and stop its worker threads.
+   The instances in the graph are not freed.
+*/
+LILV_API void
+lilv_graph_free(LilvGraph* graph);
+
+/**
+   Add an instance of `plugin` to a graph.
+   This function allocates memory and must not be called while the graph is
+   running.
+
+   If the plugin reports latency on a control output port, the graph connects
+   that port to a buffer of its own, so its value is available from
+   lilv_graph_get_latencies() even if the host does not connect it.
+   @return The index of the new node, or -1 on error.
+*/
+LILV_API int32_t
+lilv_graph_add(LilvGraph*        graph,
+               const LilvPlugin* plugin,
+               LilvInstance*     instance);
+
+/**
+   Connect an output port of one node to an input port of another.
+
+   Both ports are connected to `buffer`, and `dst` will be run after `src`
+   every cycle.  Ports not connected this way, such as graph inputs and
+   outputs, must be connected by the caller with lilv_graph_connect_port().
+   @return Zero on success, or non-zero if the connection would form a cycle.
+*/
+LILV_API int
+lilv_graph_connect(LilvGraph* graph,
+                   uint32_t   src,
+                   uint32_t   src_port,
+                   uint32_t   dst,
+                   uint32_t   dst_port,
+                   void*      buffer);
+
+/**
+   Connect a port of `node` to a buffer owned by the caller.
+
+   This is like lilv_instance_connect_port(), but if the port is the latency
+   port of the node, lilv_graph_get_latencies() reads it from `buffer`
+   afterwards.  Latency ports connected with lilv_instance_connect_port() are
+   not seen by the graph.
+   @return Zero on success, or non-zero if `node` is not in the graph.
+*/
+LILV_API int
+lilv_graph_connect_port(LilvGraph* graph,
+                        uint32_t   node,
+                        uint32_t   port,
+                        void*      buffer);
+
+/**
+   Run every instance in a graph once for `sample_count` frames.
+   This returns after all instances have been run, and does not allocate or
+   take locks other than waking and waiting for worker threads.
+*/
+LILV_API void
+lilv_graph_run(LilvGraph* graph, uint32_t sample_count);
+
+/**
+   Return how long `node` took to run in the last cycle, in nanoseconds.
+   This is zero if the system does not provide a monotonic clock.
+*/
+LILV_API uint64_t
+lilv_graph_get_node_time(const LilvGraph* graph, uint32_t node);
+
+/**
+   Read the latency reported by every node in the last cycle, in frames.
+
+   This writes one value per node to `latencies`, which must have room for
+   every node in the graph, in the order they were added.  Nodes without a
+   latency port report zero.  This function is realtime safe, so hosts can
+   recompute latency compensation after every call to lilv_graph_run().
+*/
+LILV_API void
+lilv_graph_get_latencies(const LilvGraph* graph, float* latencies);
+
+/**
+   @}
+   @name Instance Pool
+   @{
+*/
+
+/**
+   Create a pool that keeps `size` instances of a plugin ready to take.
+
+   Instantiating a plugin opens its library, calls its instantiate function,
+   and connects every port, which is too slow for a realtime thread.  A pool
+   does this ahead of time, so lilv_instance_pool_take() only has to pop an
+   instance from a lock-free stack.  On platforms without atomic operations,
+   the stack is protected by a mutex instead.
+
+   If the world is frozen (see lilv_world_freeze()) and threads are
+   supported, the pool has a thread that creates instances, in the
+   background from the start, and recycles returned ones.  Otherwise, the
+   pool is filled by this function, and the host must call
+   lilv_instance_pool_refill() from a non-realtime thread to replace the
+   instances it takes.
+
+   @param plugin The plugin to instantiate.
+   @param sample_rate The sample rate to instantiate plugins with.
+   @param features Features for instantiation and restoring state, which must
+   outlive the pool.
+   @param size The number of instances to keep ready.
+   @param state If not NULL, returned instances are reset by restoring this
+   state and reused, rather than freed and replaced.  It must outlive the
+   pool.
+*/
+LILV_API LilvInstancePool*
+lilv_instance_pool_new(const LilvPlugin*        plugin,
+                       double                   sample_rate,
+                       const LV2_Feature*const* features,
+                       uint32_t                 size,
+                       const LilvState*         state);
+
+/**
+   Free a pool and the instances that are ready or returned to it.
+   Instances taken from the pool and not returned must be freed with
+   lilv_instance_free() as usual.
+*/
+LILV_API void
+lilv_instance_pool_free(LilvInstancePool* pool);
+
+/**
+   Take an instance from a pool, or return NULL if none is ready.
+
+   The instance is not active, and every port is connected to NULL.  This
+   function is realtime safe, but must not be called from several threads at
+   once.
+*/
+LILV_API LilvInstance*
+lilv_instance_pool_take(LilvInstancePool* pool);
+
+/**
+   Return an instance that was taken from a pool.
+
+   The instance must be deactivated.  It is freed, or reset and reused if the
+   pool has a state, in the background or by the next call to
+   lilv_instance_pool_refill().  This function is realtime safe, but must not
+   be called from several threads at once.
+*/
+LILV_API void
+lilv_instance_pool_return(LilvInstancePool* pool, LilvInstance* instance);
+
+/**
+   Handle returned instances and create instances until the pool is full.
+   If the pool has a thread, this only wakes it.  Otherwise, this function is
+   not realtime safe, and must be called from the thread that uses the world.
+*/
+LILV_API void
+lilv_instance_pool_refill(LilvInstancePool* pool);
+
+/**
+   Return the number of instances that are ready to take from a pool.
+*/
+LILV_API uint32_t
+lilv_instance_pool_get_num_ready(const LilvInstancePool* pool);
+
+/**
+   @}
+   @name Port Buffers
+   @{
+*/
+
+/**
+   The alignment of every buffer in a LilvPortBuffers, in bytes.
+   This is a cache line on most systems, and enough for any SIMD registers.
+*/
+#define LILV_PORT_BUFFER_ALIGNMENT 64
+
+/**
+   Allocate a buffer for every port of a plugin.
+
+   Every buffer is allocated from a single block of memory, aligned to
+   @ref LILV_PORT_BUFFER_ALIGNMENT, and padded to a multiple of it, so ports
+   never share a cache line.  Buffers are sized from the port table (see
+   lilv_plugin_get_port_table()):
+
+   - Audio and CV ports have `block_length` floats.
+   - Control ports have a single float, set to the default value of the port,
+     or its minimum if it has no default, or zero.
+   - Atom and event ports have `atom_capacity` bytes, and are zeroed.  The
+     host must still initialise sequences before running.
+   - Other ports have no buffer.
+
+   @return New buffers which must be freed with lilv_port_buffers_free(), or
+   NULL if the plugin's ports are invalid.
+*/
+LILV_API LilvPortBuffers*
+lilv_port_buffers_new(const LilvPlugin* plugin,
+                      uint32_t          block_length,
+                      uint32_t          atom_capacity);
+
+/**
+   Free port buffers.
+   Any instance they are connected to must be reconnected before it is run.
+*/
+LILV_API void
+lilv_port_buffers_free(LilvPortBuffers* buffers);
+
+/**
+   Return the buffer for a port, or NULL if the port has none.
+*/
+LILV_API void*
+lilv_port_buffers_get(const LilvPortBuffers* buffers, uint32_t port_index);
+
+/**
+   Connect every port of `instance` to its buffer, or to NULL if it has none.
+*/
+LILV_API void
+lilv_port_buffers_connect(const LilvPortBuffers* buffers,
+                          LilvInstance*          instance);
+
+/**
+   Read the latency reported by several instances in their last run, in frames.
+
+   Each element of `buffers` holds the buffers an instance is connected to with
+   lilv_port_buffers_connect().  This writes the value of the latency output
+   port of each to `latencies`, or zero if its plugin reports no latency, so
+   hosts that schedule instances themselves can recompute latency
+   compensation after every cycle.  This function is realtime safe.
+*/
+LILV_API void
+lilv_port_buffers_get_latencies(const LilvPortBuffers* const* buffers,
+                                uint32_t                      n_buffers,
+                                float*                        latencies);
+
+/**
+   Interleave `n_channels` buffers of `n_frames` samples into `dst`.
+   This is written so compilers vectorise it, with mono and stereo cases.
+*/
+LILV_API void
+lilv_buffer_interleave(float*              dst,
+                       const float* const* src,
+                       uint32_t            n_channels,
+                       uint32_t            n_frames);
+
+/**
+   Deinterleave `n_frames` frames of `n_channels` samples into buffers.
+   This is the inverse of lilv_buffer_interleave().
+*/
+LILV_API void
+lilv_buffer_deinterleave(float* const* dst,
+                         const float*  src,
+                         uint32_t      n_channels,
+                         uint32_t      n_frames);
+
+/**
+   Replace every denormal sample in `buf` with zero of the same sign.
+
+   Denormal values are very slow to process on many CPUs, so flushing them
+   from inputs, like file data or device input, can prevent spikes in
+   processing time.  This does not branch on the value of each sample, so it
+   takes the same time for any input.
+*/
+LILV_API void
+lilv_buffer_flush_denormals(float* buf, uint32_t n_samples);
+
 /**
    @}
    @name Plugin UI
@@ -1762,6 +2964,20 @@ lilv_instance_get_handle(const LilvInstance* instance)
 LILV_API LilvUIs*
 lilv_plugin_get_uis(const LilvPlugin* plugin);
 
+/**
+   Get all UIs for `plugin` without copying them.
+
+   UIs are loaded the first time this or lilv_plugin_get_uis() is called, or
+   when the world is frozen, and cached until a bundle is loaded or unloaded.
+   The returned collection is only valid until the next call after such a
+   change.  Other queries, and lazy loading of plugin data, do
+   not invalidate it, and it is never rebuilt once the world is frozen.
+   @return A shared collection which must not be freed, or NULL if the plugin
+   has no UIs.
+*/
+LILV_API const LilvUIs*
+lilv_plugin_get_shared_uis(const LilvPlugin* plugin);
+
 /**
    Get the URI of a Plugin UI.
    @param ui The Plugin UI
@@ -1800,6 +3016,11 @@ typedef unsigned (*LilvUISupportedFunc)(const char* container_type_uri,
 
 /**
    Return true iff a Plugin UI is supported as a given widget type.
+
+   The result of `supported_func` for each UI type and container type is
+   memoized in the world, so it must always return the same value for the
+   same arguments.
+
    @param ui The Plugin UI
    @param supported_func User provided supported predicate.
    @param container_type The widget type to host the UI within.
@@ -1813,6 +3034,33 @@ lilv_ui_is_supported(const LilvUI*       ui,
                      const LilvNode*     container_type,
                      const LilvNode**    ui_type);
 
+/**
+   Choose the best supported UI for every plugin in `plugins`.
+
+   For each plugin, in collection order, this sets the corresponding element
+   of `uis` to the UI with the highest quality returned by `supported_func`,
+   or NULL if the plugin has no supported UI.  This is equivalent to calling
+   lilv_ui_is_supported() for every UI of every plugin, but uses the cached
+   UIs of each plugin and calls `supported_func` only once for each UI type.
+
+   @param world The world.
+   @param plugins The plugins to choose UIs for.
+   @param supported_func User provided supported predicate.
+   @param container_type The widget type to host the UIs within.
+   @param uis (Output) Array of lilv_plugins_size() UIs, which are shared
+   and valid as long as lilv_plugin_get_shared_uis().
+   @param ui_types (Output) If non-NULL, array of lilv_plugins_size() native
+   types of the chosen UIs, or NULL where no UI was found.
+   @return The number of plugins with a supported UI.
+*/
+LILV_API unsigned
+lilv_world_select_uis(LilvWorld*          world,
+                      const LilvPlugins*  plugins,
+                      LilvUISupportedFunc supported_func,
+                      const LilvNode*     container_type,
+                      const LilvUI**      uis,
+                      const LilvNode**    ui_types);
+
 /**
    Get the URI for a Plugin UI's bundle.
    @param ui The Plugin UI
@@ -1829,6 +3077,224 @@ lilv_ui_get_bundle_uri(const LilvUI* ui);
 LILV_API const LilvNode*
 lilv_ui_get_binary_uri(const LilvUI* ui);
 
+/**
+   @}
+   @name Plugin Search
+   @{
+*/
+
+/**
+   A combined query for lilv_search_index_find().
+
+   A plugin matches if it matches every facet which is set.  Initialize
+   queries with LILV_SEARCH_QUERY_INIT, which matches every plugin, then set
+   only the facets to filter by.
+*/
+typedef struct {
+	const LilvPluginClass* plugin_class;   ///< Class or ancestor, or NULL
+	const char*            author_name;    ///< Exact author name, or NULL
+	const char*            name_prefix;    ///< Case-insensitive name prefix, or NULL
+	const LilvNode* const* features;       ///< NULL terminated supported features, or NULL
+	int                    audio_inputs;   ///< Number of audio inputs, or -1
+	int                    audio_outputs;  ///< Number of audio outputs, or -1
+	int                    has_ui;         ///< 1 for plugins with a UI, 0 without, or -1
+} LilvSearchQuery;
+
+/**
+   Initializer for a LilvSearchQuery that matches every plugin.
+*/
+#define LILV_SEARCH_QUERY_INIT { NULL, NULL, NULL, NULL, -1, -1, -1 }
+
+/**
+   Create an index for searching the plugins in `world`.
+
+   The class, author, name, required features, number of audio ports, and
+   presence of a UI of every plugin are recorded once, which loads every
+   plugin.  When bundles are loaded or unloaded, the next search updates the
+   index by reading only the plugins that have changed.  The index must be
+   freed before `world`, and must not be used from several threads at once.
+*/
+LILV_API LilvSearchIndex*
+lilv_search_index_new(LilvWorld* world);
+
+/**
+   Free a plugin search index.
+*/
+LILV_API void
+lilv_search_index_free(LilvSearchIndex* index);
+
+/**
+   Find the plugins that match `query`.
+
+   If `features` is set, plugins that require any feature not in it do not
+   match, so an empty array matches only plugins without required features.
+   Plugin classes match their subclasses, see
+   lilv_plugin_class_is_subclass_of().
+
+   @param index The search index.
+   @param query The facets to match.
+   @param plugins Set to the first `max_plugins` matches, in index order.
+   @param max_plugins The number of elements in `plugins`, which may be 0.
+   @return The total number of matches, which may be more than `max_plugins`.
+*/
+LILV_API unsigned
+lilv_search_index_find(LilvSearchIndex*       index,
+                       const LilvSearchQuery* query,
+                       const LilvPlugin**     plugins,
+                       unsigned               max_plugins);
+
+/**
+   @}
+   @name Plugin Scanning
+   @{
+*/
+
+/**
+   A problem found in a plugin's data by lilv_world_scan_plugins().
+*/
+typedef enum {
+	LILV_SCAN_PARSE_ERROR = 1u << 0,  ///< Plugin data files have syntax errors
+	LILV_SCAN_NO_TYPE     = 1u << 1,  ///< Plugin has no rdf:type
+	LILV_SCAN_NO_NAME     = 1u << 2,  ///< Plugin has no doap:name
+	LILV_SCAN_NO_PORTS    = 1u << 3,  ///< Plugin has no lv2:port
+	LILV_SCAN_NO_BINARY   = 1u << 4   ///< Plugin has no lv2:binary
+} LilvScanError;
+
+/**
+   The overall result of scanning a plugin.
+*/
+typedef enum {
+	LILV_SCAN_OK,         ///< Plugin passed every check
+	LILV_SCAN_INVALID,    ///< Plugin data is invalid, see errors
+	LILV_SCAN_FAILED,     ///< Plugin failed to instantiate
+	LILV_SCAN_CRASHED,    ///< Plugin crashed while being instantiated
+	LILV_SCAN_TIMED_OUT   ///< Plugin took too long to instantiate
+} LilvScanStatus;
+
+/**
+   Options for lilv_world_scan_plugins().
+*/
+typedef struct {
+	unsigned                  n_threads;    ///< Number of threads or processes
+	bool                      instantiate;  ///< Test instantiation
+	double                    sample_rate;  ///< Sample rate to instantiate at
+	const LV2_Feature* const* features;     ///< Features to instantiate with
+	unsigned                  timeout_ms;   ///< Instantiation time limit, or 0
+} LilvScanOptions;
+
+/**
+   The result of scanning a single plugin.
+*/
+typedef struct {
+	const LilvPlugin* plugin;            ///< Scanned plugin
+	LilvScanStatus    status;            ///< Overall result
+	unsigned          errors;            ///< LilvScanError flags
+	int               signal;            ///< Signal that killed the plugin, or 0
+	uint64_t          verify_time;       ///< Data check time in nanoseconds
+	uint64_t          instantiate_time;  ///< Instantiation time in nanoseconds
+} LilvScanResult;
+
+/**
+   Check every plugin in `plugins`, and optionally test instantiating them.
+
+   The data of every plugin is checked like lilv_plugin_verify(), and also
+   for a binary.  If `world` is frozen (see lilv_world_freeze()), this is
+   done on `n_threads` threads, otherwise serially.
+
+   If `instantiate` is set, every valid plugin is then instantiated,
+   activated, deactivated, and freed.  Where fork() is available, this is done
+   in up to `n_threads` child processes at once, so a plugin that crashes or
+   hangs can not affect the caller.  A child that runs for longer than
+   `timeout_ms` is killed.  Otherwise, plugins are instantiated in this
+   process, and crashes or timeouts can not be detected.
+
+   @param world The world.
+   @param plugins The plugins to scan.
+   @param options Scan options, or NULL to only check plugin data serially.
+   @param results Set to the results, with one element per plugin in the
+   order of `plugins`.
+   @return The number of plugins that did not pass every check.
+*/
+LILV_API unsigned
+lilv_world_scan_plugins(LilvWorld*             world,
+                        const LilvPlugins*     plugins,
+                        const LilvScanOptions* options,
+                        LilvScanResult*        results);
+
+/**
+   @}
+   @name Plugin Catalogue
+   @{
+*/
+
+/**
+   Write a compact JSON catalogue of `plugins` to `stream`.
+
+   The catalogue is a single object with a "plugins" array, which has one
+   object per plugin in the order of `plugins`, with these members:
+
+   - "uri", "name", "class", and "bundle": Strings, or null if unknown.
+   - "required_features" and "optional_features": Arrays of feature URIs.
+   - "ports": Array of objects with "index", "symbol", "name", "types" as an
+     array of class URIs, and "default", "minimum", and "maximum" if the port
+     has them.
+   - "uis": Array of objects with "uri", and "types" as an array of UI class
+     URIs.
+   - "presets": Array of objects with "uri" and "label".
+
+   This reads everything a plugin browser typically needs at once, so other
+   processes can read the catalogue rather than loading the world.  If
+   `world` is frozen (see lilv_world_freeze()), plugins are queried on
+   `n_threads` threads, otherwise serially.  The output is the same either
+   way.
+
+   @return Zero on success, or non-zero if writing to `stream` failed.
+*/
+LILV_API int
+lilv_world_write_catalogue(LilvWorld*         world,
+                           const LilvPlugins* plugins,
+                           unsigned           n_threads,
+                           FILE*              stream);
+
+/**
+   @}
+   @name URID Map
+   @{
+*/
+
+/**
+   Create a new URID map.
+
+   This implements the LV2 URID map and unmap features with a hash table, so
+   hosts and utilities do not need to provide their own.  Mapping and
+   unmapping may be done from several threads at once.  Mapping a URI that
+   is already mapped, and unmapping, do not block if lilv is built with
+   thread support, only mapping a new URI takes a lock.  Strings returned by
+   unmap remain valid until the map is freed.
+*/
+LILV_API LilvURIDMap*
+lilv_urid_map_new(void);
+
+/**
+   Free a URID map and every string it has mapped.
+*/
+LILV_API void
+lilv_urid_map_free(LilvURIDMap* map);
+
+/**
+   Get the LV2_URID_Map feature data of `map`.
+   The returned pointer is valid for the lifetime of `map`.
+*/
+LILV_API LV2_URID_Map*
+lilv_urid_map_get_map(LilvURIDMap* map);
+
+/**
+   Get the LV2_URID_Unmap feature data of `map`.
+   The returned pointer is valid for the lifetime of `map`.
+*/
+LILV_API LV2_URID_Unmap*
+lilv_urid_map_get_unmap(LilvURIDMap* map);
+
 /**
    @}
    @}
@@ -0,0 +1,779 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file lilv.hpp C++17 API for Lilv.
+
+   Unlike lilvmm.hpp, this wrapper never copies or allocates behind the
+   caller's back.  Objects owned by the world are wrapped in trivially
+   copyable views, and values the caller must free are wrapped in move-only
+   owning types which free them on destruction.  Strings are returned as
+   std::string_view into the underlying node, and collections can be iterated
+   with range-based for without allocating, since a LilvIter is only a
+   pointer into the collection.
+*/
+
+#ifndef LILV_LILV_HPP
+#define LILV_LILV_HPP
+
+#include "lilv/lilv.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#    include <span>
+#    define LILV_HAVE_SPAN 1
+#endif
+
+namespace lilv {
+
+namespace detail {
+
+/** Move-only owner of a C object, freed with `Free`. */
+template<typename T, void (*Free)(T*)>
+class Owner {
+public:
+	Owner() noexcept : _ptr(nullptr) {}
+	explicit Owner(T* ptr) noexcept : _ptr(ptr) {}
+
+	Owner(const Owner&) = delete;
+	Owner& operator=(const Owner&) = delete;
+
+	Owner(Owner&& other) noexcept : _ptr(other.release()) {}
+
+	Owner& operator=(Owner&& other) noexcept {
+		reset(other.release());
+		return *this;
+	}
+
+	~Owner() { reset(); }
+
+	/** Free the owned object and take ownership of `ptr`. */
+	void reset(T* ptr = nullptr) noexcept {
+		if (_ptr) {
+			Free(_ptr);
+		}
+		_ptr = ptr;
+	}
+
+	/** Release ownership of the C object and return it. */
+	T* release() noexcept { return std::exchange(_ptr, nullptr); }
+
+	T* get() const noexcept { return _ptr; }
+
+	explicit operator bool() const noexcept { return _ptr; }
+
+private:
+	T* _ptr;
+};
+
+inline std::string_view
+to_view(const char* str) noexcept
+{
+	return str ? std::string_view(str) : std::string_view();
+}
+
+inline void
+free_instance(LilvInstance* instance)
+{
+	lilv_instance_free(instance);
+}
+
+/** End sentinel for collection ranges. */
+struct End {};
+
+/**
+   Iterator over a Lilv collection.
+
+   `Traits` provides the C functions for the collection, and `Element`, which
+   is constructed from each C element.
+*/
+template<typename Traits>
+class Iterator {
+public:
+	using Collection = typename Traits::Collection;
+	using Element    = typename Traits::Element;
+
+	Iterator(const Collection* coll, LilvIter* iter) noexcept
+		: _coll(coll), _iter(iter)
+	{}
+
+	Element operator*() const { return Element(Traits::get(_coll, _iter)); }
+
+	Iterator& operator++() noexcept {
+		_iter = Traits::next(_coll, _iter);
+		return *this;
+	}
+
+	bool operator==(End) const noexcept {
+		return !_coll || Traits::is_end(_coll, _iter);
+	}
+
+	bool operator!=(End end) const noexcept { return !(*this == end); }
+
+private:
+	const Collection* _coll;
+	LilvIter*         _iter;
+};
+
+/** Non-owning view of a Lilv collection which can be used with range-for. */
+template<typename Traits>
+class CollectionView {
+public:
+	using Collection = typename Traits::Collection;
+	using Element    = typename Traits::Element;
+
+	CollectionView(const Collection* coll) noexcept : _coll(coll) {}
+
+	Iterator<Traits> begin() const noexcept {
+		return Iterator<Traits>(_coll, _coll ? Traits::begin(_coll) : nullptr);
+	}
+
+	End end() const noexcept { return End(); }
+
+	unsigned size() const noexcept { return _coll ? Traits::size(_coll) : 0; }
+	bool     empty() const noexcept { return size() == 0; }
+
+	const Collection* c_obj() const noexcept { return _coll; }
+	operator const Collection*() const noexcept { return _coll; }
+
+protected:
+	const Collection* _coll;
+};
+
+/** Owning collection, freed with `Free` on destruction. */
+template<typename Traits, void (*Free)(typename Traits::Collection*)>
+class OwningCollection : public CollectionView<Traits> {
+public:
+	using Collection = typename Traits::Collection;
+
+	explicit OwningCollection(Collection* coll) noexcept
+		: CollectionView<Traits>(coll)
+	{}
+
+	OwningCollection(const OwningCollection&) = delete;
+	OwningCollection& operator=(const OwningCollection&) = delete;
+
+	OwningCollection(OwningCollection&& other) noexcept
+		: CollectionView<Traits>(std::exchange(other._coll, nullptr))
+	{}
+
+	OwningCollection& operator=(OwningCollection&& other) noexcept {
+		std::swap(this->_coll, other._coll);
+		return *this;
+	}
+
+	~OwningCollection() {
+		if (this->_coll) {
+			Free(const_cast<Collection*>(this->_coll));
+		}
+	}
+};
+
+} // namespace detail
+
+#define LILV_COLLECTION_TRAITS(CT, ET, prefix) \
+	namespace detail { \
+	struct CT ## Traits { \
+		using Collection = Lilv ## CT; \
+		using Element    = ET; \
+		static LilvIter* begin(const Collection* c) { \
+			return lilv_ ## prefix ## _begin(c); \
+		} \
+		static LilvIter* next(const Collection* c, LilvIter* i) { \
+			return lilv_ ## prefix ## _next(c, i); \
+		} \
+		static bool is_end(const Collection* c, LilvIter* i) { \
+			return lilv_ ## prefix ## _is_end(c, i); \
+		} \
+		static auto get(const Collection* c, LilvIter* i) { \
+			return lilv_ ## prefix ## _get(c, i); \
+		} \
+		static unsigned size(const Collection* c) { \
+			return lilv_ ## prefix ## _size(c); \
+		} \
+	}; \
+	}
+
+/** Non-owning view of a node. */
+class NodeView {
+public:
+	NodeView(const LilvNode* node = nullptr) noexcept : _node(node) {}
+
+	bool is_uri() const { return lilv_node_is_uri(_node); }
+	bool is_blank() const { return lilv_node_is_blank(_node); }
+	bool is_literal() const { return lilv_node_is_literal(_node); }
+	bool is_string() const { return lilv_node_is_string(_node); }
+	bool is_float() const { return lilv_node_is_float(_node); }
+	bool is_int() const { return lilv_node_is_int(_node); }
+	bool is_bool() const { return lilv_node_is_bool(_node); }
+
+	std::string_view as_uri() const {
+		return detail::to_view(lilv_node_as_uri(_node));
+	}
+
+	std::string_view as_blank() const {
+		return detail::to_view(lilv_node_as_blank(_node));
+	}
+
+	std::string_view as_string() const {
+		return detail::to_view(lilv_node_as_string(_node));
+	}
+
+	float as_float() const { return lilv_node_as_float(_node); }
+	int   as_int() const { return lilv_node_as_int(_node); }
+	bool  as_bool() const { return lilv_node_as_bool(_node); }
+
+	bool operator==(NodeView other) const {
+		return lilv_node_equals(_node, other._node);
+	}
+
+	bool operator!=(NodeView other) const { return !(*this == other); }
+
+	explicit operator bool() const noexcept { return _node; }
+
+	const LilvNode* c_obj() const noexcept { return _node; }
+	operator const LilvNode*() const noexcept { return _node; }
+
+private:
+	const LilvNode* _node;
+};
+
+/** Owned node, freed on destruction. */
+class Node : public NodeView {
+public:
+	/** Take ownership of `node`, which may be NULL. */
+	explicit Node(LilvNode* node = nullptr) noexcept
+		: NodeView(node), _owner(node)
+	{}
+
+	Node(Node&& other) noexcept
+		: NodeView(other), _owner(std::move(other._owner))
+	{
+		static_cast<NodeView&>(other) = NodeView();
+	}
+
+	Node& operator=(Node&& other) noexcept {
+		static_cast<NodeView&>(*this) = other;
+		static_cast<NodeView&>(other) = NodeView();
+		_owner = std::move(other._owner);
+		return *this;
+	}
+
+	/** Return an owned copy of `node`. */
+	static Node duplicate(NodeView node) {
+		return Node(lilv_node_duplicate(node));
+	}
+
+	/** Release ownership of the node and return it. */
+	LilvNode* release() noexcept {
+		static_cast<NodeView&>(*this) = NodeView();
+		return _owner.release();
+	}
+
+private:
+	detail::Owner<LilvNode, lilv_node_free> _owner;
+};
+
+LILV_COLLECTION_TRAITS(Nodes, NodeView, nodes)
+
+/** Non-owning view of a set of nodes. */
+class NodesView : public detail::CollectionView<detail::NodesTraits> {
+public:
+	using CollectionView::CollectionView;
+
+	bool contains(NodeView node) const {
+		return _coll && lilv_nodes_contains(_coll, node);
+	}
+
+	NodeView get_first() const {
+		return _coll ? lilv_nodes_get_first(_coll) : nullptr;
+	}
+};
+
+/** Owned set of nodes, freed on destruction. */
+class Nodes
+	: public detail::OwningCollection<detail::NodesTraits, lilv_nodes_free> {
+public:
+	using OwningCollection::OwningCollection;
+
+	bool contains(NodeView node) const { return view().contains(node); }
+	NodeView get_first() const { return view().get_first(); }
+
+	NodesView view() const noexcept { return NodesView(_coll); }
+};
+
+class ScalePoint {
+public:
+	ScalePoint(const LilvScalePoint* point) noexcept : _point(point) {}
+
+	NodeView label() const { return lilv_scale_point_get_label(_point); }
+	NodeView value() const { return lilv_scale_point_get_value(_point); }
+
+	const LilvScalePoint* c_obj() const noexcept { return _point; }
+
+private:
+	const LilvScalePoint* _point;
+};
+
+LILV_COLLECTION_TRAITS(ScalePoints, ScalePoint, scale_points)
+
+using ScalePoints = detail::OwningCollection<detail::ScalePointsTraits,
+                                             lilv_scale_points_free>;
+
+class PluginClass;
+
+LILV_COLLECTION_TRAITS(PluginClasses, PluginClass, plugin_classes)
+
+using PluginClassesView = detail::CollectionView<detail::PluginClassesTraits>;
+using PluginClasses     = detail::OwningCollection<detail::PluginClassesTraits,
+                                                  lilv_plugin_classes_free>;
+
+class PluginClass {
+public:
+	PluginClass(const LilvPluginClass* plugin_class) noexcept
+		: _class(plugin_class)
+	{}
+
+	NodeView uri() const { return lilv_plugin_class_get_uri(_class); }
+	NodeView label() const { return lilv_plugin_class_get_label(_class); }
+
+	NodeView parent_uri() const {
+		return lilv_plugin_class_get_parent_uri(_class);
+	}
+
+	unsigned depth() const { return lilv_plugin_class_get_depth(_class); }
+
+	bool is_subclass_of(PluginClass ancestor) const {
+		return lilv_plugin_class_is_subclass_of(_class, ancestor._class);
+	}
+
+	inline PluginClasses children() const;
+
+	explicit operator bool() const noexcept { return _class; }
+
+	const LilvPluginClass* c_obj() const noexcept { return _class; }
+	operator const LilvPluginClass*() const noexcept { return _class; }
+
+private:
+	const LilvPluginClass* _class;
+};
+
+inline PluginClasses
+PluginClass::children() const
+{
+	return PluginClasses(lilv_plugin_class_get_children(_class));
+}
+
+class UI {
+public:
+	UI(const LilvUI* ui) noexcept : _ui(ui) {}
+
+	NodeView  uri() const { return lilv_ui_get_uri(_ui); }
+	NodeView  bundle_uri() const { return lilv_ui_get_bundle_uri(_ui); }
+	NodeView  binary_uri() const { return lilv_ui_get_binary_uri(_ui); }
+	NodesView classes() const { return lilv_ui_get_classes(_ui); }
+
+	bool is_a(NodeView class_uri) const { return lilv_ui_is_a(_ui, class_uri); }
+
+	const LilvUI* c_obj() const noexcept { return _ui; }
+	operator const LilvUI*() const noexcept { return _ui; }
+
+private:
+	const LilvUI* _ui;
+};
+
+LILV_COLLECTION_TRAITS(UIs, UI, uis)
+
+using UIs = detail::OwningCollection<detail::UIsTraits, lilv_uis_free>;
+
+/** Range of port values, as returned by Port::range(). */
+struct PortRange {
+	Node def;  ///< Default value, or null
+	Node min;  ///< Minimum value, or null
+	Node max;  ///< Maximum value, or null
+};
+
+class Port {
+public:
+	Port(const LilvPlugin* plugin, const LilvPort* port) noexcept
+		: _plugin(plugin), _port(port)
+	{}
+
+	uint32_t index() const { return lilv_port_get_index(_plugin, _port); }
+
+	NodeView symbol() const { return lilv_port_get_symbol(_plugin, _port); }
+	Node     name() const { return Node(lilv_port_get_name(_plugin, _port)); }
+
+	NodesView classes() const {
+		return lilv_port_get_classes(_plugin, _port);
+	}
+
+	bool is_a(NodeView port_class) const {
+		return lilv_port_is_a(_plugin, _port, port_class);
+	}
+
+	bool has_property(NodeView property) const {
+		return lilv_port_has_property(_plugin, _port, property);
+	}
+
+	Node get(NodeView predicate) const {
+		return Node(lilv_port_get(_plugin, _port, predicate));
+	}
+
+	Nodes value(NodeView predicate) const {
+		return Nodes(lilv_port_get_value(_plugin, _port, predicate));
+	}
+
+	Nodes properties() const {
+		return Nodes(lilv_port_get_properties(_plugin, _port));
+	}
+
+	PortRange range() const {
+		LilvNode* def = nullptr;
+		LilvNode* min = nullptr;
+		LilvNode* max = nullptr;
+		lilv_port_get_range(_plugin, _port, &def, &min, &max);
+		return PortRange{ Node(def), Node(min), Node(max) };
+	}
+
+	ScalePoints scale_points() const {
+		return ScalePoints(lilv_port_get_scale_points(_plugin, _port));
+	}
+
+	explicit operator bool() const noexcept { return _port; }
+
+	const LilvPort* c_obj() const noexcept { return _port; }
+	operator const LilvPort*() const noexcept { return _port; }
+
+private:
+	const LilvPlugin* _plugin;
+	const LilvPort*   _port;
+};
+
+/** Range of all ports of a plugin, in index order. */
+class Ports {
+public:
+	class Iterator {
+	public:
+		Iterator(const LilvPlugin* plugin, uint32_t index) noexcept
+			: _plugin(plugin), _index(index)
+		{}
+
+		Port operator*() const {
+			return Port(_plugin,
+			            lilv_plugin_get_port_by_index(_plugin, _index));
+		}
+
+		Iterator& operator++() noexcept {
+			++_index;
+			return *this;
+		}
+
+		bool operator==(const Iterator& other) const noexcept {
+			return _index == other._index;
+		}
+
+		bool operator!=(const Iterator& other) const noexcept {
+			return _index != other._index;
+		}
+
+	private:
+		const LilvPlugin* _plugin;
+		uint32_t          _index;
+	};
+
+	explicit Ports(const LilvPlugin* plugin) noexcept
+		: _plugin(plugin), _size(lilv_plugin_get_num_ports(plugin))
+	{}
+
+	Iterator begin() const noexcept { return Iterator(_plugin, 0); }
+	Iterator end() const noexcept { return Iterator(_plugin, _size); }
+	uint32_t size() const noexcept { return _size; }
+
+	Port operator[](uint32_t index) const {
+		return Port(_plugin, lilv_plugin_get_port_by_index(_plugin, index));
+	}
+
+private:
+	const LilvPlugin* _plugin;
+	uint32_t          _size;
+};
+
+class Instance;
+
+class Plugin {
+public:
+	Plugin(const LilvPlugin* plugin) noexcept : _plugin(plugin) {}
+
+	bool verify() const { return lilv_plugin_verify(_plugin); }
+
+	NodeView    uri() const { return lilv_plugin_get_uri(_plugin); }
+	NodeView    bundle_uri() const {
+		return lilv_plugin_get_bundle_uri(_plugin);
+	}
+	NodesView   data_uris() const { return lilv_plugin_get_data_uris(_plugin); }
+	NodeView    library_uri() const {
+		return lilv_plugin_get_library_uri(_plugin);
+	}
+	Node        name() const { return Node(lilv_plugin_get_name(_plugin)); }
+	PluginClass plugin_class() const { return lilv_plugin_get_class(_plugin); }
+
+	Nodes value(NodeView predicate) const {
+		return Nodes(lilv_plugin_get_value(_plugin, predicate));
+	}
+
+	bool has_feature(NodeView feature) const {
+		return lilv_plugin_has_feature(_plugin, feature);
+	}
+
+	Nodes supported_features() const {
+		return Nodes(lilv_plugin_get_supported_features(_plugin));
+	}
+
+	Nodes required_features() const {
+		return Nodes(lilv_plugin_get_required_features(_plugin));
+	}
+
+	Nodes optional_features() const {
+		return Nodes(lilv_plugin_get_optional_features(_plugin));
+	}
+
+	Nodes extension_data() const {
+		return Nodes(lilv_plugin_get_extension_data(_plugin));
+	}
+
+	Node author_name() const {
+		return Node(lilv_plugin_get_author_name(_plugin));
+	}
+
+	Node author_email() const {
+		return Node(lilv_plugin_get_author_email(_plugin));
+	}
+
+	Node author_homepage() const {
+		return Node(lilv_plugin_get_author_homepage(_plugin));
+	}
+
+	bool is_replaced() const { return lilv_plugin_is_replaced(_plugin); }
+	bool has_latency() const { return lilv_plugin_has_latency(_plugin); }
+
+	uint32_t latency_port_index() const {
+		return lilv_plugin_get_latency_port_index(_plugin);
+	}
+
+	uint32_t num_ports() const { return lilv_plugin_get_num_ports(_plugin); }
+	Ports    ports() const { return Ports(_plugin); }
+
+	Port port_by_index(uint32_t index) const {
+		return Port(_plugin, lilv_plugin_get_port_by_index(_plugin, index));
+	}
+
+	Port port_by_symbol(NodeView symbol) const {
+		return Port(_plugin, lilv_plugin_get_port_by_symbol(_plugin, symbol));
+	}
+
+	Port port_by_designation(NodeView port_class, NodeView designation) const {
+		return Port(_plugin,
+		            lilv_plugin_get_port_by_designation(
+			            _plugin, port_class, designation));
+	}
+
+	UIs uis() const { return UIs(lilv_plugin_get_uis(_plugin)); }
+
+	Nodes related(NodeView type) const {
+		return Nodes(lilv_plugin_get_related(_plugin, type));
+	}
+
+	int preload(const LV2_Feature* const* features = nullptr) const {
+		return lilv_plugin_preload(_plugin, features);
+	}
+
+	inline Instance instantiate(double                    sample_rate,
+	                            const LV2_Feature* const* features = nullptr)
+		const;
+
+	explicit operator bool() const noexcept { return _plugin; }
+
+	const LilvPlugin* c_obj() const noexcept { return _plugin; }
+	operator const LilvPlugin*() const noexcept { return _plugin; }
+
+private:
+	const LilvPlugin* _plugin;
+};
+
+LILV_COLLECTION_TRAITS(Plugins, Plugin, plugins)
+
+/** Non-owning view of a set of plugins. */
+class Plugins : public detail::CollectionView<detail::PluginsTraits> {
+public:
+	using CollectionView::CollectionView;
+
+	Plugin get_by_uri(NodeView uri) const {
+		return _coll ? lilv_plugins_get_by_uri(_coll, uri) : nullptr;
+	}
+};
+
+/** Plugin instance, freed on destruction. */
+class Instance {
+public:
+	/** Take ownership of `instance`, which may be NULL. */
+	explicit Instance(LilvInstance* instance = nullptr) noexcept
+		: _owner(instance)
+	{}
+
+	/** Instantiate `plugin`, check the result with operator bool. */
+	static Instance create(Plugin                    plugin,
+	                       double                    sample_rate,
+	                       const LV2_Feature* const* features = nullptr) {
+		return Instance(lilv_plugin_instantiate(plugin, sample_rate, features));
+	}
+
+	void connect_port(uint32_t port_index, void* data_location) {
+		lilv_instance_connect_port(_owner.get(), port_index, data_location);
+	}
+
+#ifdef LILV_HAVE_SPAN
+	/** Connect a port to a sample buffer. */
+	void connect_port(uint32_t port_index, std::span<float> buffer) {
+		lilv_instance_connect_port(_owner.get(), port_index, buffer.data());
+	}
+#endif
+
+	void activate() { lilv_instance_activate(_owner.get()); }
+	void run(uint32_t sample_count) {
+		lilv_instance_run(_owner.get(), sample_count);
+	}
+	void deactivate() { lilv_instance_deactivate(_owner.get()); }
+
+	const void* extension_data(const char* uri) const {
+		return lilv_instance_get_extension_data(_owner.get(), uri);
+	}
+
+	const LV2_Descriptor* descriptor() const {
+		return lilv_instance_get_descriptor(_owner.get());
+	}
+
+	LV2_Handle handle() const { return lilv_instance_get_handle(_owner.get()); }
+
+	bool is_isolated() const { return lilv_instance_is_isolated(_owner.get()); }
+	bool has_crashed() const { return lilv_instance_has_crashed(_owner.get()); }
+
+	/** Release ownership of the instance and return it. */
+	LilvInstance* release() noexcept { return _owner.release(); }
+
+	explicit operator bool() const noexcept { return bool(_owner); }
+
+	LilvInstance* c_obj() const noexcept { return _owner.get(); }
+
+private:
+	detail::Owner<LilvInstance, detail::free_instance> _owner;
+};
+
+inline Instance
+Plugin::instantiate(double                    sample_rate,
+                    const LV2_Feature* const* features) const
+{
+	return Instance::create(*this, sample_rate, features);
+}
+
+/** World, freed on destruction. */
+class World {
+public:
+	World() : _owner(lilv_world_new()) {}
+
+	Node new_uri(const char* uri) { return Node(lilv_new_uri(c_obj(), uri)); }
+
+	Node new_file_uri(const char* host, const char* path) {
+		return Node(lilv_new_file_uri(c_obj(), host, path));
+	}
+
+	Node new_string(const char* str) {
+		return Node(lilv_new_string(c_obj(), str));
+	}
+
+	Node new_int(int val) { return Node(lilv_new_int(c_obj(), val)); }
+	Node new_float(float val) { return Node(lilv_new_float(c_obj(), val)); }
+	Node new_bool(bool val) { return Node(lilv_new_bool(c_obj(), val)); }
+
+	void set_option(const char* uri, NodeView value) {
+		lilv_world_set_option(c_obj(), uri, value);
+	}
+
+	void load_all() { lilv_world_load_all(c_obj()); }
+	void freeze() { lilv_world_freeze(c_obj()); }
+
+	void load_bundle(NodeView bundle_uri) {
+		lilv_world_load_bundle(c_obj(), bundle_uri);
+	}
+
+	int unload_bundle(NodeView bundle_uri) {
+		return lilv_world_unload_bundle(c_obj(), bundle_uri);
+	}
+
+	int load_resource(NodeView resource) {
+		return lilv_world_load_resource(c_obj(), resource);
+	}
+
+	int unload_resource(NodeView resource) {
+		return lilv_world_unload_resource(c_obj(), resource);
+	}
+
+	void load_specifications() { lilv_world_load_specifications(c_obj()); }
+	void load_plugin_classes() { lilv_world_load_plugin_classes(c_obj()); }
+
+	PluginClass plugin_class() const {
+		return lilv_world_get_plugin_class(c_obj());
+	}
+
+	PluginClassesView plugin_classes() const {
+		return lilv_world_get_plugin_classes(c_obj());
+	}
+
+	Plugins all_plugins() const { return lilv_world_get_all_plugins(c_obj()); }
+
+	Nodes find_nodes(NodeView subject, NodeView predicate, NodeView object) {
+		return Nodes(
+			lilv_world_find_nodes(c_obj(), subject, predicate, object));
+	}
+
+	Node get(NodeView subject, NodeView predicate, NodeView object) {
+		return Node(lilv_world_get(c_obj(), subject, predicate, object));
+	}
+
+	bool ask(NodeView subject, NodeView predicate, NodeView object) {
+		return lilv_world_ask(c_obj(), subject, predicate, object);
+	}
+
+	Node symbol(NodeView subject) {
+		return Node(lilv_world_get_symbol(c_obj(), subject));
+	}
+
+	LilvWorld* c_obj() const noexcept { return _owner.get(); }
+	operator LilvWorld*() const noexcept { return _owner.get(); }
+
+private:
+	detail::Owner<LilvWorld, lilv_world_free> _owner;
+};
+
+#undef LILV_COLLECTION_TRAITS
+
+} // namespace lilv
+
+#endif // LILV_LILV_HPP
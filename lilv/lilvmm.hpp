@@ -114,6 +114,9 @@ struct PluginClass {
 	LILV_WRAP0(Node, plugin_class, get_uri);
 	LILV_WRAP0(Node, plugin_class, get_label);
 	LILV_WRAP0(LilvPluginClasses*, plugin_class, get_children);
+	LILV_WRAP1(bool, plugin_class, is_subclass_of,
+	           const LilvPluginClass*, ancestor);
+	LILV_WRAP0(unsigned, plugin_class, get_depth);
 
 	const LilvPluginClass* me;
 };
@@ -220,6 +223,15 @@ struct Plugin {
 	LILV_WRAP0(Nodes,       plugin, get_extension_data);
 	LILV_WRAP0(UIs,         plugin, get_uis);
 	LILV_WRAP1(Nodes,       plugin, get_related, Node, type);
+	LILV_WRAP1(int,         plugin, preload, const LV2_Feature* const*, features);
+
+	inline const LilvPortTable* get_port_table() {
+		return lilv_plugin_get_port_table(me);
+	}
+
+	inline void get_port_metadata(const LilvPortMetadata* metadata) {
+		return lilv_plugin_get_port_metadata(me, metadata);
+	}
 
 	inline Port get_port_by_index(unsigned index) {
 		return Port(me, lilv_plugin_get_port_by_index(me, index));
@@ -303,6 +315,16 @@ struct Instance {
 	LilvInstance* me;
 };
 
+struct URIDMap {
+	inline URIDMap() : me(lilv_urid_map_new()) {}
+	inline ~URIDMap() { lilv_urid_map_free(me); }
+
+	LILV_WRAP0(LV2_URID_Map*,   urid_map, get_map);
+	LILV_WRAP0(LV2_URID_Unmap*, urid_map, get_unmap);
+
+	LilvURIDMap* me;
+};
+
 struct World {
 	inline World() : me(lilv_world_new()) {}
 	inline ~World() { lilv_world_free(me); }
@@ -330,6 +352,8 @@ struct World {
 
 	LILV_WRAP2_VOID(world, set_option, const char*, uri, LilvNode*, value);
 	LILV_WRAP0_VOID(world, load_all);
+	LILV_WRAP0_VOID(world, freeze);
+	LILV_WRAP1_VOID(world, preload_libraries, const LV2_Feature* const*, features);
 	LILV_WRAP1_VOID(world, load_bundle, LilvNode*, bundle_uri);
 	LILV_WRAP0(const LilvPluginClass*, world, get_plugin_class);
 	LILV_WRAP0(const LilvPluginClasses*, world, get_plugin_classes);
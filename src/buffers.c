@@ -0,0 +1,210 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lilv_internal.h"
+
+/*
+  Buffers are laid out in one allocation, which is over-allocated by one
+  alignment so the first buffer can be aligned without posix_memalign().  The
+  kernels are plain loops over contiguous arrays, which compilers vectorise,
+  so they need no instruction set specific code.
+*/
+
+#define ALIGN_SIZE(size) \
+	(((size) + LILV_PORT_BUFFER_ALIGNMENT - 1) & \
+	 ~(size_t)(LILV_PORT_BUFFER_ALIGNMENT - 1))
+
+struct LilvPortBuffersImpl {
+	void*    arena;    ///< Allocation holding every buffer
+	void**   buffers;  ///< Buffer of each port, or NULL
+	uint32_t n_ports;
+	float*   latency;  ///< Buffer of reported latency port, or NULL
+};
+
+/** Return the size of the buffer for a port with `types`, or zero. */
+static size_t
+port_buffer_size(uint32_t types, uint32_t block_length, uint32_t atom_capacity)
+{
+	if (types & (LILV_PORT_AUDIO|LILV_PORT_CV)) {
+		return ALIGN_SIZE((size_t)block_length * sizeof(float));
+	} else if (types & LILV_PORT_CONTROL) {
+		return ALIGN_SIZE(sizeof(float));
+	} else if (types & (LILV_PORT_ATOM|LILV_PORT_EVENT)) {
+		return ALIGN_SIZE((size_t)atom_capacity);
+	}
+	return 0;
+}
+
+LILV_API LilvPortBuffers*
+lilv_port_buffers_new(const LilvPlugin* plugin,
+                      uint32_t          block_length,
+                      uint32_t          atom_capacity)
+{
+	const LilvPortTable* table = lilv_plugin_get_port_table(plugin);
+	if (!table) {
+		return NULL;
+	}
+
+	size_t total = 0;
+	for (uint32_t i = 0; i < table->n_ports; ++i) {
+		total += port_buffer_size(table->types[i], block_length, atom_capacity);
+	}
+
+	LilvPortBuffers* buffers = (LilvPortBuffers*)malloc(sizeof(LilvPortBuffers));
+	buffers->arena   = calloc(1, total + LILV_PORT_BUFFER_ALIGNMENT);
+	buffers->buffers = (void**)calloc(table->n_ports + 1, sizeof(void*));
+	buffers->n_ports = table->n_ports;
+	buffers->latency = NULL;
+
+	uint8_t* const base   = (uint8_t*)buffers->arena;
+	size_t         offset = ALIGN_SIZE((uintptr_t)base) - (uintptr_t)base;
+	for (uint32_t i = 0; i < table->n_ports; ++i) {
+		const uint32_t types = table->types[i];
+		const size_t   size  = port_buffer_size(
+			types, block_length, atom_capacity);
+		if (!size) {
+			continue;
+		}
+
+		buffers->buffers[i] = base + offset;
+		offset += size;
+
+		if ((types & LILV_PORT_CONTROL) &&
+		    !(types & (LILV_PORT_AUDIO|LILV_PORT_CV))) {
+			const float def = table->def_values[i];
+			const float min = table->min_values[i];
+			*(float*)buffers->buffers[i] = (!isnan(def) ? def
+			                                : !isnan(min) ? min
+			                                : 0.0f);
+		}
+	}
+
+	const uint32_t latency_port = lilv_plugin_get_latency_port_index(plugin);
+	if (latency_port < table->n_ports &&
+	    (table->types[latency_port] & LILV_PORT_OUTPUT) &&
+	    (table->types[latency_port] & LILV_PORT_CONTROL)) {
+		buffers->latency = (float*)buffers->buffers[latency_port];
+	}
+
+	return buffers;
+}
+
+LILV_API void
+lilv_port_buffers_free(LilvPortBuffers* buffers)
+{
+	if (buffers) {
+		free(buffers->buffers);
+		free(buffers->arena);
+		free(buffers);
+	}
+}
+
+LILV_API void*
+lilv_port_buffers_get(const LilvPortBuffers* buffers, uint32_t port_index)
+{
+	return port_index < buffers->n_ports ? buffers->buffers[port_index] : NULL;
+}
+
+LILV_API void
+lilv_port_buffers_connect(const LilvPortBuffers* buffers,
+                          LilvInstance*          instance)
+{
+	const LV2_Descriptor* const descriptor = instance->lv2_descriptor;
+	for (uint32_t i = 0; i < buffers->n_ports; ++i) {
+		descriptor->connect_port(
+			instance->lv2_handle, i, buffers->buffers[i]);
+	}
+}
+
+LILV_API void
+lilv_port_buffers_get_latencies(const LilvPortBuffers* const* buffers,
+                                uint32_t                      n_buffers,
+                                float*                        latencies)
+{
+	for (uint32_t i = 0; i < n_buffers; ++i) {
+		const float* const latency = buffers[i]->latency;
+		latencies[i] = latency ? *latency : 0.0f;
+	}
+}
+
+LILV_API void
+lilv_buffer_interleave(float*              dst,
+                       const float* const* src,
+                       uint32_t            n_channels,
+                       uint32_t            n_frames)
+{
+	if (n_channels == 1) {
+		memcpy(dst, src[0], n_frames * sizeof(float));
+	} else if (n_channels == 2) {
+		const float* const l = src[0];
+		const float* const r = src[1];
+		for (uint32_t f = 0; f < n_frames; ++f) {
+			dst[2 * f]     = l[f];
+			dst[2 * f + 1] = r[f];
+		}
+	} else {
+		for (uint32_t c = 0; c < n_channels; ++c) {
+			const float* const s = src[c];
+			for (uint32_t f = 0; f < n_frames; ++f) {
+				dst[f * n_channels + c] = s[f];
+			}
+		}
+	}
+}
+
+LILV_API void
+lilv_buffer_deinterleave(float* const* dst,
+                         const float*  src,
+                         uint32_t      n_channels,
+                         uint32_t      n_frames)
+{
+	if (n_channels == 1) {
+		memcpy(dst[0], src, n_frames * sizeof(float));
+	} else if (n_channels == 2) {
+		float* const l = dst[0];
+		float* const r = dst[1];
+		for (uint32_t f = 0; f < n_frames; ++f) {
+			l[f] = src[2 * f];
+			r[f] = src[2 * f + 1];
+		}
+	} else {
+		for (uint32_t c = 0; c < n_channels; ++c) {
+			float* const d = dst[c];
+			for (uint32_t f = 0; f < n_frames; ++f) {
+				d[f] = src[f * n_channels + c];
+			}
+		}
+	}
+}
+
+LILV_API void
+lilv_buffer_flush_denormals(float* buf, uint32_t n_samples)
+{
+	for (uint32_t i = 0; i < n_samples; ++i) {
+		uint32_t bits;
+		memcpy(&bits, &buf[i], sizeof(bits));
+
+		// Keep only the sign of values with a zero exponent
+		const uint32_t normal = -(uint32_t)((bits & 0x7F800000u) != 0);
+		bits &= normal | 0x80000000u;
+
+		memcpy(&buf[i], &bits, sizeof(bits));
+	}
+}
@@ -0,0 +1,515 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "lilv_internal.h"
+
+/*
+  The cache file is a header followed by a sequence of entries, one for each
+  cached data file.  All integers are in native byte order, the header records
+  the order so a cache from another machine is simply ignored.
+
+  Header:  "LILVCACH", uint32 version, uint32 byte order mark, uint32 n_entries
+  Entry:   uint32 path_len, path + '\0', uint32 key_len, key + '\0',
+           int64 mtime, int64 size, uint32 n_statements, uint32 data_size, data
+  Data:    n_statements * 5 nodes (subject, predicate, object, datatype, lang)
+  Node:    uint32 type, uint32 flags, uint32 n_bytes, uint32 n_chars,
+           bytes + '\0'
+
+  The key is empty for data files.  Data generated by a library, such as a
+  dynamic manifest, is stored under the path of the library and a key that
+  says what was generated, so it is regenerated when the library changes.
+
+  Blank node IDs are stored without the blank node prefix of the run that
+  parsed them, and given a fresh prefix when loaded.
+*/
+
+#define LILV_CACHE_MAGIC   "LILVCACH"
+#define LILV_CACHE_VERSION 2U
+#define LILV_CACHE_BOM     0x01020304U
+
+struct LilvCacheEntryImpl {
+	char*          path;          ///< Path of data file
+	char*          key;           ///< Key of generated data, or ""
+	int64_t        mtime;         ///< Modification time of data file
+	int64_t        size;          ///< Size of data file
+	uint32_t       n_statements;  ///< Number of cached statements
+	uint32_t       data_size;     ///< Size of encoded statements
+	const uint8_t* data;          ///< Encoded statements
+	uint8_t*       owned;         ///< Data if allocated (not in file), or NULL
+};
+
+struct LilvCacheImpl {
+	char*    path;       ///< Path of cache file
+	uint8_t* file;       ///< Contents of cache file
+	size_t   file_size;  ///< Size of cache file
+	bool     mapped;     ///< True iff file is mapped, otherwise allocated
+	ZixTree* entries;    ///< Entries sorted by path
+	bool     dirty;      ///< True iff entries differ from cache file
+};
+
+static int
+lilv_cache_entry_cmp(const void* a, const void* b, void* user_data)
+{
+	const LilvCacheEntry* const entry_a = (const LilvCacheEntry*)a;
+	const LilvCacheEntry* const entry_b = (const LilvCacheEntry*)b;
+	const int                   cmp     = strcmp(entry_a->path, entry_b->path);
+	return cmp ? cmp : strcmp(entry_a->key, entry_b->key);
+}
+
+static void
+lilv_cache_entry_free(void* ptr)
+{
+	LilvCacheEntry* entry = (LilvCacheEntry*)ptr;
+	free(entry->owned);
+	free(entry->key);
+	free(entry->path);
+	free(entry);
+}
+
+static bool
+lilv_cache_stat(const char* path, int64_t* mtime, int64_t* size)
+{
+	struct stat st;
+	if (stat(path, &st)) {
+		return false;
+	}
+	*mtime = (int64_t)st.st_mtime;
+	*size  = (int64_t)st.st_size;
+	return true;
+}
+
+static void
+buffer_append_node(LilvBuffer*     buffer,
+                   const SerdNode* node,
+                   const char*     blank_prefix)
+{
+	const uint8_t* buf     = node->buf ? node->buf : (const uint8_t*)"";
+	size_t         n_bytes = node->buf ? node->n_bytes : 0;
+	size_t         n_chars = node->buf ? node->n_chars : 0;
+	if (node->type == SERD_BLANK) {
+		const size_t prefix_len = strlen(blank_prefix);
+		if (n_bytes >= prefix_len &&
+		    !strncmp((const char*)buf, blank_prefix, prefix_len)) {
+			buf     += prefix_len;
+			n_bytes -= prefix_len;
+			n_chars -= prefix_len;
+		}
+	}
+
+	lilv_buffer_append_u32(buffer, node->buf ? (uint32_t)node->type : SERD_NOTHING);
+	lilv_buffer_append_u32(buffer, node->flags);
+	lilv_buffer_append_u32(buffer, (uint32_t)n_bytes);
+	lilv_buffer_append_u32(buffer, (uint32_t)n_chars);
+	lilv_buffer_append(buffer, buf, n_bytes);
+	lilv_buffer_append(buffer, "", 1);
+}
+
+/** Read a node which refers to the string in the cache data. */
+static bool
+read_node(const uint8_t** ptr, const uint8_t* end, SerdNode* node)
+{
+	uint32_t type, flags, n_bytes, n_chars;
+	if (!lilv_read_bytes(ptr, end, &type, sizeof(type)) ||
+	    !lilv_read_bytes(ptr, end, &flags, sizeof(flags)) ||
+	    !lilv_read_bytes(ptr, end, &n_bytes, sizeof(n_bytes)) ||
+	    !lilv_read_bytes(ptr, end, &n_chars, sizeof(n_chars)) ||
+	    (size_t)(end - *ptr) < (size_t)n_bytes + 1 ||
+	    (*ptr)[n_bytes] != '\0' ||
+	    type > SERD_BLANK) {
+		return false;
+	}
+
+	node->buf     = type == SERD_NOTHING ? NULL : *ptr;
+	node->n_bytes = n_bytes;
+	node->n_chars = n_chars;
+	node->flags   = flags;
+	node->type    = (SerdType)type;
+	*ptr += n_bytes + 1;
+	return true;
+}
+
+/** Read a string with a length prefix, return NULL if invalid. */
+static const char*
+read_string(const uint8_t** ptr, const uint8_t* end)
+{
+	uint32_t len;
+	if (!lilv_read_bytes(ptr, end, &len, sizeof(len)) ||
+	    (size_t)(end - *ptr) < (size_t)len + 1 ||
+	    (*ptr)[len] != '\0') {
+		return NULL;
+	}
+
+	const char* str = (const char*)*ptr;
+	*ptr += len + 1;
+	return str;
+}
+
+/** Read the entries from the cache file contents, return false if invalid. */
+static bool
+lilv_cache_read_entries(LilvCache* cache)
+{
+	const uint8_t* ptr = cache->file;
+	const uint8_t* end = cache->file + cache->file_size;
+
+	char     magic[8];
+	uint32_t version, bom, n_entries;
+	if (!lilv_read_bytes(&ptr, end, magic, sizeof(magic)) ||
+	    memcmp(magic, LILV_CACHE_MAGIC, sizeof(magic)) ||
+	    !lilv_read_bytes(&ptr, end, &version, sizeof(version)) ||
+	    version != LILV_CACHE_VERSION ||
+	    !lilv_read_bytes(&ptr, end, &bom, sizeof(bom)) ||
+	    bom != LILV_CACHE_BOM ||
+	    !lilv_read_bytes(&ptr, end, &n_entries, sizeof(n_entries))) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < n_entries; ++i) {
+		LilvCacheEntry entry;
+		memset(&entry, '\0', sizeof(entry));
+
+		const char* path = read_string(&ptr, end);
+		const char* key  = path ? read_string(&ptr, end) : NULL;
+		if (!key ||
+		    !lilv_read_bytes(&ptr, end, &entry.mtime, sizeof(entry.mtime)) ||
+		    !lilv_read_bytes(&ptr, end, &entry.size, sizeof(entry.size)) ||
+		    !lilv_read_bytes(&ptr, end, &entry.n_statements,
+		                sizeof(entry.n_statements)) ||
+		    !lilv_read_bytes(&ptr, end, &entry.data_size,
+		                sizeof(entry.data_size)) ||
+		    (size_t)(end - ptr) < entry.data_size) {
+			return false;
+		}
+
+		entry.data = ptr;
+		ptr += entry.data_size;
+
+		LilvCacheEntry* e = (LilvCacheEntry*)malloc(sizeof(LilvCacheEntry));
+		*e      = entry;
+		e->path = lilv_strdup(path);
+		e->key  = lilv_strdup(key);
+		if (zix_tree_insert(cache->entries, e, NULL)) {
+			lilv_cache_entry_free(e);
+		}
+	}
+
+	return true;
+}
+
+char*
+lilv_cache_default_path(void)
+{
+	const char* xdg_cache = getenv("XDG_CACHE_HOME");
+	if (xdg_cache && xdg_cache[0]) {
+		return lilv_strjoin(xdg_cache, LILV_DIR_SEP,
+		                    "lilv", LILV_DIR_SEP, "discovery.cache", NULL);
+	}
+
+	const char* home = getenv("HOME");
+	if (home && home[0]) {
+		return lilv_strjoin(home, LILV_DIR_SEP, ".cache", LILV_DIR_SEP,
+		                    "lilv", LILV_DIR_SEP, "discovery.cache", NULL);
+	}
+
+	return NULL;
+}
+
+LilvCache*
+lilv_cache_new(const char* path)
+{
+	LilvCache* cache = (LilvCache*)malloc(sizeof(LilvCache));
+	cache->path      = lilv_strdup(path);
+	cache->file      = lilv_file_map(path, &cache->file_size, &cache->mapped);
+	cache->entries   = zix_tree_new(
+		false, lilv_cache_entry_cmp, NULL, lilv_cache_entry_free);
+	cache->dirty     = false;
+
+	if (cache->file_size && !lilv_cache_read_entries(cache)) {
+		LILV_WARNF("Ignoring invalid cache file %s\n", path);
+		zix_tree_free(cache->entries);
+		cache->entries = zix_tree_new(
+			false, lilv_cache_entry_cmp, NULL, lilv_cache_entry_free);
+		cache->dirty = true;
+	}
+
+	return cache;
+}
+
+void
+lilv_cache_free(LilvCache* cache)
+{
+	if (!cache) {
+		return;
+	}
+
+	zix_tree_free(cache->entries);
+	lilv_file_unmap(cache->file, cache->file_size, cache->mapped);
+	free(cache->path);
+	free(cache);
+}
+
+const LilvCacheEntry*
+lilv_cache_get(LilvCache* cache, const char* path, const char* key)
+{
+	LilvCacheEntry search;
+	ZixTreeIter*   iter;
+	search.path = (char*)path;
+	search.key  = (char*)key;
+	if (!path || zix_tree_find(cache->entries, &search, &iter)) {
+		return NULL;
+	}
+
+	const LilvCacheEntry* entry = (const LilvCacheEntry*)zix_tree_get(iter);
+	int64_t               mtime, size;
+	if (!lilv_cache_stat(path, &mtime, &size) ||
+	    mtime != entry->mtime || size != entry->size) {
+		return NULL;  // Stale entry, will be replaced after parsing
+	}
+
+	return entry;
+}
+
+void
+lilv_cache_set(LilvCache*           cache,
+               const char*          path,
+               const char*          key,
+               const LilvStatement* statements,
+               size_t               n_statements,
+               const char*          blank_prefix)
+{
+	int64_t mtime, size;
+	if (!lilv_cache_stat(path, &mtime, &size)) {
+		return;
+	}
+
+	LilvBuffer buffer = { NULL, 0, 0 };
+	for (size_t i = 0; i < n_statements; ++i) {
+		const LilvStatement* t = &statements[i];
+		buffer_append_node(&buffer, &t->s, blank_prefix);
+		buffer_append_node(&buffer, &t->p, blank_prefix);
+		buffer_append_node(&buffer, &t->o, blank_prefix);
+		buffer_append_node(&buffer, &t->datatype, blank_prefix);
+		buffer_append_node(&buffer, &t->lang, blank_prefix);
+	}
+
+	LilvCacheEntry* entry = (LilvCacheEntry*)malloc(sizeof(LilvCacheEntry));
+	entry->path         = lilv_strdup(path);
+	entry->key          = lilv_strdup(key);
+	entry->mtime        = mtime;
+	entry->size         = size;
+	entry->n_statements = (uint32_t)n_statements;
+	entry->data_size    = (uint32_t)buffer.len;
+	entry->data         = buffer.buf;
+	entry->owned        = buffer.buf;
+
+	ZixTreeIter* iter;
+	if (!zix_tree_find(cache->entries, entry, &iter)) {
+		zix_tree_remove(cache->entries, iter);
+	}
+	zix_tree_insert(cache->entries, entry, NULL);
+	cache->dirty = true;
+}
+
+void
+lilv_cache_read(const LilvCacheEntry* entry,
+                const char*           blank_prefix,
+                LilvStatementSink     sink,
+                void*                 handle)
+{
+	const uint8_t* ptr        = entry->data;
+	const uint8_t* end        = entry->data + entry->data_size;
+	const size_t   prefix_len = strlen(blank_prefix);
+	for (uint32_t i = 0; i < entry->n_statements; ++i) {
+		SerdNode nodes[5];
+		char*    blanks[5] = { NULL, NULL, NULL, NULL, NULL };
+		bool     valid     = true;
+		for (unsigned n = 0; n < 5 && valid; ++n) {
+			valid = read_node(&ptr, end, &nodes[n]);
+			if (valid && nodes[n].type == SERD_BLANK) {
+				blanks[n] = lilv_strjoin(
+					blank_prefix, (const char*)nodes[n].buf, NULL);
+				nodes[n].buf      = (const uint8_t*)blanks[n];
+				nodes[n].n_bytes += prefix_len;
+				nodes[n].n_chars += prefix_len;
+			}
+		}
+
+		if (valid) {
+			const LilvStatement statement = {
+				nodes[0], nodes[1], nodes[2], nodes[3], nodes[4]
+			};
+			sink(handle, &statement);
+		} else {
+			LILV_ERRORF("Corrupt cache entry for %s\n", entry->path);
+		}
+
+		for (unsigned n = 0; n < 5; ++n) {
+			free(blanks[n]);
+		}
+
+		if (!valid) {
+			break;
+		}
+	}
+}
+
+typedef struct {
+	LilvWorld* world;
+	SerdEnv*   env;
+	SordNode*  graph;
+} LilvCacheLoader;
+
+static void
+lilv_cache_load_statement(void* handle, const LilvStatement* t)
+{
+	LilvCacheLoader* loader = (LilvCacheLoader*)handle;
+	LilvWorld*       world  = loader->world;
+
+	SordNode* s = sord_node_from_serd_node(
+		world->world, loader->env, &t->s, NULL, NULL);
+	SordNode* p = sord_node_from_serd_node(
+		world->world, loader->env, &t->p, NULL, NULL);
+	SordNode* o = sord_node_from_serd_node(
+		world->world, loader->env, &t->o,
+		t->datatype.buf ? &t->datatype : NULL,
+		t->lang.buf ? &t->lang : NULL);
+
+	if (s && p && o && !lilv_world_skips(world, p)) {
+		SordQuad quad = { s, p, o, loader->graph };
+		sord_add(world->model, quad);
+	}
+
+	sord_node_free(world->world, o);
+	sord_node_free(world->world, p);
+	sord_node_free(world->world, s);
+}
+
+void
+lilv_cache_load(LilvWorld*            world,
+                const LilvCacheEntry* entry,
+                SordNode*             graph,
+                const char*           blank_prefix)
+{
+	LilvCacheLoader loader = { world, serd_env_new(NULL), graph };
+	lilv_world_model_changed(world);
+	lilv_cache_read(entry, blank_prefix, lilv_cache_load_statement, &loader);
+	serd_env_free(loader.env);
+}
+
+void
+lilv_cache_remove_dir(LilvCache* cache, const char* dir)
+{
+	ZixTreeIter* i = zix_tree_begin(cache->entries);
+	while (!zix_tree_iter_is_end(i)) {
+		ZixTreeIter*          next  = zix_tree_iter_next(i);
+		const LilvCacheEntry* entry = (const LilvCacheEntry*)zix_tree_get(i);
+		if (lilv_path_is_child(entry->path, dir)) {
+			zix_tree_remove(cache->entries, i);
+			cache->dirty = true;
+		}
+		i = next;
+	}
+}
+
+int
+lilv_cache_save(LilvCache* cache)
+{
+	if (!cache->dirty) {
+		return 0;
+	}
+
+	char* dir = lilv_dirname(cache->path);
+	if (lilv_mkdir_p(dir)) {
+		LILV_ERRORF("Failed to create cache directory %s (%s)\n",
+		            dir, strerror(errno));
+		free(dir);
+		return 1;
+	}
+	free(dir);
+
+	// Count entries for files that still exist
+	uint32_t n_entries = 0;
+	for (ZixTreeIter* i = zix_tree_begin(cache->entries);
+	     !zix_tree_iter_is_end(i);
+	     i = zix_tree_iter_next(i)) {
+		const LilvCacheEntry* entry = (const LilvCacheEntry*)zix_tree_get(i);
+		if (lilv_path_exists(entry->path, NULL)) {
+			++n_entries;
+		}
+	}
+
+	char* tmp_path = lilv_strjoin(cache->path, ".new", NULL);
+	FILE* fd       = fopen(tmp_path, "wb");
+	if (!fd) {
+		LILV_ERRORF("Failed to open %s (%s)\n", tmp_path, strerror(errno));
+		free(tmp_path);
+		return 1;
+	}
+
+	const uint32_t version = LILV_CACHE_VERSION;
+	const uint32_t bom     = LILV_CACHE_BOM;
+	size_t         n       = 0;
+	size_t         len     = 0;
+	n += fwrite(LILV_CACHE_MAGIC, 8, 1, fd);
+	n += fwrite(&version, sizeof(version), 1, fd);
+	n += fwrite(&bom, sizeof(bom), 1, fd);
+	n += fwrite(&n_entries, sizeof(n_entries), 1, fd);
+	len += 4;
+
+	for (ZixTreeIter* i = zix_tree_begin(cache->entries);
+	     !zix_tree_iter_is_end(i);
+	     i = zix_tree_iter_next(i)) {
+		const LilvCacheEntry* entry = (const LilvCacheEntry*)zix_tree_get(i);
+		if (!lilv_path_exists(entry->path, NULL)) {
+			continue;
+		}
+
+		const uint32_t path_len = (uint32_t)strlen(entry->path);
+		const uint32_t key_len  = (uint32_t)strlen(entry->key);
+		n += fwrite(&path_len, sizeof(path_len), 1, fd);
+		n += fwrite(entry->path, path_len + 1, 1, fd);
+		n += fwrite(&key_len, sizeof(key_len), 1, fd);
+		n += fwrite(entry->key, key_len + 1, 1, fd);
+		n += fwrite(&entry->mtime, sizeof(entry->mtime), 1, fd);
+		n += fwrite(&entry->size, sizeof(entry->size), 1, fd);
+		n += fwrite(&entry->n_statements, sizeof(entry->n_statements), 1, fd);
+		n += fwrite(&entry->data_size, sizeof(entry->data_size), 1, fd);
+		len += 8;
+		if (entry->data_size) {
+			n += fwrite(entry->data, entry->data_size, 1, fd);
+			++len;
+		}
+	}
+
+	const bool failed = fclose(fd) || n != len;
+	if (failed || rename(tmp_path, cache->path)) {
+		LILV_ERRORF("Failed to write cache %s\n", cache->path);
+		unlink(tmp_path);
+		free(tmp_path);
+		return 1;
+	}
+
+	free(tmp_path);
+	cache->dirty = false;
+	return 0;
+}
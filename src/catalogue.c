@@ -0,0 +1,349 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lilv_internal.h"
+
+/*
+  The entry of each plugin is written to its own buffer, on several threads
+  if the world is frozen and may be queried concurrently.  The buffers are
+  then written to the stream in order, so the output does not depend on the
+  number of threads.
+*/
+
+typedef struct {
+	char*  buf;
+	size_t len;
+	size_t size;
+} CatalogueBuffer;
+
+typedef struct {
+	const LilvPlugin** plugins;
+	CatalogueBuffer*   entries;  ///< Entry of each plugin
+	size_t             n_plugins;
+	size_t             next;     ///< Index of next plugin to write
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t    mutex;    ///< Protects next
+#endif
+} CatalogueBatch;
+
+/** Ensure `buffer` has room for `len` more bytes and a terminator. */
+static void
+catalogue_reserve(CatalogueBuffer* buffer, size_t len)
+{
+	const size_t needed = buffer->len + len + 1;
+	if (needed > buffer->size) {
+		buffer->size = needed > 2 * buffer->size ? needed : 2 * buffer->size;
+		buffer->buf  = (char*)realloc(buffer->buf, buffer->size);
+	}
+}
+
+static void
+catalogue_append(CatalogueBuffer* buffer, const char* str, size_t len)
+{
+	catalogue_reserve(buffer, len);
+	memcpy(buffer->buf + buffer->len, str, len);
+	buffer->len += len;
+	buffer->buf[buffer->len] = '\0';
+}
+
+static void
+catalogue_printf(CatalogueBuffer* buffer, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	va_list copy;
+	va_copy(copy, args);
+	const int len = vsnprintf(NULL, 0, fmt, copy);
+	va_end(copy);
+
+	if (len > 0) {
+		catalogue_reserve(buffer, (size_t)len);
+		vsnprintf(buffer->buf + buffer->len, (size_t)len + 1, fmt, args);
+		buffer->len += (size_t)len;
+	}
+	va_end(args);
+}
+
+static void
+catalogue_string(CatalogueBuffer* buffer, const char* str)
+{
+	if (!str) {
+		catalogue_append(buffer, "null", 4);
+		return;
+	}
+
+	catalogue_append(buffer, "\"", 1);
+	for (const char* s = str; *s;) {
+		// Append the run of characters that need no escaping at once
+		const char* run = s;
+		while (*s && *s != '"' && *s != '\\' && (unsigned char)*s >= 0x20) {
+			++s;
+		}
+		catalogue_append(buffer, run, (size_t)(s - run));
+		if (!*s) {
+			break;
+		}
+
+		switch (*s) {
+		case '"':  catalogue_append(buffer, "\\\"", 2); break;
+		case '\\': catalogue_append(buffer, "\\\\", 2); break;
+		case '\n': catalogue_append(buffer, "\\n", 2); break;
+		case '\r': catalogue_append(buffer, "\\r", 2); break;
+		case '\t': catalogue_append(buffer, "\\t", 2); break;
+		default:   catalogue_printf(buffer, "\\u%04x", (unsigned)*s);
+		}
+		++s;
+	}
+	catalogue_append(buffer, "\"", 1);
+}
+
+static void
+catalogue_node(CatalogueBuffer* buffer, const LilvNode* node)
+{
+	catalogue_string(buffer, node ? lilv_node_as_string(node) : NULL);
+}
+
+/** Write a `,"key":[...]` array of node strings, and free `nodes`. */
+static void
+catalogue_nodes(CatalogueBuffer* buffer, const char* key, LilvNodes* nodes)
+{
+	catalogue_printf(buffer, ",\"%s\":[", key);
+	bool first = true;
+	LILV_FOREACH(nodes, i, nodes) {
+		catalogue_printf(buffer, first ? "" : ",");
+		catalogue_node(buffer, lilv_nodes_get(nodes, i));
+		first = false;
+	}
+	catalogue_printf(buffer, "]");
+	lilv_nodes_free(nodes);
+}
+
+/** Write a `,"key":value` number if `node` is a finite number, and free it. */
+static void
+catalogue_number(CatalogueBuffer* buffer, const char* key, LilvNode* node)
+{
+	if (lilv_node_is_float(node) || lilv_node_is_int(node)) {
+		const float value = lilv_node_as_float(node);
+		if (isfinite(value)) {
+			catalogue_printf(buffer, ",\"%s\":%.9g", key, (double)value);
+		}
+	}
+	lilv_node_free(node);
+}
+
+static void
+catalogue_ports(CatalogueBuffer* buffer, const LilvPlugin* plugin)
+{
+	catalogue_printf(buffer, ",\"ports\":[");
+	const uint32_t n_ports = lilv_plugin_get_num_ports(plugin);
+	for (uint32_t i = 0; i < n_ports; ++i) {
+		const LilvPort* port = lilv_plugin_get_port_by_index(plugin, i);
+		LilvNode*       name = lilv_port_get_name(plugin, port);
+
+		catalogue_printf(buffer, "%s{\"index\":%u,\"symbol\":", i ? "," : "", i);
+		catalogue_node(buffer, lilv_port_get_symbol(plugin, port));
+		catalogue_printf(buffer, ",\"name\":");
+		catalogue_node(buffer, name);
+		lilv_node_free(name);
+
+		catalogue_printf(buffer, ",\"types\":[");
+		const LilvNodes* classes = lilv_port_get_classes(plugin, port);
+		bool             first   = true;
+		LILV_FOREACH(nodes, c, classes) {
+			catalogue_printf(buffer, first ? "" : ",");
+			catalogue_node(buffer, lilv_nodes_get(classes, c));
+			first = false;
+		}
+		catalogue_printf(buffer, "]");
+
+		LilvNode* deflt = NULL;
+		LilvNode* min   = NULL;
+		LilvNode* max   = NULL;
+		lilv_port_get_range(plugin, port, &deflt, &min, &max);
+		catalogue_number(buffer, "default", deflt);
+		catalogue_number(buffer, "minimum", min);
+		catalogue_number(buffer, "maximum", max);
+		catalogue_printf(buffer, "}");
+	}
+	catalogue_printf(buffer, "]");
+}
+
+static void
+catalogue_uis(CatalogueBuffer* buffer, const LilvPlugin* plugin)
+{
+	catalogue_printf(buffer, ",\"uis\":[");
+	LilvUIs* uis   = lilv_plugin_get_uis(plugin);
+	bool     first = true;
+	LILV_FOREACH(uis, i, uis) {
+		const LilvUI* ui = lilv_uis_get(uis, i);
+		catalogue_printf(buffer, "%s{\"uri\":", first ? "" : ",");
+		catalogue_node(buffer, lilv_ui_get_uri(ui));
+		catalogue_printf(buffer, ",\"types\":[");
+		const LilvNodes* classes = lilv_ui_get_classes(ui);
+		bool             first_class = true;
+		LILV_FOREACH(nodes, c, classes) {
+			catalogue_printf(buffer, first_class ? "" : ",");
+			catalogue_node(buffer, lilv_nodes_get(classes, c));
+			first_class = false;
+		}
+		catalogue_printf(buffer, "]}");
+		first = false;
+	}
+	catalogue_printf(buffer, "]");
+	lilv_uis_free(uis);
+}
+
+static void
+catalogue_presets(CatalogueBuffer* buffer, const LilvPlugin* plugin)
+{
+	unsigned        n_presets = 0;
+	LilvPresetInfo* presets   = lilv_plugin_get_presets(plugin, &n_presets);
+
+	catalogue_printf(buffer, ",\"presets\":[");
+	for (unsigned i = 0; i < n_presets; ++i) {
+		catalogue_printf(buffer, "%s{\"uri\":", i ? "," : "");
+		catalogue_node(buffer, presets[i].uri);
+		catalogue_printf(buffer, ",\"label\":");
+		catalogue_node(buffer, presets[i].label);
+		catalogue_printf(buffer, "}");
+	}
+	catalogue_printf(buffer, "]");
+	lilv_preset_infos_free(presets, n_presets);
+}
+
+static void
+catalogue_plugin(CatalogueBuffer* buffer, const LilvPlugin* plugin)
+{
+	const LilvPluginClass* plugin_class = lilv_plugin_get_class(plugin);
+	LilvNode*              name         = lilv_plugin_get_name(plugin);
+
+	catalogue_printf(buffer, "{\"uri\":");
+	catalogue_node(buffer, lilv_plugin_get_uri(plugin));
+	catalogue_printf(buffer, ",\"name\":");
+	catalogue_node(buffer, name);
+	catalogue_printf(buffer, ",\"class\":");
+	catalogue_node(buffer, plugin_class
+	               ? lilv_plugin_class_get_uri(plugin_class) : NULL);
+	catalogue_printf(buffer, ",\"bundle\":");
+	catalogue_node(buffer, lilv_plugin_get_bundle_uri(plugin));
+	lilv_node_free(name);
+
+	catalogue_nodes(buffer, "required_features",
+	                lilv_plugin_get_required_features(plugin));
+	catalogue_nodes(buffer, "optional_features",
+	                lilv_plugin_get_optional_features(plugin));
+	catalogue_ports(buffer, plugin);
+	catalogue_uis(buffer, plugin);
+	catalogue_presets(buffer, plugin);
+	catalogue_printf(buffer, "}");
+}
+
+static void*
+catalogue_batch_run(void* data)
+{
+	CatalogueBatch* batch = (CatalogueBatch*)data;
+	for (;;) {
+#ifdef HAVE_PTHREAD
+		pthread_mutex_lock(&batch->mutex);
+#endif
+		const size_t i = batch->next++;
+#ifdef HAVE_PTHREAD
+		pthread_mutex_unlock(&batch->mutex);
+#endif
+		if (i >= batch->n_plugins) {
+			break;
+		}
+
+		catalogue_plugin(&batch->entries[i], batch->plugins[i]);
+	}
+	return NULL;
+}
+
+static void
+catalogue_batch_write(CatalogueBatch* batch, unsigned n_threads)
+{
+#ifdef HAVE_PTHREAD
+	if (n_threads > batch->n_plugins) {
+		n_threads = (unsigned)batch->n_plugins;
+	}
+
+	pthread_t* threads   = (pthread_t*)calloc(n_threads, sizeof(pthread_t));
+	unsigned   n_started = 0;
+	pthread_mutex_init(&batch->mutex, NULL);
+	for (unsigned i = 1; i < n_threads; ++i) {
+		if (!pthread_create(&threads[n_started], NULL,
+		                    catalogue_batch_run, batch)) {
+			++n_started;
+		}
+	}
+	catalogue_batch_run(batch);
+	for (unsigned i = 0; i < n_started; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+	pthread_mutex_destroy(&batch->mutex);
+	free(threads);
+#else
+	catalogue_batch_run(batch);
+#endif
+}
+
+LILV_API int
+lilv_world_write_catalogue(LilvWorld*         world,
+                           const LilvPlugins* plugins,
+                           unsigned           n_threads,
+                           FILE*              stream)
+{
+	CatalogueBatch batch;
+	memset(&batch, '\0', sizeof(batch));
+	batch.n_plugins = lilv_plugins_size(plugins);
+	batch.plugins   = (const LilvPlugin**)calloc(
+		batch.n_plugins ? batch.n_plugins : 1, sizeof(const LilvPlugin*));
+	batch.entries   = (CatalogueBuffer*)calloc(
+		batch.n_plugins ? batch.n_plugins : 1, sizeof(CatalogueBuffer));
+
+	size_t n = 0;
+	LILV_FOREACH(plugins, i, plugins) {
+		batch.plugins[n++] = lilv_plugins_get(plugins, i);
+	}
+
+	// Query plugins in parallel if the world may be read concurrently
+	catalogue_batch_write(&batch, world->frozen ? n_threads : 1);
+
+	int st = fputs("{\"plugins\":[", stream) < 0;
+	for (size_t i = 0; i < batch.n_plugins; ++i) {
+		if (!st && i) {
+			st = fputc(',', stream) == EOF;
+		}
+		if (!st) {
+			st = fwrite(batch.entries[i].buf, 1, batch.entries[i].len, stream)
+				!= batch.entries[i].len;
+		}
+		free(batch.entries[i].buf);
+	}
+	if (!st) {
+		st = fputs("]}\n", stream) < 0;
+	}
+
+	free(batch.entries);
+	free(batch.plugins);
+	return st;
+}
@@ -14,6 +14,9 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "lilv_internal.h"
 
 int
@@ -30,6 +33,55 @@ lilv_resource_node_cmp(const void* a, const void* b, void* user_data)
 	return (intptr_t)an - (intptr_t)bn;
 }
 
+/* Hash index of objects with a LilvHeader, by interned URI node */
+
+static uint32_t
+lilv_header_hash(const void* value)
+{
+	const struct LilvHeader* header = *(const struct LilvHeader* const*)value;
+	const uint64_t           ptr    = (uintptr_t)header->uri->node;
+	return (uint32_t)((ptr * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+static bool
+lilv_header_equal(const void* a, const void* b)
+{
+	const struct LilvHeader* header_a = *(const struct LilvHeader* const*)a;
+	const struct LilvHeader* header_b = *(const struct LilvHeader* const*)b;
+	return header_a->uri->node == header_b->uri->node;
+}
+
+ZixHash*
+lilv_header_index_new(void)
+{
+	return zix_hash_new(
+		lilv_header_hash, lilv_header_equal, sizeof(struct LilvHeader*));
+}
+
+void
+lilv_header_index_add(ZixHash* index, struct LilvHeader* header)
+{
+	zix_hash_insert(index, &header, NULL);
+}
+
+void
+lilv_header_index_remove(ZixHash* index, const struct LilvHeader* header)
+{
+	zix_hash_remove(index, &header);
+}
+
+struct LilvHeader*
+lilv_header_index_get(const ZixHash* index, const LilvNode* uri)
+{
+	const struct LilvHeader  key   = { NULL, (LilvNode*)uri };
+	const struct LilvHeader* key_p = &key;
+
+	struct LilvHeader* const* found =
+		(struct LilvHeader* const*)zix_hash_find(index, &key_p);
+
+	return found ? *found : NULL;
+}
+
 /* Generic collection functions */
 
 static inline LilvCollection*
@@ -64,6 +116,123 @@ lilv_collection_get(const LilvCollection* collection,
 	return zix_tree_get((const ZixTreeIter*)i);
 }
 
+/* Collections built at once */
+
+void
+lilv_array_init(LilvArray* array)
+{
+	array->elems   = array->local;
+	array->n_elems = 0;
+	array->size    = sizeof(array->local) / sizeof(void*);
+}
+
+void
+lilv_array_append(LilvArray* array, void* elem)
+{
+	if (array->n_elems == array->size) {
+		array->size *= 2;
+		if (array->elems == array->local) {
+			array->elems = (void**)malloc(array->size * sizeof(void*));
+			memcpy(array->elems, array->local, sizeof(array->local));
+		} else {
+			array->elems = (void**)realloc(
+				array->elems, array->size * sizeof(void*));
+		}
+	}
+	array->elems[array->n_elems++] = elem;
+}
+
+/** Sort `elems` with a stable merge sort, unless they are already sorted. */
+static void
+lilv_array_sort(void** elems, size_t n_elems, ZixComparator cmp)
+{
+	size_t i = 1;
+	while (i < n_elems && cmp(elems[i - 1], elems[i], NULL) <= 0) {
+		++i;
+	}
+	if (i >= n_elems) {
+		return;  // Already sorted, as when copying another collection
+	}
+
+	void** tmp = (void**)malloc(n_elems * sizeof(void*));
+	for (size_t width = 1; width < n_elems; width *= 2) {
+		for (size_t lo = 0; lo < n_elems; lo += 2 * width) {
+			const size_t mid = (lo + width < n_elems) ? lo + width : n_elems;
+			const size_t hi  = (mid + width < n_elems) ? mid + width : n_elems;
+			size_t       a   = lo;
+			size_t       b   = mid;
+			size_t       o   = lo;
+			while (a < mid && b < hi) {
+				tmp[o++] = (cmp(elems[b], elems[a], NULL) < 0)
+					? elems[b++]
+					: elems[a++];
+			}
+			while (a < mid) {
+				tmp[o++] = elems[a++];
+			}
+			while (b < hi) {
+				tmp[o++] = elems[b++];
+			}
+		}
+		memcpy(elems, tmp, n_elems * sizeof(void*));
+	}
+	free(tmp);
+}
+
+LilvCollection*
+lilv_array_to_collection(LilvArray*     array,
+                         bool           allow_duplicates,
+                         ZixComparator  cmp,
+                         ZixDestroyFunc destructor)
+{
+	void** const elems   = array->elems;
+	size_t       n_elems = array->n_elems;
+
+	lilv_array_sort(elems, n_elems, cmp);
+	if (!allow_duplicates && n_elems > 1) {
+		size_t n_unique = 1;
+		for (size_t i = 1; i < n_elems; ++i) {
+			if (cmp(elems[n_unique - 1], elems[i], NULL)) {
+				elems[n_unique++] = elems[i];
+			} else if (destructor) {
+				destructor(elems[i]);
+			}
+		}
+		n_elems = n_unique;
+	}
+
+	LilvCollection* coll = zix_tree_new_sorted(
+		allow_duplicates, cmp, NULL, destructor, elems, n_elems);
+
+	if (elems != array->local) {
+		free(elems);
+	}
+	lilv_array_init(array);
+	return coll;
+}
+
+LilvNodes*
+lilv_array_to_nodes(LilvArray* array)
+{
+	// Equal nodes are shared, so allow the same pointer to appear twice
+	return lilv_array_to_collection(
+		array, true, lilv_ptr_cmp, (ZixDestroyFunc)lilv_node_free);
+}
+
+LilvScalePoints*
+lilv_array_to_scale_points(LilvArray* array)
+{
+	return lilv_array_to_collection(
+		array, false, lilv_ptr_cmp, (ZixDestroyFunc)lilv_scale_point_free);
+}
+
+LilvUIs*
+lilv_array_to_uis(LilvArray* array)
+{
+	return lilv_array_to_collection(
+		array, false, lilv_header_compare_by_uri, (ZixDestroyFunc)lilv_ui_free);
+}
+
 /* Constructors */
 
 LilvScalePoints*
@@ -76,8 +245,9 @@ lilv_scale_points_new(void)
 LilvNodes*
 lilv_nodes_new(void)
 {
-	return lilv_collection_new(lilv_ptr_cmp,
-	                           (ZixDestroyFunc)lilv_node_free);
+	// Equal nodes are shared, so allow the same pointer to appear twice
+	return zix_tree_new(true, lilv_ptr_cmp, NULL,
+	                    (ZixDestroyFunc)lilv_node_free);
 }
 
 LilvUIs*
@@ -100,6 +270,11 @@ LILV_API const LilvPluginClass*
 lilv_plugin_classes_get_by_uri(const LilvPluginClasses* coll,
                                const LilvNode*          uri)
 {
+	if (lilv_node_is_uri(uri) && coll == uri->world->plugin_classes) {
+		return (LilvPluginClass*)lilv_header_index_get(
+			uri->world->class_index, uri);
+	}
+
 	return (LilvPluginClass*)lilv_collection_get_by_uri(
 		(const ZixTree*)coll, uri);
 }
@@ -121,6 +296,10 @@ lilv_plugins_new(void)
 LILV_API const LilvPlugin*
 lilv_plugins_get_by_uri(const LilvPlugins* list, const LilvNode* uri)
 {
+	if (lilv_node_is_uri(uri) && list == uri->world->plugins) {
+		return (LilvPlugin*)lilv_header_index_get(uri->world->plugin_index, uri);
+	}
+
 	return (LilvPlugin*)lilv_collection_get_by_uri((const ZixTree*)list, uri);
 }
 
@@ -139,19 +318,16 @@ lilv_nodes_contains(const LilvNodes* list, const LilvNode* value)
 LILV_API LilvNodes*
 lilv_nodes_merge(const LilvNodes* a, const LilvNodes* b)
 {
-	LilvNodes* result = lilv_nodes_new();
+	LilvArray result;
+	lilv_array_init(&result);
 
 	LILV_FOREACH(nodes, i, a)
-		zix_tree_insert((ZixTree*)result,
-		                lilv_node_duplicate(lilv_nodes_get(a, i)),
-		                NULL);
+		lilv_array_append(&result, lilv_node_duplicate(lilv_nodes_get(a, i)));
 
 	LILV_FOREACH(nodes, i, b)
-		zix_tree_insert((ZixTree*)result,
-		                lilv_node_duplicate(lilv_nodes_get(b, i)),
-		                NULL);
+		lilv_array_append(&result, lilv_node_duplicate(lilv_nodes_get(b, i)));
 
-	return result;
+	return lilv_array_to_nodes(&result);
 }
 
 /* Iterator */
@@ -0,0 +1,345 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "lilv_internal.h"
+
+/*
+  The copy index records, for every file copied into a state copy directory,
+  the copy it last used, the content hash of that copy, and the size and
+  modification time of the file when it was copied.  There is one record per
+  source file, and several sources with the same contents may share a copy.
+  It is stored in the copy directory in native byte order.
+
+  Header:  "LILVCOPY", uint32 version, uint32 byte order mark, uint32 n_copies
+  Copy:    uint64 hash, int64 size, int64 mtime, int64 time,
+           uint32 source_len, source + '\0', uint32 name_len, name + '\0'
+
+  The source is the absolute path of the original file, and the name is the
+  path of the copy relative to the copy directory.  The time is when the
+  record was made: a source modified in that same second may have changed
+  again without its modification time changing, so its contents are always
+  hashed in that case.
+*/
+
+#define LILV_COPY_INDEX_MAGIC   "LILVCOPY"
+#define LILV_COPY_INDEX_VERSION 1U
+#define LILV_COPY_INDEX_BOM     0x01020304U
+#define LILV_COPY_INDEX_FILE    ".lilv-copies"
+#define LILV_COPY_HASH_BLOCK    4096U
+
+typedef struct {
+	uint64_t hash;    ///< Hash of file contents
+	int64_t  size;    ///< Size of source when copied
+	int64_t  mtime;   ///< Modification time of source when copied
+	int64_t  time;    ///< Time this record was made
+	char*    source;  ///< Absolute path of source file
+	char*    name;    ///< Path of copy relative to copy directory
+} LilvCopy;
+
+struct LilvCopyIndexImpl {
+	char*     dir;       ///< Copy directory with trailing separator
+	char*     path;      ///< Path of index file
+	LilvCopy* copies;
+	size_t    n_copies;
+	bool      dirty;     ///< True iff copies differ from index file
+};
+
+static bool
+read_string(const uint8_t** ptr, const uint8_t* end, char** str)
+{
+	uint32_t len;
+	if (!lilv_read_bytes(ptr, end, &len, sizeof(len)) ||
+	    (size_t)(end - *ptr) < (size_t)len + 1 ||
+	    (*ptr)[len] != '\0') {
+		return false;
+	}
+	*str  = lilv_strdup((const char*)*ptr);
+	*ptr += len + 1;
+	return true;
+}
+
+static void
+append_string(LilvBuffer* buffer, const char* str)
+{
+	const size_t len = strlen(str);
+	lilv_buffer_append_u32(buffer, (uint32_t)len);
+	lilv_buffer_append(buffer, str, len + 1);
+}
+
+static void
+lilv_copy_index_add(LilvCopyIndex* index, const LilvCopy* copy)
+{
+	index->copies = (LilvCopy*)realloc(
+		index->copies, (index->n_copies + 1) * sizeof(LilvCopy));
+	index->copies[index->n_copies++] = *copy;
+}
+
+/** Replace the record for the source of `copy`, or add it if there is none. */
+static void
+lilv_copy_index_set(LilvCopyIndex* index, const LilvCopy* copy)
+{
+	for (size_t i = 0; i < index->n_copies; ++i) {
+		LilvCopy* old = &index->copies[i];
+		if (!strcmp(old->source, copy->source)) {
+			free(old->source);
+			free(old->name);
+			*old = *copy;
+			return;
+		}
+	}
+
+	lilv_copy_index_add(index, copy);
+}
+
+/** Read copies from the index file contents, return false if invalid. */
+static bool
+lilv_copy_index_read(LilvCopyIndex* index, const uint8_t* data, size_t size)
+{
+	const uint8_t* ptr = data;
+	const uint8_t* end = data + size;
+
+	char     magic[8];
+	uint32_t version, bom, n_copies;
+	if (!lilv_read_bytes(&ptr, end, magic, sizeof(magic)) ||
+	    memcmp(magic, LILV_COPY_INDEX_MAGIC, sizeof(magic)) ||
+	    !lilv_read_bytes(&ptr, end, &version, sizeof(version)) ||
+	    version != LILV_COPY_INDEX_VERSION ||
+	    !lilv_read_bytes(&ptr, end, &bom, sizeof(bom)) ||
+	    bom != LILV_COPY_INDEX_BOM ||
+	    !lilv_read_bytes(&ptr, end, &n_copies, sizeof(n_copies))) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < n_copies; ++i) {
+		LilvCopy copy = { 0, 0, 0, 0, NULL, NULL };
+		if (!lilv_read_bytes(&ptr, end, &copy.hash, sizeof(copy.hash)) ||
+		    !lilv_read_bytes(&ptr, end, &copy.size, sizeof(copy.size)) ||
+		    !lilv_read_bytes(&ptr, end, &copy.mtime, sizeof(copy.mtime)) ||
+		    !lilv_read_bytes(&ptr, end, &copy.time, sizeof(copy.time)) ||
+		    !read_string(&ptr, end, &copy.source) ||
+		    !read_string(&ptr, end, &copy.name)) {
+			free(copy.source);
+			return false;
+		}
+		lilv_copy_index_add(index, &copy);
+	}
+
+	return true;
+}
+
+LilvCopyIndex*
+lilv_copy_index_new(const char* copy_dir)
+{
+	LilvCopyIndex* index = (LilvCopyIndex*)calloc(1, sizeof(LilvCopyIndex));
+	index->dir  = lilv_path_join(copy_dir, NULL);
+	index->path = lilv_path_join(copy_dir, LILV_COPY_INDEX_FILE);
+
+	size_t   size   = 0;
+	bool     mapped = false;
+	uint8_t* data   = lilv_file_map(index->path, &size, &mapped);
+	if (data && !lilv_copy_index_read(index, data, size)) {
+		LILV_WARNF("Ignoring invalid copy index %s\n", index->path);
+		for (size_t i = 0; i < index->n_copies; ++i) {
+			free(index->copies[i].source);
+			free(index->copies[i].name);
+		}
+		index->n_copies = 0;
+		index->dirty    = true;
+	}
+	lilv_file_unmap(data, size, mapped);
+
+	return index;
+}
+
+static int
+lilv_copy_index_save(const LilvCopyIndex* index)
+{
+	LilvBuffer buffer = { NULL, 0, 0 };
+	lilv_buffer_append(&buffer, LILV_COPY_INDEX_MAGIC, 8);
+	lilv_buffer_append_u32(&buffer, LILV_COPY_INDEX_VERSION);
+	lilv_buffer_append_u32(&buffer, LILV_COPY_INDEX_BOM);
+	lilv_buffer_append_u32(&buffer, (uint32_t)index->n_copies);
+	for (size_t i = 0; i < index->n_copies; ++i) {
+		const LilvCopy* copy = &index->copies[i];
+		lilv_buffer_append(&buffer, &copy->hash, sizeof(copy->hash));
+		lilv_buffer_append(&buffer, &copy->size, sizeof(copy->size));
+		lilv_buffer_append(&buffer, &copy->mtime, sizeof(copy->mtime));
+		lilv_buffer_append(&buffer, &copy->time, sizeof(copy->time));
+		append_string(&buffer, copy->source);
+		append_string(&buffer, copy->name);
+	}
+
+	int   st = 0;
+	FILE* fd = fopen(index->path, "wb");
+	if (!fd) {
+		st = errno;
+	} else {
+		if (fwrite(buffer.buf, 1, buffer.len, fd) != buffer.len) {
+			st = errno;
+		}
+		fclose(fd);
+	}
+
+	if (st) {
+		LILV_ERRORF("Failed to write %s (%s)\n", index->path, strerror(st));
+	}
+
+	free(buffer.buf);
+	return st;
+}
+
+void
+lilv_copy_index_free(LilvCopyIndex* index)
+{
+	if (!index) {
+		return;
+	}
+
+	if (index->dirty) {
+		lilv_copy_index_save(index);
+	}
+
+	for (size_t i = 0; i < index->n_copies; ++i) {
+		free(index->copies[i].source);
+		free(index->copies[i].name);
+	}
+	free(index->copies);
+	free(index->path);
+	free(index->dir);
+	free(index);
+}
+
+/** Return the 64-bit FNV-1a hash of the contents of a file. */
+static bool
+lilv_file_hash(const char* path, uint64_t* hash)
+{
+	FILE* fd = fopen(path, "rb");
+	if (!fd) {
+		return false;
+	}
+
+	uint8_t* const page = (uint8_t*)malloc(LILV_COPY_HASH_BLOCK);
+	uint64_t       h    = 14695981039346656037ull;
+	size_t         n_read;
+	while ((n_read = fread(page, 1, LILV_COPY_HASH_BLOCK, fd)) > 0) {
+		for (size_t i = 0; i < n_read; ++i) {
+			h = (h ^ page[i]) * 1099511628211ull;
+		}
+	}
+
+	const bool ok = !ferror(fd);
+	free(page);
+	fclose(fd);
+	*hash = h;
+	return ok;
+}
+
+/** Return the absolute path of `copy` if it still exists, or NULL. */
+static char*
+lilv_copy_index_existing(const LilvCopyIndex* index, const LilvCopy* copy)
+{
+	char* path = lilv_path_join(index->dir, copy->name);
+	if (!lilv_path_exists(path, NULL)) {
+		free(path);
+		return NULL;
+	}
+	return path;
+}
+
+/** Copy `path` to a free path based on `copy_path` and return it. */
+static char*
+lilv_copy_index_make_copy(const char* path, const char* copy_path)
+{
+	char*     copy = lilv_find_free_path(copy_path, lilv_path_exists, NULL);
+	const int st   = lilv_copy_file(path, copy);
+	if (st) {
+		LILV_ERRORF("Error copying state file %s (%s)\n", copy, strerror(st));
+	}
+	return copy;
+}
+
+char*
+lilv_copy_index_get_copy(LilvCopyIndex* index,
+                         const char*    path,
+                         const char*    copy_path)
+{
+	struct stat st;
+	if (stat(path, &st)) {
+		LILV_ERRORF("stat(%s) (%s)\n", path, strerror(errno));
+		return lilv_copy_index_make_copy(path, copy_path);
+	}
+
+	const int64_t size  = (int64_t)st.st_size;
+	const int64_t mtime = (int64_t)st.st_mtime;
+
+	// Use the copy of this file if it has not changed since
+	for (size_t i = 0; i < index->n_copies; ++i) {
+		const LilvCopy* copy = &index->copies[i];
+		if (!strcmp(copy->source, path)) {
+			char* existing = NULL;
+			if (copy->size == size && copy->mtime == mtime &&
+			    copy->mtime < copy->time &&
+			    (existing = lilv_copy_index_existing(index, copy))) {
+				return existing;
+			}
+			break;
+		}
+	}
+
+	// Otherwise, use any copy with the same contents
+	uint64_t hash;
+	if (!lilv_file_hash(path, &hash)) {
+		LILV_ERRORF("Failed to read %s\n", path);
+		return lilv_copy_index_make_copy(path, copy_path);
+	}
+
+	LilvCopy record = {
+		hash, size, mtime, (int64_t)time(NULL), lilv_strdup(path), NULL
+	};
+	char*    result = NULL;
+	for (size_t i = index->n_copies; i > 0 && !result; --i) {
+		const LilvCopy* copy = &index->copies[i - 1];
+		if (copy->hash == hash && copy->size == size &&
+		    (result = lilv_copy_index_existing(index, copy))) {
+			if (lilv_file_equals(path, result)) {
+				record.name = lilv_strdup(copy->name);
+			} else {
+				free(result);  // Hash collision, or copy was modified
+				result = NULL;
+			}
+		}
+	}
+
+	if (!result) {
+		// No copy with these contents, make a new one
+		result      = lilv_copy_index_make_copy(path, copy_path);
+		record.name = lilv_path_relative_to(result, index->dir);
+	}
+
+	// Record that the source now has this copy
+	lilv_copy_index_set(index, &record);
+	index->dirty = true;
+	return result;
+}
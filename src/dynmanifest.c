@@ -0,0 +1,295 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L  /* for open_memstream */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lilv_internal.h"
+
+/*
+  A dynamic manifest library is only opened when data must be generated, so
+  a cached dynamic manifest costs nothing until a plugin is instantiated or
+  its data is not cached either.  Data is generated into a memory buffer
+  with open_memstream() and parsed from there, rather than written to and
+  read back from a temporary file.
+
+  Generating the subjects of different libraries may happen concurrently, so
+  nothing here touches the world.  Several bundles may have dynamic manifests
+  in the same library, so every call into a library is made with a lock that
+  is shared by all the manifests of that library.
+*/
+
+#ifdef LILV_DYN_MANIFEST
+
+typedef int (*OpenFunc)(LV2_Dyn_Manifest_Handle*, const LV2_Feature* const*);
+typedef int (*GetSubjectsFunc)(LV2_Dyn_Manifest_Handle, FILE*);
+typedef int (*GetDataFunc)(LV2_Dyn_Manifest_Handle, FILE*, const char*);
+typedef void (*CloseFunc)(LV2_Dyn_Manifest_Handle);
+
+/** A lock shared by every dynamic manifest in one library. */
+struct LilvDynLockImpl {
+	struct LilvDynLockImpl* next;
+	char*                   lib_path;
+	uint32_t                refs;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t         mutex;
+#endif
+};
+
+typedef struct LilvDynLockImpl LilvDynLock;
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t dyn_locks_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static LilvDynLock*    dyn_locks       = NULL;
+
+/** Return a new reference to the lock for `lib_path`. */
+static LilvDynLock*
+lilv_dyn_lock_get(const char* lib_path)
+{
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&dyn_locks_mutex);
+#endif
+
+	LilvDynLock* lock = dyn_locks;
+	while (lock && strcmp(lock->lib_path, lib_path)) {
+		lock = lock->next;
+	}
+
+	if (lock) {
+		++lock->refs;
+	} else {
+		lock           = (LilvDynLock*)malloc(sizeof(LilvDynLock));
+		lock->next     = dyn_locks;
+		lock->lib_path = lilv_strdup(lib_path);
+		lock->refs     = 1;
+#ifdef HAVE_PTHREAD
+		pthread_mutex_init(&lock->mutex, NULL);
+#endif
+		dyn_locks = lock;
+	}
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&dyn_locks_mutex);
+#endif
+	return lock;
+}
+
+/** Drop a reference to `lock`, freeing it if it was the last. */
+static void
+lilv_dyn_lock_unref(LilvDynLock* lock)
+{
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&dyn_locks_mutex);
+#endif
+
+	if (--lock->refs == 0) {
+		LilvDynLock** prev = &dyn_locks;
+		while (*prev != lock) {
+			prev = &(*prev)->next;
+		}
+		*prev = lock->next;
+
+#ifdef HAVE_PTHREAD
+		pthread_mutex_destroy(&lock->mutex);
+#endif
+		free(lock->lib_path);
+		free(lock);
+	}
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&dyn_locks_mutex);
+#endif
+}
+
+static void
+lilv_dyn_manifest_lock(LilvDynManifest* dman)
+{
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&dman->lock->mutex);
+#endif
+}
+
+static void
+lilv_dyn_manifest_unlock(LilvDynManifest* dman)
+{
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&dman->lock->mutex);
+#endif
+}
+
+LilvDynManifest*
+lilv_dyn_manifest_new(LilvWorld*      world,
+                      const SordNode* bundle,
+                      const char*     lib_path)
+{
+	LilvDynManifest* dman = (LilvDynManifest*)malloc(sizeof(LilvDynManifest));
+	dman->bundle   = lilv_node_new_from_node(world, bundle);
+	dman->lib_path = lilv_strdup(lib_path);
+	dman->lib      = NULL;
+	dman->handle   = NULL;
+	dman->refs     = 1;
+	dman->failed   = false;
+	dman->lock     = lilv_dyn_lock_get(lib_path);
+	return dman;
+}
+
+void
+lilv_dyn_manifest_unref(LilvDynManifest* dman)
+{
+	if (!dman || --dman->refs > 0) {
+		return;
+	}
+
+	if (dman->lib) {
+		CloseFunc close_func = (CloseFunc)lilv_dlfunc(
+			dman->lib, "lv2_dyn_manifest_close");
+		if (close_func) {
+			lilv_dyn_manifest_lock(dman);
+			close_func(dman->handle);
+			lilv_dyn_manifest_unlock(dman);
+		}
+		dlclose(dman->lib);
+	}
+
+	lilv_dyn_lock_unref(dman->lock);
+	lilv_node_free(dman->bundle);
+	free(dman->lib_path);
+	free(dman);
+}
+
+/**
+   Open the library and dynamic manifest if necessary, return 0 on success.
+   This must be called with the lock of `dman` held.
+*/
+static int
+lilv_dyn_manifest_open(LilvDynManifest* dman)
+{
+	if (dman->lib) {
+		return 0;
+	} else if (dman->failed) {
+		return 1;
+	}
+
+	dlerror();
+	void* lib = dlopen(dman->lib_path, RTLD_LAZY);
+	if (!lib) {
+		LILV_ERRORF("Failed to open dynmanifest library `%s' (%s)\n",
+		            dman->lib_path, dlerror());
+		dman->failed = true;
+		return 1;
+	}
+
+	OpenFunc dmopen = (OpenFunc)lilv_dlfunc(lib, "lv2_dyn_manifest_open");
+	if (!dmopen || dmopen(&dman->handle, &dman_features)) {
+		LILV_ERRORF("No `lv2_dyn_manifest_open' in `%s'\n", dman->lib_path);
+		dlclose(lib);
+		dman->failed = true;
+		return 1;
+	}
+
+	dman->lib = lib;
+	return 0;
+}
+
+static LilvVoidFunc
+lilv_dyn_manifest_func(LilvDynManifest* dman, const char* name)
+{
+	lilv_dyn_manifest_lock(dman);
+	const int st = lilv_dyn_manifest_open(dman);
+	lilv_dyn_manifest_unlock(dman);
+	if (st) {
+		return NULL;
+	}
+
+	LilvVoidFunc func = lilv_dlfunc(dman->lib, name);
+	if (!func) {
+		LILV_ERRORF("No `%s' in `%s'\n", name, dman->lib_path);
+	}
+	return func;
+}
+
+/** Open a memory stream, or return NULL and report an error. */
+static FILE*
+lilv_dyn_manifest_stream(char** buf, size_t* size)
+{
+	FILE* fd = open_memstream(buf, size);
+	if (!fd) {
+		LILV_ERROR("Failed to open dynmanifest buffer\n");
+	}
+	return fd;
+}
+
+/** Close a memory stream, and return its contents if `st` is zero. */
+static char*
+lilv_dyn_manifest_finish(LilvDynManifest* dman, FILE* fd, char* buf, int st)
+{
+	if (fclose(fd) || st) {
+		LILV_ERRORF("Failed to generate data from `%s'\n", dman->lib_path);
+		free(buf);
+		return NULL;
+	}
+	return buf;
+}
+
+char*
+lilv_dyn_manifest_get_subjects(LilvDynManifest* dman)
+{
+	GetSubjectsFunc func = (GetSubjectsFunc)lilv_dyn_manifest_func(
+		dman, "lv2_dyn_manifest_get_subjects");
+	if (!func) {
+		return NULL;
+	}
+
+	char*  buf  = NULL;
+	size_t size = 0;
+	FILE*  fd   = lilv_dyn_manifest_stream(&buf, &size);
+	if (!fd) {
+		return NULL;
+	}
+
+	lilv_dyn_manifest_lock(dman);
+	const int st = func(dman->handle, fd);
+	lilv_dyn_manifest_unlock(dman);
+	return lilv_dyn_manifest_finish(dman, fd, buf, st);
+}
+
+char*
+lilv_dyn_manifest_get_data(LilvDynManifest* dman, const char* uri)
+{
+	GetDataFunc func = (GetDataFunc)lilv_dyn_manifest_func(
+		dman, "lv2_dyn_manifest_get_data");
+	if (!func) {
+		return NULL;
+	}
+
+	char*  buf  = NULL;
+	size_t size = 0;
+	FILE*  fd   = lilv_dyn_manifest_stream(&buf, &size);
+	if (!fd) {
+		return NULL;
+	}
+
+	lilv_dyn_manifest_lock(dman);
+	const int st = func(dman->handle, fd, uri);
+	lilv_dyn_manifest_unlock(dman);
+	return lilv_dyn_manifest_finish(dman, fd, buf, st);
+}
+
+#endif  // LILV_DYN_MANIFEST
@@ -0,0 +1,389 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lilv_internal.h"
+
+#ifdef LILV_ATOMICS
+#    define LILV_GRAPH_THREADS 1
+#    include <sched.h>
+#    include <semaphore.h>
+#endif
+
+#define NO_NODE UINT32_MAX
+
+typedef struct {
+	LilvInstance* instance;
+	uint32_t*     successors;      ///< Nodes that depend on this one
+	uint32_t      n_successors;
+	uint32_t      n_predecessors;  ///< Number of nodes this one depends on
+	uint32_t      pending;         ///< Predecessors left to run this cycle
+	uint64_t      run_time;        ///< Duration of last run in nanoseconds
+	uint32_t      latency_port;    ///< Reported latency port, or UINT32_MAX
+	const float*  latency;         ///< Buffer of latency port, or NULL
+	float*        own_latency;     ///< Latency buffer owned by graph, or NULL
+	uint32_t      visited;         ///< Generation this was last searched in
+} LilvGraphNode;
+
+struct LilvGraphImpl {
+	LilvGraphNode* nodes;
+	uint32_t       n_nodes;
+	uint32_t*      ready;         ///< Queue of nodes ready to run
+	uint32_t       ready_head;    ///< Index of next node to take from ready
+	uint32_t       ready_tail;    ///< Index of next free slot in ready
+	uint32_t       n_done;        ///< Number of nodes run this cycle
+	uint32_t       sample_count;  ///< Sample count of current cycle
+	uint32_t       generation;    ///< Generation of the current search
+	bool           realtime;
+#ifdef LILV_GRAPH_THREADS
+	pthread_t*     threads;
+	unsigned       n_threads;
+	sem_t          start;
+	sem_t          finished;
+	bool           exit;
+#endif
+};
+
+static void
+lilv_graph_push(LilvGraph* graph, uint32_t node)
+{
+	const uint32_t slot = ATOMIC_ADD(&graph->ready_tail, 1);
+	ATOMIC_STORE(&graph->ready[slot], node);
+}
+
+/** Take a node from the ready queue, or return NO_NODE if none is ready. */
+static uint32_t
+lilv_graph_pop(LilvGraph* graph)
+{
+	uint32_t head = ATOMIC_LOAD(&graph->ready_head);
+	while (head < ATOMIC_LOAD(&graph->ready_tail)) {
+		if (ATOMIC_CAS(&graph->ready_head, &head, head + 1)) {
+			// Slot is reserved, wait for the pusher to finish writing it
+			uint32_t node;
+			while ((node = ATOMIC_LOAD(&graph->ready[head])) == NO_NODE) {}
+			return node;
+		}
+	}
+	return NO_NODE;
+}
+
+static void
+lilv_graph_process(LilvGraph* graph)
+{
+	while (ATOMIC_LOAD(&graph->n_done) < graph->n_nodes) {
+		const uint32_t id = lilv_graph_pop(graph);
+		if (id == NO_NODE) {
+#ifdef LILV_GRAPH_THREADS
+			sched_yield();
+#endif
+			continue;
+		}
+
+		LilvGraphNode* node  = &graph->nodes[id];
+		const uint64_t begin = lilv_time_ns();
+		node->instance->lv2_descriptor->run(node->instance->lv2_handle,
+		                                    graph->sample_count);
+		node->run_time = lilv_time_ns() - begin;
+
+		for (uint32_t i = 0; i < node->n_successors; ++i) {
+			const uint32_t s = node->successors[i];
+			if (ATOMIC_SUB(&graph->nodes[s].pending, 1) == 1) {
+				lilv_graph_push(graph, s);
+			}
+		}
+
+		(void)ATOMIC_ADD(&graph->n_done, 1);
+	}
+}
+
+#ifdef LILV_GRAPH_THREADS
+static void*
+lilv_graph_worker(void* data)
+{
+	LilvGraph* graph = (LilvGraph*)data;
+	for (;;) {
+		while (sem_wait(&graph->start) && errno == EINTR) {}
+		if (ATOMIC_LOAD(&graph->exit)) {
+			break;
+		}
+		lilv_graph_process(graph);
+		sem_post(&graph->finished);
+	}
+	return NULL;
+}
+#endif
+
+LILV_API LilvGraph*
+lilv_graph_new(unsigned n_threads, bool realtime)
+{
+	LilvGraph* graph = (LilvGraph*)calloc(1, sizeof(LilvGraph));
+	graph->realtime = realtime;
+#ifdef LILV_GRAPH_THREADS
+	sem_init(&graph->start, 0, 0);
+	sem_init(&graph->finished, 0, 0);
+	graph->threads = (pthread_t*)calloc(n_threads, sizeof(pthread_t));
+	for (unsigned i = 0; i < n_threads; ++i) {
+		if (pthread_create(&graph->threads[i], NULL, lilv_graph_worker, graph)) {
+			LILV_WARNF("Failed to create worker thread %u\n", i);
+			break;
+		}
+		++graph->n_threads;
+		if (realtime) {
+			struct sched_param param;
+			param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+			pthread_setschedparam(graph->threads[i], SCHED_FIFO, &param);
+		}
+	}
+#else
+	if (n_threads > 0) {
+		LILV_WARN("Threads not supported, graph will run serially\n");
+	}
+#endif
+	return graph;
+}
+
+LILV_API void
+lilv_graph_free(LilvGraph* graph)
+{
+	if (!graph) {
+		return;
+	}
+
+#ifdef LILV_GRAPH_THREADS
+	ATOMIC_STORE(&graph->exit, true);
+	for (unsigned i = 0; i < graph->n_threads; ++i) {
+		sem_post(&graph->start);
+	}
+	for (unsigned i = 0; i < graph->n_threads; ++i) {
+		pthread_join(graph->threads[i], NULL);
+	}
+	free(graph->threads);
+	sem_destroy(&graph->start);
+	sem_destroy(&graph->finished);
+#endif
+
+	for (uint32_t i = 0; i < graph->n_nodes; ++i) {
+		free(graph->nodes[i].successors);
+		free(graph->nodes[i].own_latency);
+	}
+	free(graph->nodes);
+	free(graph->ready);
+	free(graph);
+}
+
+LILV_API int32_t
+lilv_graph_add(LilvGraph*        graph,
+               const LilvPlugin* plugin,
+               LilvInstance*     instance)
+{
+	if (graph->realtime) {
+		LilvNode* hard_rt = lilv_new_uri(plugin->world,
+		                                 LV2_CORE__hardRTCapable);
+		const bool capable = lilv_plugin_has_feature(plugin, hard_rt);
+		lilv_node_free(hard_rt);
+		if (!capable) {
+			LILV_ERRORF("Plugin <%s> is not hard real-time capable\n",
+			            lilv_node_as_uri(lilv_plugin_get_uri(plugin)));
+			return -1;
+		}
+	}
+
+	LilvGraphNode* nodes = (LilvGraphNode*)realloc(
+		graph->nodes, (graph->n_nodes + 1) * sizeof(LilvGraphNode));
+	uint32_t* ready = (uint32_t*)realloc(
+		graph->ready, (graph->n_nodes + 1) * sizeof(uint32_t));
+	if (nodes) {
+		graph->nodes = nodes;
+	}
+	if (ready) {
+		graph->ready = ready;
+	}
+	if (!nodes || !ready) {
+		return -1;
+	}
+
+	LilvGraphNode* node = &graph->nodes[graph->n_nodes];
+	memset(node, '\0', sizeof(LilvGraphNode));
+	node->instance     = instance;
+	node->latency_port = UINT32_MAX;
+	if (lilv_plugin_has_latency(plugin)) {
+		const uint32_t       index = lilv_plugin_get_latency_port_index(plugin);
+		const LilvPortTable* table = lilv_plugin_get_port_table(plugin);
+		const uint32_t       types = LILV_PORT_OUTPUT|LILV_PORT_CONTROL;
+		if ((table->types[index] & types) == types) {
+			// Allocated separately, so it does not move when nodes are added
+			node->latency_port = index;
+			node->own_latency  = (float*)calloc(1, sizeof(float));
+			node->latency      = node->own_latency;
+			instance->lv2_descriptor->connect_port(
+				instance->lv2_handle, index, node->own_latency);
+		}
+	}
+
+	return (int32_t)graph->n_nodes++;
+}
+
+/** Connect a port of a node, and remember where its latency is reported. */
+static void
+lilv_graph_node_connect(LilvGraphNode* node, uint32_t port, void* buffer)
+{
+	node->instance->lv2_descriptor->connect_port(
+		node->instance->lv2_handle, port, buffer);
+	if (port == node->latency_port) {
+		node->latency = (const float*)buffer;
+	}
+}
+
+/** Search from `from` for `to`, skipping nodes already searched. */
+static bool
+lilv_graph_search(LilvGraph* graph, uint32_t from, uint32_t to)
+{
+	if (from == to) {
+		return true;
+	}
+
+	LilvGraphNode* node = &graph->nodes[from];
+	if (node->visited == graph->generation) {
+		return false;  // Already searched from here, via another path
+	}
+
+	node->visited = graph->generation;
+	for (uint32_t i = 0; i < node->n_successors; ++i) {
+		if (lilv_graph_search(graph, node->successors[i], to)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Return true iff `to` is reachable from `from` along successor edges. */
+static bool
+lilv_graph_reaches(LilvGraph* graph, uint32_t from, uint32_t to)
+{
+	if (++graph->generation == 0) {
+		// Generation wrapped, so stamps from an old search may match
+		for (uint32_t i = 0; i < graph->n_nodes; ++i) {
+			graph->nodes[i].visited = 0;
+		}
+		graph->generation = 1;
+	}
+
+	return lilv_graph_search(graph, from, to);
+}
+
+LILV_API int
+lilv_graph_connect(LilvGraph* graph,
+                   uint32_t   src,
+                   uint32_t   src_port,
+                   uint32_t   dst,
+                   uint32_t   dst_port,
+                   void*      buffer)
+{
+	if (src >= graph->n_nodes || dst >= graph->n_nodes) {
+		LILV_ERRORF("Connection between invalid nodes %u and %u\n", src, dst);
+		return 1;
+	} else if (lilv_graph_reaches(graph, dst, src)) {
+		LILV_ERRORF("Connection from %u to %u would form a cycle\n", src, dst);
+		return 1;
+	}
+
+	LilvGraphNode* from = &graph->nodes[src];
+	LilvGraphNode* to   = &graph->nodes[dst];
+	bool           dup  = false;
+	for (uint32_t i = 0; i < from->n_successors; ++i) {
+		dup = dup || from->successors[i] == dst;
+	}
+
+	if (!dup) {
+		uint32_t* successors = (uint32_t*)realloc(
+			from->successors, (from->n_successors + 1) * sizeof(uint32_t));
+		if (!successors) {
+			return 1;
+		}
+		from->successors = successors;
+		from->successors[from->n_successors++] = dst;
+		++to->n_predecessors;
+	}
+
+	lilv_graph_node_connect(from, src_port, buffer);
+	lilv_graph_node_connect(to, dst_port, buffer);
+	return 0;
+}
+
+LILV_API int
+lilv_graph_connect_port(LilvGraph* graph,
+                        uint32_t   node,
+                        uint32_t   port,
+                        void*      buffer)
+{
+	if (node >= graph->n_nodes) {
+		LILV_ERRORF("Connection to invalid node %u\n", node);
+		return 1;
+	}
+
+	lilv_graph_node_connect(&graph->nodes[node], port, buffer);
+	return 0;
+}
+
+LILV_API void
+lilv_graph_run(LilvGraph* graph, uint32_t sample_count)
+{
+	graph->sample_count = sample_count;
+	graph->ready_head   = 0;
+	graph->ready_tail   = 0;
+	graph->n_done       = 0;
+	for (uint32_t i = 0; i < graph->n_nodes; ++i) {
+		graph->ready[i]         = NO_NODE;
+		graph->nodes[i].pending = graph->nodes[i].n_predecessors;
+	}
+	for (uint32_t i = 0; i < graph->n_nodes; ++i) {
+		if (graph->nodes[i].n_predecessors == 0) {
+			lilv_graph_push(graph, i);
+		}
+	}
+
+#ifdef LILV_GRAPH_THREADS
+	for (unsigned i = 0; i < graph->n_threads; ++i) {
+		sem_post(&graph->start);
+	}
+#endif
+
+	lilv_graph_process(graph);
+
+#ifdef LILV_GRAPH_THREADS
+	for (unsigned i = 0; i < graph->n_threads; ++i) {
+		while (sem_wait(&graph->finished) && errno == EINTR) {}
+	}
+#endif
+}
+
+LILV_API uint64_t
+lilv_graph_get_node_time(const LilvGraph* graph, uint32_t node)
+{
+	return node < graph->n_nodes ? graph->nodes[node].run_time : 0;
+}
+
+LILV_API void
+lilv_graph_get_latencies(const LilvGraph* graph, float* latencies)
+{
+	for (uint32_t i = 0; i < graph->n_nodes; ++i) {
+		const LilvGraphNode* node = &graph->nodes[i];
+		latencies[i] = node->latency ? *node->latency : 0.0f;
+	}
+}
@@ -30,6 +30,7 @@ lilv_plugin_instantiate(const LilvPlugin*        plugin,
 		return NULL;
 	}
 
+	const uint64_t        begin       = lilv_trace_begin(plugin->world);
 	LilvInstance*         result      = NULL;
 	const LilvNode* const lib_uri     = lilv_plugin_get_library_uri(plugin);
 	const LilvNode* const bundle_uri  = lilv_plugin_get_bundle_uri(plugin);
@@ -48,27 +49,21 @@ lilv_plugin_instantiate(const LilvPlugin*        plugin,
 		local_features[0] = NULL;
 	}
 
-	// Search for plugin by URI
-	for (uint32_t i = 0; true; ++i) {
-		const LV2_Descriptor* ld = lilv_lib_get_plugin(lib, i);
-		if (!ld) {
-			LILV_ERRORF("No plugin <%s> in <%s>\n",
-			            lilv_node_as_uri(lilv_plugin_get_uri(plugin)),
-			            lilv_node_as_uri(lib_uri));
-			lilv_lib_close(lib);
-			break;  // return NULL
-		}
-
-		if (!strcmp(ld->URI, lilv_node_as_uri(lilv_plugin_get_uri(plugin)))) {
-			// Create LilvInstance to return
-			result = (LilvInstance*)malloc(sizeof(LilvInstance));
-			result->lv2_descriptor = ld;
-			result->lv2_handle = ld->instantiate(
-				ld, sample_rate, bundle_path,
-				(features) ? features : local_features);
-			result->pimpl = lib;
-			break;
-		}
+	// Find plugin in library index
+	const char* const     uri = lilv_node_as_uri(lilv_plugin_get_uri(plugin));
+	const LV2_Descriptor* ld  = lilv_lib_get_plugin_by_uri(lib, uri);
+	if (!ld) {
+		LILV_ERRORF("No plugin <%s> in <%s>\n",
+		            uri, lilv_node_as_uri(lib_uri));
+		lilv_lib_close(lib);
+	} else {
+		// Create LilvInstance to return
+		result = (LilvInstance*)malloc(sizeof(LilvInstance));
+		result->lv2_descriptor = ld;
+		result->lv2_handle = ld->instantiate(
+			ld, sample_rate, bundle_path,
+			(features) ? features : local_features);
+		result->pimpl = lib;
 	}
 
 	free(local_features);
@@ -79,18 +74,65 @@ lilv_plugin_instantiate(const LilvPlugin*        plugin,
 			// Failed to instantiate
 			free(result);
 			lilv_lib_close(lib);
-			return NULL;
-		}
-
-		// "Connect" all ports to NULL (catches bugs)
-		for (uint32_t i = 0; i < lilv_plugin_get_num_ports(plugin); ++i) {
-			result->lv2_descriptor->connect_port(result->lv2_handle, i, NULL);
+			result = NULL;
+		} else {
+			// "Connect" all ports to NULL (catches bugs)
+			for (uint32_t i = 0; i < lilv_plugin_get_num_ports(plugin); ++i) {
+				result->lv2_descriptor->connect_port(
+					result->lv2_handle, i, NULL);
+			}
 		}
 	}
 
+	lilv_trace_end(plugin->world, LILV_TRACE_INSTANTIATE, uri, begin, 0);
 	return result;
 }
 
+LILV_API int
+lilv_plugin_preload(const LilvPlugin*        plugin,
+                    const LV2_Feature*const* features)
+{
+	lilv_plugin_load_if_necessary(plugin);
+	if (plugin->parse_errors) {
+		return 1;
+	}
+
+	LilvPlugin* const     p       = (LilvPlugin*)plugin;
+	LilvWorld* const      world   = p->world;
+	const LilvNode* const lib_uri = lilv_plugin_get_library_uri(plugin);
+	if (!lib_uri) {
+		return 1;
+	}
+
+	lilv_world_lock(world);
+	const bool loaded = p->lib;
+	lilv_world_unlock(world);
+	if (loaded) {
+		return 0;
+	}
+
+	char* const bundle_path = lilv_file_uri_parse(
+		lilv_node_as_uri(lilv_plugin_get_bundle_uri(plugin)), NULL);
+	LilvLib* lib = lilv_lib_open(world, lib_uri, bundle_path, features);
+	lilv_free(bundle_path);
+	if (!lib) {
+		return 1;
+	}
+
+	// Keep a reference to the library for the lifetime of the plugin
+	lilv_world_lock(world);
+	if (!p->lib) {
+		p->lib = lib;
+		lib    = NULL;
+	}
+	lilv_world_unlock(world);
+
+	if (lib) {
+		lilv_lib_close(lib);  // Preloaded by another thread meanwhile
+	}
+	return 0;
+}
+
 LILV_API void
 lilv_instance_free(LilvInstance* instance)
 {
@@ -99,7 +141,166 @@ lilv_instance_free(LilvInstance* instance)
 
 	instance->lv2_descriptor->cleanup(instance->lv2_handle);
 	instance->lv2_descriptor = NULL;
-	lilv_lib_close((LilvLib*)instance->pimpl);
+	if (instance->pimpl) {
+		lilv_lib_close((LilvLib*)instance->pimpl);  // Isolated if NULL
+	}
 	instance->pimpl = NULL;
 	free(instance);
 }
+
+LILV_API void
+lilv_instance_run_blocks(LilvInstance*   instance,
+                         uint32_t        n_ports,
+                         const uint32_t* ports,
+                         float* const*   buffers,
+                         uint64_t        n_frames,
+                         uint32_t        block_size)
+{
+	const LV2_Descriptor* const d = instance->lv2_descriptor;
+	if (!block_size) {
+		return;
+	}
+
+	for (uint64_t offset = 0; offset < n_frames; offset += block_size) {
+		const uint64_t remaining = n_frames - offset;
+		const uint32_t n         = (remaining < block_size
+		                            ? (uint32_t)remaining : block_size);
+		for (uint32_t i = 0; i < n_ports; ++i) {
+			d->connect_port(instance->lv2_handle, ports[i], buffers[i] + offset);
+		}
+		d->run(instance->lv2_handle, n);
+	}
+}
+
+LILV_API LilvInstanceGroup*
+lilv_instance_group_new(void)
+{
+	return (LilvInstanceGroup*)calloc(1, sizeof(LilvInstanceGroup));
+}
+
+LILV_API void
+lilv_instance_group_free(LilvInstanceGroup* group)
+{
+	if (group) {
+		free(group->entries);
+		free(group);
+	}
+}
+
+static LilvInstanceGroupEntry*
+lilv_instance_group_find(const LilvInstanceGroup* group,
+                         const LilvInstance*      instance)
+{
+	for (uint32_t i = 0; i < group->n_entries; ++i) {
+		if (group->entries[i].instance == instance) {
+			return &group->entries[i];
+		}
+	}
+	return NULL;
+}
+
+LILV_API int
+lilv_instance_group_add(LilvInstanceGroup* group, LilvInstance* instance)
+{
+	if (lilv_instance_group_find(group, instance)) {
+		return 1;
+	}
+
+	LilvInstanceGroupEntry* entries = (LilvInstanceGroupEntry*)realloc(
+		group->entries, (group->n_entries + 1) * sizeof(LilvInstanceGroupEntry));
+	if (!entries) {
+		return 1;
+	}
+	group->entries = entries;
+
+	// Insert after the last instance of the same plugin, or at the end
+	uint32_t pos = group->n_entries;
+	for (uint32_t i = group->n_entries; i > 0; --i) {
+		if (entries[i - 1].descriptor == instance->lv2_descriptor) {
+			pos = i;
+			break;
+		}
+	}
+
+	memmove(entries + pos + 1, entries + pos,
+	        (group->n_entries - pos) * sizeof(LilvInstanceGroupEntry));
+
+	LilvInstanceGroupEntry* entry = &entries[pos];
+	entry->descriptor = instance->lv2_descriptor;
+	entry->handle     = instance->lv2_handle;
+	entry->run        = instance->lv2_descriptor->run;
+	entry->instance   = instance;
+	entry->index      = group->n_entries++;
+	return 0;
+}
+
+LILV_API int
+lilv_instance_group_remove(LilvInstanceGroup* group, LilvInstance* instance)
+{
+	LilvInstanceGroupEntry* entry = lilv_instance_group_find(group, instance);
+	if (!entry) {
+		return 1;
+	}
+
+	const uint32_t index = entry->index;
+	const uint32_t pos   = entry - group->entries;
+	memmove(entry, entry + 1,
+	        (group->n_entries - pos - 1) * sizeof(LilvInstanceGroupEntry));
+	--group->n_entries;
+
+	for (uint32_t i = 0; i < group->n_entries; ++i) {
+		if (group->entries[i].index > index) {
+			--group->entries[i].index;
+		}
+	}
+	return 0;
+}
+
+LILV_API uint32_t
+lilv_instance_group_size(const LilvInstanceGroup* group)
+{
+	return group->n_entries;
+}
+
+LILV_API void
+lilv_instance_group_connect_port(LilvInstanceGroup* group,
+                                 uint32_t           port_index,
+                                 void* const*       data_locations)
+{
+	for (uint32_t i = 0; i < group->n_entries; ++i) {
+		const LilvInstanceGroupEntry* e = &group->entries[i];
+		e->descriptor->connect_port(
+			e->handle, port_index, data_locations[e->index]);
+	}
+}
+
+LILV_API void
+lilv_instance_group_activate(LilvInstanceGroup* group)
+{
+	for (uint32_t i = 0; i < group->n_entries; ++i) {
+		const LilvInstanceGroupEntry* e = &group->entries[i];
+		if (e->descriptor->activate) {
+			e->descriptor->activate(e->handle);
+		}
+	}
+}
+
+LILV_API void
+lilv_instance_group_run(LilvInstanceGroup* group, uint32_t sample_count)
+{
+	const LilvInstanceGroupEntry* const end = group->entries + group->n_entries;
+	for (const LilvInstanceGroupEntry* e = group->entries; e != end; ++e) {
+		e->run(e->handle, sample_count);
+	}
+}
+
+LILV_API void
+lilv_instance_group_deactivate(LilvInstanceGroup* group)
+{
+	for (uint32_t i = 0; i < group->n_entries; ++i) {
+		const LilvInstanceGroupEntry* e = &group->entries[i];
+		if (e->descriptor->deactivate) {
+			e->descriptor->deactivate(e->handle);
+		}
+	}
+}
@@ -0,0 +1,500 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L  /* for kill, sem_timedwait */
+#define _DEFAULT_SOURCE 1        /* for MAP_ANONYMOUS */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+
+#include "lilv_internal.h"
+
+#if defined(HAVE_FORK) && defined(HAVE_MMAP) && defined(HAVE_SEM_TIMEDWAIT)
+#    define LILV_ISOLATION 1
+#    include <semaphore.h>
+#    include <signal.h>
+#    include <sys/mman.h>
+#    include <sys/types.h>
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+
+/*
+  An isolated instance is a proxy whose descriptor forwards every call to a
+  child process, which instantiates the real plugin.  Ports are connected to
+  buffers in a shared mapping created before the fork, so they are at the
+  same address in both processes.  Running copies input buffers into the
+  mapping, wakes the child with a process-shared semaphore, and copies
+  outputs back once the child has finished.  The host waits in short slices
+  and checks whether the child is still alive, and kills a child that does
+  not respond in time.  Either way, the instance is marked as crashed, and
+  from then on running it zeroes its audio and CV outputs.
+*/
+
+#define ISOLATE_ATOM_BUFFER_SIZE 8192u
+#define ISOLATE_WAIT_NS          100000000u
+#define ISOLATE_EXIT_NS          1000000000u
+#define ISOLATE_TIMEOUT_NS       10000000000ull
+
+#ifdef LILV_ISOLATION
+
+typedef enum {
+	ISOLATE_INSTANTIATE,
+	ISOLATE_ACTIVATE,
+	ISOLATE_RUN,
+	ISOLATE_DEACTIVATE,
+	ISOLATE_EXIT
+} LilvIsolateCommand;
+
+/** Header of the shared mapping, followed by port buffers. */
+typedef struct {
+	sem_t    request;       ///< Posted by host to send a command
+	sem_t    response;      ///< Posted by child when done with command
+	uint32_t command;       ///< LilvIsolateCommand
+	uint32_t sample_count;  ///< Sample count for ISOLATE_RUN
+	int32_t  status;        ///< Non-zero if command failed
+	uint8_t  connected[];   ///< Non-zero for each port connected by host
+} LilvIsolateShared;
+
+typedef struct {
+	uint32_t types;     ///< LilvPortType flags
+	size_t   offset;    ///< Offset of buffer in shared mapping
+	size_t   size;      ///< Size of buffer in bytes
+	size_t   capacity;  ///< Capacity of host output atom buffer in this run
+	void*    host;      ///< Buffer connected by host, or NULL
+} LilvIsolatePort;
+
+typedef struct {
+	LV2_Descriptor     descriptor;   ///< Proxy that forwards calls to child
+	LilvIsolateShared* shared;       ///< Shared mapping
+	size_t             shared_size;  ///< Size of shared mapping
+	LilvIsolatePort*   ports;
+	uint32_t           n_ports;
+	uint32_t           max_block;    ///< Maximum sample count for run
+	pid_t              pid;          ///< Child process
+	bool               crashed;      ///< True if child is dead
+	bool               reaped;       ///< True if child has been waited for
+} LilvIsolate;
+
+static void*
+isolate_buffer(const LilvIsolate* isolate, uint32_t port)
+{
+	return (uint8_t*)isolate->shared + isolate->ports[port].offset;
+}
+
+static void
+isolate_deadline(struct timespec* deadline, uint64_t ns)
+{
+	clock_gettime(CLOCK_REALTIME, deadline);
+	const uint64_t nsec = (uint64_t)deadline->tv_nsec + ns;
+	deadline->tv_sec  += (time_t)(nsec / 1000000000u);
+	deadline->tv_nsec  = (long)(nsec % 1000000000u);
+}
+
+/** Tell the child to run `command`, return zero on success. */
+static int
+isolate_call(LilvIsolate* isolate, LilvIsolateCommand command)
+{
+	if (isolate->crashed) {
+		return 1;
+	}
+
+	isolate->shared->command = command;
+	isolate->shared->status  = 0;
+	sem_post(&isolate->shared->request);
+
+	int status = 0;
+	for (uint64_t waited = 0; waited < ISOLATE_TIMEOUT_NS;
+	     waited += ISOLATE_WAIT_NS) {
+		struct timespec deadline;
+		isolate_deadline(&deadline, ISOLATE_WAIT_NS);
+		if (!sem_timedwait(&isolate->shared->response, &deadline)) {
+			return isolate->shared->status;
+		} else if (errno != ETIMEDOUT && errno != EINTR) {
+			break;
+		}
+
+		if (waitpid(isolate->pid, &status, WNOHANG) == isolate->pid) {
+			LILV_ERRORF("Isolated plugin <%s> crashed\n",
+			            isolate->descriptor.URI);
+			isolate->reaped  = true;  // Pid may now be reused, never signal it
+			isolate->crashed = true;
+			return 1;
+		}
+	}
+
+	// Child is hung or unreachable, kill it so it can not respond later
+	LILV_ERRORF("Isolated plugin <%s> is not responding, killing it\n",
+	            isolate->descriptor.URI);
+	kill(isolate->pid, SIGKILL);
+	waitpid(isolate->pid, &status, 0);
+	isolate->reaped  = true;
+	isolate->crashed = true;
+	return 1;
+}
+
+/** Serve commands from the host until told to exit, in the child. */
+static void
+isolate_serve(LilvIsolate*             isolate,
+              const LilvPlugin*        plugin,
+              double                   sample_rate,
+              const LV2_Feature*const* features)
+{
+	LilvIsolateShared* const shared    = isolate->shared;
+	const pid_t              host      = getppid();
+	LilvInstance*            instance  = NULL;
+	uint8_t*                 connected = NULL;
+	for (;;) {
+		struct timespec deadline;
+		isolate_deadline(&deadline, ISOLATE_WAIT_NS);
+		if (sem_timedwait(&shared->request, &deadline)) {
+			if (getppid() != host) {
+				_exit(1);  // Host is gone
+			}
+			continue;
+		}
+
+		const LV2_Descriptor* const d = instance
+			? instance->lv2_descriptor : NULL;
+		switch ((LilvIsolateCommand)shared->command) {
+		case ISOLATE_INSTANTIATE:
+			instance = lilv_plugin_instantiate(plugin, sample_rate, features);
+			connected = (uint8_t*)calloc(isolate->n_ports + 1, 1);
+			shared->status = instance ? 0 : 1;
+			break;
+		case ISOLATE_ACTIVATE:
+			if (d && d->activate) {
+				d->activate(instance->lv2_handle);
+			}
+			break;
+		case ISOLATE_RUN:
+			if (!d) {
+				break;
+			}
+
+			// Connect ports to match the host
+			for (uint32_t i = 0; i < isolate->n_ports; ++i) {
+				if (connected[i] != shared->connected[i]) {
+					connected[i] = shared->connected[i];
+					d->connect_port(instance->lv2_handle, i,
+					                connected[i] ? isolate_buffer(isolate, i)
+					                             : NULL);
+				}
+			}
+			d->run(instance->lv2_handle, shared->sample_count);
+			break;
+		case ISOLATE_DEACTIVATE:
+			if (d && d->deactivate) {
+				d->deactivate(instance->lv2_handle);
+			}
+			break;
+		case ISOLATE_EXIT:
+			lilv_instance_free(instance);
+			free(connected);
+			sem_post(&shared->response);
+			_exit(0);
+		}
+
+		sem_post(&shared->response);
+	}
+}
+
+static void
+isolate_connect_port(LV2_Handle handle, uint32_t port, void* data)
+{
+	LilvIsolate* const isolate = (LilvIsolate*)handle;
+	if (port < isolate->n_ports) {
+		isolate->ports[port].host = data;
+	}
+}
+
+static void
+isolate_activate(LV2_Handle handle)
+{
+	isolate_call((LilvIsolate*)handle, ISOLATE_ACTIVATE);
+}
+
+/** Return the number of bytes to copy for a port buffer of `capacity`. */
+static size_t
+isolate_copy_size(const LilvIsolatePort* port,
+                  const void*            atom,
+                  uint32_t               sample_count,
+                  size_t                 capacity)
+{
+	if (port->types & (LILV_PORT_AUDIO | LILV_PORT_CV)) {
+		return sample_count * sizeof(float);
+	} else if (port->types & LILV_PORT_CONTROL) {
+		return sizeof(float);
+	} else if (port->types & LILV_PORT_ATOM) {
+		const size_t size = sizeof(LV2_Atom) + ((const LV2_Atom*)atom)->size;
+		return size < capacity ? size : capacity;
+	}
+	return 0;
+}
+
+static void
+isolate_run(LV2_Handle handle, uint32_t sample_count)
+{
+	LilvIsolate* const isolate = (LilvIsolate*)handle;
+	if (sample_count > isolate->max_block) {
+		LILV_ERRORF("Block of %u samples exceeds maximum of %u\n",
+		            sample_count, isolate->max_block);
+		return;
+	}
+
+	// Copy inputs, and output atom headers which hold their capacity
+	for (uint32_t i = 0; i < isolate->n_ports; ++i) {
+		LilvIsolatePort* const port = &isolate->ports[i];
+		void* const            buf  = isolate_buffer(isolate, i);
+		isolate->shared->connected[i] = port->host != NULL;
+		if (!port->host) {
+			continue;
+		} else if (port->types & LILV_PORT_INPUT) {
+			memcpy(buf, port->host,
+			       isolate_copy_size(port, port->host, sample_count,
+			                         port->size));
+		} else if (port->types & LILV_PORT_ATOM) {
+			// Save the host capacity, since the child may write any size
+			memcpy(buf, port->host, sizeof(LV2_Atom));
+			port->capacity = (sizeof(LV2_Atom) +
+			                  ((const LV2_Atom*)port->host)->size);
+			if (port->capacity > port->size) {
+				port->capacity = port->size;
+			}
+		}
+
+		if (port->types & LILV_PORT_ATOM) {
+			// Truncate atoms that do not fit in the shared buffer
+			LV2_Atom* const atom     = (LV2_Atom*)buf;
+			const uint32_t  max_size = port->size - sizeof(LV2_Atom);
+			if (atom->size > max_size) {
+				atom->size = max_size;
+			}
+		}
+	}
+
+	isolate->shared->sample_count = sample_count;
+	if (isolate_call(isolate, ISOLATE_RUN)) {
+		// Silence signal outputs, which the plugin has not written
+		for (uint32_t i = 0; i < isolate->n_ports; ++i) {
+			const LilvIsolatePort* const port = &isolate->ports[i];
+			if (port->host && (port->types & LILV_PORT_OUTPUT) &&
+			    (port->types & (LILV_PORT_AUDIO | LILV_PORT_CV))) {
+				memset(port->host, 0, sample_count * sizeof(float));
+			}
+		}
+		return;
+	}
+
+	for (uint32_t i = 0; i < isolate->n_ports; ++i) {
+		const LilvIsolatePort* const port = &isolate->ports[i];
+		if (port->host && (port->types & LILV_PORT_OUTPUT)) {
+			const void* const buf = isolate_buffer(isolate, i);
+			memcpy(port->host, buf,
+			       isolate_copy_size(port, buf, sample_count, port->capacity));
+		}
+	}
+}
+
+static void
+isolate_deactivate(LV2_Handle handle)
+{
+	isolate_call((LilvIsolate*)handle, ISOLATE_DEACTIVATE);
+}
+
+static void
+isolate_free(LilvIsolate* isolate)
+{
+	sem_destroy(&isolate->shared->request);
+	sem_destroy(&isolate->shared->response);
+	munmap(isolate->shared, isolate->shared_size);
+	free((char*)isolate->descriptor.URI);
+	free(isolate->ports);
+	free(isolate);
+}
+
+static void
+isolate_cleanup(LV2_Handle handle)
+{
+	LilvIsolate* const isolate = (LilvIsolate*)handle;
+	if (!isolate->crashed) {
+		// Ask the child to exit, and kill it if it does not in time
+		isolate->shared->command = ISOLATE_EXIT;
+		sem_post(&isolate->shared->request);
+
+		struct timespec deadline;
+		isolate_deadline(&deadline, ISOLATE_EXIT_NS);
+		while (sem_timedwait(&isolate->shared->response, &deadline) &&
+		       errno == EINTR) {}
+	}
+
+	int status = 0;
+	if (!isolate->reaped &&
+	    waitpid(isolate->pid, &status, WNOHANG) != isolate->pid) {
+		kill(isolate->pid, SIGKILL);
+		waitpid(isolate->pid, &status, 0);
+	}
+
+	isolate_free(isolate);
+}
+
+static const void*
+isolate_extension_data(const char* uri)
+{
+	(void)uri;
+	return NULL;
+}
+
+/** Return the size of the buffer for a port. */
+static size_t
+isolate_port_size(const LilvPlugin* plugin,
+                  uint32_t          index,
+                  uint32_t          types,
+                  uint32_t          max_block)
+{
+	if (types & (LILV_PORT_AUDIO | LILV_PORT_CV)) {
+		return max_block * sizeof(float);
+	} else if (types & LILV_PORT_CONTROL) {
+		return sizeof(float);
+	}
+
+	// Use the largest of the default and any minimum size
+	size_t          size     = ISOLATE_ATOM_BUFFER_SIZE;
+	LilvWorld*      world    = plugin->world;
+	const LilvPort* port     = lilv_plugin_get_port_by_index(plugin, index);
+	LilvNode*       min_size = lilv_node_new_from_node(
+		world, world->uris.rsz_minimumSize);
+	LilvNode*       value    = lilv_port_get(plugin, port, min_size);
+	if (value && lilv_node_is_int(value) &&
+	    (size_t)lilv_node_as_int(value) > size) {
+		size = (size_t)lilv_node_as_int(value);
+	}
+	lilv_node_free(value);
+	lilv_node_free(min_size);
+	return size;
+}
+
+#endif  /* LILV_ISOLATION */
+
+LILV_API LilvInstance*
+lilv_plugin_instantiate_isolated(const LilvPlugin*        plugin,
+                                 double                   sample_rate,
+                                 const LV2_Feature*const* features,
+                                 uint32_t                 max_block_length)
+{
+#ifdef LILV_ISOLATION
+	lilv_plugin_load_if_necessary(plugin);
+	if (plugin->parse_errors) {
+		return NULL;
+	}
+
+	const LilvPortTable* table   = lilv_plugin_get_port_table(plugin);
+	LilvIsolate*         isolate = (LilvIsolate*)calloc(1, sizeof(LilvIsolate));
+	isolate->n_ports   = table ? table->n_ports : 0;
+	isolate->ports     = (LilvIsolatePort*)calloc(
+		isolate->n_ports ? isolate->n_ports : 1, sizeof(LilvIsolatePort));
+	isolate->max_block = max_block_length;
+
+	// Lay out port buffers after the header, aligned for any type
+	size_t offset = ((sizeof(LilvIsolateShared) + isolate->n_ports + 63) &
+	                 ~(size_t)63);
+	for (uint32_t i = 0; i < isolate->n_ports; ++i) {
+		LilvIsolatePort* const port = &isolate->ports[i];
+		port->types  = table->types[i];
+		port->offset = offset;
+		port->size   = isolate_port_size(
+			plugin, i, port->types, max_block_length);
+		offset += (port->size + 63) & ~(size_t)63;
+	}
+
+	isolate->shared_size = offset;
+	isolate->shared      = (LilvIsolateShared*)mmap(
+		NULL, offset, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+		-1, 0);
+	if (isolate->shared == MAP_FAILED) {
+		LILV_ERRORF("Failed to map isolated instance buffers (%s)\n",
+		            strerror(errno));
+		free(isolate->ports);
+		free(isolate);
+		return NULL;
+	}
+
+	sem_init(&isolate->shared->request, 1, 0);
+	sem_init(&isolate->shared->response, 1, 0);
+
+	LV2_Descriptor* const d = &isolate->descriptor;
+	d->URI            = lilv_strdup(
+		lilv_node_as_uri(lilv_plugin_get_uri(plugin)));
+	d->connect_port   = isolate_connect_port;
+	d->activate       = isolate_activate;
+	d->run            = isolate_run;
+	d->deactivate     = isolate_deactivate;
+	d->cleanup        = isolate_cleanup;
+	d->extension_data = isolate_extension_data;
+
+	// Finish the preload thread, which would not exist in the child
+	lilv_world_finish_preload(plugin->world);
+
+	if ((isolate->pid = fork()) == 0) {
+		isolate_serve(isolate, plugin, sample_rate, features);
+	} else if (isolate->pid < 0) {
+		LILV_ERRORF("Failed to fork isolated instance (%s)\n",
+		            strerror(errno));
+	}
+
+	if (isolate->pid < 0) {
+		isolate_free(isolate);
+		return NULL;
+	} else if (isolate_call(isolate, ISOLATE_INSTANTIATE)) {
+		isolate_cleanup(isolate);
+		return NULL;
+	}
+
+	LilvInstance* instance   = (LilvInstance*)malloc(sizeof(LilvInstance));
+	instance->lv2_descriptor = d;
+	instance->lv2_handle     = isolate;
+	instance->pimpl          = NULL;
+	return instance;
+#else
+	LILV_ERROR("Isolated instances are not supported on this system\n");
+	return NULL;
+#endif
+}
+
+LILV_API bool
+lilv_instance_is_isolated(const LilvInstance* instance)
+{
+#ifdef LILV_ISOLATION
+	return instance->lv2_descriptor->cleanup == isolate_cleanup;
+#else
+	return false;
+#endif
+}
+
+LILV_API bool
+lilv_instance_has_crashed(const LilvInstance* instance)
+{
+#ifdef LILV_ISOLATION
+	return (lilv_instance_is_isolated(instance) &&
+	        ((const LilvIsolate*)instance->lv2_handle)->crashed);
+#else
+	return false;
+#endif
+}
@@ -14,24 +14,57 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include <string.h>
+
 #include "lilv_internal.h"
 
-LilvLib*
-lilv_lib_open(LilvWorld*               world,
-              const LilvNode*          uri,
-              const char*              bundle_path,
-              const LV2_Feature*const* features)
+/** A plugin descriptor in a library, indexed by URI. */
+typedef struct {
+	const char*           uri;
+	const LV2_Descriptor* descriptor;
+} LilvLibEntry;
+
+static uint32_t
+lilv_lib_entry_hash(const void* value)
+{
+	uint32_t h = 2166136261u;
+	for (const char* c = ((const LilvLibEntry*)value)->uri; *c; ++c) {
+		h = (h ^ (uint8_t)*c) * 16777619u;
+	}
+	return h;
+}
+
+static bool
+lilv_lib_entry_equal(const void* a, const void* b)
+{
+	return !strcmp(((const LilvLibEntry*)a)->uri,
+	               ((const LilvLibEntry*)b)->uri);
+}
+
+/** Find an open library and add a reference to it, the world must be locked. */
+static LilvLib*
+lilv_lib_find(LilvWorld* world, const LilvNode* uri, const char* bundle_path)
 {
 	ZixTreeIter*  i   = NULL;
 	const LilvLib key = {
-		world, (LilvNode*)uri, (char*)bundle_path, NULL, NULL, NULL, 0
+		world, (LilvNode*)uri, (char*)bundle_path, NULL, NULL, NULL, NULL, 0
 	};
 	if (!zix_tree_find(world->libs, &key, &i)) {
 		LilvLib* llib = (LilvLib*)zix_tree_get(i);
 		++llib->refs;
 		return llib;
 	}
+	return NULL;
+}
 
+/** Open a library and find its descriptor function, without the world lock. */
+static void*
+lilv_lib_load(const LilvNode*            uri,
+              const char*                bundle_path,
+              const LV2_Feature*const*   features,
+              LV2_Descriptor_Function*   df,
+              const LV2_Lib_Descriptor** desc)
+{
 	const char* const lib_uri  = lilv_node_as_uri(uri);
 	char* const       lib_path = lilv_file_uri_parse(lib_uri, NULL);
 	if (!lib_path) {
@@ -46,22 +79,21 @@ lilv_lib_open(LilvWorld*               world,
 		return NULL;
 	}
 
-	LV2_Descriptor_Function df = (LV2_Descriptor_Function)
-		lilv_dlfunc(lib, "lv2_descriptor");
+	*df = (LV2_Descriptor_Function)lilv_dlfunc(lib, "lv2_descriptor");
 
 	LV2_Lib_Descriptor_Function ldf = (LV2_Lib_Descriptor_Function)
 		lilv_dlfunc(lib, "lv2_lib_descriptor");
 
-	const LV2_Lib_Descriptor* desc = NULL;
+	*desc = NULL;
 	if (ldf) {
-		desc = ldf(bundle_path, features);
-		if (!desc) {
+		*desc = ldf(bundle_path, features);
+		if (!*desc) {
 			LILV_ERRORF("Call to %s:lv2_lib_descriptor failed\n", lib_path);
 			dlclose(lib);
 			lilv_free(lib_path);
 			return NULL;
 		}
-	} else if (!df) {
+	} else if (!*df) {
 		LILV_ERRORF("No `lv2_descriptor' or `lv2_lib_descriptor' in %s\n",
 		            lib_path);
 		dlclose(lib);
@@ -69,34 +101,98 @@ lilv_lib_open(LilvWorld*               world,
 		return NULL;
 	}
 	lilv_free(lib_path);
+	return lib;
+}
+
+/** Build an index of every plugin descriptor in a library by URI. */
+static ZixHash*
+lilv_lib_index(LV2_Descriptor_Function df, const LV2_Lib_Descriptor* desc)
+{
+	ZixHash* index = zix_hash_new(
+		lilv_lib_entry_hash, lilv_lib_entry_equal, sizeof(LilvLibEntry));
+
+	for (uint32_t i = 0; true; ++i) {
+		const LV2_Descriptor* ld = df ? df(i)
+		                              : desc->get_plugin(desc->handle, i);
+		if (!ld) {
+			break;
+		}
+
+		// Use the first descriptor if a library has several with this URI
+		const LilvLibEntry entry = { ld->URI, ld };
+		zix_hash_insert(index, &entry, NULL);
+	}
+
+	return index;
+}
 
-	LilvLib* llib = (LilvLib*)malloc(sizeof(LilvLib));
-	llib->world          = world;
-	llib->uri            = lilv_node_duplicate(uri);
-	llib->bundle_path    = lilv_strdup(bundle_path);
-	llib->lib            = lib;
-	llib->lv2_descriptor = df;
-	llib->desc           = desc;
-	llib->refs           = 1;
+LilvLib*
+lilv_lib_open(LilvWorld*               world,
+              const LilvNode*          uri,
+              const char*              bundle_path,
+              const LV2_Feature*const* features)
+{
+	lilv_world_lock(world);
+	LilvLib* llib = lilv_lib_find(world, uri, bundle_path);
+	lilv_world_unlock(world);
+	if (llib) {
+		return llib;
+	}
 
-	zix_tree_insert(world->libs, llib, NULL);
+	/* Open the library without holding the lock, since dlopen() may take a
+	   long time, and another thread may be instantiating another plugin. */
+	const uint64_t            begin = lilv_trace_begin(world);
+	LV2_Descriptor_Function   df    = NULL;
+	const LV2_Lib_Descriptor* desc  = NULL;
+	void* const lib = lilv_lib_load(uri, bundle_path, features, &df, &desc);
+	lilv_trace_end(world, LILV_TRACE_OPEN_LIBRARY, lilv_node_as_uri(uri),
+	               begin, 0);
+	if (!lib) {
+		return NULL;
+	}
+
+	ZixHash* const descriptors = lilv_lib_index(df, desc);
+
+	lilv_world_lock(world);
+	if ((llib = lilv_lib_find(world, uri, bundle_path))) {
+		// Another thread opened this library meanwhile, use that one
+		zix_hash_free(descriptors);
+		if (desc && desc->cleanup) {
+			desc->cleanup(desc->handle);
+		}
+		dlclose(lib);
+	} else {
+		llib = (LilvLib*)malloc(sizeof(LilvLib));
+		llib->world          = world;
+		llib->uri            = lilv_node_duplicate(uri);
+		llib->bundle_path    = lilv_strdup(bundle_path);
+		llib->lib            = lib;
+		llib->lv2_descriptor = df;
+		llib->desc           = desc;
+		llib->descriptors    = descriptors;
+		llib->refs           = 1;
+
+		zix_tree_insert(world->libs, llib, NULL);
+	}
+	lilv_world_unlock(world);
 	return llib;
 }
 
 const LV2_Descriptor*
-lilv_lib_get_plugin(LilvLib* lib, uint32_t index)
+lilv_lib_get_plugin_by_uri(LilvLib* lib, const char* uri)
 {
-	if (lib->lv2_descriptor) {
-		return lib->lv2_descriptor(index);
-	} else if (lib->desc) {
-		return lib->desc->get_plugin(lib->desc->handle, index);
-	}
-	return NULL;
+	const LilvLibEntry  key   = { uri, NULL };
+	const LilvLibEntry* entry = (const LilvLibEntry*)zix_hash_find(
+		lib->descriptors, &key);
+
+	return entry ? entry->descriptor : NULL;
 }
 
 void
 lilv_lib_close(LilvLib* lib)
 {
+	LilvWorld* world = lib->world;
+	lilv_world_lock(world);
 	if (--lib->refs == 0) {
 		dlclose(lib->lib);
 
@@ -105,8 +201,10 @@ lilv_lib_close(LilvLib* lib)
 			zix_tree_remove(lib->world->libs, i);
 		}
 
+		zix_hash_free(lib->descriptors);
 		lilv_node_free(lib->uri);
 		free(lib->bundle_path);
 		free(lib);
 	}
+	lilv_world_unlock(world);
 }
@@ -52,11 +52,37 @@ static inline const char* dlerror(void) { return "Unknown error"; }
 #include "serd/serd.h"
 #include "sord/sord.h"
 
+#include "zix/hash.h"
 #include "zix/tree.h"
 
 #include "lilv_config.h"
 #include "lilv/lilv.h"
 
+#ifdef HAVE_PTHREAD
+#    include <pthread.h>
+#endif
+
+/*
+  Atomic operations, which are plain operations without compiler support.
+  Data shared between threads with these must only be shared if LILV_ATOMICS
+  is defined, and be protected by a lock otherwise.
+*/
+#if defined(HAVE_PTHREAD) && defined(__GNUC__)
+#    define LILV_ATOMICS 1
+#    define ATOMIC_LOAD(p)         __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#    define ATOMIC_STORE(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#    define ATOMIC_ADD(p, v)       __atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL)
+#    define ATOMIC_SUB(p, v)       __atomic_fetch_sub((p), (v), __ATOMIC_ACQ_REL)
+#    define ATOMIC_CAS(p, e, v)    __atomic_compare_exchange_n( \
+		(p), (e), (v), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#else
+#    define ATOMIC_LOAD(p)         (*(p))
+#    define ATOMIC_STORE(p, v)     (*(p) = (v))
+#    define ATOMIC_ADD(p, v)       ((*(p) += (v)) - (v))
+#    define ATOMIC_SUB(p, v)       ((*(p) -= (v)) + (v))
+#    define ATOMIC_CAS(p, e, v)    (*(p) == *(e) ? (*(p) = (v), true) : false)
+#endif
+
 #ifdef LILV_DYN_MANIFEST
 #    include "lv2/lv2plug.in/ns/ext/dynmanifest/dynmanifest.h"
 #endif
@@ -69,6 +95,18 @@ static inline const char* dlerror(void) { return "Unknown error"; }
 
 typedef struct LilvSpecImpl LilvSpec;
 
+typedef struct LilvCacheImpl LilvCache;
+
+typedef struct LilvCacheEntryImpl LilvCacheEntry;
+
+typedef struct LilvQueryCacheImpl LilvQueryCache;
+
+typedef struct LilvLoadQueueImpl LilvLoadQueue;
+
+typedef union LilvNodeSlotImpl LilvNodeSlot;
+
+typedef struct LilvNodeSlabImpl LilvNodeSlab;
+
 typedef void LilvCollection;
 
 struct LilvPortImpl {
@@ -76,12 +114,15 @@ struct LilvPortImpl {
 	uint32_t   index;    ///< lv2:index
 	LilvNode*  symbol;   ///< lv2:symbol
 	LilvNodes* classes;  ///< rdf:type
+	LilvNode*  name;     ///< lv2:name in world language, or NULL
 };
 
 struct LilvSpecImpl {
 	SordNode*            spec;
 	SordNode*            bundle;
 	LilvNodes*           data_uris;
+	bool                 loaded;   ///< True if data_uris have been loaded
+	struct LilvSpecImpl* ns_next;  ///< Next spec with the same namespace
 	struct LilvSpecImpl* next;
 };
 
@@ -98,9 +139,12 @@ struct LilvHeader {
 #ifdef LILV_DYN_MANIFEST
 typedef struct {
 	LilvNode*               bundle;
-	void*                   lib;
+	char*                   lib_path;  ///< Path of dynamic manifest library
+	void*                   lib;       ///< Library, or NULL if not opened yet
 	LV2_Dyn_Manifest_Handle handle;
 	uint32_t                refs;
+	bool                    failed;    ///< True if opening the library failed
+	struct LilvDynLockImpl* lock;      ///< Shared by manifests of lib_path
 } LilvDynManifest;
 #endif
 
@@ -111,6 +155,7 @@ typedef struct {
 	void*                     lib;
 	LV2_Descriptor_Function   lv2_descriptor;
 	const LV2_Lib_Descriptor* desc;
+	ZixHash*                  descriptors;  ///< LilvLibEntry by plugin URI
 	uint32_t                  refs;
 } LilvLib;
 
@@ -124,18 +169,38 @@ struct LilvPluginImpl {
 #endif
 	const LilvPluginClass* plugin_class;
 	LilvNodes*             data_uris;  ///< rdfs::seeAlso
+	LilvNode*              name;       ///< doap:name in world language, or NULL
+	LilvLib*               lib;        ///< Preloaded library, or NULL
 	LilvPort**             ports;
 	uint32_t               num_ports;
+	LilvPortTable*         port_table;
+	LilvNode**             port_designations;   ///< First lv2:designation
+	uint32_t*              port_scale_points;   ///< Number of lv2:scalePoint
+	LilvScalePointInfo*    scale_point_infos;   ///< Numeric scale points
+	uint32_t*              scale_point_offsets; ///< First info of each port
+	uint32_t               latency_port;  ///< Latency port index, or UINT32_MAX
+	LilvUIs*               uis;         ///< Cached UIs, or NULL if none
+	unsigned               uis_version; ///< World bundles_version of uis
+	bool                   uis_loaded;  ///< True if uis has been loaded
+	bool                   scale_points_loaded;  ///< True if infos are built
+	bool                   many_designations;  ///< A port has several
 	bool                   loaded;
+	bool                   summarized;  ///< Summary loaded into plugin graph
 	bool                   parse_errors;
 	bool                   replaced;
 };
 
 struct LilvPluginClassImpl {
-	LilvWorld* world;
-	LilvNode*  uri;
-	LilvNode*  parent_uri;
-	LilvNode*  label;
+	LilvWorld*        world;
+	LilvNode*         uri;
+	LilvNode*         parent_uri;
+	LilvNode*         label;
+	LilvPluginClass*  parent;      ///< Parent class, or NULL if not loaded
+	LilvPluginClass** children;    ///< Child classes, sorted by URI
+	unsigned          n_children;
+	unsigned          depth;       ///< Number of ancestors
+	uint32_t          first;       ///< Preorder index of this class
+	uint32_t          last;        ///< Largest preorder index of a descendant
 };
 
 struct LilvInstancePimpl {
@@ -144,10 +209,24 @@ struct LilvInstancePimpl {
 };
 
 typedef struct {
-	bool dyn_manifest;
-	bool filter_language;
+	bool     dyn_manifest;
+	bool     filter_language;
+	unsigned load_threads;    ///< Manifest parsing threads, 0 or 1 for serial
+	char*    cache_path;      ///< Discovery cache file, or NULL
+	char*    lang;            ///< Language of translated values, or NULL
+	bool     copy_index;      ///< Keep a hash index of state file copies
+	bool     selective_load;  ///< Summarize plugins before a full load
+	bool     documentation;   ///< Load documentation predicates
 } LilvOptions;
 
+/** Memoized result of a LilvUISupportedFunc for a UI class in a container. */
+typedef struct {
+	LilvUISupportedFunc func;
+	LilvNode*           container_type;
+	LilvNode*           ui_type;
+	unsigned            quality;
+} LilvUIQuality;
+
 struct LilvWorldImpl {
 	SordWorld*         world;
 	SordModel*         model;
@@ -156,22 +235,64 @@ struct LilvWorldImpl {
 	LilvPluginClass*   lv2_plugin_class;
 	LilvPluginClasses* plugin_classes;
 	LilvSpec*          specs;
+	ZixHash*           spec_index;      ///< Specs by namespace
+	unsigned           n_unloaded_specs;
 	LilvPlugins*       plugins;
 	LilvPlugins*       zombies;
+	ZixHash*           plugin_index;  ///< Plugins by URI node
+	ZixHash*           class_index;   ///< Plugin classes by URI node
+	ZixHash*           bundle_index;  ///< Bundles by plugin URI node
+	LilvLoadQueue*     dyn_queue;     ///< Queue for dynamic manifests, or NULL
+	bool               frozen;        ///< True if read-only (shared)
+	unsigned           plugins_version;  ///< Incremented when plugins change
+	unsigned           bundles_version;  ///< Incremented when bundles change
+	unsigned           classes_version;  ///< bundles_version of plugin_classes
+	bool               classes_loaded;   ///< True if all classes are loaded
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t    mutex;         ///< Protects nodes and libs if frozen
+	pthread_t          preload_thread;
+	bool               preloading;    ///< True if preload_thread is running
+	const LV2_Feature*const* preload_features;  ///< For preload_thread
+#endif
 	LilvNodes*         loaded_files;
 	ZixTree*           libs;
+	LilvCache*         cache;
+	LilvQueryCache*    query_cache;  ///< Memoized queries, or NULL
+	LilvUIQuality*     ui_qualities;    ///< Memoized UI support
+	unsigned           n_ui_qualities;
+	ZixTree*           nodes;       ///< Interned nodes, by SordNode
+	LilvNodeSlab*      node_slabs;  ///< Storage for all nodes
+	LilvNodeSlot*      free_nodes;  ///< Unused node storage
+	LilvTraceFunc      trace_func;    ///< Called after traced spans, or NULL
+	void*              trace_handle;  ///< User data for trace_func
 	struct {
+		SordNode* atom_AtomPort;
+		SordNode* atom_supports;
 		SordNode* dc_replaces;
 		SordNode* dman_DynManifest;
+		SordNode* doap_maintainer;
 		SordNode* doap_name;
+		SordNode* ev_EventPort;
+		SordNode* ev_supportsEvent;
+		SordNode* foaf_homepage;
+		SordNode* foaf_mbox;
+		SordNode* foaf_name;
+		SordNode* lv2_AudioPort;
+		SordNode* lv2_CVPort;
+		SordNode* lv2_ControlPort;
+		SordNode* lv2_InputPort;
+		SordNode* lv2_OutputPort;
 		SordNode* lv2_Plugin;
 		SordNode* lv2_Specification;
 		SordNode* lv2_appliesTo;
 		SordNode* lv2_binary;
+		SordNode* lv2_connectionOptional;
 		SordNode* lv2_default;
 		SordNode* lv2_designation;
+		SordNode* lv2_enumeration;
 		SordNode* lv2_extensionData;
 		SordNode* lv2_index;
+		SordNode* lv2_integer;
 		SordNode* lv2_latency;
 		SordNode* lv2_maximum;
 		SordNode* lv2_microVersion;
@@ -183,9 +304,15 @@ struct LilvWorldImpl {
 		SordNode* lv2_portProperty;
 		SordNode* lv2_reportsLatency;
 		SordNode* lv2_requiredFeature;
+		SordNode* lv2_sampleRate;
+		SordNode* lv2_scalePoint;
 		SordNode* lv2_symbol;
+		SordNode* lv2_toggled;
+		SordNode* lv2_project;
 		SordNode* lv2_prototype;
 		SordNode* owl_Ontology;
+		SordNode* pset_Preset;
+		SordNode* pset_bank;
 		SordNode* pset_value;
 		SordNode* rdf_a;
 		SordNode* rdf_value;
@@ -193,6 +320,10 @@ struct LilvWorldImpl {
 		SordNode* rdfs_label;
 		SordNode* rdfs_seeAlso;
 		SordNode* rdfs_subClassOf;
+		SordNode* rsz_minimumSize;
+		SordNode* state_state;
+		SordNode* ui_binary;
+		SordNode* ui_ui;
 		SordNode* xsd_base64Binary;
 		SordNode* xsd_boolean;
 		SordNode* xsd_decimal;
@@ -200,6 +331,7 @@ struct LilvWorldImpl {
 		SordNode* xsd_integer;
 		SordNode* null_uri;
 	} uris;
+	SordNode*   documentation[9];  ///< Documentation predicates, NULL ended
 	LilvOptions opt;
 };
 
@@ -217,6 +349,8 @@ struct LilvNodeImpl {
 	LilvWorld*   world;
 	SordNode*    node;
 	LilvNodeType type;
+	unsigned     refs;      ///< Reference count, freed when zero
+	bool         interned;  ///< True if shared in world->nodes
 	union {
 		int   int_val;
 		float float_val;
@@ -237,6 +371,31 @@ struct LilvUIImpl {
 	LilvNodes* classes;
 };
 
+typedef struct {
+	const LV2_Descriptor* descriptor;
+	LV2_Handle            handle;
+	void (*run)(LV2_Handle instance, uint32_t sample_count);
+	LilvInstance*         instance;
+	uint32_t              index;  ///< Position in order of addition
+} LilvInstanceGroupEntry;
+
+struct LilvInstanceGroupImpl {
+	LilvInstanceGroupEntry* entries;  ///< Sorted by descriptor
+	uint32_t                n_entries;
+};
+
+/** A statement parsed from a data file, with all URIs expanded. */
+typedef struct {
+	SerdNode s;
+	SerdNode p;
+	SerdNode o;
+	SerdNode datatype;
+	SerdNode lang;
+} LilvStatement;
+
+/** Function called for each statement read from a cache entry. */
+typedef void (*LilvStatementSink)(void* handle, const LilvStatement* statement);
+
 typedef struct LilvVersion {
 	int minor;
 	int micro;
@@ -259,7 +418,11 @@ LilvPlugin* lilv_plugin_new(LilvWorld* world,
                             LilvNode*  bundle_uri);
 void        lilv_plugin_clear(LilvPlugin* plugin, LilvNode* bundle_uri);
 void        lilv_plugin_load_if_necessary(const LilvPlugin* p);
+unsigned    lilv_plugin_check(const LilvPlugin* plugin);
 void        lilv_plugin_free(LilvPlugin* plugin);
+void        lilv_plugin_clear_names(LilvPlugin* plugin);
+void        lilv_plugin_load_scale_points_if_necessary(const LilvPlugin* p);
+void        lilv_plugin_clear_scale_points(LilvPlugin* plugin);
 LilvNode*   lilv_plugin_get_unique(const LilvPlugin* p,
                                    const SordNode*   subject,
                                    const SordNode*   predicate);
@@ -270,6 +433,38 @@ LilvIter* lilv_collection_begin(const LilvCollection* collection);
 void*     lilv_collection_get(const LilvCollection* collection,
                               const LilvIter*       i);
 
+/**
+   Elements of a collection that is built all at once.
+
+   Most collections are never modified once they are built, so rather than
+   inserting elements into a tree one at a time, they are gathered here and
+   then made into a collection with a single allocation.
+*/
+typedef struct {
+	void** elems;      ///< Elements, initially local
+	size_t n_elems;    ///< Number of elements
+	size_t size;       ///< Allocated number of elements
+	void*  local[16];  ///< Storage for small collections
+} LilvArray;
+
+void lilv_array_init(LilvArray* array);
+void lilv_array_append(LilvArray* array, void* elem);
+
+/**
+   Make a collection from the elements of `array`, which is then cleared.
+
+   The elements are sorted by `cmp`, and duplicates are destroyed unless
+   `allow_duplicates` is true.
+*/
+LilvCollection* lilv_array_to_collection(LilvArray*     array,
+                                         bool           allow_duplicates,
+                                         ZixComparator  cmp,
+                                         ZixDestroyFunc destructor);
+
+LilvNodes*       lilv_array_to_nodes(LilvArray* array);
+LilvScalePoints* lilv_array_to_scale_points(LilvArray* array);
+LilvUIs*         lilv_array_to_uis(LilvArray* array);
+
 LilvPluginClass* lilv_plugin_class_new(LilvWorld*      world,
                                        const SordNode* parent_uri,
                                        const SordNode* uri,
@@ -277,15 +472,24 @@ LilvPluginClass* lilv_plugin_class_new(LilvWorld*      world,
 
 void lilv_plugin_class_free(LilvPluginClass* plugin_class);
 
+/** Build the hierarchy of all plugin classes in the world. */
+void lilv_world_index_plugin_classes(LilvWorld* world);
+
+/** Load plugin classes from all specifications, if bundles have changed. */
+void lilv_world_load_plugin_classes_if_necessary(LilvWorld* world);
+
 LilvLib*
 lilv_lib_open(LilvWorld*               world,
               const LilvNode*          uri,
               const char*              bundle_path,
               const LV2_Feature*const* features);
 
-const LV2_Descriptor* lilv_lib_get_plugin(LilvLib* lib, uint32_t index);
+const LV2_Descriptor* lilv_lib_get_plugin_by_uri(LilvLib* lib, const char* uri);
 void                  lilv_lib_close(LilvLib* lib);
 
+void lilv_world_lock(LilvWorld* world);
+void lilv_world_unlock(LilvWorld* world);
+
 LilvNodes*         lilv_nodes_new(void);
 LilvPlugins*       lilv_plugins_new(void);
 LilvScalePoints*   lilv_scale_points_new(void);
@@ -306,15 +510,82 @@ lilv_world_load_graph(LilvWorld*      world,
                       SordNode*       graph,
                       const LilvNode* uri);
 
+/** Create a reader that adds statements to `graph` in the world model. */
+SerdReader*
+lilv_world_new_reader(LilvWorld* world, SerdEnv* env, SordNode* graph);
+
+/** Return true iff statements with `predicate` are not added to the world. */
+bool lilv_world_skips(const LilvWorld* world, const SordNode* predicate);
+
+char*      lilv_cache_default_path(void);
+LilvCache* lilv_cache_new(const char* path);
+void       lilv_cache_free(LilvCache* cache);
+int        lilv_cache_save(LilvCache* cache);
+
+const LilvCacheEntry*
+lilv_cache_get(LilvCache* cache, const char* path, const char* key);
+
+void
+lilv_cache_set(LilvCache*           cache,
+               const char*          path,
+               const char*          key,
+               const LilvStatement* statements,
+               size_t               n_statements,
+               const char*          blank_prefix);
+
+void
+lilv_cache_read(const LilvCacheEntry* entry,
+                const char*           blank_prefix,
+                LilvStatementSink     sink,
+                void*                 handle);
+
+void
+lilv_cache_load(LilvWorld*            world,
+                const LilvCacheEntry* entry,
+                SordNode*             graph,
+                const char*           blank_prefix);
+
+void
+lilv_cache_remove_dir(LilvCache* cache, const char* dir);
+
+#ifdef LILV_DYN_MANIFEST
+LilvDynManifest*
+lilv_dyn_manifest_new(LilvWorld*      world,
+                      const SordNode* bundle,
+                      const char*     lib_path);
+
+void lilv_dyn_manifest_unref(LilvDynManifest* dman);
+
+/** Generate the subjects of a dynamic manifest, return a new string. */
+char* lilv_dyn_manifest_get_subjects(LilvDynManifest* dman);
+
+/** Generate the data for `uri` in a dynamic manifest, return a new string. */
+char* lilv_dyn_manifest_get_data(LilvDynManifest* dman, const char* uri);
+
+/** Load the data for `plugin` generated by `dman` into `graph`. */
+void
+lilv_world_load_dyn_data(LilvWorld*       world,
+                         LilvDynManifest* dman,
+                         const LilvNode*  plugin,
+                         const LilvNode*  graph);
+#endif
+
 LilvUI* lilv_ui_new(LilvWorld* world,
                     LilvNode*  uri,
                     LilvNode*  type_uri,
                     LilvNode*  binary_uri);
 
-void lilv_ui_free(LilvUI* ui);
+void    lilv_ui_free(LilvUI* ui);
+LilvUI* lilv_ui_duplicate(const LilvUI* ui);
+void    lilv_world_free_ui_qualities(LilvWorld* world);
 
 LilvNode* lilv_node_new(LilvWorld* world, LilvNodeType type, const char* val);
 LilvNode* lilv_node_new_from_node(LilvWorld* world, const SordNode* node);
+void      lilv_node_pool_init(LilvWorld* world);
+void      lilv_node_pool_free(LilvWorld* world);
+void      lilv_node_pool_count(const LilvWorld* world,
+                               size_t*          n_nodes,
+                               size_t*          n_bytes);
 
 int lilv_header_compare_by_uri(const void* a, const void* b, void* user_data);
 int lilv_lib_compare(const void* a, const void* b, void* user_data);
@@ -338,6 +609,14 @@ lilv_version_cmp(const LilvVersion* a, const LilvVersion* b)
 struct LilvHeader*
 lilv_collection_get_by_uri(const ZixTree* seq, const LilvNode* uri);
 
+ZixHash*           lilv_header_index_new(void);
+void               lilv_header_index_add(ZixHash*           index,
+                                         struct LilvHeader* header);
+void               lilv_header_index_remove(ZixHash*                 index,
+                                            const struct LilvHeader* header);
+struct LilvHeader* lilv_header_index_get(const ZixHash* index,
+                                         const LilvNode* uri);
+
 LilvScalePoint* lilv_scale_point_new(LilvNode* value, LilvNode* label);
 void            lilv_scale_point_free(LilvScalePoint* point);
 
@@ -359,6 +638,12 @@ lilv_world_find_nodes_internal(LilvWorld*      world,
                                const SordNode* predicate,
                                const SordNode* object);
 
+/** Return the string value of `predicate` in the world language, or NULL. */
+LilvNode*
+lilv_world_get_name(LilvWorld*      world,
+                    const SordNode* subject,
+                    const SordNode* predicate);
+
 SordModel*
 lilv_world_filter_model(LilvWorld*      world,
                         SordModel*      model,
@@ -393,6 +678,125 @@ int    lilv_mkdir_p(const char* path);
 char*  lilv_path_join(const char* a, const char* b);
 bool   lilv_file_equals(const char* a_path, const char* b_path);
 
+/** Return a monotonic time in nanoseconds, or 0 if unsupported. */
+uint64_t lilv_time_ns(void);
+
+/** Return the start time of a traced span, or 0 if tracing is disabled. */
+static inline uint64_t
+lilv_trace_begin(const LilvWorld* world)
+{
+	return world->trace_func ? lilv_time_ns() : 0;
+}
+
+/** Report a span that began at `begin` and ends now, if tracing is enabled. */
+void lilv_trace_end(LilvWorld*        world,
+                    LilvTraceSpanType type,
+                    const char*       uri,
+                    uint64_t          begin,
+                    size_t            n_statements);
+
+/** Report a span that was timed earlier, if tracing is enabled. */
+void lilv_trace_span(LilvWorld*        world,
+                     LilvTraceSpanType type,
+                     const char*       uri,
+                     uint64_t          begin,
+                     uint64_t          end,
+                     size_t            n_statements);
+
+/**
+   An index of the copies in a state copy directory.
+   This allows unchanged files to be reused without reading them, and files
+   with the same contents as an existing copy to share it.
+*/
+typedef struct LilvCopyIndexImpl LilvCopyIndex;
+
+/** Load the index of `copy_dir`, or return an empty one if there is none. */
+LilvCopyIndex* lilv_copy_index_new(const char* copy_dir);
+
+/** Save `index` to its copy directory if it has changed, and free it. */
+void lilv_copy_index_free(LilvCopyIndex* index);
+
+/**
+   Return the path of a copy of the file at `path`, making one if necessary.
+   A new copy is made at a free path based on `copy_path`.
+*/
+char* lilv_copy_index_get_copy(LilvCopyIndex* index,
+                               const char*    path,
+                               const char*    copy_path);
+
+/** Kind of query recorded in a query cache. */
+typedef enum {
+	LILV_QUERY_FIND,  ///< lilv_world_find_nodes_internal()
+	LILV_QUERY_ASK,   ///< lilv_world_ask_internal()
+	LILV_QUERY_GET    ///< lilv_world_get()
+} LilvQueryKind;
+
+/** The results of a query, for a pattern with NULL wildcards. */
+typedef struct {
+	LilvQueryKind kind;
+	SordNode*     s;
+	SordNode*     p;
+	SordNode*     o;
+	uint32_t      n_results;  ///< Number of results, or answer of an ask
+	SordNode**    results;    ///< Result nodes, or NULL for an ask
+} LilvQueryEntry;
+
+LilvQueryCache* lilv_query_cache_new(void);
+void lilv_query_cache_free(LilvQueryCache* cache, SordWorld* world);
+void lilv_query_cache_clear(LilvQueryCache* cache, SordWorld* world);
+
+/** Return the recorded results of a query, or NULL. */
+const LilvQueryEntry*
+lilv_query_cache_find(const LilvQueryCache* cache,
+                      LilvQueryKind         kind,
+                      const SordNode*       subject,
+                      const SordNode*       predicate,
+                      const SordNode*       object);
+
+/** Record the results of a query. */
+void
+lilv_query_cache_add(LilvQueryCache*        cache,
+                     SordWorld*             world,
+                     LilvQueryKind          kind,
+                     const SordNode*        subject,
+                     const SordNode*        predicate,
+                     const SordNode*        object,
+                     const SordNode* const* results,
+                     uint32_t               n_results);
+
+/** Discard memoized query results after the world model has changed. */
+void lilv_world_model_changed(LilvWorld* world);
+
+/** Remove every statement in `graph` from the world model. */
+int lilv_world_drop_graph(LilvWorld* world, const SordNode* graph);
+
+/** Wait for a background preload started earlier to finish. */
+void lilv_world_finish_preload(LilvWorld* world);
+
+/** Return the LV2 path from the environment, or the default. */
+const char* lilv_world_get_lv2_path(const LilvWorld* world);
+
+/** A growable byte buffer for building binary files. */
+typedef struct {
+	uint8_t* buf;   ///< Contents
+	size_t   len;   ///< Length of contents
+	size_t   size;  ///< Allocated size of buf
+} LilvBuffer;
+
+void lilv_buffer_append(LilvBuffer* buffer, const void* data, size_t len);
+void lilv_buffer_append_u32(LilvBuffer* buffer, uint32_t value);
+
+/** Read `len` bytes at `*ptr` and advance it, or return false if past end. */
+bool
+lilv_read_bytes(const uint8_t** ptr, const uint8_t* end, void* out, size_t len);
+
+/**
+   Return the contents of the file at `path`, or NULL on error or if empty.
+   The contents are memory-mapped if possible, `mapped` is set accordingly.
+*/
+uint8_t* lilv_file_map(const char* path, size_t* size, bool* mapped);
+void     lilv_file_unmap(uint8_t* data, size_t size, bool mapped);
+
 char*
 lilv_find_free_path(const char* in_path,
                     bool (*exists)(const char*, void*), void* user_data);
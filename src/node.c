@@ -44,81 +44,228 @@ lilv_node_set_numerics_from_string(LilvNode* val)
 	}
 }
 
+/** Storage for a node, or a link in the world's list of unused storage. */
+union LilvNodeSlotImpl {
+	LilvNode      node;
+	LilvNodeSlot* next;
+};
+
+#define LILV_NODE_SLAB_SIZE 256
+
+/** A block of node storage, allocated as a unit and freed with the world. */
+struct LilvNodeSlabImpl {
+	LilvNodeSlab* next;
+	LilvNodeSlot  slots[LILV_NODE_SLAB_SIZE];
+};
+
+static int
+lilv_node_pool_cmp(const void* a, const void* b, void* user_data)
+{
+	const SordNode* an = ((const LilvNode*)a)->node;
+	const SordNode* bn = ((const LilvNode*)b)->node;
+
+	return (an < bn) ? -1 : (an > bn) ? 1 : 0;
+}
+
+void
+lilv_node_pool_init(LilvWorld* world)
+{
+	world->nodes      = zix_tree_new(false, lilv_node_pool_cmp, NULL, NULL);
+	world->node_slabs = NULL;
+	world->free_nodes = NULL;
+}
+
+void
+lilv_node_pool_free(LilvWorld* world)
+{
+	zix_tree_free(world->nodes);
+	for (LilvNodeSlab* slab = world->node_slabs; slab;) {
+		LilvNodeSlab* next = slab->next;
+		free(slab);
+		slab = next;
+	}
+
+	world->nodes      = NULL;
+	world->node_slabs = NULL;
+	world->free_nodes = NULL;
+}
+
+/** Count the nodes in use, and the bytes allocated for all node storage. */
+void
+lilv_node_pool_count(const LilvWorld* world, size_t* n_nodes, size_t* n_bytes)
+{
+	size_t n_slots = 0;
+	for (const LilvNodeSlab* slab = world->node_slabs; slab; slab = slab->next) {
+		n_slots += LILV_NODE_SLAB_SIZE;
+		*n_bytes += sizeof(LilvNodeSlab);
+	}
+	for (const LilvNodeSlot* slot = world->free_nodes; slot; slot = slot->next) {
+		--n_slots;
+	}
+	*n_nodes = n_slots;
+}
+
+/** Allocate storage for a node from the world's pool. */
+static LilvNode*
+lilv_node_alloc(LilvWorld* world)
+{
+	if (!world->free_nodes) {
+		LilvNodeSlab* slab = (LilvNodeSlab*)malloc(sizeof(LilvNodeSlab));
+		for (unsigned i = 0; i < LILV_NODE_SLAB_SIZE - 1; ++i) {
+			slab->slots[i].next = &slab->slots[i + 1];
+		}
+		slab->slots[LILV_NODE_SLAB_SIZE - 1].next = NULL;
+		slab->next        = world->node_slabs;
+		world->node_slabs = slab;
+		world->free_nodes = &slab->slots[0];
+	}
+
+	LilvNodeSlot* slot = world->free_nodes;
+	world->free_nodes = slot->next;
+
+	LilvNode* val = &slot->node;
+	val->world    = world;
+	val->refs     = 1;
+	val->interned = false;
+	return val;
+}
+
+/**
+   Return the interned node for `node`, or NULL.
+   If a node is found, a new reference to it is returned.
+*/
+static LilvNode*
+lilv_node_pool_get(LilvWorld* world, const SordNode* node)
+{
+	LilvNode     key  = { world, (SordNode*)node, LILV_VALUE_URI, 0, false,
+	                      { 0 } };
+	ZixTreeIter* iter = NULL;
+	if (!zix_tree_find(world->nodes, &key, &iter)) {
+		LilvNode* val = (LilvNode*)zix_tree_get(iter);
+		++val->refs;
+		return val;
+	}
+	return NULL;
+}
+
+/**
+   Return the interned equivalent of the new node `val`.
+   If an equivalent node is already shared, `val` is freed.
+*/
+static LilvNode*
+lilv_node_intern(LilvWorld* world, LilvNode* val)
+{
+	LilvNode* shared = lilv_node_pool_get(world, val->node);
+	if (shared) {
+		lilv_node_free(val);
+		return shared;
+	}
+
+	val->interned = !zix_tree_insert(world->nodes, val, NULL);
+	return val;
+}
+
 /** Note that if `type` is numeric or boolean, the returned value is corrupt
  * until lilv_node_set_numerics_from_string is called.  It is not
  * automatically called from here to avoid overhead and imprecision when the
  * exact string value is known.
  */
-LilvNode*
-lilv_node_new(LilvWorld* world, LilvNodeType type, const char* str)
+static LilvNode*
+lilv_node_new_unique(LilvWorld* world, LilvNodeType type, const char* str)
 {
-	LilvNode* val = (LilvNode*)malloc(sizeof(LilvNode));
-	val->world = world;
-	val->type  = type;
-
+	SordNode*      node = NULL;
 	const uint8_t* ustr = (const uint8_t*)str;
 	switch (type) {
 	case LILV_VALUE_URI:
-		val->node = sord_new_uri(world->world, ustr);
+		node = sord_new_uri(world->world, ustr);
 		break;
 	case LILV_VALUE_BLANK:
-		val->node = sord_new_blank(world->world, ustr);
+		node = sord_new_blank(world->world, ustr);
 		break;
 	case LILV_VALUE_STRING:
-		val->node = sord_new_literal(world->world, NULL, ustr, NULL);
+		node = sord_new_literal(world->world, NULL, ustr, NULL);
 		break;
 	case LILV_VALUE_INT:
-		val->node = sord_new_literal(
+		node = sord_new_literal(
 			world->world, world->uris.xsd_integer, ustr, NULL);
 		break;
 	case LILV_VALUE_FLOAT:
-		val->node = sord_new_literal(
+		node = sord_new_literal(
 			world->world, world->uris.xsd_decimal, ustr, NULL);
 		break;
 	case LILV_VALUE_BOOL:
-		val->node = sord_new_literal(
+		node = sord_new_literal(
 			world->world, world->uris.xsd_boolean, ustr, NULL);
 		break;
 	case LILV_VALUE_BLOB:
-		val->node = sord_new_literal(
+		node = sord_new_literal(
 			world->world, world->uris.xsd_base64Binary, ustr, NULL);
 		break;
 	}
 
-	if (!val->node) {
-		free(val);
+	if (!node) {
 		return NULL;
 	}
 
+	LilvNode* val = lilv_node_alloc(world);
+	val->type = type;
+	val->node = node;
 	return val;
 }
 
-/** Create a new LilvNode from `node`, or return NULL if impossible */
-LilvNode*
-lilv_node_new_from_node(LilvWorld* world, const SordNode* node)
+static LilvNode*
+lilv_node_new_shared(LilvWorld* world, LilvNodeType type, const char* str)
 {
-	if (!node) {
-		return NULL;
+	switch (type) {
+	case LILV_VALUE_INT:
+	case LILV_VALUE_FLOAT:
+	case LILV_VALUE_BOOL:
+		return lilv_node_new_unique(world, type, str);
+	default:
+		break;
 	}
 
+	LilvNode* val = lilv_node_new_unique(world, type, str);
+	return val ? lilv_node_intern(world, val) : NULL;
+}
+
+/**
+   Create a new node, which is shared with other nodes of the same value.
+
+   Numeric and boolean nodes are not shared, since their value is set by the
+   caller (see lilv_node_new_unique()).
+*/
+LilvNode*
+lilv_node_new(LilvWorld* world, LilvNodeType type, const char* str)
+{
+	lilv_world_lock(world);
+	LilvNode* val = lilv_node_new_shared(world, type, str);
+	lilv_world_unlock(world);
+	return val;
+}
+
+static LilvNode*
+lilv_node_new_from_node_shared(LilvWorld* world, const SordNode* node)
+{
 	LilvNode*    result       = NULL;
 	SordNode*    datatype_uri = NULL;
 	LilvNodeType type         = LILV_VALUE_STRING;
 
 	switch (sord_node_get_type(node)) {
 	case SORD_URI:
-		result        = (LilvNode*)malloc(sizeof(LilvNode));
-		result->world = (LilvWorld*)world;
-		result->type  = LILV_VALUE_URI;
-		result->node  = sord_node_copy(node);
-		break;
 	case SORD_BLANK:
-		result        = (LilvNode*)malloc(sizeof(LilvNode));
-		result->world = (LilvWorld*)world;
-		result->type  = LILV_VALUE_BLANK;
-		result->node  = sord_node_copy(node);
+		if ((result = lilv_node_pool_get(world, node))) {
+			return result;
+		}
+		result       = lilv_node_alloc(world);
+		result->type = (sord_node_get_type(node) == SORD_URI
+		                ? LILV_VALUE_URI : LILV_VALUE_BLANK);
+		result->node = sord_node_copy(node);
 		break;
 	case SORD_LITERAL:
+		if ((result = lilv_node_pool_get(world, node))) {
+			return result;
+		}
 		datatype_uri = sord_node_get_datatype(node);
 		if (datatype_uri) {
 			if (sord_node_equals(datatype_uri, world->uris.xsd_boolean))
@@ -135,12 +282,33 @@ lilv_node_new_from_node(LilvWorld* world, const SordNode* node)
 				LILV_ERRORF("Unknown datatype `%s'\n",
 				            sord_node_get_string(datatype_uri));
 		}
-		result = lilv_node_new(
+		result = lilv_node_new_unique(
 			world, type, (const char*)sord_node_get_string(node));
-		lilv_node_set_numerics_from_string(result);
+		if (result) {
+			lilv_node_set_numerics_from_string(result);
+		}
 		break;
 	}
 
+	return result ? lilv_node_intern(world, result) : NULL;
+}
+
+/**
+   Create a new LilvNode from `node`, or return NULL if impossible.
+
+   The returned node is shared with every other node for the same value, so
+   repeated queries do not allocate or parse numeric literals again.
+*/
+LilvNode*
+lilv_node_new_from_node(LilvWorld* world, const SordNode* node)
+{
+	if (!node) {
+		return NULL;
+	}
+
+	lilv_world_lock(world);
+	LilvNode* result = lilv_node_new_from_node_shared(world, node);
+	lilv_world_unlock(world);
 	return result;
 }
 
@@ -205,21 +373,38 @@ lilv_node_duplicate(const LilvNode* val)
 		return NULL;
 	}
 
-	LilvNode* result = (LilvNode*)malloc(sizeof(LilvNode));
-	result->world = val->world;
-	result->node  = sord_node_copy(val->node);
-	result->val   = val->val;
-	result->type  = val->type;
+	// Nodes are immutable, so a duplicate is just another reference
+	LilvNode* result = (LilvNode*)val;
+	lilv_world_lock(result->world);
+	++result->refs;
+	lilv_world_unlock(result->world);
 	return result;
 }
 
 LILV_API void
 lilv_node_free(LilvNode* val)
 {
-	if (val) {
-		sord_node_free(val->world->world, val->node);
-		free(val);
+	if (!val) {
+		return;
+	}
+
+	LilvWorld* world = val->world;
+	lilv_world_lock(world);
+	if (--val->refs == 0) {
+		if (val->interned) {
+			ZixTreeIter* iter = NULL;
+			if (!zix_tree_find(world->nodes, val, &iter)) {
+				zix_tree_remove(world->nodes, iter);
+			}
+		}
+
+		sord_node_free(world->world, val->node);
+
+		LilvNodeSlot* slot = (LilvNodeSlot*)val;
+		slot->next        = world->free_nodes;
+		world->free_nodes = slot;
 	}
+	lilv_world_unlock(world);
 }
 
 LILV_API bool
@@ -27,26 +27,35 @@
 #include "lilv_config.h"
 #include "lilv_internal.h"
 
-#include "lv2/lv2plug.in/ns/extensions/ui/ui.h"
-
-#define NS_DOAP (const uint8_t*)"http://usefulinc.com/ns/doap#"
-#define NS_FOAF (const uint8_t*)"http://xmlns.com/foaf/0.1/"
-
 static void
 lilv_plugin_init(LilvPlugin* plugin, LilvNode* bundle_uri)
 {
-	plugin->bundle_uri   = bundle_uri;
-	plugin->binary_uri   = NULL;
+	plugin->bundle_uri          = bundle_uri;
+	plugin->binary_uri          = NULL;
 #ifdef LILV_DYN_MANIFEST
-	plugin->dynmanifest  = NULL;
+	plugin->dynmanifest         = NULL;
 #endif
-	plugin->plugin_class = NULL;
-	plugin->data_uris    = lilv_nodes_new();
-	plugin->ports        = NULL;
-	plugin->num_ports    = 0;
-	plugin->loaded       = false;
-	plugin->parse_errors = false;
-	plugin->replaced     = false;
+	plugin->plugin_class        = NULL;
+	plugin->data_uris           = lilv_nodes_new();
+	plugin->name                = NULL;
+	plugin->lib                 = NULL;
+	plugin->ports               = NULL;
+	plugin->num_ports           = 0;
+	plugin->port_table          = NULL;
+	plugin->port_designations   = NULL;
+	plugin->port_scale_points   = NULL;
+	plugin->scale_point_infos   = NULL;
+	plugin->scale_point_offsets = NULL;
+	plugin->latency_port        = UINT32_MAX;
+	plugin->uis                 = NULL;
+	plugin->uis_version         = 0;
+	plugin->uis_loaded          = false;
+	plugin->scale_points_loaded = false;
+	plugin->many_designations   = false;
+	plugin->loaded              = false;
+	plugin->summarized          = false;
+	plugin->parse_errors        = false;
+	plugin->replaced            = false;
 }
 
 /** Ownership of `uri` and `bundle` is taken */
@@ -68,6 +77,11 @@ lilv_plugin_clear(LilvPlugin* plugin, LilvNode* bundle_uri)
 	lilv_node_free(plugin->bundle_uri);
 	lilv_node_free(plugin->binary_uri);
 	lilv_nodes_free(plugin->data_uris);
+	lilv_node_free(plugin->name);
+	lilv_uis_free(plugin->uis);
+	if (plugin->lib) {
+		lilv_lib_close(plugin->lib);
+	}
 	lilv_plugin_init(plugin, bundle_uri);
 }
 
@@ -82,24 +96,28 @@ lilv_plugin_free_ports(LilvPlugin* p)
 		p->num_ports = 0;
 		p->ports     = NULL;
 	}
+
+	if (p->port_designations) {
+		for (uint32_t i = 0; i < p->port_table->n_ports; ++i) {
+			lilv_node_free(p->port_designations[i]);
+		}
+		free(p->port_designations);
+	}
+
+	free(p->port_table);
+	p->port_table        = NULL;
+	p->port_designations = NULL;
+	p->port_scale_points = NULL;
+	p->latency_port      = UINT32_MAX;
+	p->many_designations = false;
+	lilv_plugin_clear_scale_points(p);
 }
 
 void
 lilv_plugin_free(LilvPlugin* p)
 {
 #ifdef LILV_DYN_MANIFEST
-	if (p->dynmanifest && --p->dynmanifest->refs == 0) {
-		typedef int (*CloseFunc)(LV2_Dyn_Manifest_Handle);
-		CloseFunc close_func = (CloseFunc)lilv_dlfunc(p->dynmanifest->lib,
-		                                              "lv2_dyn_manifest_close");
-		if (close_func) {
-			close_func(p->dynmanifest->handle);
-		}
-
-		dlclose(p->dynmanifest->lib);
-		lilv_node_free(p->dynmanifest->bundle);
-		free(p->dynmanifest);
-	}
+	lilv_dyn_manifest_unref(p->dynmanifest);
 #endif
 
 	lilv_node_free(p->plugin_uri);
@@ -116,6 +134,17 @@ lilv_plugin_free(LilvPlugin* p)
 	lilv_nodes_free(p->data_uris);
 	p->data_uris = NULL;
 
+	lilv_node_free(p->name);
+	p->name = NULL;
+
+	lilv_uis_free(p->uis);
+	p->uis = NULL;
+
+	if (p->lib) {
+		lilv_lib_close(p->lib);
+		p->lib = NULL;
+	}
+
 	free(p);
 }
 
@@ -149,15 +178,80 @@ lilv_plugin_get_unique(const LilvPlugin* p,
 	return ret;
 }
 
+/** Point loaded ports at their nodes in the full description of the plugin. */
+static void
+lilv_plugin_relink_ports(LilvPlugin* p)
+{
+	SordIter* ports = lilv_world_query_internal(
+		p->world, p->plugin_uri->node, p->world->uris.lv2_port, NULL);
+	FOREACH_MATCH(ports) {
+		const SordNode* port  = sord_iter_get_node(ports, SORD_OBJECT);
+		LilvNode*       index = lilv_plugin_get_one(
+			p, port, p->world->uris.lv2_index);
+		if (lilv_node_is_int(index) && lilv_node_as_int(index) >= 0 &&
+		    (uint32_t)lilv_node_as_int(index) < p->num_ports) {
+			LilvPort* lport = p->ports[lilv_node_as_int(index)];
+			lilv_node_free(lport->node);
+			lport->node = lilv_node_new_from_node(p->world, port);
+		}
+		lilv_node_free(index);
+	}
+	sord_iter_free(ports);
+}
+
+/** Return true iff `a` and `b` share a data file. */
+static bool
+lilv_plugin_shares_data(const LilvPlugin* a, const LilvPlugin* b)
+{
+	LILV_FOREACH(nodes, i, a->data_uris) {
+		ZixTreeIter* iter;
+		if (!zix_tree_find((const ZixTree*)b->data_uris,
+		                   lilv_nodes_get(a->data_uris, i),
+		                   &iter)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void lilv_plugin_load(LilvPlugin* p);
+
+/** Finish the (full) load of a plugin which may have been summarized. */
+static void
+lilv_plugin_set_loaded(LilvPlugin* p)
+{
+	p->loaded = true;
+	if (p->summarized) {
+		p->summarized = false;
+		if (p->ports) {
+			lilv_plugin_relink_ports(p);
+		}
+	}
+
+	// Summaries from files that are now fully loaded would be duplicates
+	LILV_FOREACH(plugins, i, p->world->plugins) {
+		LilvPlugin* other = (LilvPlugin*)lilv_plugins_get(p->world->plugins, i);
+		if (other != p && other->summarized && !other->loaded &&
+		    lilv_plugin_shares_data(p, other)) {
+			lilv_plugin_load(other);
+		}
+	}
+}
+
 static void
 lilv_plugin_load(LilvPlugin* p)
 {
+	const uint64_t begin = lilv_trace_begin(p->world);
+	if (p->summarized) {
+		// Replace the summary with the full description
+		lilv_world_drop_graph(p->world, p->plugin_uri->node);
+	}
+
 	SordNode*       bundle_uri_node  = p->bundle_uri->node;
 	const SerdNode* bundle_uri_snode = sord_node_to_serd_node(bundle_uri_node);
 
 	SerdEnv*    env    = serd_env_new(bundle_uri_snode);
-	SerdReader* reader = sord_new_reader(p->world->model, env, SERD_TURTLE,
-	                                     bundle_uri_node);
+	SerdReader* reader = lilv_world_new_reader(p->world, env, bundle_uri_node);
 
 	SordModel* prots = lilv_world_filter_model(p->world,
 	                                           p->world->model,
@@ -186,6 +280,7 @@ lilv_plugin_load(LilvPlugin* p)
 	}
 	sord_iter_free(iter);
 
+	lilv_world_model_changed(p->world);
 	for (iter = sord_begin(skel); !sord_iter_end(iter); sord_iter_next(iter)) {
 		SordQuad quad;
 		sord_iter_get(iter, quad);
@@ -208,41 +303,210 @@ lilv_plugin_load(LilvPlugin* p)
 	}
 
 	if (st > SERD_FAILURE) {
-		p->loaded       = true;
 		p->parse_errors = true;
 		serd_reader_free(reader);
 		serd_env_free(env);
+		lilv_plugin_set_loaded(p);
+		lilv_trace_end(p->world, LILV_TRACE_LOAD_PLUGIN,
+		               lilv_node_as_uri(p->plugin_uri), begin, 0);
 		return;
 	}
 
+	serd_reader_free(reader);
+	serd_env_free(env);
+
 #ifdef LILV_DYN_MANIFEST
-	typedef void* LV2_Dyn_Manifest_Handle;
-	// Load and parse dynamic manifest data, if this is a library
+	// Load dynamic manifest data (from the cache if possible)
 	if (p->dynmanifest) {
-		typedef int (*GetDataFunc)(LV2_Dyn_Manifest_Handle handle,
-		                           FILE*                   fp,
-		                           const char*             uri);
-		GetDataFunc get_data_func = (GetDataFunc)lilv_dlfunc(
-			p->dynmanifest->lib, "lv2_dyn_manifest_get_data");
-		if (get_data_func) {
-			const SordNode* bundle = p->dynmanifest->bundle->node;
-			serd_env_set_base_uri(env, sord_node_to_serd_node(bundle));
-			FILE* fd = tmpfile();
-			get_data_func(p->dynmanifest->handle, fd,
-			              lilv_node_as_string(p->plugin_uri));
-			rewind(fd);
-			serd_reader_add_blank_prefix(
-				reader, lilv_world_blank_node_prefix(p->world));
-			serd_reader_read_file_handle(
-				reader, fd, (const uint8_t*)"(dyn-manifest)");
-			fclose(fd);
+		lilv_world_load_dyn_data(
+			p->world, p->dynmanifest, p->plugin_uri, p->bundle_uri);
+	}
+#endif
+
+	// Choose the name for the world language now, rather than on every call
+	lilv_node_free(p->name);
+	p->name = lilv_world_get_name(
+		p->world, p->plugin_uri->node, p->world->uris.doap_name);
+
+	lilv_plugin_set_loaded(p);
+	lilv_trace_end(p->world, LILV_TRACE_LOAD_PLUGIN,
+	               lilv_node_as_uri(p->plugin_uri), begin, 0);
+}
+
+/** State of reading the data files of a plugin into its summary. */
+typedef struct {
+	LilvPlugin* plugin;
+	SerdEnv*    env;      ///< Environment of the current file
+	SordNode**  ports;    ///< Ports of the plugin seen so far
+	size_t      n_ports;
+} LilvSummary;
+
+static SerdStatus
+summary_base(void* handle, const SerdNode* uri)
+{
+	return serd_env_set_base_uri(((LilvSummary*)handle)->env, uri);
+}
+
+static SerdStatus
+summary_prefix(void* handle, const SerdNode* name, const SerdNode* uri)
+{
+	return serd_env_set_prefix(((LilvSummary*)handle)->env, name, uri);
+}
+
+/** Add a statement to the summary if it is about the plugin or a port. */
+static SerdStatus
+summary_statement(void*              handle,
+                  SerdStatementFlags flags,
+                  const SerdNode*    graph,
+                  const SerdNode*    subject,
+                  const SerdNode*    predicate,
+                  const SerdNode*    object,
+                  const SerdNode*    object_datatype,
+                  const SerdNode*    object_lang)
+{
+	LilvSummary* const summary = (LilvSummary*)handle;
+	LilvWorld* const   world   = summary->plugin->world;
+	SordNode* const    plugin  = summary->plugin->plugin_uri->node;
+
+	SordNode* s = sord_node_from_serd_node(
+		world->world, summary->env, subject, NULL, NULL);
+	if (!s) {
+		return SERD_SUCCESS;
+	}
+
+	bool keep = sord_node_equals(s, plugin);
+	for (size_t i = 0; !keep && i < summary->n_ports; ++i) {
+		keep = sord_node_equals(s, summary->ports[i]);
+	}
+
+	if (keep) {
+		SordNode* p = sord_node_from_serd_node(
+			world->world, summary->env, predicate, NULL, NULL);
+		SordNode* o = sord_node_from_serd_node(
+			world->world, summary->env, object,
+			object_datatype, object_lang);
+
+		if (p && o && !lilv_world_skips(world, p)) {
+			SordQuad quad = { s, p, o, plugin };
+			sord_add(world->model, quad);
+
+			if (sord_node_equals(s, plugin) &&
+			    sord_node_equals(p, world->uris.lv2_port)) {
+				summary->ports = (SordNode**)realloc(
+					summary->ports,
+					(summary->n_ports + 1) * sizeof(SordNode*));
+				summary->ports[summary->n_ports++] = sord_node_copy(o);
+			}
 		}
+
+		sord_node_free(world->world, o);
+		sord_node_free(world->world, p);
+	}
+
+	sord_node_free(world->world, s);
+	return SERD_SUCCESS;
+}
+
+/**
+   Load a summary of the plugin from its data files.
+
+   Files are parsed in full, but only statements about the plugin and its
+   ports are kept, in a graph named by the plugin URI, so scale points,
+   presets, and everything else in the files cost no model memory.  Returns
+   false if the plugin can not be summarized and must be loaded fully.
+*/
+static bool
+lilv_plugin_load_summary(LilvPlugin* p)
+{
+	LilvWorld* const world = p->world;
+
+#ifdef LILV_DYN_MANIFEST
+	if (p->dynmanifest) {
+		return false;
 	}
 #endif
+	if (lilv_world_ask_internal(
+		    world, p->plugin_uri->node, world->uris.lv2_prototype, NULL)) {
+		return false;
+	}
+
+	const uint64_t begin   = lilv_trace_begin(world);
+	LilvSummary    summary = { p, NULL, NULL, 0 };
+	SerdReader*    reader  = serd_reader_new(
+		SERD_TURTLE, &summary, NULL,
+		summary_base, summary_prefix, summary_statement, NULL);
+
+	lilv_world_model_changed(world);
+
+	SerdStatus st = SERD_SUCCESS;
+	LILV_FOREACH(nodes, i, p->data_uris) {
+		const LilvNode* data_uri = lilv_nodes_get(p->data_uris, i);
+		ZixTreeIter*    iter;
+		if (!zix_tree_find((ZixTree*)world->loaded_files, data_uri, &iter)) {
+			continue;  // File is already in the model
+		}
+
+		const uint64_t file_begin = lilv_trace_begin(world);
+		const size_t   n_quads    = sord_num_quads(world->model);
+
+		summary.env = serd_env_new(sord_node_to_serd_node(data_uri->node));
+		serd_reader_add_blank_prefix(reader,
+		                             lilv_world_blank_node_prefix(world));
+		st = serd_reader_read_file(reader,
+		                           sord_node_get_string(data_uri->node));
+		serd_env_free(summary.env);
+		lilv_trace_end(world, LILV_TRACE_LOAD_FILE,
+		               lilv_node_as_string(data_uri), file_begin,
+		               sord_num_quads(world->model) - n_quads);
+		if (st > SERD_FAILURE) {
+			break;
+		}
+	}
 	serd_reader_free(reader);
-	serd_env_free(env);
 
-	p->loaded = true;
+	// Statements about a port before it is linked to the plugin are missed
+	bool complete = st <= SERD_FAILURE;
+	for (size_t i = 0; i < summary.n_ports; ++i) {
+		const SordNode* port = summary.ports[i];
+		complete = complete &&
+			lilv_world_ask_internal(
+				world, port, world->uris.lv2_index, NULL) &&
+			lilv_world_ask_internal(
+				world, port, world->uris.lv2_symbol, NULL);
+		sord_node_free(world->world, summary.ports[i]);
+	}
+	free(summary.ports);
+
+	if (!complete) {
+		lilv_world_drop_graph(world, p->plugin_uri->node);
+		lilv_trace_end(world, LILV_TRACE_LOAD_PLUGIN,
+		               lilv_node_as_uri(p->plugin_uri), begin, 0);
+		return false;
+	}
+
+	lilv_node_free(p->name);
+	p->name = lilv_world_get_name(
+		world, p->plugin_uri->node, world->uris.doap_name);
+
+	p->summarized = true;
+	lilv_trace_end(world, LILV_TRACE_LOAD_PLUGIN,
+	               lilv_node_as_uri(p->plugin_uri), begin, 0);
+	return true;
+}
+
+/**
+   Load enough of the plugin to describe it and its ports.
+   This is a full load unless LILV_OPTION_SELECTIVE_LOAD is enabled.
+*/
+static void
+lilv_plugin_load_summary_if_necessary(const LilvPlugin* const_p)
+{
+	LilvPlugin* p = (LilvPlugin*)const_p;
+	if (p->loaded || p->summarized) {
+		return;
+	} else if (!p->world->opt.selective_load || !lilv_plugin_load_summary(p)) {
+		lilv_plugin_load(p);
+	}
 }
 
 static bool
@@ -259,12 +523,152 @@ is_symbol(const char* str)
 	return true;
 }
 
+/** Return the numeric value of a literal, or NAN if it is not a number. */
+static float
+lilv_plugin_node_float(const LilvWorld* world, const SordNode* node)
+{
+	const SordNode* datatype = sord_node_get_datatype(node);
+	const char*     str      = (const char*)sord_node_get_string(node);
+	if (sord_node_get_type(node) != SORD_LITERAL || !datatype) {
+		return NAN;
+	} else if (sord_node_equals(datatype, world->uris.xsd_decimal) ||
+	           sord_node_equals(datatype, world->uris.xsd_double)) {
+		return (float)serd_strtod(str, NULL);
+	} else if (sord_node_equals(datatype, world->uris.xsd_integer)) {
+		return (float)strtol(str, NULL, 10);
+	}
+	return NAN;
+}
+
+/** Set `*value` to the numeric value of `node` if it has not been set. */
+static void
+lilv_plugin_set_port_float(const LilvWorld* world,
+                           const SordNode*  node,
+                           float*           value)
+{
+	if (isnan(*value)) {
+		*value = lilv_plugin_node_float(world, node);
+	}
+}
+
+/**
+   Build the port table from the (already loaded and valid) ports.
+
+   This makes a single pass over the description of each port, so the table
+   (and everything derived from it) costs one model search per port.
+*/
+static void
+lilv_plugin_load_port_table(LilvPlugin* p)
+{
+	LilvWorld*     world   = p->world;
+	const uint32_t n_ports = p->num_ports;
+
+	const SordNode* type_uris[] = { world->uris.lv2_InputPort,
+	                                world->uris.lv2_OutputPort,
+	                                world->uris.lv2_AudioPort,
+	                                world->uris.lv2_ControlPort,
+	                                world->uris.lv2_CVPort,
+	                                world->uris.atom_AtomPort,
+	                                world->uris.ev_EventPort,
+	                                NULL };
+
+	const SordNode* property_uris[] = { world->uris.lv2_connectionOptional,
+	                                    world->uris.lv2_integer,
+	                                    world->uris.lv2_enumeration,
+	                                    world->uris.lv2_toggled,
+	                                    world->uris.lv2_sampleRate,
+	                                    world->uris.lv2_reportsLatency,
+	                                    NULL };
+
+	// Allocate the table and all of its arrays in a single block
+	const size_t size = sizeof(LilvPortTable)
+		+ n_ports * (3 * sizeof(uint32_t) + 3 * sizeof(float));
+
+	LilvPortTable* table        = (LilvPortTable*)calloc(1, size);
+	uint32_t*      types        = (uint32_t*)(table + 1);
+	uint32_t*      properties   = types + n_ports;
+	uint32_t*      scale_points = properties + n_ports;
+	float*         min_values   = (float*)(scale_points + n_ports);
+	float*         max_values   = min_values + n_ports;
+	float*         def_values   = max_values + n_ports;
+	LilvNode**     designations = (LilvNode**)calloc(n_ports, sizeof(LilvNode*));
+	uint32_t       latency_designated = UINT32_MAX;
+
+	for (uint32_t i = 0; i < n_ports; ++i) {
+		const LilvPort* port = p->ports[i];
+
+		LILV_FOREACH(nodes, c, port->classes) {
+			const LilvNode* type = lilv_nodes_get(port->classes, c);
+			for (unsigned t = 0; type_uris[t]; ++t) {
+				if (sord_node_equals(type->node, type_uris[t])) {
+					types[i] |= (1u << t);
+				}
+			}
+		}
+
+		min_values[i] = max_values[i] = def_values[i] = NAN;
+
+		SordIter* stmts = lilv_world_query_internal(
+			world, port->node->node, NULL, NULL);
+		FOREACH_MATCH(stmts) {
+			const SordNode* pred = sord_iter_get_node(stmts, SORD_PREDICATE);
+			const SordNode* obj  = sord_iter_get_node(stmts, SORD_OBJECT);
+			if (sord_node_equals(pred, world->uris.lv2_portProperty)) {
+				for (unsigned t = 0; property_uris[t]; ++t) {
+					if (sord_node_equals(obj, property_uris[t])) {
+						properties[i] |= (1u << t);
+					}
+				}
+			} else if (sord_node_equals(pred, world->uris.lv2_minimum)) {
+				lilv_plugin_set_port_float(world, obj, &min_values[i]);
+			} else if (sord_node_equals(pred, world->uris.lv2_maximum)) {
+				lilv_plugin_set_port_float(world, obj, &max_values[i]);
+			} else if (sord_node_equals(pred, world->uris.lv2_default)) {
+				lilv_plugin_set_port_float(world, obj, &def_values[i]);
+			} else if (sord_node_equals(pred, world->uris.lv2_scalePoint)) {
+				++scale_points[i];
+			} else if (sord_node_equals(pred, world->uris.lv2_designation)) {
+				if (!designations[i]) {
+					designations[i] = lilv_node_new_from_node(world, obj);
+				} else {
+					p->many_designations = true;
+				}
+				if (sord_node_equals(obj, world->uris.lv2_latency) &&
+				    latency_designated == UINT32_MAX) {
+					latency_designated = i;
+				}
+			}
+		}
+		sord_iter_free(stmts);
+
+		if ((properties[i] & LILV_PORT_REPORTS_LATENCY) &&
+		    p->latency_port == UINT32_MAX) {
+			p->latency_port = i;
+		}
+	}
+
+	// Prefer lv2:reportsLatency, and fall back to the lv2:latency designation
+	if (p->latency_port == UINT32_MAX) {
+		p->latency_port = latency_designated;
+	}
+
+	table->n_ports       = n_ports;
+	table->types         = types;
+	table->properties    = properties;
+	table->min_values    = min_values;
+	table->max_values    = max_values;
+	table->def_values    = def_values;
+	p->port_table        = table;
+	p->port_designations = designations;
+	p->port_scale_points = scale_points;
+}
+
 static void
 lilv_plugin_load_ports_if_necessary(const LilvPlugin* const_p)
 {
 	LilvPlugin* p = (LilvPlugin*)const_p;
 
-	lilv_plugin_load_if_necessary(p);
+	lilv_plugin_load_summary_if_necessary(p);
 
 	if (!p->ports) {
 		p->ports = (LilvPort**)malloc(sizeof(LilvPort*));
@@ -339,6 +743,11 @@ lilv_plugin_load_ports_if_necessary(const LilvPlugin* const_p)
 			}
 			sord_iter_free(types);
 
+			if (!this_port->name) {
+				this_port->name = lilv_world_get_name(
+					p->world, port, p->world->uris.lv2_name);
+			}
+
 			lilv_node_free(symbol);
 			lilv_node_free(index);
 		}
@@ -353,6 +762,10 @@ lilv_plugin_load_ports_if_necessary(const LilvPlugin* const_p)
 				break;
 			}
 		}
+
+		if (p->ports) {
+			lilv_plugin_load_port_table(p);
+		}
 	}
 }
 
@@ -379,7 +792,7 @@ LILV_API const LilvNode*
 lilv_plugin_get_library_uri(const LilvPlugin* const_p)
 {
 	LilvPlugin* p = (LilvPlugin*)const_p;
-	lilv_plugin_load_if_necessary(p);
+	lilv_plugin_load_summary_if_necessary(p);
 	if (!p->binary_uri) {
 		// <plugin> lv2:binary ?binary
 		SordIter* i = lilv_world_query_internal(p->world,
@@ -412,8 +825,10 @@ LILV_API const LilvPluginClass*
 lilv_plugin_get_class(const LilvPlugin* const_p)
 {
 	LilvPlugin* p = (LilvPlugin*)const_p;
-	lilv_plugin_load_if_necessary(p);
+	lilv_plugin_load_summary_if_necessary(p);
 	if (!p->plugin_class) {
+		lilv_world_load_plugin_classes_if_necessary(p->world);
+
 		// <plugin> a ?class
 		SordIter* c = lilv_world_query_internal(p->world,
 		                                        p->plugin_uri->node,
@@ -456,53 +871,59 @@ lilv_plugin_get_value_internal(const LilvPlugin* p,
 		p->world, p->plugin_uri->node, predicate, NULL);
 }
 
-LILV_API bool
-lilv_plugin_verify(const LilvPlugin* plugin)
+unsigned
+lilv_plugin_check(const LilvPlugin* plugin)
 {
 	lilv_plugin_load_if_necessary(plugin);
 	if (plugin->parse_errors) {
-		return false;
+		return LILV_SCAN_PARSE_ERROR;
 	}
 
-	LilvNode*  rdf_type = lilv_new_uri(plugin->world, LILV_NS_RDF "type");
-	LilvNodes* results  = lilv_plugin_get_value(plugin, rdf_type);
-	lilv_node_free(rdf_type);
-	if (!results) {
-		return false;
+	LilvWorld* const       world  = plugin->world;
+	const SordNode* const  subj   = plugin->plugin_uri->node;
+	unsigned               errors = 0;
+	if (!lilv_world_ask_internal(world, subj, world->uris.rdf_a, NULL)) {
+		errors |= LILV_SCAN_NO_TYPE;
 	}
-
-	lilv_nodes_free(results);
-	results = lilv_plugin_get_value_internal(plugin,
-	                                         plugin->world->uris.doap_name);
-	if (!results) {
-		return false;
+	if (!lilv_world_ask_internal(world, subj, world->uris.doap_name, NULL)) {
+		errors |= LILV_SCAN_NO_NAME;
 	}
-
-	lilv_nodes_free(results);
-	LilvNode* lv2_port = lilv_new_uri(plugin->world, LV2_CORE__port);
-	results = lilv_plugin_get_value(plugin, lv2_port);
-	lilv_node_free(lv2_port);
-	if (!results) {
-		return false;
+	if (!lilv_world_ask_internal(world, subj, world->uris.lv2_port, NULL)) {
+		errors |= LILV_SCAN_NO_PORTS;
 	}
+	return errors;
+}
 
-	lilv_nodes_free(results);
-	return true;
+LILV_API bool
+lilv_plugin_verify(const LilvPlugin* plugin)
+{
+	return !lilv_plugin_check(plugin);
+}
+
+void
+lilv_plugin_clear_names(LilvPlugin* plugin)
+{
+	lilv_node_free(plugin->name);
+	plugin->name = NULL;
+	for (uint32_t i = 0; plugin->ports && i < plugin->num_ports; ++i) {
+		if (plugin->ports[i]) {
+			lilv_node_free(plugin->ports[i]->name);
+			plugin->ports[i]->name = NULL;
+		}
+	}
+	lilv_plugin_clear_scale_points(plugin);
 }
 
 LILV_API LilvNode*
 lilv_plugin_get_name(const LilvPlugin* plugin)
 {
-	LilvNodes* results = lilv_plugin_get_value_internal(
-		plugin, plugin->world->uris.doap_name);
+	lilv_plugin_load_summary_if_necessary(plugin);
 
-	LilvNode* ret = NULL;
-	if (results) {
-		LilvNode* val = lilv_nodes_get_first(results);
-		if (lilv_node_is_string(val))
-			ret = lilv_node_duplicate(val);
-		lilv_nodes_free(results);
-	}
+	LilvWorld* const world = plugin->world;
+	LilvNode*        ret   = plugin->name
+		? lilv_node_duplicate(plugin->name)
+		: lilv_world_get_name(world, plugin->plugin_uri->node,
+		                      world->uris.doap_name);
 
 	if (!ret)
 		LILV_WARNF("Plugin <%s> has no (mandatory) doap:name\n",
@@ -526,50 +947,70 @@ lilv_plugin_get_num_ports(const LilvPlugin* p)
 	return p->num_ports;
 }
 
+LILV_API const LilvPortTable*
+lilv_plugin_get_port_table(const LilvPlugin* p)
+{
+	lilv_plugin_load_ports_if_necessary(p);
+	return p->port_table;
+}
+
 LILV_API void
 lilv_plugin_get_port_ranges_float(const LilvPlugin* p,
                                   float*            min_values,
                                   float*            max_values,
                                   float*            def_values)
+{
+	const LilvPortMetadata metadata = {
+		min_values, max_values, def_values, NULL, NULL, NULL, NULL, NULL
+	};
+
+	lilv_plugin_get_port_metadata(p, &metadata);
+}
+
+LILV_API void
+lilv_plugin_get_port_metadata(const LilvPlugin*       p,
+                              const LilvPortMetadata* metadata)
 {
 	lilv_plugin_load_ports_if_necessary(p);
-	LilvNode*  min    = NULL;
-	LilvNode*  max    = NULL;
-	LilvNode*  def    = NULL;
-	LilvNode** minptr = min_values ? &min : NULL;
-	LilvNode** maxptr = max_values ? &max : NULL;
-	LilvNode** defptr = def_values ? &def : NULL;
 
-	for (uint32_t i = 0; i < p->num_ports; ++i) {
-		lilv_port_get_range(p, p->ports[i], defptr, minptr, maxptr);
+	const LilvPortTable* table = p->port_table;
+	if (!table) {
+		return;
+	}
 
-		if (min_values) {
-			if (lilv_node_is_float(min) || lilv_node_is_int(min)) {
-				min_values[i] = lilv_node_as_float(min);
-			} else {
-				min_values[i] = NAN;
-			}
-		}
+	const size_t n_ports = table->n_ports;
+	if (metadata->min_values) {
+		memcpy(metadata->min_values, table->min_values, n_ports * sizeof(float));
+	}
+	if (metadata->max_values) {
+		memcpy(metadata->max_values, table->max_values, n_ports * sizeof(float));
+	}
+	if (metadata->def_values) {
+		memcpy(metadata->def_values, table->def_values, n_ports * sizeof(float));
+	}
+	if (metadata->properties) {
+		memcpy(metadata->properties, table->properties,
+		       n_ports * sizeof(uint32_t));
+	}
+	if (metadata->n_scale_points) {
+		memcpy(metadata->n_scale_points, p->port_scale_points,
+		       n_ports * sizeof(uint32_t));
+	}
 
-		if (max_values) {
-			if (lilv_node_is_float(max) || lilv_node_is_int(max)) {
-				max_values[i] = lilv_node_as_float(max);
-			} else {
-				max_values[i] = NAN;
-			}
+	for (uint32_t i = 0; i < n_ports; ++i) {
+		const LilvNode* designation = p->port_designations[i];
+		if (metadata->symbols) {
+			metadata->symbols[i] = p->ports[i]->symbol;
 		}
-
-		if (def_values) {
-			if (lilv_node_is_float(def) || lilv_node_is_int(def)) {
-				def_values[i] = lilv_node_as_float(def);
-			} else {
-				def_values[i] = NAN;
-			}
+		if (metadata->designations) {
+			metadata->designations[i] = designation;
+		}
+		if (metadata->reports_latency) {
+			metadata->reports_latency[i] =
+				(table->properties[i] & LILV_PORT_REPORTS_LATENCY) ||
+				(designation &&
+				 sord_node_equals(designation->node, p->world->uris.lv2_latency));
 		}
-
-		lilv_node_free(def);
-		lilv_node_free(min);
-		lilv_node_free(max);
 	}
 }
 
@@ -629,61 +1070,8 @@ lilv_plugin_get_num_ports_of_class(const LilvPlugin* p,
 LILV_API bool
 lilv_plugin_has_latency(const LilvPlugin* p)
 {
-	lilv_plugin_load_if_necessary(p);
-	SordIter* ports = lilv_world_query_internal(
-		p->world,
-		p->plugin_uri->node,
-		p->world->uris.lv2_port,
-		NULL);
-
-	bool ret = false;
-	FOREACH_MATCH(ports) {
-		const SordNode* port = sord_iter_get_node(ports, SORD_OBJECT);
-		SordIter*       prop = lilv_world_query_internal(
-			p->world,
-			port,
-			p->world->uris.lv2_portProperty,
-			p->world->uris.lv2_reportsLatency);
-		SordIter* des = lilv_world_query_internal(
-			p->world,
-			port,
-			p->world->uris.lv2_designation,
-			p->world->uris.lv2_latency);
-		const bool latent = !sord_iter_end(prop) || !sord_iter_end(des);
-		sord_iter_free(prop);
-		sord_iter_free(des);
-		if (latent) {
-			ret = true;
-			break;
-		}
-	}
-	sord_iter_free(ports);
-
-	return ret;
-}
-
-static const LilvPort*
-lilv_plugin_get_port_by_property(const LilvPlugin* plugin,
-                                 const SordNode*   port_property)
-{
-	lilv_plugin_load_ports_if_necessary(plugin);
-	for (uint32_t i = 0; i < plugin->num_ports; ++i) {
-		LilvPort* port = plugin->ports[i];
-		SordIter* iter = lilv_world_query_internal(
-			plugin->world,
-			port->node->node,
-			plugin->world->uris.lv2_portProperty,
-			port_property);
-
-		const bool found = !sord_iter_end(iter);
-		sord_iter_free(iter);
-
-		if (found) {
-			return port;
-		}
-	}
-
-	return NULL;
+	lilv_plugin_load_ports_if_necessary(p);
+	return p->latency_port != UINT32_MAX;
 }
 
 LILV_API const LilvPort*
@@ -693,19 +1081,27 @@ lilv_plugin_get_port_by_designation(const LilvPlugin* plugin,
 {
 	LilvWorld* world = plugin->world;
 	lilv_plugin_load_ports_if_necessary(plugin);
+	if (!plugin->port_table) {
+		return NULL;
+	}
+
 	for (uint32_t i = 0; i < plugin->num_ports; ++i) {
-		LilvPort* port = plugin->ports[i];
-		SordIter* iter = lilv_world_query_internal(
-			world,
-			port->node->node,
-			world->uris.lv2_designation,
-			designation->node);
-
-		const bool found = !sord_iter_end(iter) &&
-			(!port_class || lilv_port_is_a(plugin, port, port_class));
-		sord_iter_free(iter);
-
-		if (found) {
+		LilvPort*       port  = plugin->ports[i];
+		const LilvNode* first = plugin->port_designations[i];
+		bool            found = first &&
+			sord_node_equals(first->node, designation->node);
+		if (!found && first && plugin->many_designations) {
+			// Only the first designation is cached, so search for others
+			SordIter* iter = lilv_world_query_internal(
+				world,
+				port->node->node,
+				world->uris.lv2_designation,
+				designation->node);
+			found = !sord_iter_end(iter);
+			sord_iter_free(iter);
+		}
+
+		if (found && (!port_class || lilv_port_is_a(plugin, port, port_class))) {
 			return port;
 		}
 	}
@@ -716,17 +1112,8 @@ lilv_plugin_get_port_by_designation(const LilvPlugin* plugin,
 LILV_API uint32_t
 lilv_plugin_get_latency_port_index(const LilvPlugin* p)
 {
-	const LilvPort* prop_port = lilv_plugin_get_port_by_property(
-		p, p->world->uris.lv2_reportsLatency);
-	const LilvPort* des_port = lilv_plugin_get_port_by_property(
-		p, p->world->uris.lv2_latency);
-	if (prop_port) {
-		return prop_port->index;
-	} else if (des_port) {
-		return des_port->index;
-	} else {
-		return (uint32_t)-1;
-	}
+	lilv_plugin_load_ports_if_necessary(p);
+	return p->latency_port;
 }
 
 LILV_API bool
@@ -832,16 +1219,11 @@ lilv_plugin_get_project(const LilvPlugin* p)
 {
 	lilv_plugin_load_if_necessary(p);
 
-	SordNode* lv2_project = sord_new_uri(p->world->world,
-	                                     (const uint8_t*)LV2_CORE__project);
-
 	SordIter* projects = lilv_world_query_internal(p->world,
 	                                               p->plugin_uri->node,
-	                                               lv2_project,
+	                                               p->world->uris.lv2_project,
 	                                               NULL);
 
-	sord_node_free(p->world->world, lv2_project);
-
 	if (sord_iter_end(projects)) {
 		sord_iter_free(projects);
 		return NULL;
@@ -858,8 +1240,7 @@ lilv_plugin_get_author(const LilvPlugin* p)
 {
 	lilv_plugin_load_if_necessary(p);
 
-	SordNode* doap_maintainer = sord_new_uri(
-		p->world->world, NS_DOAP "maintainer");
+	const SordNode* doap_maintainer = p->world->uris.doap_maintainer;
 
 	SordIter* maintainers = lilv_world_query_internal(
 		p->world,
@@ -872,7 +1253,6 @@ lilv_plugin_get_author(const LilvPlugin* p)
 
 		LilvNode* project = lilv_plugin_get_project(p);
 		if (!project) {
-			sord_node_free(p->world->world, doap_maintainer);
 			return NULL;
 		}
 
@@ -885,8 +1265,6 @@ lilv_plugin_get_author(const LilvPlugin* p)
 		lilv_node_free(project);
 	}
 
-	sord_node_free(p->world->world, doap_maintainer);
-
 	if (sord_iter_end(maintainers)) {
 		sord_iter_free(maintainers);
 		return NULL;
@@ -899,15 +1277,12 @@ lilv_plugin_get_author(const LilvPlugin* p)
 }
 
 static LilvNode*
-lilv_plugin_get_author_property(const LilvPlugin* plugin, const uint8_t* uri)
+lilv_plugin_get_author_property(const LilvPlugin* plugin,
+                                const SordNode*   pred)
 {
 	const SordNode* author = lilv_plugin_get_author(plugin);
 	if (author) {
-		SordWorld* sworld = plugin->world->world;
-		SordNode*  pred   = sord_new_uri(sworld, uri);
-		LilvNode*  ret    = lilv_plugin_get_one(plugin, author, pred);
-		sord_node_free(sworld, pred);
-		return ret;
+		return lilv_plugin_get_one(plugin, author, pred);
 	}
 	return NULL;
 }
@@ -915,19 +1290,22 @@ lilv_plugin_get_author_property(const LilvPlugin* plugin, const uint8_t* uri)
 LILV_API LilvNode*
 lilv_plugin_get_author_name(const LilvPlugin* plugin)
 {
-	return lilv_plugin_get_author_property(plugin, NS_FOAF "name");
+	return lilv_plugin_get_author_property(
+		plugin, plugin->world->uris.foaf_name);
 }
 
 LILV_API LilvNode*
 lilv_plugin_get_author_email(const LilvPlugin* plugin)
 {
-	return lilv_plugin_get_author_property(plugin, NS_FOAF "mbox");
+	return lilv_plugin_get_author_property(
+		plugin, plugin->world->uris.foaf_mbox);
 }
 
 LILV_API LilvNode*
 lilv_plugin_get_author_homepage(const LilvPlugin* plugin)
 {
-	return lilv_plugin_get_author_property(plugin, NS_FOAF "homepage");
+	return lilv_plugin_get_author_property(
+		plugin, plugin->world->uris.foaf_homepage);
 }
 
 LILV_API bool
@@ -936,18 +1314,17 @@ lilv_plugin_is_replaced(const LilvPlugin* plugin)
 	return plugin->replaced;
 }
 
-LILV_API LilvUIs*
-lilv_plugin_get_uis(const LilvPlugin* p)
+static LilvUIs*
+lilv_plugin_load_uis(const LilvPlugin* p)
 {
 	lilv_plugin_load_if_necessary(p);
 
-	SordNode* ui_ui_node = sord_new_uri(p->world->world,
-	                                    (const uint8_t*)LV2_UI__ui);
-	SordNode* ui_binary_node = sord_new_uri(p->world->world,
-	                                        (const uint8_t*)LV2_UI__binary);
+	const SordNode* ui_ui_node     = p->world->uris.ui_ui;
+	const SordNode* ui_binary_node = p->world->uris.ui_binary;
 
-	LilvUIs*  result = lilv_uis_new();
-	SordIter* uis    = lilv_world_query_internal(p->world,
+	LilvArray result;
+	lilv_array_init(&result);
+	SordIter* uis = lilv_world_query_internal(p->world,
 	                                             p->plugin_uri->node,
 	                                             ui_ui_node,
 	                                             NULL);
@@ -976,19 +1353,42 @@ lilv_plugin_get_uis(const LilvPlugin* p)
 			type,
 			binary);
 
-		zix_tree_insert((ZixTree*)result, lilv_ui, NULL);
+		lilv_array_append(&result, lilv_ui);
 	}
 	sord_iter_free(uis);
 
-	sord_node_free(p->world->world, ui_binary_node);
-	sord_node_free(p->world->world, ui_ui_node);
+	return result.n_elems > 0 ? lilv_array_to_uis(&result) : NULL;
+}
 
-	if (lilv_uis_size(result) > 0) {
-		return result;
-	} else {
-		lilv_uis_free(result);
+LILV_API const LilvUIs*
+lilv_plugin_get_shared_uis(const LilvPlugin* plugin)
+{
+	// Reload if bundles have changed, but never in a frozen (shared) world
+	LilvPlugin* p = (LilvPlugin*)plugin;
+	if (!p->world->frozen &&
+	    (!p->uis_loaded || p->uis_version != p->world->bundles_version)) {
+		lilv_uis_free(p->uis);
+		p->uis         = lilv_plugin_load_uis(plugin);
+		p->uis_version = p->world->bundles_version;
+		p->uis_loaded  = true;
+	}
+	return plugin->uis;
+}
+
+LILV_API LilvUIs*
+lilv_plugin_get_uis(const LilvPlugin* p)
+{
+	const LilvUIs* const uis = lilv_plugin_get_shared_uis(p);
+	if (!uis) {
 		return NULL;
 	}
+
+	LilvArray result;
+	lilv_array_init(&result);
+	LILV_FOREACH(uis, i, uis) {
+		lilv_array_append(&result, lilv_ui_duplicate(lilv_uis_get(uis, i)));
+	}
+	return lilv_array_to_uis(&result);
 }
 
 LILV_API LilvNodes*
@@ -1007,19 +1407,88 @@ lilv_plugin_get_related(const LilvPlugin* plugin, const LilvNode* type)
 		return related;
 	}
 
-	LilvNodes* matches = lilv_nodes_new();
+	LilvArray matches;
+	lilv_array_init(&matches);
 	LILV_FOREACH(nodes, i, related) {
 		LilvNode* node  = (LilvNode*)lilv_collection_get((ZixTree*)related, i);
 		if (lilv_world_ask_internal(
 			    world, node->node, world->uris.rdf_a, type->node)) {
-			zix_tree_insert((ZixTree*)matches,
-			                lilv_node_new_from_node(world, node->node),
-			                NULL);
+			lilv_array_append(&matches,
+			                  lilv_node_new_from_node(world, node->node));
 		}
 	}
 
 	lilv_nodes_free(related);
-	return matches;
+	return lilv_array_to_nodes(&matches);
+}
+
+/** Return the first value of `predicate` on `subject`, or NULL. */
+static LilvNode*
+lilv_world_get_first(LilvWorld*      world,
+                     const SordNode* subject,
+                     const SordNode* predicate)
+{
+	LilvNodes* values = lilv_world_find_nodes_internal(
+		world, subject, predicate, NULL);
+
+	LilvNode* ret = NULL;
+	if (values) {
+		ret = lilv_node_duplicate(lilv_nodes_get_first(values));
+		lilv_nodes_free(values);
+	}
+	return ret;
+}
+
+LILV_API LilvPresetInfo*
+lilv_plugin_get_presets(const LilvPlugin* plugin, unsigned* n_presets)
+{
+	lilv_plugin_load_if_necessary(plugin);
+
+	LilvWorld* const world   = plugin->world;
+	LilvNodes* const related = lilv_world_find_nodes_internal(
+		world,
+		NULL,
+		world->uris.lv2_appliesTo,
+		lilv_plugin_get_uri(plugin)->node);
+
+	LilvPresetInfo* presets = NULL;
+	unsigned        n       = 0;
+	LILV_FOREACH(nodes, i, related) {
+		const LilvNode* node = lilv_nodes_get(related, i);
+		if (!lilv_world_ask_internal(world,
+		                             node->node,
+		                             world->uris.rdf_a,
+		                             world->uris.pset_Preset)) {
+			continue;
+		}
+
+		presets = (LilvPresetInfo*)realloc(
+			presets, (n + 1) * sizeof(LilvPresetInfo));
+
+		LilvPresetInfo* const preset = &presets[n++];
+		preset->uri    = lilv_node_duplicate(node);
+		preset->plugin = lilv_node_duplicate(lilv_plugin_get_uri(plugin));
+		preset->label  = lilv_world_get_first(
+			world, node->node, world->uris.rdfs_label);
+		preset->bank   = lilv_world_get_first(
+			world, node->node, world->uris.pset_bank);
+	}
+
+	lilv_nodes_free(related);
+	*n_presets = n;
+	return presets;
+}
+
+LILV_API void
+lilv_preset_infos_free(LilvPresetInfo* presets, unsigned n_presets)
+{
+	for (unsigned i = 0; i < n_presets; ++i) {
+		lilv_node_free(presets[i].uri);
+		lilv_node_free(presets[i].plugin);
+		lilv_node_free(presets[i].label);
+		lilv_node_free(presets[i].bank);
+	}
+	free(presets);
 }
 
 static SerdEnv*
@@ -32,6 +32,12 @@ lilv_plugin_class_new(LilvWorld*      world,
 	pc->parent_uri = (parent_node
 	                  ? lilv_node_new_from_node(world, parent_node)
 	                  : NULL);
+	pc->parent     = NULL;
+	pc->children   = NULL;
+	pc->n_children = 0;
+	pc->depth      = 0;
+	pc->first      = 0;
+	pc->last       = 0;
 	return pc;
 }
 
@@ -45,6 +51,7 @@ lilv_plugin_class_free(LilvPluginClass* plugin_class)
 	lilv_node_free(plugin_class->uri);
 	lilv_node_free(plugin_class->parent_uri);
 	lilv_node_free(plugin_class->label);
+	free(plugin_class->children);
 	free(plugin_class);
 }
 
@@ -70,18 +77,116 @@ LILV_API LilvPluginClasses*
 lilv_plugin_class_get_children(const LilvPluginClass* plugin_class)
 {
 	// Returned list doesn't own categories
-	LilvPluginClasses* all    = plugin_class->world->plugin_classes;
-	LilvPluginClasses* result = zix_tree_new(false, lilv_ptr_cmp, NULL, NULL);
-
-	for (ZixTreeIter* i = zix_tree_begin((ZixTree*)all);
-	     i != zix_tree_end((ZixTree*)all);
-	     i = zix_tree_iter_next(i)) {
-		const LilvPluginClass* c      = (LilvPluginClass*)zix_tree_get(i);
-		const LilvNode*        parent = lilv_plugin_class_get_parent_uri(c);
-		if (parent && lilv_node_equals(lilv_plugin_class_get_uri(plugin_class),
-		                               parent))
-			zix_tree_insert((ZixTree*)result, (LilvPluginClass*)c, NULL);
+	LilvArray result;
+	lilv_array_init(&result);
+	for (unsigned i = 0; i < plugin_class->n_children; ++i) {
+		lilv_array_append(&result, plugin_class->children[i]);
 	}
 
-	return result;
+	return lilv_array_to_collection(&result, false, lilv_ptr_cmp, NULL);
+}
+
+LILV_API bool
+lilv_plugin_class_is_subclass_of(const LilvPluginClass* plugin_class,
+                                 const LilvPluginClass* ancestor)
+{
+	return (plugin_class->first >= ancestor->first &&
+	        plugin_class->first <= ancestor->last);
+}
+
+LILV_API unsigned
+lilv_plugin_class_get_depth(const LilvPluginClass* plugin_class)
+{
+	return plugin_class->depth;
+}
+
+static void
+lilv_plugin_class_reset(LilvPluginClass* plugin_class)
+{
+	free(plugin_class->children);
+	plugin_class->parent     = NULL;
+	plugin_class->children   = NULL;
+	plugin_class->n_children = 0;
+	plugin_class->depth      = 0;
+	plugin_class->first      = UINT32_MAX;
+	plugin_class->last       = UINT32_MAX;
+}
+
+/** Number the classes in the subtree at `plugin_class` in preorder. */
+static uint32_t
+lilv_plugin_class_number(LilvPluginClass* plugin_class,
+                         unsigned         depth,
+                         uint32_t         next)
+{
+	plugin_class->depth = depth;
+	plugin_class->first = next++;
+	for (unsigned i = 0; i < plugin_class->n_children; ++i) {
+		next = lilv_plugin_class_number(
+			plugin_class->children[i], depth + 1, next);
+	}
+	plugin_class->last = next - 1;
+	return next;
+}
+
+/**
+   Link every class to its parent and children, and number them so that the
+   descendants of a class are exactly the classes numbered from its `first`
+   to its `last`.  Classes only have one parent, so this is a forest rooted at
+   lv2:Plugin and any classes whose parent is not loaded.  Classes in a
+   subclass cycle are not reachable from any root, so are left alone.
+*/
+void
+lilv_world_index_plugin_classes(LilvWorld* world)
+{
+	LilvPluginClass* const   root    = world->lv2_plugin_class;
+	LilvPluginClasses* const classes = world->plugin_classes;
+
+	lilv_plugin_class_reset(root);
+	LILV_FOREACH(plugin_classes, i, classes) {
+		lilv_plugin_class_reset(
+			(LilvPluginClass*)lilv_plugin_classes_get(classes, i));
+	}
+
+	// Link classes, in URI order so children are sorted
+	LILV_FOREACH(plugin_classes, i, classes) {
+		LilvPluginClass* c = (LilvPluginClass*)lilv_plugin_classes_get(
+			classes, i);
+		LilvPluginClass* parent = NULL;
+		if (!c->parent_uri) {
+			continue;
+		} else if (lilv_node_equals(c->parent_uri, root->uri)) {
+			parent = root;
+		} else {
+			parent = (LilvPluginClass*)lilv_header_index_get(
+				world->class_index, c->parent_uri);
+		}
+
+		if (parent && parent != c) {
+			LilvPluginClass** children = (LilvPluginClass**)realloc(
+				parent->children,
+				(parent->n_children + 1) * sizeof(LilvPluginClass*));
+			if (children) {
+				parent->children = children;
+				parent->children[parent->n_children++] = c;
+				c->parent = parent;
+			}
+		}
+	}
+
+	// Number every tree, then classes in cycles on their own
+	uint32_t next = lilv_plugin_class_number(root, 0, 0);
+	LILV_FOREACH(plugin_classes, i, classes) {
+		LilvPluginClass* c = (LilvPluginClass*)lilv_plugin_classes_get(
+			classes, i);
+		if (!c->parent) {
+			next = lilv_plugin_class_number(c, 0, next);
+		}
+	}
+	LILV_FOREACH(plugin_classes, i, classes) {
+		LilvPluginClass* c = (LilvPluginClass*)lilv_plugin_classes_get(
+			classes, i);
+		if (c->first == UINT32_MAX) {
+			c->first = c->last = next++;
+		}
+	}
 }
@@ -0,0 +1,338 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lilv_internal.h"
+
+#ifdef LILV_ATOMICS
+#    define LILV_POOL_THREAD 1
+#    include <semaphore.h>
+#elif defined(HAVE_PTHREAD)
+#    define LILV_POOL_LOCK 1
+#endif
+
+/*
+  Instances are kept on two lock-free stacks.  New and recycled instances are
+  pushed onto the ready stack by the worker, and popped by the thread that
+  takes instances.  Returned instances are pushed onto the returned stack by
+  the thread that returns them, and the worker takes the whole stack at once.
+  Each stack has a single popper, so neither suffers from the ABA problem.
+
+  Without atomic operations, the stacks are protected by a mutex instead,
+  since the host may still take and refill from different threads.
+
+  Pooled instances are reallocated with a link after the LilvInstance, so they
+  can still be freed with lilv_instance_free() once they leave the pool.
+*/
+
+typedef struct LilvPoolEntryImpl {
+	LilvInstance              instance;  ///< Must be first
+	struct LilvPoolEntryImpl* next;      ///< Next entry in stack
+} LilvPoolEntry;
+
+struct LilvInstancePoolImpl {
+	const LilvPlugin*        plugin;
+	double                   sample_rate;
+	const LV2_Feature*const* features;
+	const LilvState*         state;     ///< State to reset instances, or NULL
+	uint32_t                 size;      ///< Number of instances to keep ready
+	uint32_t                 n_ready;   ///< Number of instances in ready
+	LilvPoolEntry*           ready;     ///< Stack of instances to take
+	LilvPoolEntry*           returned;  ///< Stack of returned instances
+#ifdef LILV_POOL_THREAD
+	pthread_t                thread;
+	sem_t                    wake;
+	bool                     threaded;  ///< True if thread is running
+	bool                     exit;
+#endif
+#ifdef LILV_POOL_LOCK
+	pthread_mutex_t          mutex;     ///< Protects stacks and n_ready
+#endif
+};
+
+static void
+lilv_pool_lock(const LilvInstancePool* pool)
+{
+#ifdef LILV_POOL_LOCK
+	pthread_mutex_lock(&((LilvInstancePool*)pool)->mutex);
+#else
+	(void)pool;
+#endif
+}
+
+static void
+lilv_pool_unlock(const LilvInstancePool* pool)
+{
+#ifdef LILV_POOL_LOCK
+	pthread_mutex_unlock(&((LilvInstancePool*)pool)->mutex);
+#else
+	(void)pool;
+#endif
+}
+
+/** Return the number of ready instances. */
+static uint32_t
+lilv_pool_num_ready(const LilvInstancePool* pool)
+{
+	lilv_pool_lock(pool);
+	const uint32_t n_ready = ATOMIC_LOAD(&pool->n_ready);
+	lilv_pool_unlock(pool);
+	return n_ready;
+}
+
+static void
+lilv_pool_push(LilvPoolEntry** stack, LilvPoolEntry* entry)
+{
+	LilvPoolEntry* head = ATOMIC_LOAD(stack);
+	do {
+		entry->next = head;
+	} while (!ATOMIC_CAS(stack, &head, entry));
+}
+
+/** Pop the top of a stack, which must only be done by one thread. */
+static LilvPoolEntry*
+lilv_pool_pop(LilvPoolEntry** stack)
+{
+	LilvPoolEntry* head = ATOMIC_LOAD(stack);
+	while (head && !ATOMIC_CAS(stack, &head, head->next)) {}
+	return head;
+}
+
+/** Take every entry of a stack at once. */
+static LilvPoolEntry*
+lilv_pool_pop_all(LilvPoolEntry** stack)
+{
+	LilvPoolEntry* head = ATOMIC_LOAD(stack);
+	while (head && !ATOMIC_CAS(stack, &head, (LilvPoolEntry*)NULL)) {}
+	return head;
+}
+
+static void
+lilv_pool_free_all(LilvPoolEntry* entry)
+{
+	while (entry) {
+		LilvPoolEntry* next = entry->next;
+		lilv_instance_free(&entry->instance);
+		entry = next;
+	}
+}
+
+static LilvPoolEntry*
+lilv_pool_entry_new(LilvInstancePool* pool)
+{
+	LilvInstance* instance = lilv_plugin_instantiate(
+		pool->plugin, pool->sample_rate, pool->features);
+	if (!instance) {
+		return NULL;
+	}
+
+	LilvPoolEntry* entry = (LilvPoolEntry*)realloc(
+		instance, sizeof(LilvPoolEntry));
+	if (!entry) {
+		lilv_instance_free(instance);
+	}
+	return entry;
+}
+
+static void
+lilv_pool_push_ready(LilvInstancePool* pool, LilvPoolEntry* entry)
+{
+	lilv_pool_lock(pool);
+	lilv_pool_push(&pool->ready, entry);
+	(void)ATOMIC_ADD(&pool->n_ready, 1);
+	lilv_pool_unlock(pool);
+}
+
+static bool
+lilv_pool_exiting(LilvInstancePool* pool)
+{
+#ifdef LILV_POOL_THREAD
+	return ATOMIC_LOAD(&pool->exit);
+#else
+	return false;
+#endif
+}
+
+/** Connect every port of a recycled instance to NULL, as when it was new. */
+static void
+lilv_pool_disconnect(LilvInstancePool* pool, LilvInstance* instance)
+{
+	const uint32_t n_ports = lilv_plugin_get_num_ports(pool->plugin);
+	for (uint32_t i = 0; i < n_ports; ++i) {
+		instance->lv2_descriptor->connect_port(instance->lv2_handle, i, NULL);
+	}
+}
+
+/** Recycle or free returned instances, then create any that are missing. */
+static void
+lilv_pool_work(LilvInstancePool* pool)
+{
+	lilv_pool_lock(pool);
+	LilvPoolEntry* entry = lilv_pool_pop_all(&pool->returned);
+	lilv_pool_unlock(pool);
+	while (entry) {
+		LilvPoolEntry* next = entry->next;
+		if (pool->state && lilv_pool_num_ready(pool) < pool->size) {
+			lilv_state_restore(pool->state, &entry->instance,
+			                   NULL, NULL, 0, pool->features);
+			lilv_pool_disconnect(pool, &entry->instance);
+			lilv_pool_push_ready(pool, entry);
+		} else {
+			lilv_instance_free(&entry->instance);
+		}
+		entry = next;
+	}
+
+	while (lilv_pool_num_ready(pool) < pool->size &&
+	       !lilv_pool_exiting(pool)) {
+		if (!(entry = lilv_pool_entry_new(pool))) {
+			LILV_ERRORF("Failed to instantiate <%s> for pool\n",
+			            lilv_node_as_uri(lilv_plugin_get_uri(pool->plugin)));
+			break;
+		}
+		lilv_pool_push_ready(pool, entry);
+	}
+}
+
+#ifdef LILV_POOL_THREAD
+static void*
+lilv_pool_worker(void* data)
+{
+	LilvInstancePool* pool = (LilvInstancePool*)data;
+	while (!ATOMIC_LOAD(&pool->exit)) {
+		lilv_pool_work(pool);
+		while (sem_wait(&pool->wake) && errno == EINTR) {}
+	}
+	return NULL;
+}
+#endif
+
+/** Wake the worker, or return false if there is none. */
+static bool
+lilv_pool_wake(LilvInstancePool* pool)
+{
+#ifdef LILV_POOL_THREAD
+	if (pool->threaded) {
+		sem_post(&pool->wake);
+		return true;
+	}
+#endif
+	return false;
+}
+
+LILV_API LilvInstancePool*
+lilv_instance_pool_new(const LilvPlugin*        plugin,
+                       double                   sample_rate,
+                       const LV2_Feature*const* features,
+                       uint32_t                 size,
+                       const LilvState*         state)
+{
+	LilvInstancePool* pool = (LilvInstancePool*)calloc(
+		1, sizeof(LilvInstancePool));
+	pool->plugin      = plugin;
+	pool->sample_rate = sample_rate;
+	pool->features    = features;
+	pool->state       = state;
+	pool->size        = size;
+#ifdef LILV_POOL_LOCK
+	pthread_mutex_init(&pool->mutex, NULL);
+#endif
+
+#ifdef LILV_POOL_THREAD
+	// Instances may only be created on another thread if the world is frozen
+	if (plugin->world->frozen) {
+		sem_init(&pool->wake, 0, 0);
+		if (pthread_create(&pool->thread, NULL, lilv_pool_worker, pool)) {
+			LILV_WARN("Failed to create pool thread\n");
+			sem_destroy(&pool->wake);
+		} else {
+			pool->threaded = true;
+		}
+	}
+#endif
+
+	if (!lilv_pool_wake(pool)) {
+		lilv_pool_work(pool);
+	}
+	return pool;
+}
+
+LILV_API void
+lilv_instance_pool_free(LilvInstancePool* pool)
+{
+	if (!pool) {
+		return;
+	}
+
+#ifdef LILV_POOL_THREAD
+	if (pool->threaded) {
+		ATOMIC_STORE(&pool->exit, true);
+		sem_post(&pool->wake);
+		pthread_join(pool->thread, NULL);
+		sem_destroy(&pool->wake);
+	}
+#endif
+
+	lilv_pool_free_all(pool->ready);
+	lilv_pool_free_all(pool->returned);
+#ifdef LILV_POOL_LOCK
+	pthread_mutex_destroy(&pool->mutex);
+#endif
+	free(pool);
+}
+
+LILV_API LilvInstance*
+lilv_instance_pool_take(LilvInstancePool* pool)
+{
+	lilv_pool_lock(pool);
+	LilvPoolEntry* entry = lilv_pool_pop(&pool->ready);
+	if (entry) {
+		(void)ATOMIC_SUB(&pool->n_ready, 1);
+	}
+	lilv_pool_unlock(pool);
+	if (!entry) {
+		return NULL;
+	}
+
+	lilv_pool_wake(pool);
+	return &entry->instance;
+}
+
+LILV_API void
+lilv_instance_pool_return(LilvInstancePool* pool, LilvInstance* instance)
+{
+	lilv_pool_lock(pool);
+	lilv_pool_push(&pool->returned, (LilvPoolEntry*)instance);
+	lilv_pool_unlock(pool);
+	lilv_pool_wake(pool);
+}
+
+LILV_API void
+lilv_instance_pool_refill(LilvInstancePool* pool)
+{
+	if (!lilv_pool_wake(pool)) {
+		lilv_pool_work(pool);
+	}
+}
+
+LILV_API uint32_t
+lilv_instance_pool_get_num_ready(const LilvInstancePool* pool)
+{
+	return lilv_pool_num_ready(pool);
+}
@@ -20,9 +20,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
-#include "lv2/lv2plug.in/ns/ext/event/event.h"
-
 #include "lilv_internal.h"
 
 LilvPort*
@@ -36,6 +33,7 @@ lilv_port_new(LilvWorld*      world,
 	port->index   = index;
 	port->symbol  = lilv_node_new(world, LILV_VALUE_STRING, symbol);
 	port->classes = lilv_nodes_new();
+	port->name    = NULL;
 	return port;
 }
 
@@ -46,6 +44,7 @@ lilv_port_free(const LilvPlugin* plugin, LilvPort* port)
 		lilv_node_free(port->node);
 		lilv_nodes_free(port->classes);
 		lilv_node_free(port->symbol);
+		lilv_node_free(port->name);
 		free(port);
 	}
 }
@@ -67,6 +66,7 @@ lilv_port_has_property(const LilvPlugin* p,
                        const LilvPort*   port,
                        const LilvNode*   property)
 {
+	lilv_plugin_load_if_necessary(p);
 	return lilv_world_ask_internal(p->world,
 	                               port->node->node,
 	                               p->world->uris.lv2_portProperty,
@@ -78,14 +78,16 @@ lilv_port_supports_event(const LilvPlugin* p,
                          const LilvPort*   port,
                          const LilvNode*   event)
 {
-	const uint8_t* predicates[] = { (const uint8_t*)LV2_EVENT__supportsEvent,
-	                                (const uint8_t*)LV2_ATOM__supports,
-	                                NULL };
+	lilv_plugin_load_if_necessary(p);
+
+	const SordNode* predicates[] = { p->world->uris.ev_supportsEvent,
+	                                 p->world->uris.atom_supports,
+	                                 NULL };
 
-	for (const uint8_t** pred = predicates; *pred; ++pred) {
+	for (const SordNode** pred = predicates; *pred; ++pred) {
 		if (lilv_world_ask_internal(p->world,
 		                            port->node->node,
-		                            sord_new_uri(p->world->world, *pred),
+		                            *pred,
 		                            event->node)) {
 			return true;
 		}
@@ -122,6 +124,7 @@ lilv_port_get_value(const LilvPlugin* p,
 		return NULL;
 	}
 
+	lilv_plugin_load_if_necessary(p);
 	return lilv_port_get_value_by_node(p, port, predicate->node);
 }
 
@@ -157,16 +160,10 @@ LILV_API LilvNode*
 lilv_port_get_name(const LilvPlugin* p,
                    const LilvPort*   port)
 {
-	LilvNodes* results = lilv_port_get_value_by_node(
-		p, port, p->world->uris.lv2_name);
-
-	LilvNode* ret = NULL;
-	if (results) {
-		LilvNode* val = lilv_nodes_get_first(results);
-		if (lilv_node_is_string(val))
-			ret = lilv_node_duplicate(val);
-		lilv_nodes_free(results);
-	}
+	LilvWorld* const world = p->world;
+	LilvNode*        ret   = port->name
+		? lilv_node_duplicate(port->name)
+		: lilv_world_get_name(world, port->node->node, world->uris.lv2_name);
 
 	if (!ret)
 		LILV_WARNF("Plugin <%s> port has no (mandatory) doap:name\n",
@@ -219,16 +216,21 @@ LILV_API LilvScalePoints*
 lilv_port_get_scale_points(const LilvPlugin* p,
                            const LilvPort*   port)
 {
+	lilv_plugin_load_if_necessary(p);
+
 	SordIter* points = lilv_world_query_internal(
 		p->world,
 		port->node->node,
-		sord_new_uri(p->world->world, (const uint8_t*)LV2_CORE__scalePoint),
+		p->world->uris.lv2_scalePoint,
 		NULL);
 
-	LilvScalePoints* ret = NULL;
-	if (!sord_iter_end(points))
-		ret = lilv_scale_points_new();
+	if (sord_iter_end(points)) {
+		sord_iter_free(points);
+		return NULL;
+	}
 
+	LilvArray ret;
+	lilv_array_init(&ret);
 	FOREACH_MATCH(points) {
 		const SordNode* point = sord_iter_get_node(points, SORD_OBJECT);
 
@@ -241,14 +243,175 @@ lilv_port_get_scale_points(const LilvPlugin* p,
 		                                         p->world->uris.rdfs_label);
 
 		if (value && label) {
-			zix_tree_insert(
-				(ZixTree*)ret, lilv_scale_point_new(value, label), NULL);
+			lilv_array_append(&ret, lilv_scale_point_new(value, label));
 		}
 	}
 	sord_iter_free(points);
 
-	assert(!ret || lilv_nodes_size(ret) > 0);
-	return ret;
+	return lilv_array_to_scale_points(&ret);
+}
+
+static int
+scale_point_info_cmp(const void* a, const void* b)
+{
+	const float av = ((const LilvScalePointInfo*)a)->value;
+	const float bv = ((const LilvScalePointInfo*)b)->value;
+	return (av < bv) ? -1 : (av > bv);
+}
+
+/** Sort scale points by value, keeping the order of those that are equal. */
+static void
+scale_point_infos_sort(LilvScalePointInfo* infos, uint32_t n_infos)
+{
+	for (uint32_t i = 1; i < n_infos; ++i) {
+		const LilvScalePointInfo info = infos[i];
+		uint32_t                 j    = i;
+		for (; j > 0 && scale_point_info_cmp(&infos[j - 1], &info) > 0; --j) {
+			infos[j] = infos[j - 1];
+		}
+		infos[j] = info;
+	}
+}
+
+void
+lilv_plugin_clear_scale_points(LilvPlugin* plugin)
+{
+	free(plugin->scale_point_infos);
+	plugin->scale_point_infos   = NULL;
+	plugin->scale_point_offsets = NULL;
+	plugin->scale_points_loaded = false;
+}
+
+/**
+   Build the numeric scale points of every port.
+
+   The values and labels of every port are gathered first, so the infos,
+   their offsets by port, and the label strings can be allocated together.
+*/
+void
+lilv_plugin_load_scale_points_if_necessary(const LilvPlugin* const_p)
+{
+	LilvPlugin* p = (LilvPlugin*)const_p;
+	if (p->scale_points_loaded) {
+		return;
+	}
+
+	const uint32_t n_ports = lilv_plugin_get_num_ports(p);
+	uint32_t*      counts  = (uint32_t*)calloc(n_ports + 1, sizeof(uint32_t));
+	size_t         n_bytes = 0;
+	LilvArray      nodes;
+	lilv_array_init(&nodes);
+	for (uint32_t i = 0; i < n_ports; ++i) {
+		if (!p->port_scale_points || !p->port_scale_points[i]) {
+			continue;
+		}
+
+		SordIter* points = lilv_world_query_internal(
+			p->world, p->ports[i]->node->node,
+			p->world->uris.lv2_scalePoint, NULL);
+		FOREACH_MATCH(points) {
+			const SordNode* point = sord_iter_get_node(points, SORD_OBJECT);
+
+			LilvNode* value = lilv_plugin_get_unique(
+				p, point, p->world->uris.rdf_value);
+			LilvNode* label = lilv_plugin_get_unique(
+				p, point, p->world->uris.rdfs_label);
+			if ((lilv_node_is_float(value) || lilv_node_is_int(value)) &&
+			    label) {
+				lilv_array_append(&nodes, value);
+				lilv_array_append(&nodes, label);
+				n_bytes += strlen(lilv_node_as_string(label)) + 1;
+				++counts[i];
+			} else {
+				lilv_node_free(value);
+				lilv_node_free(label);
+			}
+		}
+		sord_iter_free(points);
+	}
+
+	const size_t n_infos = nodes.n_elems / 2;
+	if (n_infos) {
+		LilvScalePointInfo* infos = (LilvScalePointInfo*)malloc(
+			n_infos * sizeof(LilvScalePointInfo) +
+			(n_ports + 1) * sizeof(uint32_t) + n_bytes);
+		uint32_t* offsets = (uint32_t*)(infos + n_infos);
+		char*     labels  = (char*)(offsets + n_ports + 1);
+
+		for (size_t i = 0; i < n_infos; ++i) {
+			const LilvNode* value = (const LilvNode*)nodes.elems[2 * i];
+			const LilvNode* label = (const LilvNode*)nodes.elems[2 * i + 1];
+			const char*     str   = lilv_node_as_string(label);
+			const size_t    len   = strlen(str);
+
+			infos[i].value = lilv_node_as_float(value);
+			infos[i].label = labels;
+			memcpy(labels, str, len + 1);
+			labels += len + 1;
+		}
+
+		offsets[0] = 0;
+		for (uint32_t i = 0; i < n_ports; ++i) {
+			offsets[i + 1] = offsets[i] + counts[i];
+			scale_point_infos_sort(infos + offsets[i], counts[i]);
+		}
+
+		p->scale_point_infos   = infos;
+		p->scale_point_offsets = offsets;
+	}
+
+	for (size_t i = 0; i < nodes.n_elems; ++i) {
+		lilv_node_free((LilvNode*)nodes.elems[i]);
+	}
+	if (nodes.elems != nodes.local) {
+		free(nodes.elems);
+	}
+	free(counts);
+	p->scale_points_loaded = true;
+}
+
+LILV_API const LilvScalePointInfo*
+lilv_port_get_scale_point_infos(const LilvPlugin* p,
+                                const LilvPort*   port,
+                                uint32_t*         n_points)
+{
+	lilv_plugin_load_if_necessary(p);
+	lilv_plugin_load_scale_points_if_necessary(p);
+
+	*n_points = 0;
+	if (!p->scale_point_infos || port->index >= p->num_ports) {
+		return NULL;
+	}
+
+	const uint32_t* offsets = p->scale_point_offsets;
+	*n_points = offsets[port->index + 1] - offsets[port->index];
+	return *n_points ? p->scale_point_infos + offsets[port->index] : NULL;
+}
+
+LILV_API const char*
+lilv_port_get_scale_point_label(const LilvPlugin* p,
+                                const LilvPort*   port,
+                                float             value)
+{
+	uint32_t                  n_points = 0;
+	const LilvScalePointInfo* infos    = lilv_port_get_scale_point_infos(
+		p, port, &n_points);
+
+	// Find the first point with a value not less than `value`
+	uint32_t lower = 0;
+	uint32_t n     = n_points;
+	while (n > 0) {
+		const uint32_t half = n / 2;
+		if (infos[lower + half].value < value) {
+			lower += half + 1;
+			n     -= half + 1;
+		} else {
+			n = half;
+		}
+	}
+
+	return (lower < n_points && infos[lower].value == value)
+		? infos[lower].label : NULL;
 }
 
 LILV_API LilvNodes*
@@ -50,10 +50,11 @@ lilv_nodes_from_stream_objects_i18n(LilvWorld*    world,
                                     SordIter*     stream,
                                     SordQuadIndex field)
 {
-	LilvNodes*      values  = lilv_nodes_new();
+	LilvArray       values;
 	const SordNode* nolang  = NULL;  // Untranslated value
 	const SordNode* partial = NULL;  // Partial language match
-	char*           syslang = lilv_get_lang();
+	const char*     syslang = world->opt.lang;
+	lilv_array_init(&values);
 	FOREACH_MATCH(stream) {
 		const SordNode* value = sord_iter_get_node(stream, field);
 		if (sord_node_get_type(value) == SORD_LITERAL) {
@@ -72,24 +73,20 @@ lilv_nodes_from_stream_objects_i18n(LilvWorld*    world,
 
 			if (lm == LILV_LANG_MATCH_EXACT) {
 				// Exact language match, add to results
-				zix_tree_insert((ZixTree*)values,
-				                lilv_node_new_from_node(world, value),
-				                NULL);
+				lilv_array_append(&values,
+				                  lilv_node_new_from_node(world, value));
 			} else if (lm == LILV_LANG_MATCH_PARTIAL) {
 				// Partial language match, save in case we find no exact
 				partial = value;
 			}
 		} else {
-			zix_tree_insert((ZixTree*)values,
-			                lilv_node_new_from_node(world, value),
-			                NULL);
+			lilv_array_append(&values, lilv_node_new_from_node(world, value));
 		}
 	}
 	sord_iter_free(stream);
-	free(syslang);
 
-	if (lilv_nodes_size(values) > 0) {
-		return values;
+	if (values.n_elems > 0) {
+		return lilv_array_to_nodes(&values);
 	}
 
 	const SordNode* best = nolang;
@@ -103,15 +100,12 @@ lilv_nodes_from_stream_objects_i18n(LilvWorld*    world,
 	}
 
 	if (best) {
-		zix_tree_insert(
-			(ZixTree*)values, lilv_node_new_from_node(world, best), NULL);
-	} else {
-		// No matches whatsoever
-		lilv_nodes_free(values);
-		values = NULL;
+		lilv_array_append(&values, lilv_node_new_from_node(world, best));
+		return lilv_array_to_nodes(&values);
 	}
 
-	return values;
+	// No matches whatsoever
+	return NULL;
 }
 
 LilvNodes*
@@ -125,15 +119,16 @@ lilv_nodes_from_stream_objects(LilvWorld*    world,
 	} else if (world->opt.filter_language) {
 		return lilv_nodes_from_stream_objects_i18n(world, stream, field);
 	} else {
-		LilvNodes* values = lilv_nodes_new();
+		LilvArray values;
+		lilv_array_init(&values);
 		FOREACH_MATCH(stream) {
 			const SordNode* value = sord_iter_get_node(stream, field);
 			LilvNode*       node  = lilv_node_new_from_node(world, value);
 			if (node) {
-				zix_tree_insert((ZixTree*)values, node, NULL);
+				lilv_array_append(&values, node);
 			}
 		}
 		sord_iter_free(stream);
-		return values;
+		return lilv_array_to_nodes(&values);
 	}
 }
@@ -0,0 +1,156 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lilv_internal.h"
+
+/*
+  The query cache records the results of world queries by pattern.  Sord
+  nodes are interned, so a pattern is keyed by node pointers, and every entry
+  holds a reference to its pattern and result nodes so they are not reused
+  while it exists.  The world clears the cache whenever its model changes,
+  and when the cache is full, since results must always match the model.
+*/
+
+#define LILV_QUERY_CACHE_MAX_ENTRIES 16384U
+
+struct LilvQueryCacheImpl {
+	ZixHash* entries;  ///< Hash of LilvQueryEntry
+};
+
+static uint32_t
+lilv_query_hash(const void* value)
+{
+	const LilvQueryEntry* entry = (const LilvQueryEntry*)value;
+	uint64_t              h     = (uint64_t)entry->kind;
+	h = (h ^ (uintptr_t)entry->s) * 0x9E3779B97F4A7C15ull;
+	h = (h ^ (uintptr_t)entry->p) * 0x9E3779B97F4A7C15ull;
+	h = (h ^ (uintptr_t)entry->o) * 0x9E3779B97F4A7C15ull;
+	return (uint32_t)(h >> 32);
+}
+
+static bool
+lilv_query_equal(const void* a, const void* b)
+{
+	const LilvQueryEntry* entry_a = (const LilvQueryEntry*)a;
+	const LilvQueryEntry* entry_b = (const LilvQueryEntry*)b;
+	return (entry_a->kind == entry_b->kind &&
+	        entry_a->s == entry_b->s &&
+	        entry_a->p == entry_b->p &&
+	        entry_a->o == entry_b->o);
+}
+
+static ZixHash*
+lilv_query_cache_entries_new(void)
+{
+	return zix_hash_new(
+		lilv_query_hash, lilv_query_equal, sizeof(LilvQueryEntry));
+}
+
+static void
+lilv_query_entry_free(void* value, void* user_data)
+{
+	LilvQueryEntry* entry = (LilvQueryEntry*)value;
+	SordWorld*      world = (SordWorld*)user_data;
+	for (uint32_t i = 0; entry->results && i < entry->n_results; ++i) {
+		sord_node_free(world, entry->results[i]);
+	}
+	sord_node_free(world, entry->s);
+	sord_node_free(world, entry->p);
+	sord_node_free(world, entry->o);
+	free(entry->results);
+}
+
+LilvQueryCache*
+lilv_query_cache_new(void)
+{
+	LilvQueryCache* cache = (LilvQueryCache*)malloc(sizeof(LilvQueryCache));
+	cache->entries = lilv_query_cache_entries_new();
+	return cache;
+}
+
+void
+lilv_query_cache_clear(LilvQueryCache* cache, SordWorld* world)
+{
+	if (zix_hash_size(cache->entries) > 0) {
+		zix_hash_foreach(cache->entries, lilv_query_entry_free, world);
+		zix_hash_free(cache->entries);
+		cache->entries = lilv_query_cache_entries_new();
+	}
+}
+
+void
+lilv_query_cache_free(LilvQueryCache* cache, SordWorld* world)
+{
+	if (cache) {
+		lilv_query_cache_clear(cache, world);
+		zix_hash_free(cache->entries);
+		free(cache);
+	}
+}
+
+const LilvQueryEntry*
+lilv_query_cache_find(const LilvQueryCache* cache,
+                      LilvQueryKind         kind,
+                      const SordNode*       subject,
+                      const SordNode*       predicate,
+                      const SordNode*       object)
+{
+	const LilvQueryEntry key = {
+		kind, (SordNode*)subject, (SordNode*)predicate, (SordNode*)object,
+		0, NULL
+	};
+	return (const LilvQueryEntry*)zix_hash_find(cache->entries, &key);
+}
+
+void
+lilv_query_cache_add(LilvQueryCache*        cache,
+                     SordWorld*             world,
+                     LilvQueryKind          kind,
+                     const SordNode*        subject,
+                     const SordNode*        predicate,
+                     const SordNode*        object,
+                     const SordNode* const* results,
+                     uint32_t               n_results)
+{
+	if (zix_hash_size(cache->entries) >= LILV_QUERY_CACHE_MAX_ENTRIES) {
+		lilv_query_cache_clear(cache, world);
+	}
+
+	LilvQueryEntry entry = {
+		kind, (SordNode*)subject, (SordNode*)predicate, (SordNode*)object,
+		n_results, NULL
+	};
+	if (zix_hash_find(cache->entries, &entry)) {
+		return;  // Added by another thread
+	}
+
+	if (results && n_results) {
+		entry.results = (SordNode**)malloc(n_results * sizeof(SordNode*));
+		for (uint32_t i = 0; i < n_results; ++i) {
+			entry.results[i] = sord_node_copy(results[i]);
+		}
+	}
+
+	entry.s = sord_node_copy(subject);
+	entry.p = sord_node_copy(predicate);
+	entry.o = sord_node_copy(object);
+	if (zix_hash_insert(cache->entries, &entry, NULL)) {
+		lilv_query_entry_free(&entry, world);
+	}
+}
@@ -0,0 +1,276 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L  /* for kill, nanosleep */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef HAVE_FORK
+#    include <signal.h>
+#    include <sys/types.h>
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+
+#include "lilv_internal.h"
+
+/*
+  Scanning happens in two phases.  Plugin data is checked first, on several
+  threads if the world is frozen and may be queried concurrently.  Plugins
+  are then instantiated in child processes, which are forked from the
+  calling thread only after every checking thread has finished, since a
+  child of a multi-threaded process may inherit locks that are never
+  released.
+*/
+
+#define SCAN_POLL_NS 1000000u
+
+typedef struct {
+	LilvScanResult* results;
+	size_t          n_results;
+	size_t          next;   ///< Index of next result to check
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t mutex;  ///< Protects next
+#endif
+} LilvScanBatch;
+
+static void*
+lilv_scan_batch_run(void* data)
+{
+	LilvScanBatch* batch = (LilvScanBatch*)data;
+	for (;;) {
+#ifdef HAVE_PTHREAD
+		pthread_mutex_lock(&batch->mutex);
+#endif
+		const size_t i = batch->next++;
+#ifdef HAVE_PTHREAD
+		pthread_mutex_unlock(&batch->mutex);
+#endif
+		if (i >= batch->n_results) {
+			break;
+		}
+
+		LilvScanResult* const result = &batch->results[i];
+		const uint64_t        begin  = lilv_time_ns();
+		result->errors = lilv_plugin_check(result->plugin);
+		if (!(result->errors & LILV_SCAN_PARSE_ERROR) &&
+		    !lilv_plugin_get_library_uri(result->plugin)) {
+			result->errors |= LILV_SCAN_NO_BINARY;
+		}
+		result->verify_time = lilv_time_ns() - begin;
+		result->status = result->errors ? LILV_SCAN_INVALID : LILV_SCAN_OK;
+	}
+	return NULL;
+}
+
+static void
+lilv_scan_check(LilvScanBatch* batch, unsigned n_threads)
+{
+#ifdef HAVE_PTHREAD
+	if (n_threads > batch->n_results) {
+		n_threads = (unsigned)batch->n_results;
+	}
+
+	pthread_t* threads   = (pthread_t*)calloc(n_threads, sizeof(pthread_t));
+	unsigned   n_started = 0;
+	pthread_mutex_init(&batch->mutex, NULL);
+	for (unsigned i = 1; i < n_threads; ++i) {
+		if (!pthread_create(&threads[n_started], NULL,
+		                    lilv_scan_batch_run, batch)) {
+			++n_started;
+		}
+	}
+	lilv_scan_batch_run(batch);
+	for (unsigned i = 0; i < n_started; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+	pthread_mutex_destroy(&batch->mutex);
+	free(threads);
+#else
+	lilv_scan_batch_run(batch);
+#endif
+}
+
+/** Instantiate a plugin, return true on success. */
+static bool
+lilv_scan_instantiate(const LilvPlugin* plugin, const LilvScanOptions* options)
+{
+	LilvInstance* instance = lilv_plugin_instantiate(
+		plugin, options->sample_rate, options->features);
+	if (!instance) {
+		return false;
+	}
+
+	const LV2_Descriptor* const descriptor = instance->lv2_descriptor;
+	if (descriptor->activate) {
+		descriptor->activate(instance->lv2_handle);
+	}
+	if (descriptor->deactivate) {
+		descriptor->deactivate(instance->lv2_handle);
+	}
+	lilv_instance_free(instance);
+	return true;
+}
+
+#ifdef HAVE_FORK
+
+typedef struct {
+	pid_t           pid;
+	LilvScanResult* result;
+	uint64_t        begin;
+} LilvScanChild;
+
+static pid_t
+lilv_scan_fork(const LilvScanResult* result, const LilvScanOptions* options)
+{
+	const pid_t pid = fork();
+	if (pid == 0) {
+		_exit(lilv_scan_instantiate(result->plugin, options) ? 0 : 1);
+	} else if (pid < 0) {
+		LILV_ERRORF("Failed to fork scanner (%s)\n", strerror(errno));
+	}
+	return pid;
+}
+
+/** Record the exit status of a child, return true if it has finished. */
+static bool
+lilv_scan_reap(LilvScanChild* child, const LilvScanOptions* options)
+{
+	const uint64_t now    = lilv_time_ns();
+	int            status = 0;
+	if (waitpid(child->pid, &status, WNOHANG) == 0) {
+		const uint64_t timeout = (uint64_t)options->timeout_ms * 1000000u;
+		if (!timeout || now - child->begin < timeout) {
+			return false;  // Still running
+		}
+
+		// Timed out, kill it
+		kill(child->pid, SIGKILL);
+		waitpid(child->pid, &status, 0);
+		child->result->status = LILV_SCAN_TIMED_OUT;
+	} else if (WIFSIGNALED(status)) {
+		child->result->status = LILV_SCAN_CRASHED;
+		child->result->signal = WTERMSIG(status);
+	} else if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+		child->result->status = LILV_SCAN_FAILED;
+	}
+
+	child->result->instantiate_time = now - child->begin;
+	return true;
+}
+
+static void
+lilv_scan_instantiate_all(LilvScanResult*        results,
+                          size_t                 n_results,
+                          const LilvScanOptions* options)
+{
+	const unsigned n_children = options->n_threads ? options->n_threads : 1;
+	LilvScanChild* children   = (LilvScanChild*)calloc(
+		n_children, sizeof(LilvScanChild));
+
+	size_t   next      = 0;
+	unsigned n_running = 0;
+	while (next < n_results || n_running > 0) {
+		// Start children for the next valid plugins
+		while (n_running < n_children && next < n_results) {
+			LilvScanResult* const result = &results[next++];
+			if (result->status == LILV_SCAN_OK) {
+				LilvScanChild* const child = &children[n_running];
+				child->result = result;
+				child->begin  = lilv_time_ns();
+				if ((child->pid = lilv_scan_fork(result, options)) > 0) {
+					++n_running;
+				} else {
+					result->status = LILV_SCAN_FAILED;
+				}
+			}
+		}
+
+		// Reap any finished children
+		bool reaped = false;
+		for (unsigned i = 0; i < n_running;) {
+			if (lilv_scan_reap(&children[i], options)) {
+				children[i] = children[--n_running];
+				reaped      = true;
+			} else {
+				++i;
+			}
+		}
+
+		if (!reaped && n_running > 0) {
+			const struct timespec delay = { 0, SCAN_POLL_NS };
+			nanosleep(&delay, NULL);
+		}
+	}
+
+	free(children);
+}
+
+#else
+
+static void
+lilv_scan_instantiate_all(LilvScanResult*        results,
+                          size_t                 n_results,
+                          const LilvScanOptions* options)
+{
+	for (size_t i = 0; i < n_results; ++i) {
+		if (results[i].status == LILV_SCAN_OK) {
+			const uint64_t begin = lilv_time_ns();
+			if (!lilv_scan_instantiate(results[i].plugin, options)) {
+				results[i].status = LILV_SCAN_FAILED;
+			}
+			results[i].instantiate_time = lilv_time_ns() - begin;
+		}
+	}
+}
+
+#endif
+
+LILV_API unsigned
+lilv_world_scan_plugins(LilvWorld*             world,
+                        const LilvPlugins*     plugins,
+                        const LilvScanOptions* options,
+                        LilvScanResult*        results)
+{
+	LilvScanBatch batch;
+	memset(&batch, '\0', sizeof(batch));
+	batch.results = results;
+
+	LILV_FOREACH(plugins, i, plugins) {
+		LilvScanResult* const result = &results[batch.n_results++];
+		memset(result, '\0', sizeof(LilvScanResult));
+		result->plugin = lilv_plugins_get(plugins, i);
+	}
+
+	// Check plugin data, in parallel if the world may be read concurrently
+	const unsigned n_threads = options ? options->n_threads : 1;
+	lilv_scan_check(&batch, world->frozen ? n_threads : 1);
+
+	// Instantiate valid plugins
+	if (options && options->instantiate) {
+		lilv_world_finish_preload(world);
+		lilv_scan_instantiate_all(results, batch.n_results, options);
+	}
+
+	unsigned n_failed = 0;
+	for (size_t i = 0; i < batch.n_results; ++i) {
+		n_failed += results[i].status != LILV_SCAN_OK;
+	}
+	return n_failed;
+}
@@ -0,0 +1,491 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lilv_internal.h"
+
+/*
+  The search index stores each facet of every plugin in a column indexed by
+  row, so a query is a few passes over flat arrays.  Boolean facets, and the
+  rows that require each feature, are bitsets of 64 rows per word.  Rows are
+  never removed: a plugin that leaves the world has its row cleared from the
+  live set, and gets it back if its bundle is loaded again.
+*/
+
+#define NO_AUTHOR UINT32_MAX
+#define WORD_BITS 64U
+
+typedef struct {
+	const LilvPlugin* plugin;
+	uint32_t          row;
+} LilvSearchRow;
+
+typedef struct {
+	const char* name;  ///< Lower case plugin name
+	uint32_t    row;
+} LilvSearchName;
+
+typedef struct {
+	LilvNode* uri;   ///< Feature URI
+	uint64_t* rows;  ///< Bitset of rows that require this feature
+} LilvSearchFeature;
+
+struct LilvSearchIndexImpl {
+	LilvWorld*              world;
+	unsigned                version;     ///< Plugins version when updated
+	ZixHash*                rows;        ///< Row of each plugin
+	uint32_t                n_rows;
+	uint32_t                n_words;     ///< Allocated words in each bitset
+	const LilvPlugin**      plugins;     ///< Plugin of each row
+	const LilvPluginClass** classes;     ///< Class of each row
+	uint32_t*               authors;     ///< Author of each row, or NO_AUTHOR
+	uint32_t*               audio_ins;   ///< Number of audio inputs
+	uint32_t*               audio_outs;  ///< Number of audio outputs
+	char**                  names;       ///< Lower case name of each row
+	LilvSearchName*         by_name;     ///< Live rows sorted by name
+	uint32_t                n_by_name;
+	bool                    sorted;      ///< True if by_name is up to date
+	uint64_t*               live;        ///< Bitset of rows in the world
+	uint64_t*               has_ui;      ///< Bitset of rows with a UI
+	uint64_t*               matches;     ///< Bitset for query results
+	uint64_t*               named;       ///< Bitset for name matches
+	char**                  author_names;
+	uint32_t                n_authors;
+	LilvSearchFeature*      features;
+	uint32_t                n_features;
+};
+
+static uint32_t
+lilv_search_row_hash(const void* value)
+{
+	const LilvSearchRow* row = (const LilvSearchRow*)value;
+	return (uint32_t)(((uintptr_t)row->plugin * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+static bool
+lilv_search_row_equal(const void* a, const void* b)
+{
+	return ((const LilvSearchRow*)a)->plugin == ((const LilvSearchRow*)b)->plugin;
+}
+
+/** Return the index of the lowest set bit in `bits`, which is not zero. */
+static inline uint32_t
+bitset_lowest(uint64_t bits)
+{
+#ifdef __GNUC__
+	return (uint32_t)__builtin_ctzll(bits);
+#else
+	uint32_t i = 0;
+	while (!(bits & 1)) {
+		bits >>= 1;
+		++i;
+	}
+	return i;
+#endif
+}
+
+static inline bool
+bitset_get(const uint64_t* bits, uint32_t i)
+{
+	return bits[i / WORD_BITS] & ((uint64_t)1 << (i % WORD_BITS));
+}
+
+static inline void
+bitset_set(uint64_t* bits, uint32_t i, bool value)
+{
+	const uint64_t mask = (uint64_t)1 << (i % WORD_BITS);
+	bits[i / WORD_BITS] = (value
+	                       ? bits[i / WORD_BITS] | mask
+	                       : bits[i / WORD_BITS] & ~mask);
+}
+
+/** Grow `bits` from `old_words` to `new_words` zeroed words. */
+static uint64_t*
+bitset_grow(uint64_t* bits, uint32_t old_words, uint32_t new_words)
+{
+	bits = (uint64_t*)realloc(bits, new_words * sizeof(uint64_t));
+	memset(bits + old_words, '\0', (new_words - old_words) * sizeof(uint64_t));
+	return bits;
+}
+
+static char*
+lilv_search_fold(const char* str)
+{
+	char* folded = lilv_strdup(str);
+	for (char* c = folded; *c; ++c) {
+		*c = (char)tolower((unsigned char)*c);
+	}
+	return folded;
+}
+
+static uint32_t
+lilv_search_author(LilvSearchIndex* index, const char* name, bool add)
+{
+	for (uint32_t i = 0; i < index->n_authors; ++i) {
+		if (!strcmp(index->author_names[i], name)) {
+			return i;
+		}
+	}
+
+	if (!add) {
+		return NO_AUTHOR;
+	}
+
+	index->author_names = (char**)realloc(
+		index->author_names, (index->n_authors + 1) * sizeof(char*));
+	index->author_names[index->n_authors] = lilv_strdup(name);
+	return index->n_authors++;
+}
+
+static LilvSearchFeature*
+lilv_search_feature(LilvSearchIndex* index, const LilvNode* uri)
+{
+	for (uint32_t i = 0; i < index->n_features; ++i) {
+		if (lilv_node_equals(index->features[i].uri, uri)) {
+			return &index->features[i];
+		}
+	}
+
+	index->features = (LilvSearchFeature*)realloc(
+		index->features, (index->n_features + 1) * sizeof(LilvSearchFeature));
+
+	LilvSearchFeature* feature = &index->features[index->n_features++];
+	feature->uri  = lilv_node_duplicate(uri);
+	feature->rows = (uint64_t*)calloc(index->n_words, sizeof(uint64_t));
+	return feature;
+}
+
+/** Return the row of `plugin`, adding a new one if necessary. */
+static uint32_t
+lilv_search_index_row(LilvSearchIndex* index, const LilvPlugin* plugin)
+{
+	const LilvSearchRow  key   = { plugin, 0 };
+	const LilvSearchRow* found = (const LilvSearchRow*)zix_hash_find(
+		index->rows, &key);
+	if (found) {
+		return found->row;
+	}
+
+	const uint32_t row = index->n_rows++;
+	if (row % WORD_BITS == 0) {
+		// Grow every column by a word's worth of rows
+		const uint32_t n_words = index->n_words + 1;
+		const uint32_t n       = n_words * WORD_BITS;
+
+		index->plugins = (const LilvPlugin**)realloc(
+			index->plugins, n * sizeof(const LilvPlugin*));
+		index->classes = (const LilvPluginClass**)realloc(
+			index->classes, n * sizeof(const LilvPluginClass*));
+		index->authors    = (uint32_t*)realloc(index->authors, n * sizeof(uint32_t));
+		index->audio_ins  = (uint32_t*)realloc(index->audio_ins, n * sizeof(uint32_t));
+		index->audio_outs = (uint32_t*)realloc(index->audio_outs, n * sizeof(uint32_t));
+		index->names      = (char**)realloc(index->names, n * sizeof(char*));
+		index->by_name    = (LilvSearchName*)realloc(
+			index->by_name, n * sizeof(LilvSearchName));
+
+		index->live    = bitset_grow(index->live, index->n_words, n_words);
+		index->has_ui  = bitset_grow(index->has_ui, index->n_words, n_words);
+		index->matches = bitset_grow(index->matches, index->n_words, n_words);
+		index->named   = bitset_grow(index->named, index->n_words, n_words);
+		for (uint32_t f = 0; f < index->n_features; ++f) {
+			index->features[f].rows = bitset_grow(
+				index->features[f].rows, index->n_words, n_words);
+		}
+		index->n_words = n_words;
+	}
+
+	index->plugins[row] = plugin;
+	index->names[row]   = NULL;
+
+	const LilvSearchRow entry = { plugin, row };
+	zix_hash_insert(index->rows, &entry, NULL);
+	return row;
+}
+
+/** Read every facet of `plugin` into its row, loading it if necessary. */
+static void
+lilv_search_index_read(LilvSearchIndex* index, const LilvPlugin* plugin)
+{
+	const uint32_t row = lilv_search_index_row(index, plugin);
+
+	index->classes[row] = lilv_plugin_get_class(plugin);
+
+	LilvNode* author = lilv_plugin_get_author_name(plugin);
+	index->authors[row] = (author
+	                       ? lilv_search_author(
+		                       index, lilv_node_as_string(author), true)
+	                       : NO_AUTHOR);
+	lilv_node_free(author);
+
+	uint32_t             n_ins  = 0;
+	uint32_t             n_outs = 0;
+	const LilvPortTable* ports  = lilv_plugin_get_port_table(plugin);
+	for (uint32_t i = 0; ports && i < ports->n_ports; ++i) {
+		if (ports->types[i] & LILV_PORT_AUDIO) {
+			n_ins  += (ports->types[i] & LILV_PORT_INPUT) ? 1 : 0;
+			n_outs += (ports->types[i] & LILV_PORT_OUTPUT) ? 1 : 0;
+		}
+	}
+	index->audio_ins[row]  = n_ins;
+	index->audio_outs[row] = n_outs;
+
+	free(index->names[row]);
+	LilvNode* name = lilv_plugin_get_name(plugin);
+	index->names[row] = lilv_search_fold(name ? lilv_node_as_string(name) : "");
+	lilv_node_free(name);
+
+	LilvUIs* uis = lilv_plugin_get_uis(plugin);
+	bitset_set(index->has_ui, row, uis != NULL);
+	lilv_uis_free(uis);
+
+	for (uint32_t f = 0; f < index->n_features; ++f) {
+		bitset_set(index->features[f].rows, row, false);
+	}
+	LilvNodes* required = lilv_plugin_get_required_features(plugin);
+	LILV_FOREACH(nodes, i, required) {
+		LilvSearchFeature* feature = lilv_search_feature(
+			index, lilv_nodes_get(required, i));
+		bitset_set(feature->rows, row, true);
+	}
+	lilv_nodes_free(required);
+
+	bitset_set(index->live, row, true);
+	index->sorted = false;
+}
+
+/** Bring the index up to date with the plugins in the world. */
+static void
+lilv_search_index_update(LilvSearchIndex* index)
+{
+	LilvWorld* const world = index->world;
+	if (index->version == world->plugins_version) {
+		return;
+	}
+
+	// Drop plugins that have left the world, and re-read reloaded plugins
+	for (uint32_t r = 0; r < index->n_rows; ++r) {
+		const LilvPlugin* plugin = index->plugins[r];
+		if (lilv_plugins_get_by_uri(world->plugins,
+		                            lilv_plugin_get_uri(plugin)) != plugin) {
+			bitset_set(index->live, r, false);
+			index->sorted = false;
+		} else if (!plugin->loaded) {
+			lilv_search_index_read(index, plugin);
+		}
+	}
+
+	// Add new plugins, and plugins that have come back
+	LILV_FOREACH(plugins, i, world->plugins) {
+		const LilvPlugin*   plugin = lilv_plugins_get(world->plugins, i);
+		const LilvSearchRow key    = { plugin, 0 };
+		const LilvSearchRow* found = (const LilvSearchRow*)zix_hash_find(
+			index->rows, &key);
+		if (!found || !bitset_get(index->live, found->row)) {
+			lilv_search_index_read(index, plugin);
+		}
+	}
+
+	index->version = world->plugins_version;
+}
+
+static int
+lilv_search_name_cmp(const void* a, const void* b)
+{
+	const LilvSearchName* name_a = (const LilvSearchName*)a;
+	const LilvSearchName* name_b = (const LilvSearchName*)b;
+	const int             c      = strcmp(name_a->name, name_b->name);
+	return c ? c : (name_a->row > name_b->row) - (name_a->row < name_b->row);
+}
+
+static void
+lilv_search_index_sort(LilvSearchIndex* index)
+{
+	index->n_by_name = 0;
+	for (uint32_t r = 0; r < index->n_rows; ++r) {
+		if (bitset_get(index->live, r)) {
+			const LilvSearchName name = { index->names[r], r };
+			index->by_name[index->n_by_name++] = name;
+		}
+	}
+
+	qsort(index->by_name, index->n_by_name, sizeof(LilvSearchName),
+	      lilv_search_name_cmp);
+	index->sorted = true;
+}
+
+/** Return the first position in by_name with a name not less than `prefix`. */
+static uint32_t
+lilv_search_lower_bound(const LilvSearchIndex* index,
+                        const char*            prefix,
+                        size_t                 len)
+{
+	uint32_t lo = 0;
+	uint32_t hi = index->n_by_name;
+	while (lo < hi) {
+		const uint32_t mid = lo + (hi - lo) / 2;
+		if (strncmp(index->by_name[mid].name, prefix, len) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+LILV_API LilvSearchIndex*
+lilv_search_index_new(LilvWorld* world)
+{
+	LilvSearchIndex* index = (LilvSearchIndex*)calloc(1, sizeof(LilvSearchIndex));
+	index->world   = world;
+	index->version = world->plugins_version - 1;
+	index->rows    = zix_hash_new(lilv_search_row_hash,
+	                              lilv_search_row_equal,
+	                              sizeof(LilvSearchRow));
+	lilv_search_index_update(index);
+	return index;
+}
+
+LILV_API void
+lilv_search_index_free(LilvSearchIndex* index)
+{
+	if (!index) {
+		return;
+	}
+
+	for (uint32_t r = 0; r < index->n_rows; ++r) {
+		free(index->names[r]);
+	}
+	for (uint32_t a = 0; a < index->n_authors; ++a) {
+		free(index->author_names[a]);
+	}
+	for (uint32_t f = 0; f < index->n_features; ++f) {
+		lilv_node_free(index->features[f].uri);
+		free(index->features[f].rows);
+	}
+
+	zix_hash_free(index->rows);
+	free(index->plugins);
+	free(index->classes);
+	free(index->authors);
+	free(index->audio_ins);
+	free(index->audio_outs);
+	free(index->names);
+	free(index->by_name);
+	free(index->live);
+	free(index->has_ui);
+	free(index->matches);
+	free(index->named);
+	free(index->author_names);
+	free(index->features);
+	free(index);
+}
+
+LILV_API unsigned
+lilv_search_index_find(LilvSearchIndex*       index,
+                       const LilvSearchQuery* query,
+                       const LilvPlugin**     plugins,
+                       unsigned               max_plugins)
+{
+	lilv_search_index_update(index);
+
+	const uint32_t n_words = (index->n_rows + WORD_BITS - 1) / WORD_BITS;
+	uint64_t*      matches = index->matches;
+
+	// Start with live rows filtered by the boolean facets
+	for (uint32_t w = 0; w < n_words; ++w) {
+		matches[w] = index->live[w];
+		if (query->has_ui > 0) {
+			matches[w] &= index->has_ui[w];
+		} else if (query->has_ui == 0) {
+			matches[w] &= ~index->has_ui[w];
+		}
+	}
+
+	// Remove rows that require a feature which is not supported
+	for (uint32_t f = 0; query->features && f < index->n_features; ++f) {
+		bool supported = false;
+		for (const LilvNode* const* s = query->features; *s; ++s) {
+			if (lilv_node_equals(*s, index->features[f].uri)) {
+				supported = true;
+				break;
+			}
+		}
+		for (uint32_t w = 0; !supported && w < n_words; ++w) {
+			matches[w] &= ~index->features[f].rows[w];
+		}
+	}
+
+	// Keep only rows with a matching name, found by binary search
+	if (query->name_prefix && query->name_prefix[0]) {
+		if (!index->sorted) {
+			lilv_search_index_sort(index);
+		}
+
+		char* const    prefix = lilv_search_fold(query->name_prefix);
+		const size_t   len    = strlen(prefix);
+		const uint32_t begin  = lilv_search_lower_bound(index, prefix, len);
+		uint32_t       end    = begin;
+		while (end < index->n_by_name &&
+		       !strncmp(index->by_name[end].name, prefix, len)) {
+			++end;
+		}
+		free(prefix);
+
+		uint64_t* named = index->named;
+		memset(named, '\0', n_words * sizeof(uint64_t));
+		for (uint32_t i = begin; i < end; ++i) {
+			bitset_set(named, index->by_name[i].row, true);
+		}
+		for (uint32_t w = 0; w < n_words; ++w) {
+			matches[w] &= named[w];
+		}
+	}
+
+	const uint32_t author = (query->author_name
+	                         ? lilv_search_author(index, query->author_name, false)
+	                         : NO_AUTHOR);
+	if (query->author_name && author == NO_AUTHOR) {
+		return 0;
+	}
+
+	// Check the remaining facets of each candidate
+	unsigned n_matches = 0;
+	for (uint32_t w = 0; w < n_words; ++w) {
+		for (uint64_t bits = matches[w]; bits; bits &= bits - 1) {
+			const uint32_t r = w * WORD_BITS + bitset_lowest(bits);
+			if ((query->plugin_class &&
+			     !lilv_plugin_class_is_subclass_of(index->classes[r],
+			                                       query->plugin_class)) ||
+			    (query->author_name && index->authors[r] != author) ||
+			    (query->audio_inputs >= 0 &&
+			     index->audio_ins[r] != (uint32_t)query->audio_inputs) ||
+			    (query->audio_outputs >= 0 &&
+			     index->audio_outs[r] != (uint32_t)query->audio_outputs)) {
+				continue;
+			}
+
+			if (n_matches < max_plugins) {
+				plugins[n_matches] = index->plugins[r];
+			}
+			++n_matches;
+		}
+	}
+
+	return n_matches;
+}
@@ -55,20 +55,21 @@ typedef struct {
 } PropertyArray;
 
 struct LilvStateImpl {
-	LilvNode*     plugin_uri;   ///< Plugin URI
-	LilvNode*     uri;          ///< State/preset URI
-	char*         dir;          ///< Save directory (if saved)
-	char*         file_dir;     ///< Directory for files created by plugin
-	char*         copy_dir;     ///< Directory for snapshots of external files
-	char*         link_dir;     ///< Directory for links to external files
-	char*         label;        ///< State/Preset label
-	ZixTree*      abs2rel;      ///< PathMap sorted by abs
-	ZixTree*      rel2abs;      ///< PathMap sorted by rel
-	PropertyArray props;        ///< State properties
-	PropertyArray metadata;     ///< State metadata
-	PortValue*    values;       ///< Port values
-	uint32_t      atom_Path;    ///< atom:Path URID
-	uint32_t      n_values;     ///< Number of port values
+	LilvNode*      plugin_uri;   ///< Plugin URI
+	LilvNode*      uri;          ///< State/preset URI
+	char*          dir;          ///< Save directory (if saved)
+	char*          file_dir;     ///< Directory for files created by plugin
+	char*          copy_dir;     ///< Directory for snapshots of external files
+	char*          link_dir;     ///< Directory for links to external files
+	LilvCopyIndex* copy_index;   ///< Index of copy_dir, while saving
+	char*          label;        ///< State/Preset label
+	ZixTree*       abs2rel;      ///< PathMap sorted by abs
+	ZixTree*       rel2abs;      ///< PathMap sorted by rel
+	PropertyArray  props;        ///< State properties
+	PropertyArray  metadata;     ///< State metadata
+	PortValue*     values;       ///< Port values
+	uint32_t       atom_Path;    ///< atom:Path URID
+	uint32_t       n_values;     ///< Number of port values
 };
 
 static int
@@ -242,8 +243,12 @@ abstract_path(LV2_State_Map_Path_Handle handle,
 				lilv_mkdir_p(state->copy_dir);
 			}
 			char* cpath = lilv_path_join(state->copy_dir, path);
-			char* copy  = lilv_get_latest_copy(real_path, cpath);
-			if (!copy || !lilv_file_equals(real_path, copy)) {
+			char* copy  = NULL;
+			if (state->copy_index) {
+				copy = lilv_copy_index_get_copy(
+					state->copy_index, real_path, cpath);
+			} else if (!(copy = lilv_get_latest_copy(real_path, cpath)) ||
+			           !lilv_file_equals(real_path, copy)) {
 				// No recent enough copy, make a new one
 				free(copy);
 				copy = lilv_find_free_path(cpath, lilv_path_exists, NULL);
@@ -367,6 +372,9 @@ lilv_state_new_from_instance(const LilvPlugin*          plugin,
 	state->link_dir   = link_dir ? absolute_dir(link_dir) : NULL;
 	state->dir        = save_dir ? absolute_dir(save_dir) : NULL;
 	state->atom_Path  = map->map(map->handle, LV2_ATOM__Path);
+	if (state->copy_dir && world->opt.copy_index) {
+		state->copy_index = lilv_copy_index_new(state->copy_dir);
+	}
 
 	LV2_State_Map_Path  pmap          = { state, abstract_path, absolute_path };
 	LV2_Feature         pmap_feature  = { LV2_STATE__mapPath, &pmap };
@@ -414,6 +422,9 @@ lilv_state_new_from_instance(const LilvPlugin*          plugin,
 
 	qsort(state->values, state->n_values, sizeof(PortValue), value_cmp);
 
+	lilv_copy_index_free(state->copy_index);
+	state->copy_index = NULL;
+
 	free(sfeatures);
 	return state;
 }
@@ -446,6 +457,10 @@ lilv_state_restore(const LilvState*           state,
 		(LilvState*)state, abstract_path, absolute_path };
 	LV2_Feature map_feature = { LV2_STATE__mapPath, &map_path };
 
+	// Only restoring a loaded instance is traced, otherwise there is no world
+	const LilvLib* const lib   = instance ? (LilvLib*)instance->pimpl : NULL;
+	LilvWorld* const     world = lib ? lib->world : NULL;
+	const uint64_t       begin = world ? lilv_trace_begin(world) : 0;
 	if (instance) {
 		const LV2_Descriptor* desc = instance->lv2_descriptor;
 		if (desc->extension_data) {
@@ -468,6 +483,132 @@ lilv_state_restore(const LilvState*           state,
 	if (set_value) {
 		lilv_state_emit_port_values(state, set_value, user_data);
 	}
+
+	if (world) {
+		lilv_trace_end(world, LILV_TRACE_RESTORE_STATE,
+		               state->uri ? lilv_node_as_uri(state->uri) : NULL,
+		               begin, 0);
+	}
+}
+
+typedef struct {
+	uint32_t         index;  ///< Port index
+	const PortValue* value;  ///< Value in state
+} PreparedPortValue;
+
+struct LilvPreparedStateImpl {
+	const LilvState*           state;
+	const LV2_Descriptor*      descriptor;  ///< Descriptor of iface
+	const LV2_State_Interface* iface;       ///< State interface, or NULL
+	LV2_State_Map_Path         map_path;
+	LV2_Feature                map_feature;
+	const LV2_Feature**        features;    ///< Features including map_path
+	PreparedPortValue*         values;      ///< Port values sorted by index
+	uint32_t                   n_values;
+};
+
+static int
+prepared_value_cmp(const void* a, const void* b)
+{
+	const uint32_t ai = ((const PreparedPortValue*)a)->index;
+	const uint32_t bi = ((const PreparedPortValue*)b)->index;
+	return (ai < bi) ? -1 : (ai > bi);
+}
+
+LILV_API LilvPreparedState*
+lilv_state_prepare(const LilvState*           state,
+                   const LilvPlugin*          plugin,
+                   const LilvInstance*        instance,
+                   const LV2_Feature *const * features)
+{
+	if (!state) {
+		LILV_ERROR("lilv_state_prepare() called on NULL state\n");
+		return NULL;
+	}
+
+	LilvPreparedState* prepared = (LilvPreparedState*)calloc(
+		1, sizeof(LilvPreparedState));
+
+	const LV2_State_Map_Path map_path = {
+		(LilvState*)state, abstract_path, absolute_path };
+
+	prepared->state            = state;
+	prepared->map_path         = map_path;
+	prepared->map_feature.URI  = LV2_STATE__mapPath;
+	prepared->map_feature.data = &prepared->map_path;
+	prepared->features         = add_features(
+		features, &prepared->map_feature, NULL);
+
+	if (instance) {
+		const LV2_Descriptor* desc = instance->lv2_descriptor;
+		prepared->descriptor = desc;
+		if (desc->extension_data) {
+			prepared->iface = (const LV2_State_Interface*)
+				desc->extension_data(LV2_STATE__interface);
+		}
+	}
+
+	// Resolve port symbols to indices
+	prepared->values = (PreparedPortValue*)malloc(
+		state->n_values * sizeof(PreparedPortValue));
+	LilvNode* sym = NULL;
+	for (uint32_t i = 0; i < state->n_values; ++i) {
+		const PortValue* const value = &state->values[i];
+
+		lilv_node_free(sym);
+		sym = lilv_new_string(plugin->world, value->symbol);
+
+		const LilvPort* port = lilv_plugin_get_port_by_symbol(plugin, sym);
+		if (port) {
+			PreparedPortValue* pv = &prepared->values[prepared->n_values++];
+			pv->index = lilv_port_get_index(plugin, port);
+			pv->value = value;
+		} else {
+			LILV_WARNF("State has value for unknown port `%s'\n",
+			           value->symbol);
+		}
+	}
+	lilv_node_free(sym);
+
+	qsort(prepared->values, prepared->n_values, sizeof(PreparedPortValue),
+	      prepared_value_cmp);
+
+	return prepared;
+}
+
+LILV_API void
+lilv_prepared_state_apply(const LilvPreparedState*  prepared,
+                          LilvInstance*             instance,
+                          LilvSetPortIndexValueFunc set_value,
+                          void*                     user_data,
+                          uint32_t                  flags)
+{
+	if (instance && prepared->iface && prepared->iface->restore &&
+	    instance->lv2_descriptor == prepared->descriptor) {
+		prepared->iface->restore(instance->lv2_handle,
+		                         retrieve_callback,
+		                         (LV2_State_Handle)prepared->state,
+		                         flags,
+		                         prepared->features);
+	}
+
+	if (set_value) {
+		for (uint32_t i = 0; i < prepared->n_values; ++i) {
+			const PreparedPortValue* pv = &prepared->values[i];
+			set_value(pv->index, user_data,
+			          pv->value->value, pv->value->size, pv->value->type);
+		}
+	}
+}
+
+LILV_API void
+lilv_prepared_state_free(LilvPreparedState* prepared)
+{
+	if (prepared) {
+		free(prepared->features);
+		free(prepared->values);
+		free(prepared);
+	}
 }
 
 static LilvState*
@@ -564,8 +705,8 @@ new_state_from_model(LilvWorld*       world,
 	sord_iter_free(ports);
 
 	// Get properties
-	SordNode* statep     = sord_new_uri(world->world, USTR(LV2_STATE__state));
-	SordNode* state_node = sord_get(model, node, statep, NULL, NULL);
+	SordNode* state_node = sord_get(
+		model, node, world->uris.state_state, NULL, NULL);
 	if (state_node) {
 		SordIter* props = sord_search(model, state_node, 0, 0, 0);
 		FOREACH_MATCH(props) {
@@ -600,7 +741,6 @@ new_state_from_model(LilvWorld*       world,
 		sord_iter_free(props);
 	}
 	sord_node_free(world->world, state_node);
-	sord_node_free(world->world, statep);
 
 	free((void*)chunk.buf);
 	sratom_free(sratom);
@@ -682,27 +822,36 @@ set_prefixes(SerdEnv* env)
 	SET_PSET(env, USTR("xsd"),   USTR(LILV_NS_XSD));
 }
 
-LILV_API LilvState*
-lilv_state_new_from_string(LilvWorld*    world,
-                           LV2_URID_Map* map,
-                           const char*   str)
+/**
+   Parse a state from Turtle that `read` reads with `reader`.
+   If `strict` is true, no state is made from a document with errors.
+*/
+static LilvState*
+new_state_from_reader(LilvWorld*    world,
+                      LV2_URID_Map* map,
+                      SerdStatus (*read)(SerdReader* reader, void* data),
+                      void*         data,
+                      bool          strict)
 {
-	if (!str) {
-		return NULL;
-	}
-
 	SerdNode    base   = SERD_NODE_NULL;
 	SerdEnv*    env    = serd_env_new(&base);
 	SordModel*  model  = sord_new(world->world, SORD_SPO|SORD_OPS, false);
 	SerdReader* reader = sord_new_reader(model, env, SERD_TURTLE, NULL);
 
 	set_prefixes(env);
-	serd_reader_read_string(reader, USTR(str));
+	const SerdStatus st = read(reader, data);
 
 	SordNode* o = sord_new_uri(world->world, USTR(LV2_PRESETS__Preset));
 	SordNode* s = sord_get(model, NULL, world->uris.rdf_a, o, NULL);
 
-	LilvState* state = new_state_from_model(world, map, model, s, NULL);
+	// Do not make a partial state from a document that failed to parse
+	LilvState* state = NULL;
+	if (strict && st > SERD_FAILURE) {
+		LILV_ERRORF("Failed to read state (%s)\n",
+		            serd_strerror(st));
+	} else {
+		state = new_state_from_model(world, map, model, s, NULL);
+	}
 
 	sord_node_free(world->world, s);
 	sord_node_free(world->world, o);
@@ -713,6 +862,72 @@ lilv_state_new_from_string(LilvWorld*    world,
 	return state;
 }
 
+static SerdStatus
+read_string(SerdReader* reader, void* data)
+{
+	return serd_reader_read_string(reader, (const uint8_t*)data);
+}
+
+LILV_API LilvState*
+lilv_state_new_from_string(LilvWorld*    world,
+                           LV2_URID_Map* map,
+                           const char*   str)
+{
+	if (!str) {
+		return NULL;
+	}
+
+	return new_state_from_reader(world, map, read_string, (void*)str, false);
+}
+
+/** A LilvStateSource wrapped to be a SerdSource. */
+typedef struct {
+	LilvStateSource source;
+	void*           stream;
+	bool            failed;  ///< True if source returned an error
+} StateSource;
+
+static size_t
+state_source_read(void* buf, size_t size, size_t nmemb, void* stream)
+{
+	StateSource* const source = (StateSource*)stream;
+	const size_t       n      = source->source(buf, size * nmemb, source->stream);
+	if (n == LILV_STATE_SOURCE_ERROR) {
+		source->failed = true;
+		return 0;
+	}
+	return n / size;
+}
+
+static int
+state_source_error(void* stream)
+{
+	return ((StateSource*)stream)->failed;
+}
+
+static SerdStatus
+read_source(SerdReader* reader, void* data)
+{
+	const SerdStatus st = serd_reader_read_source(reader,
+	                                              state_source_read,
+	                                              state_source_error,
+	                                              data,
+	                                              USTR("(stream)"),
+	                                              SERD_PAGE_SIZE);
+
+	return ((StateSource*)data)->failed ? SERD_ERR_UNKNOWN : st;
+}
+
+LILV_API LilvState*
+lilv_state_new_from_stream(LilvWorld*      world,
+                           LV2_URID_Map*   map,
+                           LilvStateSource source,
+                           void*           stream)
+{
+	StateSource state_source = { source, stream, false };
+	return new_state_from_reader(world, map, read_source, &state_source, true);
+}
+
 static SerdWriter*
 ttl_writer(SerdSink sink, void* stream, const SerdNode* base, SerdEnv** new_env)
 {
@@ -788,27 +1003,22 @@ remove_manifest_entry(SordWorld* world, SordModel* model, const char* subject)
 	sord_node_free(world, s);
 }
 
-static int
-add_state_to_manifest(LilvWorld*      lworld,
-                      const LilvNode* plugin_uri,
-                      const char*     manifest_path,
-                      const char*     state_uri,
-                      const char*     state_path)
-{
-	SordWorld*  world    = lworld->world;
-	SerdNode    manifest = serd_node_new_file_uri(USTR(manifest_path), 0, 0, 0);
-	SerdNode    file     = serd_node_new_file_uri(USTR(state_path), 0, 0, 0);
-	SerdEnv*    env      = serd_env_new(&manifest);
-	SordModel*  model    = sord_new(world, SORD_SPO, false);
+/** A state to add to a bundle manifest. */
+typedef struct {
+	const LilvNode* plugin_uri;  ///< URI of plugin state applies to
+	const char*     state_uri;   ///< URI of state, or NULL to use file URI
+	const char*     state_path;  ///< Path of state file
+} ManifestEntry;
 
-	FILE* rfd = fopen(manifest_path, "r");
-	if (rfd) {
-		// Read manifest into model
-		SerdReader* reader = sord_new_reader(model, env, SERD_TURTLE, NULL);
-		lilv_flock(rfd, true);
-		serd_reader_read_file_handle(reader, rfd, manifest.buf);
-		serd_reader_free(reader);
-	}
+static void
+add_manifest_entry(SordWorld*           world,
+                   SerdEnv*             env,
+                   SordModel*           model,
+                   const ManifestEntry* entry)
+{
+	SerdNode    file      = serd_node_new_file_uri(
+		USTR(entry->state_path), 0, 0, 0);
+	const char* state_uri = entry->state_uri;
 
 	// Choose state URI (use file URI if not given)
 	if (!state_uri) {
@@ -821,12 +1031,6 @@ add_state_to_manifest(LilvWorld*      lworld,
 	// Add manifest entry for this state to model
 	SerdNode s = serd_node_from_string(SERD_URI, USTR(state_uri));
 
-	// <state> a pset:Preset
-	add_to_model(world, env, model,
-	             s,
-	             serd_node_from_string(SERD_URI, USTR(LILV_NS_RDF "type")),
-	             serd_node_from_string(SERD_URI, USTR(LV2_PRESETS__Preset)));
-
 	// <state> a pset:Preset
 	add_to_model(world, env, model,
 	             s,
@@ -843,8 +1047,36 @@ add_state_to_manifest(LilvWorld*      lworld,
 	add_to_model(world, env, model,
 	             s,
 	             serd_node_from_string(SERD_URI, USTR(LV2_CORE__appliesTo)),
-	             serd_node_from_string(SERD_URI,
-	                                   USTR(lilv_node_as_string(plugin_uri))));
+	             serd_node_from_string(
+		             SERD_URI, USTR(lilv_node_as_string(entry->plugin_uri))));
+
+	serd_node_free(&file);
+}
+
+/** Add entries for several states to a manifest, rewriting it once. */
+static int
+add_states_to_manifest(LilvWorld*           lworld,
+                       const char*          manifest_path,
+                       const ManifestEntry* entries,
+                       size_t               n_entries)
+{
+	SordWorld*  world    = lworld->world;
+	SerdNode    manifest = serd_node_new_file_uri(USTR(manifest_path), 0, 0, 0);
+	SerdEnv*    env      = serd_env_new(&manifest);
+	SordModel*  model    = sord_new(world, SORD_SPO, false);
+
+	FILE* rfd = fopen(manifest_path, "r");
+	if (rfd) {
+		// Read manifest into model
+		SerdReader* reader = sord_new_reader(model, env, SERD_TURTLE, NULL);
+		lilv_flock(rfd, true);
+		serd_reader_read_file_handle(reader, rfd, manifest.buf);
+		serd_reader_free(reader);
+	}
+
+	for (size_t i = 0; i < n_entries; ++i) {
+		add_manifest_entry(world, env, model, &entries[i]);
+	}
 
 	// Write manifest model to file
 	FILE* wfd = fopen(manifest_path, "w");
@@ -859,7 +1091,6 @@ add_state_to_manifest(LilvWorld*      lworld,
 	}
 
 	sord_free(model);
-	serd_node_free(&file);
 	serd_node_free(&manifest);
 	serd_env_free(env);
 
@@ -1054,6 +1285,91 @@ lilv_state_make_links(const LilvState* state, const char* dir)
 	}
 }
 
+/** A state file being saved by lilv_state_save() or lilv_state_save_batch(). */
+typedef struct {
+	const LilvState* state;
+	const char*      uri;      ///< URI of state, or NULL
+	char*            abs_dir;  ///< Absolute path of bundle directory
+	char*            path;     ///< Absolute path of state file
+	char*            subject;  ///< URI of state in written file
+	FILE*            fd;       ///< State file while open for writing
+	int              status;   ///< Zero on success
+} StateSaveJob;
+
+/** Create the bundle directory and open the state file for writing. */
+static int
+state_save_job_open(StateSaveJob*    job,
+                    const LilvState* state,
+                    const char*      uri,
+                    const char*      dir,
+                    const char*      filename)
+{
+	memset(job, '\0', sizeof(StateSaveJob));
+	job->state = state;
+	job->uri   = uri;
+	if (!filename || !dir || lilv_mkdir_p(dir)) {
+		return (job->status = 1);
+	}
+
+	job->abs_dir = absolute_dir(dir);
+	job->path    = lilv_path_join(job->abs_dir, filename);
+	job->fd      = fopen(job->path, "w");
+	if (!job->fd) {
+		LILV_ERRORF("Failed to open %s (%s)\n", job->path, strerror(errno));
+		free(job->abs_dir);
+		free(job->path);
+		job->abs_dir = job->path = NULL;
+		return (job->status = 4);
+	}
+
+	return 0;
+}
+
+/** Write the state file, this only uses serd and may be called in any thread. */
+static void
+state_save_job_write(LilvWorld*       world,
+                     LV2_URID_Map*    map,
+                     LV2_URID_Unmap*  unmap,
+                     StateSaveJob*    job)
+{
+	SerdNode    file = serd_node_new_file_uri(
+		USTR(job->path), NULL, NULL, false);
+	SerdNode    node = job->uri
+		? serd_node_from_string(SERD_URI, USTR(job->uri))
+		: file;
+	SerdEnv*    env  = NULL;
+	SerdWriter* ttl  = ttl_file_writer(job->fd, &file, &env);
+
+	job->status = lilv_state_write(world, map, unmap, job->state, ttl,
+	                               (const char*)node.buf, job->abs_dir);
+	job->subject = lilv_strdup((const char*)node.buf);
+
+	serd_node_free(&file);
+	serd_writer_free(ttl);
+	serd_env_free(env);
+	fclose(job->fd);
+	job->fd = NULL;
+}
+
+/** Set the saved dir and URI of the state and free the job. */
+static void
+state_save_job_finish(LilvWorld* world, StateSaveJob* job)
+{
+	if (job->subject) {
+		// FIXME: const violation
+		SerdNode dir_uri = serd_node_new_file_uri(
+			USTR(job->abs_dir), NULL, NULL, false);
+		free(job->state->dir);
+		lilv_node_free(job->state->uri);
+		((LilvState*)job->state)->dir = (char*)dir_uri.buf;
+		((LilvState*)job->state)->uri = lilv_new_uri(world, job->subject);
+	}
+
+	free(job->subject);
+	free(job->abs_dir);
+	free(job->path);
+}
+
 LILV_API int
 lilv_state_save(LilvWorld*       world,
                 LV2_URID_Map*    map,
@@ -1062,6 +1378,367 @@ lilv_state_save(LilvWorld*       world,
                 const char*      uri,
                 const char*      dir,
                 const char*      filename)
+{
+	const uint64_t begin = lilv_trace_begin(world);
+	StateSaveJob   job;
+	if (state_save_job_open(&job, state, uri, dir, filename)) {
+		return job.status;
+	}
+
+	// Create symlinks to files if necessary
+	lilv_state_make_links(state, job.abs_dir);
+
+	// Write state to Turtle file
+	state_save_job_write(world, map, unmap, &job);
+
+	// Add entry to manifest
+	const ManifestEntry entry    = { state->plugin_uri, uri, job.path };
+	char* const         manifest = lilv_path_join(job.abs_dir, "manifest.ttl");
+	add_states_to_manifest(world, manifest, &entry, 1);
+	free(manifest);
+
+	const int ret = job.status;
+	state_save_job_finish(world, &job);
+	lilv_trace_end(world, LILV_TRACE_SAVE_STATE, uri, begin, 0);
+	return ret;
+}
+
+typedef struct {
+	LilvWorld*      world;
+	LV2_URID_Map*   map;
+	LV2_URID_Unmap* unmap;
+	StateSaveJob*   jobs;
+	size_t          n_jobs;
+	size_t          next;   ///< Index of next job to write
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t mutex;  ///< Protects next
+#endif
+} StateSaveBatch;
+
+static void*
+state_save_batch_run(void* data)
+{
+	StateSaveBatch* batch = (StateSaveBatch*)data;
+	for (;;) {
+#ifdef HAVE_PTHREAD
+		pthread_mutex_lock(&batch->mutex);
+#endif
+		const size_t i = batch->next++;
+#ifdef HAVE_PTHREAD
+		pthread_mutex_unlock(&batch->mutex);
+#endif
+		if (i >= batch->n_jobs) {
+			break;
+		} else if (batch->jobs[i].fd) {
+			state_save_job_write(
+				batch->world, batch->map, batch->unmap, &batch->jobs[i]);
+		}
+	}
+	return NULL;
+}
+
+static int
+job_dir_cmp(const void* a, const void* b)
+{
+	const StateSaveJob* ja = *(const StateSaveJob* const*)a;
+	const StateSaveJob* jb = *(const StateSaveJob* const*)b;
+	return strcmp(ja->abs_dir, jb->abs_dir);
+}
+
+/** Update the manifest of every bundle saved to once. */
+static void
+state_save_batch_write_manifests(StateSaveBatch* batch)
+{
+	StateSaveJob** saved   = (StateSaveJob**)malloc(
+		batch->n_jobs * sizeof(StateSaveJob*));
+	size_t         n_saved = 0;
+	for (size_t i = 0; i < batch->n_jobs; ++i) {
+		if (batch->jobs[i].subject) {
+			saved[n_saved++] = &batch->jobs[i];
+		}
+	}
+
+	qsort(saved, n_saved, sizeof(StateSaveJob*), job_dir_cmp);
+
+	ManifestEntry* entries = (ManifestEntry*)malloc(
+		(n_saved ? n_saved : 1) * sizeof(ManifestEntry));
+	for (size_t i = 0; i < n_saved;) {
+		// Collect entries for all states saved to this bundle
+		size_t n_entries = 0;
+		size_t j         = i;
+		for (; j < n_saved && !strcmp(saved[j]->abs_dir, saved[i]->abs_dir);
+		     ++j) {
+			const ManifestEntry entry = {
+				saved[j]->state->plugin_uri, saved[j]->uri, saved[j]->path };
+			entries[n_entries++] = entry;
+		}
+
+		char* const manifest = lilv_path_join(saved[i]->abs_dir,
+		                                      "manifest.ttl");
+		add_states_to_manifest(batch->world, manifest, entries, n_entries);
+		free(manifest);
+		i = j;
+	}
+
+	free(entries);
+	free(saved);
+}
+
+LILV_API unsigned
+lilv_state_save_batch(LilvWorld*                  world,
+                      LV2_URID_Map*               map,
+                      LV2_URID_Unmap*             unmap,
+                      const LilvStateSaveRequest* requests,
+                      size_t                      n_requests,
+                      unsigned                    n_threads,
+                      LilvStateSavedFunc          saved,
+                      void*                       user_data)
+{
+	StateSaveBatch batch;
+	memset(&batch, '\0', sizeof(batch));
+	batch.world  = world;
+	batch.map    = map;
+	batch.unmap  = unmap;
+	batch.jobs   = (StateSaveJob*)calloc(n_requests, sizeof(StateSaveJob));
+	batch.n_jobs = n_requests;
+
+	// Open files and create links, which may share directories, serially
+	for (size_t i = 0; i < n_requests; ++i) {
+		const LilvStateSaveRequest* r = &requests[i];
+		if (!state_save_job_open(&batch.jobs[i], r->state, r->uri,
+		                         r->dir, r->filename)) {
+			lilv_state_make_links(r->state, batch.jobs[i].abs_dir);
+		}
+	}
+
+	// Write state files, in parallel if possible
+#ifdef HAVE_PTHREAD
+	if (n_threads > n_requests) {
+		n_threads = (unsigned)n_requests;
+	}
+
+	pthread_t* threads   = (pthread_t*)calloc(n_threads, sizeof(pthread_t));
+	unsigned   n_started = 0;
+	pthread_mutex_init(&batch.mutex, NULL);
+	for (unsigned i = 1; i < n_threads; ++i) {
+		if (!pthread_create(&threads[n_started], NULL,
+		                    state_save_batch_run, &batch)) {
+			++n_started;
+		}
+	}
+	state_save_batch_run(&batch);
+	for (unsigned i = 0; i < n_started; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+	pthread_mutex_destroy(&batch.mutex);
+	free(threads);
+#else
+	state_save_batch_run(&batch);
+#endif
+
+	// Update each manifest once, then report results
+	state_save_batch_write_manifests(&batch);
+
+	unsigned n_failed = 0;
+	for (size_t i = 0; i < n_requests; ++i) {
+		StateSaveJob* job    = &batch.jobs[i];
+		const int     status = job->status;
+		n_failed += (status != 0);
+		state_save_job_finish(world, job);
+		if (saved) {
+			saved(requests[i].state, status, user_data);
+		}
+	}
+
+	free(batch.jobs);
+	return n_failed;
+}
+
+LILV_API char*
+lilv_state_to_string(LilvWorld*       world,
+                     LV2_URID_Map*    map,
+                     LV2_URID_Unmap*  unmap,
+                     const LilvState* state,
+                     const char*      uri,
+                     const char*      base_uri)
+{
+	if (!uri) {
+		LILV_ERROR("Attempt to serialise state with no URI\n");
+		return NULL;
+	}
+
+	SerdChunk   chunk  = { NULL, 0 };
+	SerdEnv*    env    = NULL;
+	SerdNode    base   = serd_node_from_string(SERD_URI, USTR(base_uri));
+	SerdWriter* writer = ttl_writer(serd_chunk_sink, &chunk, &base, &env);
+
+	lilv_state_write(world, map, unmap, state, writer, uri, NULL);
+
+	serd_writer_free(writer);
+	serd_env_free(env);
+	return (char*)serd_chunk_sink_finish(&chunk);
+}
+
+/** A LilvStateSink wrapped to be a SerdSink that remembers failure. */
+typedef struct {
+	LilvStateSink sink;
+	void*         stream;
+	bool          failed;
+} StateSink;
+
+static size_t
+state_sink_write(const void* buf, size_t len, void* stream)
+{
+	StateSink* const sink = (StateSink*)stream;
+	if (sink->failed) {
+		return 0;
+	}
+
+	const size_t n_written = sink->sink(buf, len, sink->stream);
+	sink->failed = n_written < len;
+	return n_written;
+}
+
+LILV_API int
+lilv_state_write_stream(LilvWorld*       world,
+                        LV2_URID_Map*    map,
+                        LV2_URID_Unmap*  unmap,
+                        const LilvState* state,
+                        const char*      uri,
+                        const char*      base_uri,
+                        LilvStateSink    sink,
+                        void*            stream)
+{
+	if (!uri) {
+		LILV_ERROR("Attempt to serialise state with no URI\n");
+		return 1;
+	}
+
+	StateSink   state_sink = { sink, stream, false };
+	SerdEnv*    env        = NULL;
+	SerdNode    base       = serd_node_from_string(SERD_URI, USTR(base_uri));
+	SerdWriter* writer     = ttl_writer(
+		state_sink_write, &state_sink, &base, &env);
+
+	lilv_state_write(world, map, unmap, state, writer, uri, NULL);
+
+	serd_writer_free(writer);
+	serd_env_free(env);
+	return state_sink.failed;
+}
+
+/*
+  The binary state format is a header, a string table, and the port values,
+  properties, and metadata of the state.  URIDs are stored as offsets of
+  their URI in the string table so the file is independent of the URID map.
+  All integers are in native byte order, the header records the order so a
+  file from another machine is rejected.
+
+  Header:    "LILVSTAT", uint32 version, uint32 byte order mark,
+             uint32 strings_size, uint32 n_values, uint32 n_props,
+             uint32 n_metadata, uint32 plugin_uri, uint32 uri, uint32 label
+  Strings:   strings_size bytes of null-terminated strings
+  Value:     uint32 symbol, uint32 type, uint32 size, value
+  Property:  uint32 key, uint32 type, uint32 flags, uint32 size, value
+
+  Properties are followed by metadata, both in the same format.  An absent
+  string is stored as LILV_STATE_NO_STRING.  Paths are stored as abstract
+  paths relative to the state directory, like in Turtle.
+*/
+
+#define LILV_STATE_MAGIC     "LILVSTAT"
+#define LILV_STATE_VERSION   1U
+#define LILV_STATE_BOM       0x01020304U
+#define LILV_STATE_NO_STRING UINT32_MAX
+
+typedef struct {
+	uint32_t urid;
+	uint32_t offset;
+} StringOffset;
+
+typedef struct {
+	LilvBuffer      buffer;   ///< Null-terminated strings
+	ZixHash*        offsets;  ///< StringOffset of URIs by URID
+	LV2_URID_Unmap* unmap;
+} StringTable;
+
+static uint32_t
+string_offset_hash(const void* value)
+{
+	const uint64_t urid = ((const StringOffset*)value)->urid;
+	return (uint32_t)((urid * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+static bool
+string_offset_equal(const void* a, const void* b)
+{
+	return ((const StringOffset*)a)->urid == ((const StringOffset*)b)->urid;
+}
+
+static uint32_t
+string_table_add(StringTable* table, const char* str)
+{
+	if (!str) {
+		return LILV_STATE_NO_STRING;
+	}
+
+	const uint32_t offset = (uint32_t)table->buffer.len;
+	lilv_buffer_append(&table->buffer, str, strlen(str) + 1);
+	return offset;
+}
+
+static uint32_t
+string_table_add_urid(StringTable* table, uint32_t urid)
+{
+	const StringOffset  key   = { urid, 0 };
+	const StringOffset* found = (const StringOffset*)zix_hash_find(
+		table->offsets, &key);
+	if (found) {
+		return found->offset;
+	}
+
+	const char*        uri   = table->unmap->unmap(table->unmap->handle, urid);
+	const StringOffset entry = { urid, string_table_add(table, uri) };
+	zix_hash_insert(table->offsets, &entry, NULL);
+	return entry.offset;
+}
+
+static void
+write_binary_property_array(const LilvState*     state,
+                            const PropertyArray* array,
+                            StringTable*         strings,
+                            LilvBuffer*          body,
+                            uint32_t*            n_written)
+{
+	*n_written = 0;
+	for (uint32_t i = 0; i < array->n; ++i) {
+		const Property* const prop = &array->props[i];
+		if (!(prop->flags & LV2_STATE_IS_POD) &&
+		    prop->type != state->atom_Path) {
+			LILV_WARNF("Lost non-POD property <%s> on save\n",
+			           strings->unmap->unmap(strings->unmap->handle,
+			                                 prop->key));
+			continue;
+		}
+
+		const uint32_t key  = string_table_add_urid(strings, prop->key);
+		const uint32_t type = string_table_add_urid(strings, prop->type);
+		lilv_buffer_append_u32(body, key);
+		lilv_buffer_append_u32(body, type);
+		lilv_buffer_append_u32(body, prop->flags);
+		lilv_buffer_append_u32(body, (uint32_t)prop->size);
+		lilv_buffer_append(body, prop->value, prop->size);
+		++*n_written;
+	}
+}
+
+LILV_API int
+lilv_state_save_binary(LilvWorld*       world,
+                       LV2_URID_Unmap*  unmap,
+                       const LilvState* state,
+                       const char*      uri,
+                       const char*      dir,
+                       const char*      filename)
 {
 	if (!filename || !dir || lilv_mkdir_p(dir)) {
 		return 1;
@@ -1069,7 +1746,7 @@ lilv_state_save(LilvWorld*       world,
 
 	char*       abs_dir = absolute_dir(dir);
 	char* const path    = lilv_path_join(abs_dir, filename);
-	FILE*       fd      = fopen(path, "w");
+	FILE*       fd      = fopen(path, "wb");
 	if (!fd) {
 		LILV_ERRORF("Failed to open %s (%s)\n", path, strerror(errno));
 		free(abs_dir);
@@ -1080,59 +1757,232 @@ lilv_state_save(LilvWorld*       world,
 	// Create symlinks to files if necessary
 	lilv_state_make_links(state, abs_dir);
 
-	// Write state to Turtle file
-	SerdNode    file = serd_node_new_file_uri(USTR(path), NULL, NULL, false);
-	SerdNode    node = uri ? serd_node_from_string(SERD_URI, USTR(uri)) : file;
-	SerdEnv*    env  = NULL;
-	SerdWriter* ttl  = ttl_file_writer(fd, &file, &env);
-	int         ret  = lilv_state_write(
-		world, map, unmap, state, ttl, (const char*)node.buf, dir);
+	StringTable strings = {
+		{ NULL, 0, 0 },
+		zix_hash_new(string_offset_hash, string_offset_equal,
+		             sizeof(StringOffset)),
+		unmap };
+
+	const uint32_t plugin_uri = string_table_add(
+		&strings, lilv_node_as_uri(state->plugin_uri));
+	const uint32_t state_uri = string_table_add(&strings, uri);
+	const uint32_t label     = string_table_add(&strings, state->label);
+
+	// Write port values
+	LilvBuffer body = { NULL, 0, 0 };
+	for (uint32_t i = 0; i < state->n_values; ++i) {
+		const PortValue* const value = &state->values[i];
+		const uint32_t symbol = string_table_add(&strings, value->symbol);
+		const uint32_t type   = string_table_add_urid(&strings, value->type);
+		lilv_buffer_append_u32(&body, symbol);
+		lilv_buffer_append_u32(&body, type);
+		lilv_buffer_append_u32(&body, value->size);
+		lilv_buffer_append(&body, value->value, value->size);
+	}
+
+	// Write properties and metadata
+	uint32_t n_props, n_metadata;
+	write_binary_property_array(
+		state, &state->props, &strings, &body, &n_props);
+	write_binary_property_array(
+		state, &state->metadata, &strings, &body, &n_metadata);
+
+	const uint32_t header[] = { LILV_STATE_VERSION, LILV_STATE_BOM,
+	                            (uint32_t)strings.buffer.len, state->n_values,
+	                            n_props, n_metadata,
+	                            plugin_uri, state_uri, label };
+
+	int ret = 0;
+	if (fwrite(LILV_STATE_MAGIC, 8, 1, fd) != 1 ||
+	    fwrite(header, sizeof(header), 1, fd) != 1 ||
+	    (strings.buffer.len &&
+	     fwrite(strings.buffer.buf, strings.buffer.len, 1, fd) != 1) ||
+	    (body.len && fwrite(body.buf, body.len, 1, fd) != 1)) {
+		LILV_ERRORF("Failed to write %s (%s)\n", path, strerror(errno));
+		ret = 4;
+	}
+	fclose(fd);
+
+	free(body.buf);
+	free(strings.buffer.buf);
+	zix_hash_free(strings.offsets);
 
 	// Set saved dir and uri (FIXME: const violation)
+	SerdNode file    = serd_node_new_file_uri(USTR(path), NULL, NULL, false);
 	SerdNode dir_uri = serd_node_new_file_uri(USTR(abs_dir), NULL, NULL, false);
 	free(state->dir);
 	lilv_node_free(state->uri);
 	((LilvState*)state)->dir = (char*)dir_uri.buf;
-	((LilvState*)state)->uri = lilv_new_uri(world, (const char*)node.buf);
+	((LilvState*)state)->uri = lilv_new_uri(
+		world, uri ? uri : (const char*)file.buf);
 
 	serd_node_free(&file);
-	serd_writer_free(ttl);
-	serd_env_free(env);
-	fclose(fd);
-
-	// Add entry to manifest
-	char* const manifest = lilv_path_join(abs_dir, "manifest.ttl");
-	add_state_to_manifest(world, state->plugin_uri, manifest, uri, path);
-
-	free(manifest);
 	free(abs_dir);
 	free(path);
 	return ret;
 }
 
-LILV_API char*
-lilv_state_to_string(LilvWorld*       world,
-                     LV2_URID_Map*    map,
-                     LV2_URID_Unmap*  unmap,
-                     const LilvState* state,
-                     const char*      uri,
-                     const char*      base_uri)
+/** Return the string at `offset`, or NULL if it is absent or invalid. */
+static const char*
+read_binary_string(const char* strings, uint32_t size, uint32_t offset)
 {
-	if (!uri) {
-		LILV_ERROR("Attempt to serialise state with no URI\n");
+	return offset < size ? strings + offset : NULL;
+}
+
+static bool
+read_binary_property_array(LilvState*      state,
+                           PropertyArray*  array,
+                           LV2_URID_Map*   map,
+                           const char*     strings,
+                           uint32_t        strings_size,
+                           uint32_t        n_props,
+                           const uint8_t** ptr,
+                           const uint8_t*  end)
+{
+	for (uint32_t i = 0; i < n_props; ++i) {
+		uint32_t key, type, flags, size;
+		if (!lilv_read_bytes(ptr, end, &key, sizeof(key)) ||
+		    !lilv_read_bytes(ptr, end, &type, sizeof(type)) ||
+		    !lilv_read_bytes(ptr, end, &flags, sizeof(flags)) ||
+		    !lilv_read_bytes(ptr, end, &size, sizeof(size)) ||
+		    (size_t)(end - *ptr) < size) {
+			return false;
+		}
+
+		const char* key_uri  = read_binary_string(strings, strings_size, key);
+		const char* type_uri = read_binary_string(strings, strings_size, type);
+		if (!key_uri || !type_uri) {
+			return false;
+		}
+
+		const uint8_t* value = *ptr;
+		*ptr += size;
+
+		const uint32_t type_urid = map->map(map->handle, type_uri);
+		if (type_urid == state->atom_Path && state->dir && size > 0 &&
+		    value[size - 1] == '\0' &&
+		    !lilv_path_is_absolute((const char*)value)) {
+			// Make path absolute, like paths loaded from Turtle
+			char* abs_path = lilv_path_join(state->dir, (const char*)value);
+			append_property(state, array, map->map(map->handle, key_uri),
+			                abs_path, strlen(abs_path) + 1, type_urid, flags);
+			free(abs_path);
+		} else {
+			append_property(state, array, map->map(map->handle, key_uri),
+			                value, size, type_urid, flags | LV2_STATE_IS_POD);
+		}
+	}
+
+	qsort(array->props, array->n, sizeof(Property), property_cmp);
+	return true;
+}
+
+static LilvState*
+new_state_from_binary(LilvWorld*     world,
+                      LV2_URID_Map*  map,
+                      const uint8_t* data,
+                      size_t         size,
+                      const char*    dir)
+{
+	const uint8_t* ptr = data;
+	const uint8_t* end = data + size;
+
+	char     magic[8];
+	uint32_t header[9];
+	if (!lilv_read_bytes(&ptr, end, magic, sizeof(magic)) ||
+	    memcmp(magic, LILV_STATE_MAGIC, sizeof(magic)) ||
+	    !lilv_read_bytes(&ptr, end, header, sizeof(header)) ||
+	    header[0] != LILV_STATE_VERSION ||
+	    header[1] != LILV_STATE_BOM ||
+	    (size_t)(end - ptr) < header[2] ||
+	    (header[2] && ptr[header[2] - 1] != '\0')) {
 		return NULL;
 	}
 
-	SerdChunk   chunk  = { NULL, 0 };
-	SerdEnv*    env    = NULL;
-	SerdNode    base   = serd_node_from_string(SERD_URI, USTR(base_uri));
-	SerdWriter* writer = ttl_writer(serd_chunk_sink, &chunk, &base, &env);
+	const uint32_t strings_size = header[2];
+	const uint32_t n_values     = header[3];
+	const uint32_t n_props      = header[4];
+	const uint32_t n_metadata   = header[5];
+	const char*    strings      = (const char*)ptr;
+	const char*    plugin_uri   = read_binary_string(
+		strings, strings_size, header[6]);
+	const char* uri   = read_binary_string(strings, strings_size, header[7]);
+	const char* label = read_binary_string(strings, strings_size, header[8]);
+	if (!plugin_uri) {
+		return NULL;
+	}
+	ptr += strings_size;
 
-	lilv_state_write(world, map, unmap, state, writer, uri, NULL);
+	LilvState* const state = (LilvState*)calloc(1, sizeof(LilvState));
+	state->dir        = lilv_strdup(dir);
+	state->atom_Path  = map->map(map->handle, LV2_ATOM__Path);
+	state->plugin_uri = lilv_new_uri(world, plugin_uri);
+	state->uri        = uri ? lilv_new_uri(world, uri) : NULL;
+	if (label) {
+		lilv_state_set_label(state, label);
+	}
 
-	serd_writer_free(writer);
-	serd_env_free(env);
-	return (char*)serd_chunk_sink_finish(&chunk);
+	// Read port values
+	bool valid = true;
+	for (uint32_t i = 0; valid && i < n_values; ++i) {
+		uint32_t symbol, type, value_size;
+		valid = (lilv_read_bytes(&ptr, end, &symbol, sizeof(symbol)) &&
+		         lilv_read_bytes(&ptr, end, &type, sizeof(type)) &&
+		         lilv_read_bytes(&ptr, end, &value_size, sizeof(value_size)) &&
+		         (size_t)(end - ptr) >= value_size);
+
+		const char* sym = read_binary_string(strings, strings_size, symbol);
+		const char* typ = read_binary_string(strings, strings_size, type);
+		if (valid && sym && typ) {
+			append_port_value(state, sym, ptr, value_size,
+			                  map->map(map->handle, typ));
+			ptr += value_size;
+		} else {
+			valid = false;
+		}
+	}
+
+	// Read properties and metadata
+	if (!valid ||
+	    !read_binary_property_array(state, &state->props, map,
+	                                strings, strings_size, n_props,
+	                                &ptr, end) ||
+	    !read_binary_property_array(state, &state->metadata, map,
+	                                strings, strings_size, n_metadata,
+	                                &ptr, end)) {
+		lilv_state_free(state);
+		return NULL;
+	}
+
+	qsort(state->values, state->n_values, sizeof(PortValue), value_cmp);
+	return state;
+}
+
+LILV_API LilvState*
+lilv_state_new_from_binary(LilvWorld*    world,
+                           LV2_URID_Map* map,
+                           const char*   path)
+{
+	size_t   size   = 0;
+	bool     mapped = false;
+	uint8_t* data   = lilv_file_map(path, &size, &mapped);
+	if (!data) {
+		LILV_ERRORF("Failed to read %s\n", path);
+		return NULL;
+	}
+
+	char*      dirname   = lilv_dirname(path);
+	char*      real_path = lilv_realpath(dirname);
+	LilvState* state     = new_state_from_binary(
+		world, map, data, size, real_path);
+	if (!state) {
+		LILV_ERRORF("Invalid binary state file %s\n", path);
+	}
+
+	free(dirname);
+	free(real_path);
+	lilv_file_unmap(data, size, mapped);
+	return state;
 }
 
 LILV_API int
@@ -1175,6 +2025,7 @@ lilv_state_delete(LilvWorld*       world,
 		world->world, model, lilv_node_as_string(state->uri));
 	remove_manifest_entry(
 		world->world, world->model, lilv_node_as_string(state->uri));
+	lilv_world_model_changed(world);
 
 	// Drop bundle from model
 	lilv_world_unload_bundle(world, bundle);
@@ -1241,6 +2092,30 @@ lilv_state_free(LilvState* state)
 	}
 }
 
+static bool
+port_value_equals(const PortValue* a, const PortValue* b)
+{
+	return (a->size == b->size && a->type == b->type
+	        && !strcmp(a->symbol, b->symbol)
+	        && !memcmp(a->value, b->value, a->size));
+}
+
+static bool
+property_equals(const LilvState* a_state,
+                const Property*  a,
+                const LilvState* b_state,
+                const Property*  b)
+{
+	if (a->key != b->key || a->type != b->type || a->flags != b->flags) {
+		return false;
+	} else if (a->type == a_state->atom_Path) {
+		return lilv_file_equals(lilv_state_rel2abs(a_state, (char*)a->value),
+		                        lilv_state_rel2abs(b_state, (char*)b->value));
+	}
+
+	return a->size == b->size && !memcmp(a->value, b->value, a->size);
+}
+
 LILV_API bool
 lilv_state_equals(const LilvState* a, const LilvState* b)
 {
@@ -1254,29 +2129,13 @@ lilv_state_equals(const LilvState* a, const LilvState* b)
 	}
 
 	for (uint32_t i = 0; i < a->n_values; ++i) {
-		PortValue* const av = &a->values[i];
-		PortValue* const bv = &b->values[i];
-		if (av->size != bv->size || av->type != bv->type
-		    || strcmp(av->symbol, bv->symbol)
-		    || memcmp(av->value, bv->value, av->size)) {
+		if (!port_value_equals(&a->values[i], &b->values[i])) {
 			return false;
 		}
 	}
 
 	for (uint32_t i = 0; i < a->props.n; ++i) {
-		Property* const ap = &a->props.props[i];
-		Property* const bp = &b->props.props[i];
-		if (ap->key != bp->key
-		    || ap->type != bp->type
-		    || ap->flags != bp->flags) {
-			return false;
-		} else if (ap->type == a->atom_Path) {
-			if (!lilv_file_equals(lilv_state_rel2abs(a, (char*)ap->value),
-			                      lilv_state_rel2abs(b, (char*)bp->value))) {
-				return false;
-			}
-		} else if (ap->size != bp->size
-		           || memcmp(ap->value, bp->value, ap->size)) {
+		if (!property_equals(a, &a->props.props[i], b, &b->props.props[i])) {
 			return false;
 		}
 	}
@@ -1284,6 +2143,149 @@ lilv_state_equals(const LilvState* a, const LilvState* b)
 	return true;
 }
 
+/** Return a new empty state with the same plugin and directories as `state`. */
+static LilvState*
+lilv_state_new_like(const LilvState* state)
+{
+	LilvState* const result = (LilvState*)calloc(1, sizeof(LilvState));
+	result->plugin_uri = lilv_node_duplicate(state->plugin_uri);
+	result->dir        = lilv_strdup(state->dir);
+	result->file_dir   = lilv_strdup(state->file_dir);
+	result->copy_dir   = lilv_strdup(state->copy_dir);
+	result->link_dir   = lilv_strdup(state->link_dir);
+	result->label      = lilv_strdup(state->label);
+	result->atom_Path  = state->atom_Path;
+	return result;
+}
+
+/** Copy the path mappings of `src` to `dst`, except for existing paths. */
+static void
+copy_path_maps(LilvState* dst, const LilvState* src)
+{
+	if (!src->abs2rel) {
+		return;
+	}
+
+	if (!dst->abs2rel) {
+		dst->abs2rel = zix_tree_new(false, abs_cmp, NULL, path_rel_free);
+		dst->rel2abs = zix_tree_new(false, rel_cmp, NULL, NULL);
+	}
+
+	for (ZixTreeIter* i = zix_tree_begin(src->abs2rel);
+	     i != zix_tree_end(src->abs2rel);
+	     i = zix_tree_iter_next(i)) {
+		const PathMap* pm   = (const PathMap*)zix_tree_get(i);
+		PathMap*       copy = (PathMap*)malloc(sizeof(PathMap));
+		copy->abs = lilv_strdup(pm->abs);
+		copy->rel = lilv_strdup(pm->rel);
+		if (zix_tree_insert(dst->abs2rel, copy, NULL)) {
+			path_rel_free(copy);
+		} else {
+			zix_tree_insert(dst->rel2abs, copy, NULL);
+		}
+	}
+}
+
+static void
+copy_port_value(LilvState* state, const PortValue* value)
+{
+	append_port_value(
+		state, value->symbol, value->value, value->size, value->type);
+}
+
+static void
+copy_property(LilvState* state, PropertyArray* array, const Property* prop)
+{
+	append_property(state, array, prop->key, prop->value, prop->size,
+	                prop->type, prop->flags);
+}
+
+LILV_API LilvState*
+lilv_state_new_delta(const LilvState* from, const LilvState* to)
+{
+	if (!lilv_node_equals(from->plugin_uri, to->plugin_uri)) {
+		LILV_ERROR("Attempt to diff states of different plugins\n");
+		return NULL;
+	}
+
+	LilvState* const delta = lilv_state_new_like(to);
+	copy_path_maps(delta, to);
+
+	// Both value arrays are sorted by symbol, walk them together
+	uint32_t f = 0;
+	for (uint32_t t = 0; t < to->n_values; ++t) {
+		const PortValue* tv = &to->values[t];
+		int              c  = 1;
+		while (f < from->n_values &&
+		       (c = strcmp(from->values[f].symbol, tv->symbol)) < 0) {
+			++f;
+		}
+		if (c || !port_value_equals(&from->values[f], tv)) {
+			copy_port_value(delta, tv);
+		}
+	}
+
+	// Both property arrays are sorted by key, walk them together
+	f = 0;
+	for (uint32_t t = 0; t < to->props.n; ++t) {
+		const Property* tp = &to->props.props[t];
+		while (f < from->props.n && from->props.props[f].key < tp->key) {
+			++f;
+		}
+		if (f == from->props.n || from->props.props[f].key != tp->key ||
+		    !property_equals(from, &from->props.props[f], to, tp)) {
+			copy_property(delta, &delta->props, tp);
+		}
+	}
+
+	return delta;
+}
+
+LILV_API LilvState*
+lilv_state_new_merged(const LilvState* base, const LilvState* delta)
+{
+	if (!lilv_node_equals(base->plugin_uri, delta->plugin_uri)) {
+		LILV_ERROR("Attempt to merge states of different plugins\n");
+		return NULL;
+	}
+
+	LilvState* const merged = lilv_state_new_like(delta->label ? delta : base);
+	copy_path_maps(merged, delta);
+	copy_path_maps(merged, base);
+
+	// Merge values sorted by symbol, preferring those in delta
+	uint32_t b = 0;
+	uint32_t d = 0;
+	while (b < base->n_values || d < delta->n_values) {
+		const int c = (b == base->n_values)    ? 1
+		            : (d == delta->n_values)   ? -1
+		            : strcmp(base->values[b].symbol, delta->values[d].symbol);
+		if (c < 0) {
+			copy_port_value(merged, &base->values[b++]);
+		} else {
+			copy_port_value(merged, &delta->values[d++]);
+			b += (c == 0);
+		}
+	}
+
+	// Merge properties sorted by key, preferring those in delta
+	b = d = 0;
+	while (b < base->props.n || d < delta->props.n) {
+		const Property* bp = (b < base->props.n) ? &base->props.props[b] : NULL;
+		const Property* dp = (d < delta->props.n) ? &delta->props.props[d] : NULL;
+		if (!dp || (bp && bp->key < dp->key)) {
+			copy_property(merged, &merged->props, bp);
+			++b;
+		} else {
+			copy_property(merged, &merged->props, dp);
+			b += (bp && bp->key == dp->key);
+			++d;
+		}
+	}
+
+	return merged;
+}
+
 LILV_API unsigned
 lilv_state_get_num_properties(const LilvState* state)
 {
@@ -42,12 +42,33 @@ lilv_ui_new(LilvWorld* world,
 	ui->bundle_uri = lilv_new_uri(world, bundle);
 	free(bundle);
 
-	ui->classes = lilv_nodes_new();
-	zix_tree_insert((ZixTree*)ui->classes, type_uri, NULL);
+	LilvArray classes;
+	lilv_array_init(&classes);
+	lilv_array_append(&classes, type_uri);
+	ui->classes = lilv_array_to_nodes(&classes);
 
 	return ui;
 }
 
+LilvUI*
+lilv_ui_duplicate(const LilvUI* ui)
+{
+	LilvUI* copy = (LilvUI*)malloc(sizeof(LilvUI));
+	copy->world      = ui->world;
+	copy->uri        = lilv_node_duplicate(ui->uri);
+	copy->bundle_uri = lilv_node_duplicate(ui->bundle_uri);
+	copy->binary_uri = lilv_node_duplicate(ui->binary_uri);
+
+	LilvArray classes;
+	lilv_array_init(&classes);
+	LILV_FOREACH(nodes, c, ui->classes) {
+		lilv_array_append(&classes,
+		                  lilv_node_duplicate(lilv_nodes_get(ui->classes, c)));
+	}
+	copy->classes = lilv_array_to_nodes(&classes);
+	return copy;
+}
+
 void
 lilv_ui_free(LilvUI* ui)
 {
@@ -64,6 +85,77 @@ lilv_ui_get_uri(const LilvUI* ui)
 	return ui->uri;
 }
 
+void
+lilv_world_free_ui_qualities(LilvWorld* world)
+{
+	for (unsigned i = 0; i < world->n_ui_qualities; ++i) {
+		lilv_node_free(world->ui_qualities[i].container_type);
+		lilv_node_free(world->ui_qualities[i].ui_type);
+	}
+	free(world->ui_qualities);
+	world->ui_qualities   = NULL;
+	world->n_ui_qualities = 0;
+}
+
+static const LilvUIQuality*
+lilv_world_find_ui_quality(const LilvWorld*    world,
+                           LilvUISupportedFunc func,
+                           const LilvNode*     container_type,
+                           const LilvNode*     ui_type)
+{
+	for (unsigned i = 0; i < world->n_ui_qualities; ++i) {
+		const LilvUIQuality* const q = &world->ui_qualities[i];
+		if (q->func == func &&
+		    lilv_node_equals(q->ui_type, ui_type) &&
+		    lilv_node_equals(q->container_type, container_type)) {
+			return q;
+		}
+	}
+	return NULL;
+}
+
+/**
+   Return the quality of a UI type in a container, calling `func` only the
+   first time a pair is seen.  There are only a handful of UI types and
+   containers, so a linear search is plenty.
+*/
+static unsigned
+lilv_world_get_ui_quality(LilvWorld*          world,
+                          LilvUISupportedFunc func,
+                          const LilvNode*     container_type,
+                          const LilvNode*     ui_type)
+{
+	lilv_world_lock(world);
+	const LilvUIQuality* q = lilv_world_find_ui_quality(
+		world, func, container_type, ui_type);
+	const unsigned memoized = q ? q->quality : 0;
+	lilv_world_unlock(world);
+	if (q) {
+		return memoized;
+	}
+
+	// Call the host without the lock held, it may do anything
+	const unsigned quality = func(lilv_node_as_uri(container_type),
+	                              lilv_node_as_uri(ui_type));
+
+	lilv_world_lock(world);
+	if (!lilv_world_find_ui_quality(world, func, container_type, ui_type)) {
+		LilvUIQuality* const qualities = (LilvUIQuality*)realloc(
+			world->ui_qualities,
+			(world->n_ui_qualities + 1) * sizeof(LilvUIQuality));
+		if (qualities) {
+			LilvUIQuality* const entry = &qualities[world->n_ui_qualities++];
+			entry->func           = func;
+			entry->container_type = lilv_node_duplicate(container_type);
+			entry->ui_type        = lilv_node_duplicate(ui_type);
+			entry->quality        = quality;
+			world->ui_qualities   = qualities;
+		}
+	}
+	lilv_world_unlock(world);
+	return quality;
+}
+
 LILV_API unsigned
 lilv_ui_is_supported(const LilvUI*       ui,
                      LilvUISupportedFunc supported_func,
@@ -73,8 +165,8 @@ lilv_ui_is_supported(const LilvUI*       ui,
 	const LilvNodes* classes = lilv_ui_get_classes(ui);
 	LILV_FOREACH(nodes, c, classes) {
 		const LilvNode* type = lilv_nodes_get(classes, c);
-		const unsigned  q    = supported_func(lilv_node_as_uri(container_type),
-		                                      lilv_node_as_uri(type));
+		const unsigned  q    = lilv_world_get_ui_quality(
+			ui->world, supported_func, container_type, type);
 		if (q) {
 			if (ui_type) {
 				*ui_type = type;
@@ -109,3 +201,45 @@ lilv_ui_get_binary_uri(const LilvUI* ui)
 {
 	return ui->binary_uri;
 }
+
+LILV_API unsigned
+lilv_world_select_uis(LilvWorld*          world,
+                      const LilvPlugins*  plugins,
+                      LilvUISupportedFunc supported_func,
+                      const LilvNode*     container_type,
+                      const LilvUI**      uis,
+                      const LilvNode**    ui_types)
+{
+	unsigned n_found = 0;
+	unsigned index   = 0;
+	LILV_FOREACH(plugins, p, plugins) {
+		const LilvPlugin* const plugin     = lilv_plugins_get(plugins, p);
+		const LilvUIs* const    candidates = lilv_plugin_get_shared_uis(plugin);
+		const LilvUI*           best       = NULL;
+		const LilvNode*         best_type  = NULL;
+		unsigned                best_q     = 0;
+
+		LILV_FOREACH(uis, u, candidates) {
+			const LilvUI* const ui = lilv_uis_get(candidates, u);
+			LILV_FOREACH(nodes, c, ui->classes) {
+				const LilvNode* const type = lilv_nodes_get(ui->classes, c);
+				const unsigned        q    = lilv_world_get_ui_quality(
+					world, supported_func, container_type, type);
+				if (q > best_q) {
+					best      = ui;
+					best_type = type;
+					best_q    = q;
+				}
+			}
+		}
+
+		uis[index] = best;
+		if (ui_types) {
+			ui_types[index] = best_type;
+		}
+		n_found += (best != NULL);
+		++index;
+	}
+
+	return n_found;
+}
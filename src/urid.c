@@ -0,0 +1,272 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lilv_internal.h"
+
+/*
+  Mapped URIs are stored in chunks which are never moved, where chunk k holds
+  the URIs for URIDs 2^k to 2^(k+1)-1, so unmapped strings are stable and
+  unmapping never locks.  URIDs are found with an open addressing hash table.
+  When it is full it is replaced with a larger one, but old tables are kept
+  until the map is freed, so a reader may finish probing one safely.  Only
+  adding a new URI takes the mutex.
+*/
+
+#define N_CHUNKS          32
+#define INITIAL_N_SLOTS   64
+
+typedef struct {
+	uint32_t hash;  ///< Hash of URI
+	LV2_URID urid;  ///< URID, or 0 if slot is empty
+} URIDSlot;
+
+typedef struct URIDTableImpl {
+	struct URIDTableImpl* prev;     ///< Previous (smaller) table
+	uint32_t              mask;     ///< Number of slots minus one
+	URIDSlot              slots[];
+} URIDTable;
+
+struct LilvURIDMapImpl {
+	LV2_URID_Map    map;
+	LV2_URID_Unmap  unmap;
+	URIDTable*      table;             ///< Current hash table
+	char**          chunks[N_CHUNKS];  ///< Mapped URIs by URID
+	uint32_t        n_uris;            ///< Number of mapped URIs
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t mutex;             ///< Protects adding URIs
+#endif
+};
+
+static uint32_t
+uri_hash(const char* uri)
+{
+	uint32_t h = 2166136261u;
+	for (const char* c = uri; *c; ++c) {
+		h = (h ^ (uint8_t)*c) * 16777619u;
+	}
+	return h;
+}
+
+static unsigned
+urid_chunk(LV2_URID urid)
+{
+#ifdef __GNUC__
+	return 31u - (unsigned)__builtin_clz(urid);
+#else
+	unsigned k = 0;
+	while (urid >>= 1) {
+		++k;
+	}
+	return k;
+#endif
+}
+
+static void
+lilv_urid_map_lock(LilvURIDMap* map)
+{
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&map->mutex);
+#endif
+}
+
+static void
+lilv_urid_map_unlock(LilvURIDMap* map)
+{
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&map->mutex);
+#endif
+}
+
+static URIDTable*
+urid_table_new(uint32_t n_slots, URIDTable* prev)
+{
+	URIDTable* table = (URIDTable*)calloc(
+		1, sizeof(URIDTable) + n_slots * sizeof(URIDSlot));
+	table->prev = prev;
+	table->mask = n_slots - 1;
+	return table;
+}
+
+static void
+urid_table_insert(URIDTable* table, uint32_t hash, LV2_URID urid)
+{
+	uint32_t i = hash & table->mask;
+	while (table->slots[i].urid) {
+		i = (i + 1) & table->mask;
+	}
+
+	table->slots[i].hash = hash;
+	ATOMIC_STORE(&table->slots[i].urid, urid);
+}
+
+/** Return the URI for a URID known to be mapped. */
+static const char*
+lilv_urid_map_string(const LilvURIDMap* map, LV2_URID urid)
+{
+	const unsigned     k     = urid_chunk(urid);
+	char* const* const chunk = ATOMIC_LOAD(&map->chunks[k]);
+	return chunk[urid - (1u << k)];
+}
+
+static LV2_URID
+lilv_urid_map_find(const LilvURIDMap* map,
+                   const URIDTable*   table,
+                   uint32_t           hash,
+                   const char*        uri)
+{
+	for (uint32_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+		const LV2_URID urid = ATOMIC_LOAD(&table->slots[i].urid);
+		if (!urid) {
+			return 0;
+		} else if (table->slots[i].hash == hash &&
+		           !strcmp(lilv_urid_map_string(map, urid), uri)) {
+			return urid;
+		}
+	}
+}
+
+/** Add a new URI, the map must be locked. */
+static LV2_URID
+lilv_urid_map_add(LilvURIDMap* map, uint32_t hash, const char* uri)
+{
+	const LV2_URID urid = map->n_uris + 1;
+	if (!urid) {
+		LILV_ERROR("URID map is full\n");
+		return 0;
+	}
+
+	const unsigned k = urid_chunk(urid);
+	if (!map->chunks[k]) {
+		char** chunk = (char**)malloc(((size_t)1 << k) * sizeof(char*));
+		ATOMIC_STORE(&map->chunks[k], chunk);
+	}
+	map->chunks[k][urid - (1u << k)] = lilv_strdup(uri);
+	ATOMIC_STORE(&map->n_uris, urid);
+
+	URIDTable* const table = map->table;
+	if ((uint64_t)urid * 4 <= ((uint64_t)table->mask + 1) * 3) {
+		urid_table_insert(table, hash, urid);
+		return urid;
+	}
+
+	// Table is too full, fill a larger one then replace it
+	URIDTable* const bigger = urid_table_new((table->mask + 1) * 2, table);
+	for (uint32_t i = 0; i <= table->mask; ++i) {
+		if (table->slots[i].urid) {
+			urid_table_insert(
+				bigger, table->slots[i].hash, table->slots[i].urid);
+		}
+	}
+	urid_table_insert(bigger, hash, urid);
+	ATOMIC_STORE(&map->table, bigger);
+	return urid;
+}
+
+static LV2_URID
+lilv_urid_map_map(LV2_URID_Map_Handle handle, const char* uri)
+{
+	LilvURIDMap* const map  = (LilvURIDMap*)handle;
+	const uint32_t     hash = uri_hash(uri);
+	LV2_URID           urid = 0;
+
+#ifdef LILV_ATOMICS
+	// Look up existing URI without locking
+	if ((urid = lilv_urid_map_find(map, ATOMIC_LOAD(&map->table), hash, uri))) {
+		return urid;
+	}
+#endif
+
+	lilv_urid_map_lock(map);
+	if (!(urid = lilv_urid_map_find(map, map->table, hash, uri))) {
+		urid = lilv_urid_map_add(map, hash, uri);
+	}
+	lilv_urid_map_unlock(map);
+	return urid;
+}
+
+static const char*
+lilv_urid_map_unmap(LV2_URID_Unmap_Handle handle, LV2_URID urid)
+{
+	LilvURIDMap* const map    = (LilvURIDMap*)handle;
+	const char*        result = NULL;
+
+#ifndef LILV_ATOMICS
+	lilv_urid_map_lock(map);
+#endif
+	if (urid > 0 && urid <= ATOMIC_LOAD(&map->n_uris)) {
+		result = lilv_urid_map_string(map, urid);
+	}
+#ifndef LILV_ATOMICS
+	lilv_urid_map_unlock(map);
+#endif
+
+	return result;
+}
+
+LILV_API LilvURIDMap*
+lilv_urid_map_new(void)
+{
+	LilvURIDMap* map = (LilvURIDMap*)calloc(1, sizeof(LilvURIDMap));
+	map->map.handle   = map;
+	map->map.map      = lilv_urid_map_map;
+	map->unmap.handle = map;
+	map->unmap.unmap  = lilv_urid_map_unmap;
+	map->table        = urid_table_new(INITIAL_N_SLOTS, NULL);
+#ifdef HAVE_PTHREAD
+	pthread_mutex_init(&map->mutex, NULL);
+#endif
+	return map;
+}
+
+LILV_API void
+lilv_urid_map_free(LilvURIDMap* map)
+{
+	if (!map) {
+		return;
+	}
+
+	for (LV2_URID urid = 1; urid && urid <= map->n_uris; ++urid) {
+		free((char*)lilv_urid_map_string(map, urid));
+	}
+	for (unsigned k = 0; k < N_CHUNKS; ++k) {
+		free(map->chunks[k]);
+	}
+	for (URIDTable* t = map->table; t;) {
+		URIDTable* const prev = t->prev;
+		free(t);
+		t = prev;
+	}
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_destroy(&map->mutex);
+#endif
+	free(map);
+}
+
+LILV_API LV2_URID_Map*
+lilv_urid_map_get_map(LilvURIDMap* map)
+{
+	return &map->map;
+}
+
+LILV_API LV2_URID_Unmap*
+lilv_urid_map_get_unmap(LilvURIDMap* map)
+{
+	return &map->unmap;
+}
@@ -28,6 +28,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stddef.h>
+#include <time.h>
 
 #ifdef _WIN32
 #ifndef _WIN32_WINNT
@@ -59,6 +60,11 @@ CreateSymbolicLink(LPCTSTR linkpath, LPCTSTR targetpath, DWORD flags)
 
 #include "lilv_internal.h"
 
+#ifdef HAVE_MMAP
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#endif
+
 #if defined(HAVE_FLOCK) && defined(HAVE_FILENO)
 #    include <sys/file.h>
 #endif
@@ -634,3 +640,102 @@ lilv_file_equals(const char* a_path, const char* b_path)
 	free(b_real);
 	return match;
 }
+
+void
+lilv_buffer_append(LilvBuffer* buffer, const void* data, size_t len)
+{
+	if (buffer->len + len > buffer->size) {
+		while (buffer->len + len > buffer->size) {
+			buffer->size = buffer->size * 2 + 256;
+		}
+		buffer->buf = (uint8_t*)realloc(buffer->buf, buffer->size);
+	}
+	memcpy(buffer->buf + buffer->len, data, len);
+	buffer->len += len;
+}
+
+void
+lilv_buffer_append_u32(LilvBuffer* buffer, uint32_t value)
+{
+	lilv_buffer_append(buffer, &value, sizeof(value));
+}
+
+bool
+lilv_read_bytes(const uint8_t** ptr, const uint8_t* end, void* out, size_t len)
+{
+	if ((size_t)(end - *ptr) < len) {
+		return false;
+	}
+	memcpy(out, *ptr, len);
+	*ptr += len;
+	return true;
+}
+
+uint8_t*
+lilv_file_map(const char* path, size_t* size, bool* mapped)
+{
+	*size   = 0;
+	*mapped = false;
+
+#ifdef HAVE_MMAP
+	uint8_t*  data = NULL;
+	const int fd   = open(path, O_RDONLY);
+	if (fd >= 0) {
+		struct stat st;
+		if (!fstat(fd, &st) && st.st_size > 0) {
+			void* map = mmap(NULL, (size_t)st.st_size, PROT_READ,
+			                 MAP_PRIVATE, fd, 0);
+			if (map != MAP_FAILED) {
+				data    = (uint8_t*)map;
+				*size   = (size_t)st.st_size;
+				*mapped = true;
+			}
+		}
+		close(fd);
+	}
+	return data;
+#else
+	uint8_t* data = NULL;
+	FILE*    fd   = fopen(path, "rb");
+	if (fd) {
+		fseek(fd, 0, SEEK_END);
+		const long len = ftell(fd);
+		fseek(fd, 0, SEEK_SET);
+		if (len > 0) {
+			data = (uint8_t*)malloc((size_t)len);
+			if (fread(data, 1, (size_t)len, fd) == (size_t)len) {
+				*size = (size_t)len;
+			} else {
+				free(data);
+				data = NULL;
+			}
+		}
+		fclose(fd);
+	}
+	return data;
+#endif
+}
+
+void
+lilv_file_unmap(uint8_t* data, size_t size, bool mapped)
+{
+#ifdef HAVE_MMAP
+	if (mapped) {
+		munmap(data, size);
+		return;
+	}
+#endif
+	free(data);
+}
+
+uint64_t
+lilv_time_ns(void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+#else
+	return 0;
+#endif
+}
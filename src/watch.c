@@ -0,0 +1,410 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef HAVE_INOTIFY
+#    include <sys/inotify.h>
+#    include <unistd.h>
+#endif
+
+#include "lilv_internal.h"
+
+/*
+  The watcher records a stamp for every bundle in the LV2 path, which is a
+  hash of the names, inodes, sizes, and modification times of the files
+  directly inside it.  Times have nanoseconds where supported, so a file
+  rewritten within a second, or replaced by a rename, still changes it.  An
+  update reloads only the bundles whose stamp has changed, and loads or
+  unloads bundles that have appeared or disappeared.  With inotify, only
+  directories that have had events since the last update are scanned, so an
+  update with nothing to do costs a single read.  Otherwise, every bundle is
+  stamped on every update, which is still far cheaper than parsing its data
+  again.
+*/
+
+#ifdef HAVE_INOTIFY
+#    define WATCH_DIR_MASK    (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+#    define WATCH_BUNDLE_MASK (WATCH_DIR_MASK | IN_CLOSE_WRITE | IN_ATTRIB)
+#else
+#    define WATCH_DIR_MASK    0
+#    define WATCH_BUNDLE_MASK 0
+#endif
+
+typedef struct {
+	char*     path;    ///< Bundle directory path, with trailing separator
+	LilvNode* uri;     ///< Bundle URI
+	uint64_t  stamp;   ///< Hash of the bundle's files
+	int       wd;      ///< Watch descriptor, or -1
+	bool      dirty;   ///< True if files changed since last update
+	bool      seen;    ///< True if found by the latest directory scan
+} LilvWatchedBundle;
+
+typedef struct {
+	char* path;  ///< Expanded LV2 path directory
+	int   wd;    ///< Watch descriptor, or -1
+} LilvWatchedDir;
+
+struct LilvWatcherImpl {
+	LilvWorld*         world;
+	LilvBundleFunc     func;
+	void*              handle;
+	LilvWatchedDir*    dirs;
+	unsigned           n_dirs;
+	LilvWatchedBundle* bundles;
+	unsigned           n_bundles;
+	int                fd;         ///< Inotify descriptor, or -1 to poll
+	bool               dirs_dirty; ///< True if bundles may have been added
+};
+
+typedef struct {
+	const char* dir;
+	uint64_t    stamp;
+} LilvStamper;
+
+static void
+stamp_dir_entry(const char* dir, const char* name, void* data)
+{
+	LilvStamper* stamper = (LilvStamper*)data;
+	if (!strcmp(name, ".") || !strcmp(name, "..")) {
+		return;
+	}
+
+	char*       path = lilv_path_join(stamper->dir, name);
+	struct stat st;
+	uint64_t    h    = 14695981039346656037ull;
+	for (const char* c = name; *c; ++c) {
+		h = (h ^ (uint8_t)*c) * 1099511628211ull;
+	}
+	if (!stat(path, &st)) {
+		h = (h ^ (uint64_t)st.st_ino) * 1099511628211ull;
+		h = (h ^ (uint64_t)st.st_mtime) * 1099511628211ull;
+#ifdef HAVE_STAT_MTIM
+		h = (h ^ (uint64_t)st.st_mtim.tv_nsec) * 1099511628211ull;
+#endif
+		h = (h ^ (uint64_t)st.st_size) * 1099511628211ull;
+	}
+	free(path);
+
+	// Summed so the order of directory entries does not matter
+	stamper->stamp += h;
+}
+
+static uint64_t
+lilv_watcher_stamp(const char* bundle_path)
+{
+	LilvStamper stamper = { bundle_path, 0 };
+	lilv_dir_for_each(bundle_path, &stamper, stamp_dir_entry);
+	return stamper.stamp;
+}
+
+static int
+lilv_watcher_add_watch(LilvWatcher* watcher, const char* path, uint32_t mask)
+{
+#ifdef HAVE_INOTIFY
+	if (watcher->fd >= 0) {
+		return inotify_add_watch(watcher->fd, path, mask);
+	}
+#endif
+	return -1;
+}
+
+static void
+lilv_watcher_rm_watch(LilvWatcher* watcher, int wd)
+{
+#ifdef HAVE_INOTIFY
+	if (watcher->fd >= 0 && wd >= 0) {
+		inotify_rm_watch(watcher->fd, wd);
+	}
+#endif
+}
+
+static LilvWatchedBundle*
+lilv_watcher_find(LilvWatcher* watcher, const char* path)
+{
+	for (unsigned i = 0; i < watcher->n_bundles; ++i) {
+		if (!strcmp(watcher->bundles[i].path, path)) {
+			return &watcher->bundles[i];
+		}
+	}
+	return NULL;
+}
+
+static LilvWatchedBundle*
+lilv_watcher_add(LilvWatcher* watcher, char* path)
+{
+	watcher->bundles = (LilvWatchedBundle*)realloc(
+		watcher->bundles, (watcher->n_bundles + 1) * sizeof(LilvWatchedBundle));
+
+	SerdNode suri = serd_node_new_file_uri((const uint8_t*)path, 0, 0, true);
+
+	LilvWatchedBundle* bundle = &watcher->bundles[watcher->n_bundles++];
+	bundle->path  = path;
+	bundle->uri   = lilv_new_uri(watcher->world, (const char*)suri.buf);
+	bundle->wd    = lilv_watcher_add_watch(watcher, path, WATCH_BUNDLE_MASK);
+	bundle->stamp = lilv_watcher_stamp(path);
+	bundle->dirty = false;
+	bundle->seen  = true;
+
+	serd_node_free(&suri);
+	return bundle;
+}
+
+static void
+lilv_watcher_notify(LilvWatcher*      watcher,
+                    const LilvNode*   bundle_uri,
+                    LilvBundleChange  change)
+{
+	if (watcher->func) {
+		watcher->func(watcher->handle, bundle_uri, change);
+	}
+}
+
+typedef struct {
+	LilvWatcher* watcher;
+	bool         initial;    ///< True if bundles are already loaded
+	unsigned     n_changes;
+} LilvWatchScan;
+
+static void
+scan_dir_entry(const char* dir, const char* name, void* data)
+{
+	LilvWatchScan* scan    = (LilvWatchScan*)data;
+	LilvWatcher*   watcher = scan->watcher;
+	if (!strcmp(name, ".") || !strcmp(name, "..")) {
+		return;
+	}
+
+	char*       path = lilv_strjoin(dir, "/", name, "/", NULL);
+	struct stat st;
+	if (stat(path, &st) || !S_ISDIR(st.st_mode)) {
+		free(path);
+		return;
+	}
+
+	LilvWatchedBundle* bundle = lilv_watcher_find(watcher, path);
+	if (bundle) {
+		bundle->seen = true;
+		free(path);
+	} else if (scan->initial) {
+		lilv_watcher_add(watcher, path);
+	} else {
+		// New bundle, load it
+		bundle = lilv_watcher_add(watcher, path);
+		lilv_world_load_bundle(watcher->world, bundle->uri);
+		lilv_watcher_notify(watcher, bundle->uri, LILV_BUNDLE_ADDED);
+		++scan->n_changes;
+	}
+}
+
+/** Scan the LV2 path for bundles, loading new ones and removing old ones. */
+static unsigned
+lilv_watcher_scan(LilvWatcher* watcher, bool initial)
+{
+	for (unsigned i = 0; i < watcher->n_bundles; ++i) {
+		watcher->bundles[i].seen = false;
+	}
+
+	LilvWatchScan scan = { watcher, initial, 0 };
+	for (unsigned i = 0; i < watcher->n_dirs; ++i) {
+		lilv_dir_for_each(watcher->dirs[i].path, &scan, scan_dir_entry);
+	}
+	if (initial) {
+		return 0;
+	}
+
+	// Unload any bundles that no longer exist
+	for (unsigned i = 0; i < watcher->n_bundles;) {
+		LilvWatchedBundle* bundle = &watcher->bundles[i];
+		if (bundle->seen) {
+			++i;
+			continue;
+		}
+
+		lilv_world_unload_bundle(watcher->world, bundle->uri);
+		lilv_watcher_notify(watcher, bundle->uri, LILV_BUNDLE_REMOVED);
+		lilv_watcher_rm_watch(watcher, bundle->wd);
+		lilv_node_free(bundle->uri);
+		free(bundle->path);
+		watcher->bundles[i] = watcher->bundles[--watcher->n_bundles];
+		++scan.n_changes;
+	}
+
+	return scan.n_changes;
+}
+
+#ifdef HAVE_INOTIFY
+/** Read pending events, return true if anything was dirtied. */
+static bool
+lilv_watcher_read_events(LilvWatcher* watcher)
+{
+	uint64_t    aligned[4096 / sizeof(uint64_t)];
+	char* const buf   = (char*)aligned;
+	bool        dirty = false;
+	ssize_t     len   = 0;
+	while ((len = read(watcher->fd, buf, sizeof(aligned))) > 0) {
+		for (char* p = buf; p < buf + len;) {
+			const struct inotify_event* event = (struct inotify_event*)p;
+			if (event->mask & IN_Q_OVERFLOW) {
+				// Events were lost, check everything
+				watcher->dirs_dirty = true;
+				for (unsigned i = 0; i < watcher->n_bundles; ++i) {
+					watcher->bundles[i].dirty = true;
+				}
+			}
+			for (unsigned i = 0; i < watcher->n_dirs; ++i) {
+				if (watcher->dirs[i].wd == event->wd) {
+					watcher->dirs_dirty = true;
+				}
+			}
+			for (unsigned i = 0; i < watcher->n_bundles; ++i) {
+				if (watcher->bundles[i].wd == event->wd) {
+					watcher->bundles[i].dirty = true;
+				}
+			}
+			dirty = true;
+			p += sizeof(struct inotify_event) + event->len;
+		}
+	}
+
+	return dirty;
+}
+#endif
+
+LILV_API LilvWatcher*
+lilv_watcher_new(LilvWorld* world, LilvBundleFunc func, void* handle)
+{
+	LilvWatcher* watcher = (LilvWatcher*)calloc(1, sizeof(LilvWatcher));
+	watcher->world  = world;
+	watcher->func   = func;
+	watcher->handle = handle;
+	watcher->fd     = -1;
+#ifdef HAVE_INOTIFY
+	watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watcher->fd < 0) {
+		LILV_WARNF("Failed to watch LV2 path (%s), polling\n", strerror(errno));
+	}
+#endif
+
+	const char* lv2_path = lilv_world_get_lv2_path(world);
+	while (lv2_path[0] != '\0') {
+		const char*  sep = strchr(lv2_path, LILV_PATH_SEP[0]);
+		const size_t len = sep ? (size_t)(sep - lv2_path) : strlen(lv2_path);
+		char* const  dir = (char*)malloc(len + 1);
+		memcpy(dir, lv2_path, len);
+		dir[len] = '\0';
+
+		char* path = lilv_expand(dir);
+		free(dir);
+		if (path) {
+			watcher->dirs = (LilvWatchedDir*)realloc(
+				watcher->dirs, (watcher->n_dirs + 1) * sizeof(LilvWatchedDir));
+			watcher->dirs[watcher->n_dirs].path = path;
+			watcher->dirs[watcher->n_dirs].wd   = lilv_watcher_add_watch(
+				watcher, path, WATCH_DIR_MASK);
+			++watcher->n_dirs;
+		}
+
+		lv2_path += sep ? len + 1 : len;
+	}
+
+	lilv_watcher_scan(watcher, true);
+	return watcher;
+}
+
+LILV_API void
+lilv_watcher_free(LilvWatcher* watcher)
+{
+	if (!watcher) {
+		return;
+	}
+
+	for (unsigned i = 0; i < watcher->n_bundles; ++i) {
+		lilv_node_free(watcher->bundles[i].uri);
+		free(watcher->bundles[i].path);
+	}
+	for (unsigned i = 0; i < watcher->n_dirs; ++i) {
+		free(watcher->dirs[i].path);
+	}
+#ifdef HAVE_INOTIFY
+	if (watcher->fd >= 0) {
+		close(watcher->fd);
+	}
+#endif
+	free(watcher->bundles);
+	free(watcher->dirs);
+	free(watcher);
+}
+
+LILV_API int
+lilv_watcher_get_fd(const LilvWatcher* watcher)
+{
+	return watcher->fd;
+}
+
+LILV_API int
+lilv_watcher_update(LilvWatcher* watcher)
+{
+	if (watcher->world->frozen) {
+		LILV_ERROR("World is frozen\n");
+		return -1;
+	}
+
+#ifdef HAVE_INOTIFY
+	if (watcher->fd >= 0 && !lilv_watcher_read_events(watcher)) {
+		return 0;
+	}
+#endif
+
+	if (watcher->fd < 0) {
+		// Polling, check everything
+		watcher->dirs_dirty = true;
+		for (unsigned i = 0; i < watcher->n_bundles; ++i) {
+			watcher->bundles[i].dirty = true;
+		}
+	}
+
+	unsigned n_changes = 0;
+	if (watcher->dirs_dirty) {
+		n_changes += lilv_watcher_scan(watcher, false);
+		watcher->dirs_dirty = false;
+	}
+
+	// Reload bundles with changed files
+	for (unsigned i = 0; i < watcher->n_bundles; ++i) {
+		LilvWatchedBundle* bundle = &watcher->bundles[i];
+		if (!bundle->dirty) {
+			continue;
+		}
+
+		bundle->dirty = false;
+		const uint64_t stamp = lilv_watcher_stamp(bundle->path);
+		if (stamp != bundle->stamp) {
+			bundle->stamp = stamp;
+			lilv_world_unload_bundle(watcher->world, bundle->uri);
+			lilv_world_load_bundle(watcher->world, bundle->uri);
+			lilv_watcher_notify(watcher, bundle->uri, LILV_BUNDLE_CHANGED);
+			++n_changes;
+		}
+	}
+
+	return (int)n_changes;
+}
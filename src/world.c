@@ -19,12 +19,48 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/event/event.h"
 #include "lv2/lv2plug.in/ns/ext/presets/presets.h"
+#include "lv2/lv2plug.in/ns/ext/state/state.h"
+#include "lv2/lv2plug.in/ns/extensions/ui/ui.h"
 
 #include "lilv_internal.h"
 
-static int
-lilv_world_drop_graph(LilvWorld* world, const SordNode* graph);
+static void
+bundle_index_entry_free(void* value, void* user_data);
+
+static void
+lilv_world_load_namespaces(LilvWorld*      world,
+                           const SordNode* subject,
+                           const SordNode* predicate,
+                           const SordNode* object);
+
+/** An entry in the index of specifications (world->spec_index). */
+typedef struct {
+	const char* ns;     ///< Namespace, not null terminated
+	size_t      len;    ///< Length of ns
+	LilvSpec*   specs;  ///< Specifications in ns, linked by ns_next
+} LilvSpecIndexEntry;
+
+static uint32_t
+spec_index_hash(const void* value)
+{
+	const LilvSpecIndexEntry* entry = (const LilvSpecIndexEntry*)value;
+	uint32_t                  h     = 2166136261u;
+	for (size_t i = 0; i < entry->len; ++i) {
+		h = (h ^ (uint8_t)entry->ns[i]) * 16777619u;
+	}
+	return h;
+}
+
+static bool
+spec_index_equal(const void* a, const void* b)
+{
+	const LilvSpecIndexEntry* ea = (const LilvSpecIndexEntry*)a;
+	const LilvSpecIndexEntry* eb = (const LilvSpecIndexEntry*)b;
+	return ea->len == eb->len && !memcmp(ea->ns, eb->ns, ea->len);
+}
 
 LILV_API LilvWorld*
 lilv_world_new(void)
@@ -40,31 +76,72 @@ lilv_world_new(void)
 		goto fail;
 
 	world->specs          = NULL;
+	world->spec_index     = zix_hash_new(
+		spec_index_hash, spec_index_equal, sizeof(LilvSpecIndexEntry));
+	world->n_unloaded_specs = 0;
 	world->plugin_classes = lilv_plugin_classes_new();
 	world->plugins        = lilv_plugins_new();
 	world->zombies        = lilv_plugins_new();
+	world->plugin_index   = lilv_header_index_new();
+	world->class_index    = lilv_header_index_new();
+	world->bundle_index   = NULL;
+	world->dyn_queue      = NULL;
+	world->frozen         = false;
+	world->plugins_version = 0;
+	world->bundles_version = 0;
+	world->classes_version = 0;
+	world->classes_loaded  = false;
+
+#ifdef HAVE_PTHREAD
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&world->mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+	world->preloading       = false;
+	world->preload_features = NULL;
+#endif
 	world->loaded_files   = zix_tree_new(
 		false, lilv_resource_node_cmp, NULL, (ZixDestroyFunc)lilv_node_free);
 
 	world->libs = zix_tree_new(false, lilv_lib_compare, NULL, NULL);
 
+	lilv_node_pool_init(world);
+
 #define NS_DCTERMS "http://purl.org/dc/terms/"
 #define NS_DYNMAN  "http://lv2plug.in/ns/ext/dynmanifest#"
 #define NS_OWL     "http://www.w3.org/2002/07/owl#"
+#define NS_RSZ     "http://lv2plug.in/ns/ext/resize-port#"
 
 #define NEW_URI(uri) sord_new_uri(world->world, (const uint8_t*)uri)
 
+	world->uris.atom_AtomPort       = NEW_URI(LV2_ATOM__AtomPort);
+	world->uris.atom_supports       = NEW_URI(LV2_ATOM__supports);
 	world->uris.dc_replaces         = NEW_URI(NS_DCTERMS   "replaces");
 	world->uris.dman_DynManifest    = NEW_URI(NS_DYNMAN    "DynManifest");
+	world->uris.doap_maintainer     = NEW_URI(LILV_NS_DOAP "maintainer");
 	world->uris.doap_name           = NEW_URI(LILV_NS_DOAP "name");
+	world->uris.ev_EventPort        = NEW_URI(LILV_URI_EVENT_PORT);
+	world->uris.ev_supportsEvent    = NEW_URI(LV2_EVENT__supportsEvent);
+	world->uris.foaf_homepage       = NEW_URI(LILV_NS_FOAF "homepage");
+	world->uris.foaf_mbox           = NEW_URI(LILV_NS_FOAF "mbox");
+	world->uris.foaf_name           = NEW_URI(LILV_NS_FOAF "name");
+	world->uris.lv2_AudioPort       = NEW_URI(LV2_CORE__AudioPort);
+	world->uris.lv2_CVPort          = NEW_URI(LV2_CORE__CVPort);
+	world->uris.lv2_ControlPort     = NEW_URI(LV2_CORE__ControlPort);
+	world->uris.lv2_InputPort       = NEW_URI(LV2_CORE__InputPort);
+	world->uris.lv2_OutputPort      = NEW_URI(LV2_CORE__OutputPort);
 	world->uris.lv2_Plugin          = NEW_URI(LV2_CORE__Plugin);
 	world->uris.lv2_Specification   = NEW_URI(LV2_CORE__Specification);
 	world->uris.lv2_appliesTo       = NEW_URI(LV2_CORE__appliesTo);
 	world->uris.lv2_binary          = NEW_URI(LV2_CORE__binary);
+	world->uris.lv2_connectionOptional = NEW_URI(LV2_CORE__connectionOptional);
 	world->uris.lv2_default         = NEW_URI(LV2_CORE__default);
 	world->uris.lv2_designation     = NEW_URI(LV2_CORE__designation);
+	world->uris.lv2_enumeration     = NEW_URI(LV2_CORE__enumeration);
 	world->uris.lv2_extensionData   = NEW_URI(LV2_CORE__extensionData);
 	world->uris.lv2_index           = NEW_URI(LV2_CORE__index);
+	world->uris.lv2_integer         = NEW_URI(LV2_CORE__integer);
 	world->uris.lv2_latency         = NEW_URI(LV2_CORE__latency);
 	world->uris.lv2_maximum         = NEW_URI(LV2_CORE__maximum);
 	world->uris.lv2_microVersion    = NEW_URI(LV2_CORE__microVersion);
@@ -76,9 +153,15 @@ lilv_world_new(void)
 	world->uris.lv2_portProperty    = NEW_URI(LV2_CORE__portProperty);
 	world->uris.lv2_reportsLatency  = NEW_URI(LV2_CORE__reportsLatency);
 	world->uris.lv2_requiredFeature = NEW_URI(LV2_CORE__requiredFeature);
+	world->uris.lv2_sampleRate      = NEW_URI(LV2_CORE__sampleRate);
+	world->uris.lv2_scalePoint      = NEW_URI(LV2_CORE__scalePoint);
 	world->uris.lv2_symbol          = NEW_URI(LV2_CORE__symbol);
+	world->uris.lv2_toggled         = NEW_URI(LV2_CORE__toggled);
+	world->uris.lv2_project         = NEW_URI(LV2_CORE__project);
 	world->uris.lv2_prototype       = NEW_URI(LV2_CORE__prototype);
 	world->uris.owl_Ontology        = NEW_URI(NS_OWL "Ontology");
+	world->uris.pset_Preset         = NEW_URI(LV2_PRESETS__Preset);
+	world->uris.pset_bank           = NEW_URI(LV2_PRESETS__bank);
 	world->uris.pset_value          = NEW_URI(LV2_PRESETS__value);
 	world->uris.rdf_a               = NEW_URI(LILV_NS_RDF  "type");
 	world->uris.rdf_value           = NEW_URI(LILV_NS_RDF  "value");
@@ -86,6 +169,10 @@ lilv_world_new(void)
 	world->uris.rdfs_label          = NEW_URI(LILV_NS_RDFS "label");
 	world->uris.rdfs_seeAlso        = NEW_URI(LILV_NS_RDFS "seeAlso");
 	world->uris.rdfs_subClassOf     = NEW_URI(LILV_NS_RDFS "subClassOf");
+	world->uris.rsz_minimumSize     = NEW_URI(NS_RSZ "minimumSize");
+	world->uris.state_state         = NEW_URI(LV2_STATE__state);
+	world->uris.ui_binary           = NEW_URI(LV2_UI__binary);
+	world->uris.ui_ui               = NEW_URI(LV2_UI__ui);
 	world->uris.xsd_base64Binary    = NEW_URI(LILV_NS_XSD  "base64Binary");
 	world->uris.xsd_boolean         = NEW_URI(LILV_NS_XSD  "boolean");
 	world->uris.xsd_decimal         = NEW_URI(LILV_NS_XSD  "decimal");
@@ -93,6 +180,18 @@ lilv_world_new(void)
 	world->uris.xsd_integer         = NEW_URI(LILV_NS_XSD  "integer");
 	world->uris.null_uri            = NULL;
 
+#define NS_DCS "http://ontologi.es/doap-changeset#"
+
+	world->documentation[0] = NEW_URI(LILV_NS_RDFS "comment");
+	world->documentation[1] = NEW_URI(LV2_CORE__documentation);
+	world->documentation[2] = NEW_URI(LILV_NS_DOAP "description");
+	world->documentation[3] = NEW_URI(LILV_NS_DOAP "shortdesc");
+	world->documentation[4] = NEW_URI(LILV_NS_DOAP "release");
+	world->documentation[5] = NEW_URI(NS_DCS "changeset");
+	world->documentation[6] = NEW_URI(NS_DCS "item");
+	world->documentation[7] = NEW_URI(NS_DCS "blame");
+	world->documentation[8] = NULL;
+
 	world->lv2_plugin_class = lilv_plugin_class_new(
 		world, NULL, world->uris.lv2_Plugin, "Plugin");
 	assert(world->lv2_plugin_class);
@@ -100,6 +199,18 @@ lilv_world_new(void)
 	world->n_read_files        = 0;
 	world->opt.filter_language = true;
 	world->opt.dyn_manifest    = true;
+	world->opt.load_threads    = 0;
+	world->opt.cache_path      = NULL;
+	world->opt.copy_index      = false;
+	world->opt.selective_load  = false;
+	world->opt.documentation   = true;
+	world->opt.lang            = lilv_get_lang();
+	world->cache               = NULL;
+	world->query_cache         = NULL;
+	world->ui_qualities        = NULL;
+	world->n_ui_qualities      = 0;
+	world->trace_func          = NULL;
+	world->trace_handle        = NULL;
 
 	return world;
 
@@ -108,6 +219,30 @@ fail:
 	return NULL;
 }
 
+#ifdef HAVE_PTHREAD
+static void*
+lilv_world_preload_thread(void* data)
+{
+	LilvWorld* const world = (LilvWorld*)data;
+	LILV_FOREACH(plugins, i, world->plugins) {
+		lilv_plugin_preload(lilv_plugins_get(world->plugins, i),
+		                    world->preload_features);
+	}
+	return NULL;
+}
+#endif
+
+void
+lilv_world_finish_preload(LilvWorld* world)
+{
+#ifdef HAVE_PTHREAD
+	if (world->preloading) {
+		pthread_join(world->preload_thread, NULL);
+		world->preloading = false;
+	}
+#endif
+}
+
 LILV_API void
 lilv_world_free(LilvWorld* world)
 {
@@ -115,12 +250,17 @@ lilv_world_free(LilvWorld* world)
 		return;
 	}
 
+	lilv_world_finish_preload(world);
+
 	lilv_plugin_class_free(world->lv2_plugin_class);
 	world->lv2_plugin_class = NULL;
 
 	for (SordNode** n = (SordNode**)&world->uris; *n; ++n) {
 		sord_node_free(world->world, *n);
 	}
+	for (SordNode** n = world->documentation; *n; ++n) {
+		sord_node_free(world->world, *n);
+	}
 
 	for (LilvSpec* spec = world->specs; spec;) {
 		LilvSpec* next = spec->next;
@@ -131,6 +271,7 @@ lilv_world_free(LilvWorld* world)
 		spec = next;
 	}
 	world->specs = NULL;
+	zix_hash_free(world->spec_index);
 
 	LILV_FOREACH(plugins, i, world->plugins) {
 		const LilvPlugin* p = lilv_plugins_get(world->plugins, i);
@@ -155,15 +296,129 @@ lilv_world_free(LilvWorld* world)
 	zix_tree_free((ZixTree*)world->plugin_classes);
 	world->plugin_classes = NULL;
 
+	zix_hash_free(world->plugin_index);
+	zix_hash_free(world->class_index);
+	world->plugin_index = NULL;
+	world->class_index  = NULL;
+
+	if (world->bundle_index) {
+		zix_hash_foreach(world->bundle_index, bundle_index_entry_free, NULL);
+		zix_hash_free(world->bundle_index);
+		world->bundle_index = NULL;
+	}
+
+	if (world->cache) {
+		lilv_cache_save(world->cache);
+		lilv_cache_free(world->cache);
+		world->cache = NULL;
+	}
+	free(world->opt.cache_path);
+	free(world->opt.lang);
+
+	lilv_query_cache_free(world->query_cache, world->world);
+	world->query_cache = NULL;
+
+	lilv_world_free_ui_qualities(world);
+
+	lilv_node_pool_free(world);
+
 	sord_free(world->model);
 	world->model = NULL;
 
 	sord_world_free(world->world);
 	world->world = NULL;
 
+#ifdef HAVE_PTHREAD
+	pthread_mutex_destroy(&world->mutex);
+#endif
+
 	free(world);
 }
 
+void
+lilv_world_lock(LilvWorld* world)
+{
+#ifdef HAVE_PTHREAD
+	if (world->frozen) {
+		pthread_mutex_lock(&world->mutex);
+	}
+#endif
+}
+
+void
+lilv_world_unlock(LilvWorld* world)
+{
+#ifdef HAVE_PTHREAD
+	if (world->frozen) {
+		pthread_mutex_unlock(&world->mutex);
+	}
+#endif
+}
+
+LILV_API void
+lilv_world_preload_libraries(LilvWorld*               world,
+                             const LV2_Feature*const* features)
+{
+	lilv_world_finish_preload(world);
+
+#ifdef HAVE_PTHREAD
+	if (world->frozen) {
+		world->preload_features = features;
+		if (!pthread_create(&world->preload_thread, NULL,
+		                    lilv_world_preload_thread, world)) {
+			world->preloading = true;
+			return;
+		}
+	}
+#endif
+
+	LILV_FOREACH(plugins, i, world->plugins) {
+		lilv_plugin_preload(lilv_plugins_get(world->plugins, i), features);
+	}
+}
+
+LILV_API void
+lilv_world_freeze(LilvWorld* world)
+{
+	if (world->frozen) {
+		return;
+	}
+
+	// Do every lazy load that a query may otherwise trigger
+	lilv_world_load_plugin_classes_if_necessary(world);
+	LILV_FOREACH(plugins, i, world->plugins) {
+		const LilvPlugin* plugin = lilv_plugins_get(world->plugins, i);
+		lilv_plugin_load_if_necessary(plugin);
+		lilv_plugin_get_num_ports(plugin);
+		lilv_plugin_get_class(plugin);
+		lilv_plugin_get_library_uri(plugin);
+		lilv_plugin_get_shared_uis(plugin);
+		lilv_plugin_load_scale_points_if_necessary(plugin);
+	}
+	lilv_world_load_specifications(world);
+
+	world->frozen = true;
+}
+
+void
+lilv_world_model_changed(LilvWorld* world)
+{
+	if (world->query_cache) {
+		lilv_query_cache_clear(world->query_cache, world->world);
+	}
+}
+
+/** Discard names and results chosen for the previous language settings. */
+static void
+lilv_world_clear_names(LilvWorld* world)
+{
+	lilv_world_model_changed(world);
+	LILV_FOREACH(plugins, i, world->plugins) {
+		lilv_plugin_clear_names(
+			(LilvPlugin*)lilv_plugins_get(world->plugins, i));
+	}
+}
+
 LILV_API void
 lilv_world_set_option(LilvWorld*      world,
                       const char*     option,
@@ -177,12 +432,156 @@ lilv_world_set_option(LilvWorld*      world,
 	} else if (!strcmp(option, LILV_OPTION_FILTER_LANG)) {
 		if (lilv_node_is_bool(value)) {
 			world->opt.filter_language = lilv_node_as_bool(value);
+			lilv_world_clear_names(world);
+			return;
+		}
+	} else if (!strcmp(option, LILV_OPTION_LANG)) {
+		if (lilv_node_is_string(value)) {
+			const char* lang = lilv_node_as_string(value);
+			free(world->opt.lang);
+			world->opt.lang = lang[0] ? lilv_strdup(lang) : NULL;
+			lilv_world_clear_names(world);
+			return;
+		}
+	} else if (!strcmp(option, LILV_OPTION_CACHE)) {
+		if (lilv_node_is_bool(value) || lilv_node_is_string(value)) {
+			if (world->cache) {
+				lilv_cache_save(world->cache);
+				lilv_cache_free(world->cache);
+				world->cache = NULL;
+			}
+			free(world->opt.cache_path);
+			if (lilv_node_is_string(value)) {
+				world->opt.cache_path = lilv_strdup(lilv_node_as_string(value));
+			} else if (lilv_node_as_bool(value)) {
+				world->opt.cache_path = lilv_cache_default_path();
+			} else {
+				world->opt.cache_path = NULL;
+			}
+			return;
+		}
+	} else if (!strcmp(option, LILV_OPTION_LOAD_THREADS)) {
+		if (lilv_node_is_int(value) && lilv_node_as_int(value) >= 0) {
+			world->opt.load_threads = (unsigned)lilv_node_as_int(value);
+			return;
+		}
+	} else if (!strcmp(option, LILV_OPTION_QUERY_CACHE)) {
+		if (lilv_node_is_bool(value)) {
+			if (!lilv_node_as_bool(value)) {
+				lilv_query_cache_free(world->query_cache, world->world);
+				world->query_cache = NULL;
+			} else if (!world->query_cache) {
+				world->query_cache = lilv_query_cache_new();
+			}
+			return;
+		}
+	} else if (!strcmp(option, LILV_OPTION_SELECTIVE_LOAD)) {
+		if (lilv_node_is_bool(value)) {
+			world->opt.selective_load = lilv_node_as_bool(value);
+			return;
+		}
+	} else if (!strcmp(option, LILV_OPTION_DOCUMENTATION)) {
+		if (lilv_node_is_bool(value)) {
+			world->opt.documentation = lilv_node_as_bool(value);
+			return;
+		}
+	} else if (!strcmp(option, LILV_OPTION_STATE_COPY_INDEX)) {
+		if (lilv_node_is_bool(value)) {
+			world->opt.copy_index = lilv_node_as_bool(value);
 			return;
 		}
 	}
 	LILV_WARNF("Unrecognized or invalid option `%s'\n", option);
 }
 
+LILV_API void
+lilv_world_set_trace_func(LilvWorld* world, LilvTraceFunc func, void* handle)
+{
+	world->trace_func   = func;
+	world->trace_handle = handle;
+}
+
+LILV_API void
+lilv_world_get_memory_stats(LilvWorld* world, LilvMemoryStats* stats)
+{
+	memset(stats, 0, sizeof(LilvMemoryStats));
+	stats->n_statements = sord_num_quads(world->model);
+	stats->n_rdf_nodes  = sord_num_nodes(world->world);
+	stats->n_plugins    = lilv_plugins_size(world->plugins);
+	stats->n_files      = lilv_nodes_size(world->loaded_files);
+
+	LILV_FOREACH(plugins, i, world->plugins) {
+		const LilvPlugin* plugin = lilv_plugins_get(world->plugins, i);
+		stats->n_loaded_plugins += plugin->loaded;
+	}
+
+	for (const LilvSpec* spec = world->specs; spec; spec = spec->next) {
+		++stats->n_specs;
+	}
+
+	lilv_world_lock(world);
+	lilv_node_pool_count(world, &stats->n_nodes, &stats->node_bytes);
+	stats->n_interned_nodes = zix_tree_size(world->nodes);
+	stats->n_libraries      = world->libs ? zix_tree_size(world->libs) : 0;
+	lilv_world_unlock(world);
+}
+
+LILV_API int
+lilv_world_get_bundle_stats(LilvWorld*       world,
+                            const LilvNode*  bundle_uri,
+                            LilvBundleStats* stats)
+{
+	memset(stats, 0, sizeof(LilvBundleStats));
+	if (!bundle_uri) {
+		LILV_ERROR("lilv_world_get_bundle_stats() called on NULL bundle\n");
+		return 1;
+	} else if (!lilv_node_is_uri(bundle_uri)) {
+		LILV_ERRORF("Bundle URI `%s' is not a URI\n",
+		            sord_node_get_string(bundle_uri->node));
+		return 1;
+	}
+
+	SordIter* i = sord_search(
+		world->model, NULL, NULL, NULL, bundle_uri->node);
+	FOREACH_MATCH(i) {
+		const SordNode* object = sord_iter_get_node(i, SORD_OBJECT);
+		if (sord_node_get_type(object) == SORD_LITERAL) {
+			size_t n_bytes = 0;
+			sord_node_get_string_counted(object, &n_bytes);
+			stats->literal_bytes += n_bytes;
+		}
+		++stats->n_statements;
+	}
+	sord_iter_free(i);
+	return 0;
+}
+
+void
+lilv_trace_end(LilvWorld*        world,
+               LilvTraceSpanType type,
+               const char*       uri,
+               uint64_t          begin,
+               size_t            n_statements)
+{
+	if (world->trace_func) {
+		lilv_trace_span(world, type, uri, begin, lilv_time_ns(), n_statements);
+	}
+}
+
+void
+lilv_trace_span(LilvWorld*        world,
+                LilvTraceSpanType type,
+                const char*       uri,
+                uint64_t          begin,
+                uint64_t          end,
+                size_t            n_statements)
+{
+	if (world->trace_func) {
+		const LilvTraceSpan span = { type, uri, begin, end, n_statements };
+		world->trace_func(world->trace_handle, &span);
+	}
+}
+
 LILV_API LilvNodes*
 lilv_world_find_nodes(LilvWorld*      world,
                       const LilvNode* subject,
@@ -205,6 +604,11 @@ lilv_world_find_nodes(LilvWorld*      world,
 		return NULL;
 	}
 
+	lilv_world_load_namespaces(world,
+	                           subject ? subject->node : NULL,
+	                           predicate->node,
+	                           object ? object->node : NULL);
+
 	return lilv_world_find_nodes_internal(world,
 	                                      subject ? subject->node : NULL,
 	                                      predicate->node,
@@ -217,13 +621,34 @@ lilv_world_get(LilvWorld*      world,
                const LilvNode* predicate,
                const LilvNode* object)
 {
-	SordNode* snode = sord_get(world->model,
-	                           subject   ? subject->node   : NULL,
-	                           predicate ? predicate->node : NULL,
-	                           object    ? object->node    : NULL,
-	                           NULL);
-	LilvNode* lnode = lilv_node_new_from_node(world, snode);
-	sord_node_free(world->world, snode);
+	const SordNode* s = subject   ? subject->node   : NULL;
+	const SordNode* p = predicate ? predicate->node : NULL;
+	const SordNode* o = object    ? object->node    : NULL;
+
+	lilv_world_load_namespaces(world, s, p, o);
+
+	lilv_world_lock(world);
+	const LilvQueryEntry* entry =
+		world->query_cache
+		? lilv_query_cache_find(world->query_cache, LILV_QUERY_GET, s, p, o)
+		: NULL;
+
+	LilvNode* lnode = NULL;
+	if (entry) {
+		lnode = entry->n_results
+			? lilv_node_new_from_node(world, entry->results[0])
+			: NULL;
+	} else {
+		SordNode* snode = sord_get(world->model, s, p, o, NULL);
+		lnode = lilv_node_new_from_node(world, snode);
+		if (world->query_cache) {
+			lilv_query_cache_add(world->query_cache, world->world,
+			                     LILV_QUERY_GET, s, p, o,
+			                     (const SordNode* const*)&snode, snode ? 1 : 0);
+		}
+		sord_node_free(world->world, snode);
+	}
+	lilv_world_unlock(world);
 	return lnode;
 }
 
@@ -242,7 +667,25 @@ lilv_world_ask_internal(LilvWorld*      world,
                         const SordNode* predicate,
                         const SordNode* object)
 {
-	return sord_ask(world->model, subject, predicate, object, NULL);
+	if (!world->query_cache) {
+		return sord_ask(world->model, subject, predicate, object, NULL);
+	}
+
+	lilv_world_lock(world);
+	const LilvQueryEntry* entry = lilv_query_cache_find(
+		world->query_cache, LILV_QUERY_ASK, subject, predicate, object);
+
+	bool result = false;
+	if (entry) {
+		result = entry->n_results;
+	} else {
+		result = sord_ask(world->model, subject, predicate, object, NULL);
+		lilv_query_cache_add(world->query_cache, world->world,
+		                     LILV_QUERY_ASK, subject, predicate, object,
+		                     NULL, result);
+	}
+	lilv_world_unlock(world);
+	return result;
 }
 
 LILV_API bool
@@ -251,11 +694,13 @@ lilv_world_ask(LilvWorld*      world,
                const LilvNode* predicate,
                const LilvNode* object)
 {
-	return sord_ask(world->model,
-	                subject   ? subject->node   : NULL,
-	                predicate ? predicate->node : NULL,
-	                object    ? object->node    : NULL,
-	                NULL);
+	const SordNode* s = subject   ? subject->node   : NULL;
+	const SordNode* p = predicate ? predicate->node : NULL;
+	const SordNode* o = object    ? object->node    : NULL;
+
+	lilv_world_load_namespaces(world, s, p, o);
+
+	return lilv_world_ask_internal(world, s, p, o);
 }
 
 SordModel*
@@ -283,10 +728,68 @@ lilv_world_find_nodes_internal(LilvWorld*      world,
                                const SordNode* predicate,
                                const SordNode* object)
 {
-	return lilv_nodes_from_stream_objects(
+	const LilvQueryEntry* entry = NULL;
+	if (world->query_cache) {
+		lilv_world_lock(world);
+		entry = lilv_query_cache_find(
+			world->query_cache, LILV_QUERY_FIND, subject, predicate, object);
+		if (entry) {
+			// Copy results before unlocking, since the cache may be cleared
+			LilvArray values;
+			lilv_array_init(&values);
+			for (uint32_t i = 0; i < entry->n_results; ++i) {
+				lilv_array_append(
+					&values, lilv_node_new_from_node(world, entry->results[i]));
+			}
+			lilv_world_unlock(world);
+			return entry->n_results ? lilv_array_to_nodes(&values) : NULL;
+		}
+		lilv_world_unlock(world);
+	}
+
+	LilvNodes* values = lilv_nodes_from_stream_objects(
 		world,
 		lilv_world_query_internal(world, subject, predicate, object),
 		(object == NULL) ? SORD_OBJECT : SORD_SUBJECT);
+
+	if (world->query_cache) {
+		const uint32_t   n_values = (uint32_t)lilv_nodes_size(values);
+		const SordNode** nodes    = (const SordNode**)malloc(
+			(n_values + 1) * sizeof(SordNode*));
+		uint32_t         n        = 0;
+		LILV_FOREACH(nodes, i, values) {
+			nodes[n++] = lilv_nodes_get(values, i)->node;
+		}
+
+		lilv_world_lock(world);
+		lilv_query_cache_add(world->query_cache, world->world,
+		                     LILV_QUERY_FIND, subject, predicate, object,
+		                     nodes, n);
+		lilv_world_unlock(world);
+		free(nodes);
+	}
+
+	return values;
+}
+
+LilvNode*
+lilv_world_get_name(LilvWorld*      world,
+                    const SordNode* subject,
+                    const SordNode* predicate)
+{
+	LilvNodes* results = lilv_world_find_nodes_internal(
+		world, subject, predicate, NULL);
+
+	LilvNode* ret = NULL;
+	if (results) {
+		LilvNode* val = lilv_nodes_get_first(results);
+		if (lilv_node_is_string(val)) {
+			ret = lilv_node_duplicate(val);
+		}
+		lilv_nodes_free(results);
+	}
+
+	return ret;
 }
 
 static SerdNode
@@ -354,6 +857,32 @@ lilv_collection_get_by_uri(const ZixTree* seq, const LilvNode* uri)
 	return i ? (struct LilvHeader*)zix_tree_get(i) : NULL;
 }
 
+/** Return the length of the namespace `uri` without any trailing separator. */
+static size_t
+spec_namespace_len(const char* uri, size_t len)
+{
+	return (len > 0 && (uri[len - 1] == '#' || uri[len - 1] == '/'))
+		? len - 1
+		: len;
+}
+
+/** Return the length of the namespace of a term like ns#term or ns/term. */
+static size_t
+term_namespace_len(const char* uri, size_t len)
+{
+	const char* hash = (const char*)memchr(uri, '#', len);
+	if (hash) {
+		return (size_t)(hash - uri);
+	}
+
+	for (size_t i = len; i > 0; --i) {
+		if (uri[i - 1] == '/') {
+			return i - 1;
+		}
+	}
+	return len;
+}
+
 static void
 lilv_world_add_spec(LilvWorld*      world,
                     const SordNode* specification_node,
@@ -363,6 +892,8 @@ lilv_world_add_spec(LilvWorld*      world,
 	spec->spec      = sord_node_copy(specification_node);
 	spec->bundle    = sord_node_copy(bundle_node);
 	spec->data_uris = lilv_nodes_new();
+	spec->loaded    = false;
+	spec->ns_next   = NULL;
 
 	// Add all data files (rdfs:seeAlso)
 	SordIter* files = sord_search(world->model,
@@ -381,6 +912,23 @@ lilv_world_add_spec(LilvWorld*      world,
 	// Add specification to world specification list
 	spec->next   = world->specs;
 	world->specs = spec;
+	++world->n_unloaded_specs;
+
+	// Index specification by namespace, so its data can be loaded lazily
+	if (sord_node_get_type(spec->spec) == SORD_URI) {
+		const char*              uri = (const char*)sord_node_get_string(
+			spec->spec);
+		const LilvSpecIndexEntry key = {
+			uri, spec_namespace_len(uri, strlen(uri)), spec
+		};
+		const void* inserted = NULL;
+		if (zix_hash_insert(world->spec_index, &key, &inserted) ==
+		    ZIX_STATUS_EXISTS) {
+			LilvSpecIndexEntry* entry = (LilvSpecIndexEntry*)inserted;
+			spec->ns_next = entry->specs;
+			entry->specs  = spec;
+		}
+	}
 }
 
 static void
@@ -417,6 +965,7 @@ lilv_world_add_plugin(LilvWorld*      world,
 		plugin = (LilvPlugin*)zix_tree_get(z);
 		zix_tree_remove((ZixTree*)world->zombies, z);
 		zix_tree_insert((ZixTree*)world->plugins, plugin, NULL);
+		lilv_header_index_add(world->plugin_index, (struct LilvHeader*)plugin);
 		lilv_node_free(plugin_uri);
 		lilv_plugin_clear(plugin, lilv_node_new_from_node(world, bundle));
 	} else {
@@ -431,12 +980,15 @@ lilv_world_add_plugin(LilvWorld*      world,
 
 		// Add plugin to world plugin sequence
 		zix_tree_insert((ZixTree*)world->plugins, plugin, NULL);
+		lilv_header_index_add(world->plugin_index, (struct LilvHeader*)plugin);
 	}
 
+	++world->plugins_version;
 
 #ifdef LILV_DYN_MANIFEST
 	// Set dynamic manifest library URI, if applicable
-	if (dynmanifest) {
+	if (dynmanifest && plugin->dynmanifest != dynmanifest) {
+		lilv_dyn_manifest_unref(plugin->dynmanifest);
 		plugin->dynmanifest = (LilvDynManifest*)dynmanifest;
 		++((LilvDynManifest*)dynmanifest)->refs;
 	}
@@ -457,13 +1009,96 @@ lilv_world_add_plugin(LilvWorld*      world,
 	sord_iter_free(files);
 }
 
+bool
+lilv_world_skips(const LilvWorld* world, const SordNode* predicate)
+{
+	if (!world->opt.documentation) {
+		for (SordNode* const* d = world->documentation; *d; ++d) {
+			if (*d == predicate) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/** Statement sink for reading data into the world model. */
+typedef struct {
+	LilvWorld* world;
+	SerdEnv*   env;
+	SordNode*  graph;
+} LilvInserter;
+
+static SerdStatus
+inserter_base(void* handle, const SerdNode* uri)
+{
+	return serd_env_set_base_uri(((LilvInserter*)handle)->env, uri);
+}
+
+static SerdStatus
+inserter_prefix(void* handle, const SerdNode* name, const SerdNode* uri)
+{
+	return serd_env_set_prefix(((LilvInserter*)handle)->env, name, uri);
+}
+
+static SerdStatus
+inserter_statement(void*              handle,
+                   SerdStatementFlags flags,
+                   const SerdNode*    graph,
+                   const SerdNode*    subject,
+                   const SerdNode*    predicate,
+                   const SerdNode*    object,
+                   const SerdNode*    object_datatype,
+                   const SerdNode*    object_lang)
+{
+	LilvInserter* const inserter = (LilvInserter*)handle;
+	LilvWorld* const    world    = inserter->world;
+
+	SordNode* p = sord_node_from_serd_node(
+		world->world, inserter->env, predicate, NULL, NULL);
+	if (!p) {
+		return SERD_ERR_BAD_ARG;
+	} else if (lilv_world_skips(world, p)) {
+		sord_node_free(world->world, p);
+		return SERD_SUCCESS;
+	}
+
+	SordNode* s = sord_node_from_serd_node(
+		world->world, inserter->env, subject, NULL, NULL);
+	SordNode* o = sord_node_from_serd_node(
+		world->world, inserter->env, object, object_datatype, object_lang);
+
+	SerdStatus st = SERD_ERR_BAD_ARG;
+	if (s && o) {
+		SordQuad quad = { s, p, o, inserter->graph };
+		sord_add(world->model, quad);
+		st = SERD_SUCCESS;
+	}
+
+	sord_node_free(world->world, o);
+	sord_node_free(world->world, s);
+	sord_node_free(world->world, p);
+	return st;
+}
+
+SerdReader*
+lilv_world_new_reader(LilvWorld* world, SerdEnv* env, SordNode* graph)
+{
+	LilvInserter* inserter = (LilvInserter*)malloc(sizeof(LilvInserter));
+	inserter->world = world;
+	inserter->env   = env;
+	inserter->graph = graph;
+	return serd_reader_new(SERD_TURTLE, inserter, free,
+	                       inserter_base, inserter_prefix,
+	                       inserter_statement, NULL);
+}
+
 SerdStatus
 lilv_world_load_graph(LilvWorld* world, SordNode* graph, const LilvNode* uri)
 {
 	const SerdNode* base   = sord_node_to_serd_node(uri->node);
 	SerdEnv*        env    = serd_env_new(base);
-	SerdReader*     reader = sord_new_reader(
-		world->model, env, SERD_TURTLE, graph);
+	SerdReader*     reader = lilv_world_new_reader(world, env, graph);
 
 	const SerdStatus st = lilv_world_load_file(world, reader, uri);
 
@@ -472,6 +1107,30 @@ lilv_world_load_graph(LilvWorld* world, SordNode* graph, const LilvNode* uri)
 	return st;
 }
 
+#ifdef LILV_DYN_MANIFEST
+static LilvLoadQueue*
+load_queue_new(LilvWorld* world);
+
+static void
+load_queue_add_dyn(LilvLoadQueue*   queue,
+                   LilvDynManifest* dman,
+                   LilvNode*        graph,
+                   LilvNode*        base,
+                   LilvNode*        subject,
+                   const LilvNode*  manifest);
+
+static void
+load_queue_load(LilvLoadQueue* queue);
+#endif
+
+/**
+   Load the dynamic manifests in a bundle.
+
+   The subjects of each dynamic manifest are generated by a load job, from the
+   cache if the library has not changed.  While loading everything, the jobs
+   are added to `world->dyn_queue` so libraries are run in parallel after all
+   the manifests have been loaded.
+*/
 static void
 lilv_world_load_dyn_manifest(LilvWorld*      world,
                              SordNode*       bundle_node,
@@ -482,8 +1141,10 @@ lilv_world_load_dyn_manifest(LilvWorld*      world,
 		return;
 	}
 
-	typedef void* LV2_Dyn_Manifest_Handle;
-	LV2_Dyn_Manifest_Handle handle = NULL;
+	LilvLoadQueue* queue = world->dyn_queue;
+	if (!queue) {
+		queue = load_queue_new(world);
+	}
 
 	// ?dman a dynman:DynManifest bundle_node
 	SordModel* model = lilv_world_filter_model(world,
@@ -513,95 +1174,27 @@ lilv_world_load_dyn_manifest(LilvWorld*      world,
 		const SordNode* binary   = sord_iter_get_node(binaries, SORD_OBJECT);
 		const uint8_t*  lib_uri  = sord_node_get_string(binary);
 		char*           lib_path = lilv_file_uri_parse((const char*)lib_uri, 0);
+		sord_iter_free(binaries);
 		if (!lib_path) {
 			LILV_ERROR("No dynamic manifest library path\n");
-			sord_iter_free(binaries);
-			continue;
-		}
-
-		// Open library
-		dlerror();
-		void* lib = dlopen(lib_path, RTLD_LAZY);
-		if (!lib) {
-			LILV_ERRORF("Failed to open dynmanifest library `%s' (%s)\n",
-			            lib_path, dlerror());
-			sord_iter_free(binaries);
-			lilv_free(lib_path);
-			continue;
-		}
-
-		// Open dynamic manifest
-		typedef int (*OpenFunc)(LV2_Dyn_Manifest_Handle*,
-		                        const LV2_Feature *const *);
-		OpenFunc dmopen = (OpenFunc)lilv_dlfunc(lib, "lv2_dyn_manifest_open");
-		if (!dmopen || dmopen(&handle, &dman_features)) {
-			LILV_ERRORF("No `lv2_dyn_manifest_open' in `%s'\n", lib_path);
-			sord_iter_free(binaries);
-			dlclose(lib);
-			lilv_free(lib_path);
-			continue;
-		}
-
-		// Get subjects (the data that would be in manifest.ttl)
-		typedef int (*GetSubjectsFunc)(LV2_Dyn_Manifest_Handle, FILE*);
-		GetSubjectsFunc get_subjects_func = (GetSubjectsFunc)lilv_dlfunc(
-			lib, "lv2_dyn_manifest_get_subjects");
-		if (!get_subjects_func) {
-			LILV_ERRORF("No `lv2_dyn_manifest_get_subjects' in `%s'\n",
-			            lib_path);
-			sord_iter_free(binaries);
-			dlclose(lib);
-			lilv_free(lib_path);
 			continue;
 		}
 
-		LilvDynManifest* desc = malloc(sizeof(LilvDynManifest));
-		desc->bundle = lilv_node_new_from_node(world, bundle_node);
-		desc->lib    = lib;
-		desc->handle = handle;
-		desc->refs   = 0;
-
-		sord_iter_free(binaries);
-
-		// Generate data file
-		FILE* fd = tmpfile();
-		get_subjects_func(handle, fd);
-		rewind(fd);
-
-		// Parse generated data file into temporary model
-		// FIXME
-		const SerdNode* base   = sord_node_to_serd_node(dmanifest);
-		SerdEnv*        env    = serd_env_new(base);
-		SerdReader*     reader = sord_new_reader(
-			world->model, env, SERD_TURTLE, sord_node_copy(dmanifest));
-		serd_reader_add_blank_prefix(reader,
-		                             lilv_world_blank_node_prefix(world));
-		serd_reader_read_file_handle(reader, fd,
-		                             (const uint8_t*)"(dyn-manifest)");
-		serd_reader_free(reader);
-		serd_env_free(env);
-
-		// Close (and automatically delete) temporary data file
-		fclose(fd);
-
-		// ?plugin a lv2:Plugin
-		SordModel* plugins = lilv_world_filter_model(world,
-		                                             world->model,
-		                                             NULL,
-		                                             world->uris.rdf_a,
-		                                             world->uris.lv2_Plugin,
-		                                             dmanifest);
-		SordIter* p = sord_begin(plugins);
-		FOREACH_MATCH(p) {
-			const SordNode* plug = sord_iter_get_node(p, SORD_SUBJECT);
-			lilv_world_add_plugin(world, plug, manifest, desc, bundle_node);
-		}
-		sord_iter_free(p);
-		sord_free(plugins);
+		// Generate subjects (the data that would be in manifest.ttl)
+		LilvDynManifest* dman = lilv_dyn_manifest_new(
+			world, bundle_node, lib_path);
+		LilvNode* dman_node = lilv_node_new_from_node(world, dmanifest);
+		load_queue_add_dyn(queue, dman, dman_node,
+		                   lilv_node_duplicate(dman_node), NULL, manifest);
 		lilv_free(lib_path);
 	}
 	sord_iter_free(iter);
 	sord_free(model);
+
+	if (queue != world->dyn_queue) {
+		load_queue_load(queue);
+		free(queue);
+	}
 #endif  // LILV_DYN_MANIFEST
 }
 
@@ -675,25 +1268,15 @@ get_version(LilvWorld* world, SordModel* model, const LilvNode* subject)
 	return version;
 }
 
-LILV_API void
-lilv_world_load_bundle(LilvWorld* world, const LilvNode* bundle_uri)
+/** Add the plugins and specifications of a bundle whose manifest is loaded. */
+static void
+lilv_world_add_bundle(LilvWorld*      world,
+                      const LilvNode* bundle_uri,
+                      const LilvNode* manifest)
 {
-	if (!lilv_node_is_uri(bundle_uri)) {
-		LILV_ERRORF("Bundle URI `%s' is not a URI\n",
-		            sord_node_get_string(bundle_uri->node));
-		return;
-	}
-
 	SordNode* bundle_node = bundle_uri->node;
-	LilvNode* manifest    = lilv_world_get_manifest_uri(world, bundle_uri);
 
-	// Read manifest into model with graph = bundle_node
-	SerdStatus st = lilv_world_load_graph(world, bundle_node, manifest);
-	if (st > SERD_FAILURE) {
-		LILV_ERRORF("Error reading %s\n", lilv_node_as_string(manifest));
-		lilv_node_free(manifest);
-		return;
-	}
+	++world->bundles_version;
 
 	// ?plugin a lv2:Plugin
 	SordIter* plug_results = sord_search(world->model,
@@ -744,7 +1327,6 @@ lilv_world_load_bundle(LilvWorld* world, const LilvNode* bundle_uri)
 			lilv_node_free(plugin_uri);
 			sord_iter_free(plug_results);
 			lilv_world_drop_graph(world, bundle_node);
-			lilv_node_free(manifest);
 			lilv_nodes_free(unload_uris);
 			return;
 		}
@@ -805,13 +1387,44 @@ lilv_world_load_bundle(LilvWorld* world, const LilvNode* bundle_uri)
 		}
 		sord_iter_free(i);
 	}
-
-	lilv_node_free(manifest);
 }
 
-static int
+LILV_API void
+lilv_world_load_bundle(LilvWorld* world, const LilvNode* bundle_uri)
+{
+	if (world->frozen) {
+		LILV_ERROR("World is frozen\n");
+		return;
+	}
+
+	if (!lilv_node_is_uri(bundle_uri)) {
+		LILV_ERRORF("Bundle URI `%s' is not a URI\n",
+		            sord_node_get_string(bundle_uri->node));
+		return;
+	}
+
+	const uint64_t begin       = lilv_trace_begin(world);
+	SordNode*      bundle_node = bundle_uri->node;
+	LilvNode*      manifest    = lilv_world_get_manifest_uri(world, bundle_uri);
+
+	// Read manifest into model with graph = bundle_node
+	SerdStatus st = lilv_world_load_graph(world, bundle_node, manifest);
+	if (st > SERD_FAILURE) {
+		LILV_ERRORF("Error reading %s\n", lilv_node_as_string(manifest));
+	} else {
+		lilv_world_add_bundle(world, bundle_uri, manifest);
+	}
+
+	lilv_node_free(manifest);
+	lilv_trace_end(world, LILV_TRACE_LOAD_BUNDLE,
+	               lilv_node_as_uri(bundle_uri), begin, 0);
+}
+
+int
 lilv_world_drop_graph(LilvWorld* world, const SordNode* graph)
 {
+	lilv_world_model_changed(world);
+
 	SordIter* i = sord_search(world->model, NULL, NULL, NULL, graph);
 	while (!sord_iter_end(i)) {
 		const SerdStatus st = sord_erase(world->model, i);
@@ -843,8 +1456,13 @@ lilv_world_unload_bundle(LilvWorld* world, const LilvNode* bundle_uri)
 {
 	if (!bundle_uri) {
 		return 0;
+	} else if (world->frozen) {
+		LILV_ERROR("World is frozen\n");
+		return -1;
 	}
 
+	++world->bundles_version;
+
 	// Find all loaded files that are inside the bundle
 	LilvNodes* files = lilv_nodes_new();
 	LILV_FOREACH(nodes, i, world->loaded_files) {
@@ -878,17 +1496,510 @@ lilv_world_unload_bundle(LilvWorld* world, const LilvNode* bundle_uri)
 		ZixTreeIter* next = zix_tree_iter_next(i);
 
 		if (lilv_node_equals(lilv_plugin_get_bundle_uri(p), bundle_uri)) {
+			if (p->summarized) {
+				lilv_world_drop_graph(world, p->plugin_uri->node);
+				p->summarized = false;
+			}
 			zix_tree_remove((ZixTree*)world->plugins, i);
 			zix_tree_insert((ZixTree*)world->zombies, p, NULL);
+			++world->plugins_version;
+			lilv_header_index_remove(world->plugin_index,
+			                         (struct LilvHeader*)p);
 		}
 
 		i = next;
 	}
 
+	// Forget any cached data from the bundle
+	if (world->cache) {
+		char* bundle_path = lilv_file_uri_parse(
+			lilv_node_as_uri(bundle_uri), NULL);
+		if (bundle_path) {
+			lilv_cache_remove_dir(world->cache, bundle_path);
+			lilv_free(bundle_path);
+		}
+	}
+
 	// Drop everything in bundle graph
 	return lilv_world_drop_graph(world, bundle_uri->node);
 }
 
+/**
+   A data file to be parsed by a load queue.
+
+   A job may instead parse data generated by a dynamic manifest library, in
+   which case `uri` is the base URI of the data, and `path` is the path of the
+   library, which the data is cached under with a key of `subject`, or `uri`
+   for the subjects of the dynamic manifest.
+*/
+typedef struct {
+	LilvNode*             bundle;        ///< Bundle URI, or NULL for no graph
+	LilvNode*             uri;           ///< File URI
+	char*                 path;          ///< File path, if caching
+#ifdef LILV_DYN_MANIFEST
+	LilvDynManifest*      dman;          ///< Dynamic manifest, or NULL
+	LilvNode*             subject;       ///< Plugin to generate data for
+	LilvNode*             manifest;      ///< Manifest of dynamic manifest
+#endif
+	const LilvCacheEntry* cached;        ///< Valid cache entry, or NULL
+	char                  prefix[32];    ///< Blank node prefix
+	SerdEnv*              env;           ///< Environment at end of file
+	LilvStatement*        statements;    ///< Parsed statements
+	size_t                n_statements;  ///< Number of parsed statements
+	size_t                statements_size;  ///< Allocated statements
+	SerdStatus            st;            ///< Status of parsing
+	uint64_t              parse_begin;   ///< Traced start time of parsing
+	uint64_t              parse_end;     ///< Traced end time of parsing
+} LilvLoadJob;
+
+/** Data files to be parsed in parallel, then loaded in order. */
+struct LilvLoadQueueImpl {
+	LilvWorld*      world;
+	LilvLoadJob*    jobs;
+	size_t          n_jobs;
+	size_t          next;  ///< Index of the next job to be parsed
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t mutex;
+#endif
+};
+
+static SerdStatus
+load_job_base(void* handle, const SerdNode* uri)
+{
+	return serd_env_set_base_uri(((LilvLoadJob*)handle)->env, uri);
+}
+
+static SerdStatus
+load_job_prefix(void* handle, const SerdNode* name, const SerdNode* uri)
+{
+	return serd_env_set_prefix(((LilvLoadJob*)handle)->env, name, uri);
+}
+
+static SerdNode
+load_job_copy_node(LilvLoadJob* job, const SerdNode* node)
+{
+	if (!node) {
+		const SerdNode null_node = SERD_NODE_NULL;
+		return null_node;
+	} else if (node->type == SERD_URI || node->type == SERD_CURIE) {
+		return serd_env_expand_node(job->env, node);
+	}
+	return serd_node_copy(node);
+}
+
+static SerdStatus
+load_job_statement(void*              handle,
+                       SerdStatementFlags flags,
+                       const SerdNode*    graph,
+                       const SerdNode*    subject,
+                       const SerdNode*    predicate,
+                       const SerdNode*    object,
+                       const SerdNode*    object_datatype,
+                       const SerdNode*    object_lang)
+{
+	LilvLoadJob* job = (LilvLoadJob*)handle;
+	if (job->n_statements == job->statements_size) {
+		job->statements_size = job->statements_size * 2 + 16;
+		job->statements      = (LilvStatement*)realloc(
+			job->statements, job->statements_size * sizeof(LilvStatement));
+	}
+
+	LilvStatement* t = &job->statements[job->n_statements];
+	t->s        = load_job_copy_node(job, subject);
+	t->p        = load_job_copy_node(job, predicate);
+	t->o        = load_job_copy_node(job, object);
+	t->datatype = load_job_copy_node(job, object_datatype);
+	t->lang     = load_job_copy_node(job, object_lang);
+	if (!t->s.buf || !t->p.buf || !t->o.buf) {
+		LILV_ERRORF("Failed to expand statement in %s\n",
+		            lilv_node_as_string(job->uri));
+		serd_node_free(&t->s);
+		serd_node_free(&t->p);
+		serd_node_free(&t->o);
+		serd_node_free(&t->datatype);
+		serd_node_free(&t->lang);
+		return SERD_SUCCESS;
+	}
+
+	++job->n_statements;
+	return SERD_SUCCESS;
+}
+
+/**
+   Parse the file of a job into its own statement list.
+
+   This does not touch the world, so may be called from any thread.  The
+   parse is timed here, but traced by load_job_load() in the calling thread.
+*/
+static void
+load_job_parse(const LilvWorld* world, LilvLoadJob* job)
+{
+	if (job->cached) {
+		return;  // Statements will be loaded from the cache
+	}
+
+	job->parse_begin = lilv_trace_begin(world);
+	job->env = serd_env_new(sord_node_to_serd_node(job->uri->node));
+
+	SerdReader* reader = serd_reader_new(
+		SERD_TURTLE, job, NULL,
+		load_job_base, load_job_prefix, load_job_statement, NULL);
+
+	serd_reader_add_blank_prefix(reader, (const uint8_t*)job->prefix);
+
+#ifdef LILV_DYN_MANIFEST
+	if (job->dman) {
+		char* const text = job->subject
+			? lilv_dyn_manifest_get_data(job->dman,
+			                             lilv_node_as_uri(job->subject))
+			: lilv_dyn_manifest_get_subjects(job->dman);
+
+		job->st = text ? serd_reader_read_string(reader, (const uint8_t*)text)
+		               : SERD_ERR_UNKNOWN;
+		free(text);
+		serd_reader_free(reader);
+		job->parse_end = lilv_trace_begin(world);
+		return;
+	}
+#endif
+
+	job->st = serd_reader_read_file(
+		reader, sord_node_get_string(job->uri->node));
+
+	serd_reader_free(reader);
+	job->parse_end = lilv_trace_begin(world);
+}
+
+/** Return the cache key of a job, which is empty for data files. */
+static const char*
+load_job_key(const LilvLoadJob* job)
+{
+#ifdef LILV_DYN_MANIFEST
+	if (job->dman) {
+		return lilv_node_as_uri(job->subject ? job->subject : job->uri);
+	}
+#endif
+	return "";
+}
+
+static void
+load_job_free(LilvLoadJob* job)
+{
+	for (size_t i = 0; i < job->n_statements; ++i) {
+		LilvStatement* t = &job->statements[i];
+		serd_node_free(&t->s);
+		serd_node_free(&t->p);
+		serd_node_free(&t->o);
+		serd_node_free(&t->datatype);
+		serd_node_free(&t->lang);
+	}
+	free(job->statements);
+	if (job->env) {
+		serd_env_free(job->env);
+	}
+	lilv_free(job->path);
+	lilv_node_free(job->uri);
+	lilv_node_free(job->bundle);
+#ifdef LILV_DYN_MANIFEST
+	lilv_dyn_manifest_unref(job->dman);
+	lilv_node_free(job->subject);
+	lilv_node_free(job->manifest);
+#endif
+}
+
+#ifdef LILV_DYN_MANIFEST
+/** Add the plugins described by the subjects of a dynamic manifest. */
+static void
+load_job_add_dyn_plugins(LilvWorld* world, LilvLoadJob* job)
+{
+	// ?plugin a lv2:Plugin
+	SordModel* plugins = lilv_world_filter_model(world,
+	                                             world->model,
+	                                             NULL,
+	                                             world->uris.rdf_a,
+	                                             world->uris.lv2_Plugin,
+	                                             job->bundle->node);
+	SordIter* p = sord_begin(plugins);
+	FOREACH_MATCH(p) {
+		const SordNode* plug = sord_iter_get_node(p, SORD_SUBJECT);
+		lilv_world_add_plugin(world, plug, job->manifest, job->dman,
+		                      job->dman->bundle->node);
+	}
+	sord_iter_free(p);
+	sord_free(plugins);
+}
+#endif
+
+/**
+   Add the bundle of a manifest job to the world.
+   The bundle is traced from `begin`, when the job started to be added.
+*/
+static void
+load_job_add_bundle(LilvWorld* world, LilvLoadJob* job, uint64_t begin)
+{
+	lilv_world_add_bundle(world, job->bundle, job->uri);
+	lilv_trace_end(world, LILV_TRACE_LOAD_BUNDLE,
+	               lilv_node_as_uri(job->bundle), begin, 0);
+}
+
+/**
+   Add the statements of a job to the world.
+   If the job is a bundle manifest, the bundle is then loaded.
+*/
+static void
+load_job_load(LilvWorld* world, LilvLoadJob* job)
+{
+	const uint64_t begin   = lilv_trace_begin(world);
+	bool           is_file = true;
+#ifdef LILV_DYN_MANIFEST
+	is_file = !job->dman;
+#endif
+
+	ZixTreeIter* iter;
+	if (is_file &&
+	    !zix_tree_find((ZixTree*)world->loaded_files, job->uri, &iter)) {
+		// File is already loaded, like lilv_world_load_file()
+		if (job->bundle) {
+			load_job_add_bundle(world, job, begin);
+		}
+		return;
+	}
+
+	lilv_world_model_changed(world);
+
+	SordNode* graph = job->bundle ? job->bundle->node : NULL;
+	if (job->cached) {
+		const size_t n_quads = sord_num_quads(world->model);
+		lilv_cache_load(world, job->cached, graph, job->prefix);
+		lilv_trace_end(world, LILV_TRACE_LOAD_FILE,
+		               lilv_node_as_string(job->uri), begin,
+		               sord_num_quads(world->model) - n_quads);
+	} else {
+		lilv_trace_span(world, LILV_TRACE_LOAD_FILE,
+		                lilv_node_as_string(job->uri),
+		                job->parse_begin, job->parse_end, job->n_statements);
+	}
+
+	for (size_t i = 0; i < job->n_statements; ++i) {
+		const LilvStatement* t = &job->statements[i];
+
+		SordNode* s = sord_node_from_serd_node(
+			world->world, job->env, &t->s, NULL, NULL);
+		SordNode* p = sord_node_from_serd_node(
+			world->world, job->env, &t->p, NULL, NULL);
+		SordNode* o = sord_node_from_serd_node(
+			world->world, job->env, &t->o,
+			t->datatype.buf ? &t->datatype : NULL,
+			t->lang.buf ? &t->lang : NULL);
+
+		if (s && p && o && !lilv_world_skips(world, p)) {
+			SordQuad quad = { s, p, o, graph };
+			sord_add(world->model, quad);
+		}
+
+		sord_node_free(world->world, o);
+		sord_node_free(world->world, p);
+		sord_node_free(world->world, s);
+	}
+
+	if (job->st > SERD_FAILURE) {
+		LILV_ERRORF("Error reading %s\n", lilv_node_as_string(job->uri));
+		return;
+	}
+
+	if (world->cache && job->path && !job->cached) {
+		lilv_cache_set(world->cache, job->path, load_job_key(job),
+		               job->statements, job->n_statements, job->prefix);
+	}
+
+#ifdef LILV_DYN_MANIFEST
+	if (job->dman) {
+		if (!job->subject) {
+			load_job_add_dyn_plugins(world, job);
+		}
+		return;
+	}
+#endif
+
+	zix_tree_insert((ZixTree*)world->loaded_files,
+	                lilv_node_duplicate(job->uri),
+	                NULL);
+
+	if (job->bundle) {
+		load_job_add_bundle(world, job, begin);
+	}
+}
+
+/**
+   Add a job to load `uri` (which is taken) into the graph `bundle`.
+   The job is satisfied from the world cache if possible.
+*/
+#ifdef LILV_DYN_MANIFEST
+static LilvLoadQueue*
+load_queue_new(LilvWorld* world)
+{
+	LilvLoadQueue* queue = (LilvLoadQueue*)calloc(1, sizeof(LilvLoadQueue));
+	queue->world = world;
+	return queue;
+}
+#endif
+
+static LilvLoadJob*
+load_queue_push(LilvLoadQueue* queue, LilvNode* bundle, LilvNode* uri)
+{
+	queue->jobs = (LilvLoadJob*)realloc(
+		queue->jobs, ++queue->n_jobs * sizeof(LilvLoadJob));
+
+	LilvLoadJob* job = &queue->jobs[queue->n_jobs - 1];
+	memset(job, '\0', sizeof(LilvLoadJob));
+	job->bundle = bundle;
+	job->uri    = uri;
+	strncpy(job->prefix,
+	        (const char*)lilv_world_blank_node_prefix(queue->world),
+	        sizeof(job->prefix) - 1);
+	return job;
+}
+
+static void
+load_queue_add(LilvLoadQueue* queue, LilvNode* bundle, LilvNode* uri)
+{
+	LilvWorld*   world = queue->world;
+	LilvLoadJob* job   = load_queue_push(queue, bundle, uri);
+	if (world->cache) {
+		job->path   = lilv_file_uri_parse(lilv_node_as_uri(uri), NULL);
+		job->cached = lilv_cache_get(world->cache, job->path, "");
+	}
+}
+
+#ifdef LILV_DYN_MANIFEST
+/**
+   Add a job to load data generated by `dman` into `graph`.
+
+   The reference to `dman` and the nodes `graph`, `base`, and `subject` are
+   taken.  If `subject` is NULL, the subjects of the dynamic manifest are
+   generated, and the plugins found are added to the world with `manifest`.
+*/
+static void
+load_queue_add_dyn(LilvLoadQueue*   queue,
+                   LilvDynManifest* dman,
+                   LilvNode*        graph,
+                   LilvNode*        base,
+                   LilvNode*        subject,
+                   const LilvNode*  manifest)
+{
+	LilvWorld*   world = queue->world;
+	LilvLoadJob* job   = load_queue_push(queue, graph, base);
+	job->dman     = dman;
+	job->subject  = subject;
+	job->manifest = lilv_node_duplicate(manifest);
+	if (world->cache) {
+		job->path   = lilv_strdup(dman->lib_path);
+		job->cached = lilv_cache_get(world->cache, job->path, load_job_key(job));
+	}
+}
+
+void
+lilv_world_load_dyn_data(LilvWorld*       world,
+                         LilvDynManifest* dman,
+                         const LilvNode*  plugin,
+                         const LilvNode*  graph)
+{
+	LilvLoadQueue queue;
+	memset(&queue, '\0', sizeof(queue));
+	queue.world = world;
+
+	++dman->refs;
+	load_queue_add_dyn(&queue, dman,
+	                   lilv_node_duplicate(graph),
+	                   lilv_node_duplicate(dman->bundle),
+	                   lilv_node_duplicate(plugin),
+	                   NULL);
+	load_queue_load(&queue);
+}
+#endif
+
+static void*
+load_queue_run(void* data)
+{
+	LilvLoadQueue* queue = (LilvLoadQueue*)data;
+	for (;;) {
+#ifdef HAVE_PTHREAD
+		pthread_mutex_lock(&queue->mutex);
+#endif
+		const size_t i = queue->next;
+		if (i < queue->n_jobs) {
+			++queue->next;
+		}
+#ifdef HAVE_PTHREAD
+		pthread_mutex_unlock(&queue->mutex);
+#endif
+		if (i >= queue->n_jobs) {
+			break;
+		}
+
+		load_job_parse(queue->world, &queue->jobs[i]);
+	}
+	return NULL;
+}
+
+/**
+   Parse all queued files.
+
+   Parsing happens concurrently on `world->opt.load_threads` threads (including
+   the calling one), but does not touch the world.
+*/
+static void
+load_queue_parse(LilvLoadQueue* queue)
+{
+#ifdef HAVE_PTHREAD
+	size_t n_threads = queue->world->opt.load_threads;
+	if (n_threads > queue->n_jobs) {
+		n_threads = queue->n_jobs;
+	}
+
+	pthread_t* threads   = (pthread_t*)calloc(n_threads, sizeof(pthread_t));
+	size_t     n_started = 0;
+	pthread_mutex_init(&queue->mutex, NULL);
+	for (; n_started + 1 < n_threads; ++n_started) {
+		if (pthread_create(
+			    &threads[n_started], NULL, load_queue_run, queue)) {
+			LILV_WARNF("Failed to start loader thread (%s)\n",
+			           strerror(errno));
+			break;
+		}
+	}
+	load_queue_run(queue);
+	for (size_t i = 0; i < n_started; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+	pthread_mutex_destroy(&queue->mutex);
+	free(threads);
+#else
+	load_queue_run(queue);
+#endif
+}
+
+/**
+   Parse all queued files, then add them to the world in the order queued.
+
+   Only the calling thread touches the world, so the result does not depend
+   on the order the parses finish.
+*/
+static void
+load_queue_load(LilvLoadQueue* queue)
+{
+	LilvWorld* world = queue->world;
+
+	load_queue_parse(queue);
+	for (size_t i = 0; i < queue->n_jobs; ++i) {
+		load_job_load(world, &queue->jobs[i]);
+		load_job_free(&queue->jobs[i]);
+	}
+	free(queue->jobs);
+	queue->jobs   = NULL;
+	queue->n_jobs = 0;
+}
+
 static void
 load_dir_entry(const char* dir, const char* name, void* data)
 {
@@ -906,13 +2017,40 @@ load_dir_entry(const char* dir, const char* name, void* data)
 	free(path);
 }
 
-/** Load all bundles in the directory at `dir_path`. */
 static void
-lilv_world_load_directory(LilvWorld* world, const char* dir_path)
+queue_dir_entry(const char* dir, const char* name, void* data)
+{
+	LilvLoadQueue* queue = (LilvLoadQueue*)data;
+	LilvWorld*     world = queue->world;
+	if (!strcmp(name, ".") || !strcmp(name, ".."))
+		return;
+
+	char*     path   = lilv_strjoin(dir, "/", name, "/", NULL);
+	SerdNode  suri   = serd_node_new_file_uri((const uint8_t*)path, 0, 0, true);
+	LilvNode* bundle = lilv_new_uri(world, (const char*)suri.buf);
+
+	load_queue_add(queue, bundle, lilv_world_get_manifest_uri(world, bundle));
+
+	serd_node_free(&suri);
+	free(path);
+}
+
+/**
+   Load all bundles in the directory at `dir_path`.
+   If `queue` is non-NULL, bundles are added to it rather than loaded.
+*/
+static void
+lilv_world_load_directory(LilvWorld*         world,
+                          LilvLoadQueue* queue,
+                          const char*        dir_path)
 {
 	char* path = lilv_expand(dir_path);
 	if (path) {
-		lilv_dir_for_each(path, world, load_dir_entry);
+		if (queue) {
+			lilv_dir_for_each(path, queue, queue_dir_entry);
+		} else {
+			lilv_dir_for_each(path, world, load_dir_entry);
+		}
 		free(path);
 	}
 }
@@ -934,8 +2072,9 @@ first_path_sep(const char* path)
  * parent directories of bundles, not a list of bundle directories).
  */
 static void
-lilv_world_load_path(LilvWorld*  world,
-                     const char* lv2_path)
+lilv_world_load_path(LilvWorld*         world,
+                     LilvLoadQueue* queue,
+                     const char*        lv2_path)
 {
 	while (lv2_path[0] != '\0') {
 		const char* const sep = first_path_sep(lv2_path);
@@ -944,29 +2083,294 @@ lilv_world_load_path(LilvWorld*  world,
 			char* const  dir     = (char*)malloc(dir_len + 1);
 			memcpy(dir, lv2_path, dir_len);
 			dir[dir_len] = '\0';
-			lilv_world_load_directory(world, dir);
+			lilv_world_load_directory(world, queue, dir);
 			free(dir);
 			lv2_path += dir_len + 1;
 		} else {
-			lilv_world_load_directory(world, lv2_path);
+			lilv_world_load_directory(world, queue, lv2_path);
 			lv2_path = "\0";
 		}
 	}
 }
 
+/** Add the data files of `spec` to `queue`, or load them if it is NULL. */
+static void
+lilv_world_load_spec(LilvWorld* world, LilvLoadQueue* queue, LilvSpec* spec)
+{
+	LILV_FOREACH(nodes, f, spec->data_uris) {
+		LilvNode* file = (LilvNode*)lilv_collection_get(spec->data_uris, f);
+		if (queue) {
+			load_queue_add(queue, NULL, lilv_node_duplicate(file));
+		} else {
+			lilv_world_load_graph(world, NULL, file);
+		}
+	}
+
+	spec->loaded = true;
+	--world->n_unloaded_specs;
+}
+
+/** Load any unloaded specification in the namespace `ns`. */
+static void
+lilv_world_load_namespace(LilvWorld*     world,
+                          LilvLoadQueue* queue,
+                          const char*    ns,
+                          size_t         len)
+{
+	const LilvSpecIndexEntry  key   = { ns, len, NULL };
+	const LilvSpecIndexEntry* entry = (const LilvSpecIndexEntry*)zix_hash_find(
+		world->spec_index, &key);
+	for (LilvSpec* spec = entry ? entry->specs : NULL; spec;
+	     spec = spec->ns_next) {
+		if (!spec->loaded) {
+			lilv_world_load_spec(world, queue, spec);
+		}
+	}
+}
+
+/**
+   Load the specifications that a query for a triple pattern may touch.
+
+   Specification data is not loaded by lilv_world_load_all(), but the first
+   time a query mentions a specification or a term in its namespace.  This is
+   only done by public queries, since internal ones may be nested in an
+   iteration over the model, which must not change.
+*/
+static void
+lilv_world_load_namespaces(LilvWorld*      world,
+                           const SordNode* subject,
+                           const SordNode* predicate,
+                           const SordNode* object)
+{
+	if (world->frozen || !world->n_unloaded_specs) {
+		return;
+	}
+
+	LilvLoadQueue queue;
+	memset(&queue, '\0', sizeof(queue));
+	queue.world = world;
+
+	const bool      use_queue = world->cache || world->opt.load_threads > 1;
+	const unsigned  n_before  = world->n_unloaded_specs;
+	const SordNode* nodes[]   = { subject, predicate, object };
+	for (unsigned i = 0; i < 3; ++i) {
+		if (!nodes[i] || sord_node_get_type(nodes[i]) != SORD_URI) {
+			continue;
+		}
+
+		const char*  uri      = (const char*)sord_node_get_string(nodes[i]);
+		const size_t len      = strlen(uri);
+		const size_t spec_len = spec_namespace_len(uri, len);
+		const size_t term_len = term_namespace_len(uri, len);
+		lilv_world_load_namespace(
+			world, use_queue ? &queue : NULL, uri, spec_len);
+		if (term_len != spec_len) {
+			lilv_world_load_namespace(
+				world, use_queue ? &queue : NULL, uri, term_len);
+		}
+	}
+
+	if (world->n_unloaded_specs != n_before) {
+		load_queue_load(&queue);
+		lilv_world_model_changed(world);
+	}
+}
+
 void
 lilv_world_load_specifications(LilvWorld* world)
 {
+	if (world->frozen) {
+		LILV_ERROR("World is frozen\n");
+		return;
+	}
+
+	LilvLoadQueue queue;
+	memset(&queue, '\0', sizeof(queue));
+	queue.world = world;
+
+	const bool use_queue = world->cache || world->opt.load_threads > 1;
 	for (LilvSpec* spec = world->specs; spec; spec = spec->next) {
+		if (!spec->loaded) {
+			lilv_world_load_spec(world, use_queue ? &queue : NULL, spec);
+		}
+	}
+
+	load_queue_load(&queue);
+	lilv_world_model_changed(world);
+}
+
+/** A class declared in an unloaded specification. */
+typedef struct {
+	SordNode* child;
+	SordNode* parent;
+	LilvSpec* spec;      ///< Specification that declares the class
+	bool      plugin;    ///< True if child is a subclass of lv2:Plugin
+} LilvClassEdge;
+
+/** State of scanning unloaded specifications for subclass declarations. */
+typedef struct {
+	LilvWorld*     world;
+	SerdEnv*       env;      ///< Environment of the current file
+	LilvSpec*      spec;     ///< Specification of the current file
+	LilvClassEdge* edges;
+	size_t         n_edges;
+} LilvClassScan;
+
+static SerdStatus
+class_scan_base(void* handle, const SerdNode* uri)
+{
+	return serd_env_set_base_uri(((LilvClassScan*)handle)->env, uri);
+}
+
+static SerdStatus
+class_scan_prefix(void* handle, const SerdNode* name, const SerdNode* uri)
+{
+	return serd_env_set_prefix(((LilvClassScan*)handle)->env, name, uri);
+}
+
+static bool
+class_scan_is_uri(const SerdNode* node)
+{
+	return node->type == SERD_URI || node->type == SERD_CURIE;
+}
+
+/** Record every `?child rdfs:subClassOf ?parent` between URIs. */
+static SerdStatus
+class_scan_statement(void*              handle,
+                     SerdStatementFlags flags,
+                     const SerdNode*    graph,
+                     const SerdNode*    subject,
+                     const SerdNode*    predicate,
+                     const SerdNode*    object,
+                     const SerdNode*    object_datatype,
+                     const SerdNode*    object_lang)
+{
+	LilvClassScan* const scan  = (LilvClassScan*)handle;
+	LilvWorld* const     world = scan->world;
+	if (!class_scan_is_uri(subject) || !class_scan_is_uri(object)) {
+		return SERD_SUCCESS;
+	}
+
+	SordNode* p = sord_node_from_serd_node(
+		world->world, scan->env, predicate, NULL, NULL);
+	if (sord_node_equals(p, world->uris.rdfs_subClassOf)) {
+		SordNode* c = sord_node_from_serd_node(
+			world->world, scan->env, subject, NULL, NULL);
+		SordNode* o = sord_node_from_serd_node(
+			world->world, scan->env, object, NULL, NULL);
+		if (c && o) {
+			scan->edges = (LilvClassEdge*)realloc(
+				scan->edges, (scan->n_edges + 1) * sizeof(LilvClassEdge));
+			LilvClassEdge* edge = &scan->edges[scan->n_edges++];
+			edge->child  = c;
+			edge->parent = o;
+			edge->spec   = scan->spec;
+			edge->plugin = false;
+		} else {
+			sord_node_free(world->world, o);
+			sord_node_free(world->world, c);
+		}
+	}
+	sord_node_free(world->world, p);
+	return SERD_SUCCESS;
+}
+
+/** Return true iff `node` is lv2:Plugin or a subclass of it in the model. */
+static bool
+lilv_world_is_plugin_class(LilvWorld* world, const SordNode* node)
+{
+	// Bound the depth, since the data may have cycles
+	for (unsigned depth = 0; node && depth < 32; ++depth) {
+		if (sord_node_equals(node, world->uris.lv2_Plugin)) {
+			return true;
+		}
+
+		SordIter* p = sord_search(
+			world->model, node, world->uris.rdfs_subClassOf, NULL, NULL);
+		node = sord_iter_end(p) ? NULL : sord_iter_get_node(p, SORD_OBJECT);
+		sord_iter_free(p);
+	}
+	return false;
+}
+
+/**
+   Load the unloaded specifications that declare plugin classes.
+
+   Specifications are parsed without adding anything to the model, to find
+   their subclass declarations, and only those that declare a subclass of
+   lv2:Plugin (directly or via any other class) are loaded.
+*/
+static void
+lilv_world_load_plugin_class_specs(LilvWorld* world)
+{
+	if (!world->n_unloaded_specs) {
+		return;
+	}
+
+	LilvClassScan scan   = { world, NULL, NULL, NULL, 0 };
+	SerdReader*   reader = serd_reader_new(
+		SERD_TURTLE, &scan, NULL,
+		class_scan_base, class_scan_prefix, class_scan_statement, NULL);
+	for (LilvSpec* spec = world->specs; spec; spec = spec->next) {
+		if (spec->loaded) {
+			continue;
+		}
+
+		scan.spec = spec;
 		LILV_FOREACH(nodes, f, spec->data_uris) {
-			LilvNode* file = (LilvNode*)lilv_collection_get(spec->data_uris, f);
-			lilv_world_load_graph(world, NULL, file);
+			const LilvNode* file  = lilv_nodes_get(spec->data_uris, f);
+			const uint64_t  begin = lilv_trace_begin(world);
+			scan.env = serd_env_new(sord_node_to_serd_node(file->node));
+			serd_reader_read_file(reader, sord_node_get_string(file->node));
+			serd_env_free(scan.env);
+			lilv_trace_end(world, LILV_TRACE_LOAD_FILE,
+			               (const char*)sord_node_get_string(file->node),
+			               begin, 0);
+		}
+	}
+	serd_reader_free(reader);
+
+	// Mark subclasses of lv2:Plugin until no more are found
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (size_t i = 0; i < scan.n_edges; ++i) {
+			LilvClassEdge* edge = &scan.edges[i];
+			bool           is_plugin = !edge->plugin &&
+				lilv_world_is_plugin_class(world, edge->parent);
+			for (size_t j = 0; !edge->plugin && !is_plugin && j < scan.n_edges;
+			     ++j) {
+				is_plugin = (scan.edges[j].plugin &&
+				             sord_node_equals(scan.edges[j].child,
+				                              edge->parent));
+			}
+			if (is_plugin) {
+				edge->plugin = changed = true;
+			}
 		}
 	}
+
+	LilvLoadQueue queue;
+	memset(&queue, '\0', sizeof(queue));
+	queue.world = world;
+
+	const bool use_queue = world->cache || world->opt.load_threads > 1;
+	for (size_t i = 0; i < scan.n_edges; ++i) {
+		LilvClassEdge* edge = &scan.edges[i];
+		if (edge->plugin && !edge->spec->loaded) {
+			lilv_world_load_spec(world, use_queue ? &queue : NULL, edge->spec);
+		}
+		sord_node_free(world->world, edge->parent);
+		sord_node_free(world->world, edge->child);
+	}
+	free(scan.edges);
+
+	load_queue_load(&queue);
+	lilv_world_model_changed(world);
 }
 
-void
-lilv_world_load_plugin_classes(LilvWorld* world)
+/** Add every class in the model with a parent and label to the classes. */
+static void
+lilv_world_add_plugin_classes(LilvWorld* world)
 {
 	/* FIXME: This loads all classes, not just lv2:Plugin subclasses.
 	   However, if the host gets all the classes via lilv_plugin_class_get_children
@@ -998,25 +2402,90 @@ lilv_world_load_plugin_classes(LilvWorld* world)
 		LilvPluginClass* pclass = lilv_plugin_class_new(
 			world, parent, class_node,
 			(const char*)sord_node_get_string(label));
-		if (pclass) {
-			zix_tree_insert((ZixTree*)world->plugin_classes, pclass, NULL);
+		if (pclass &&
+		    !zix_tree_insert((ZixTree*)world->plugin_classes, pclass, NULL)) {
+			lilv_header_index_add(world->class_index,
+			                      (struct LilvHeader*)pclass);
+		} else if (pclass) {
+			lilv_plugin_class_free(pclass);  // Already known
 		}
 
 		sord_node_free(world->world, label);
 		sord_node_free(world->world, parent);
 	}
 	sord_iter_free(classes);
+
+	lilv_world_index_plugin_classes(world);
+}
+
+void
+lilv_world_load_plugin_classes(LilvWorld* world)
+{
+	if (world->frozen) {
+		LILV_ERROR("World is frozen\n");
+		return;
+	}
+
+	// Load the specification of lv2:Plugin, then any that extend it
+	lilv_world_load_namespaces(world, NULL, NULL, world->uris.lv2_Plugin);
+	lilv_world_load_plugin_class_specs(world);
+	lilv_world_add_plugin_classes(world);
+
+	world->classes_version = world->bundles_version;
+	world->classes_loaded  = true;
+}
+
+void
+lilv_world_load_plugin_classes_if_necessary(LilvWorld* world)
+{
+	if (!world->frozen &&
+	    (!world->classes_loaded ||
+	     world->classes_version != world->bundles_version)) {
+		lilv_world_load_plugin_classes(world);
+	}
+}
+
+const char*
+lilv_world_get_lv2_path(const LilvWorld* world)
+{
+	const char* lv2_path = getenv("LV2_PATH");
+	return lv2_path ? lv2_path : LILV_DEFAULT_LV2_PATH;
 }
 
 LILV_API void
 lilv_world_load_all(LilvWorld* world)
 {
-	const char* lv2_path = getenv("LV2_PATH");
-	if (!lv2_path)
-		lv2_path = LILV_DEFAULT_LV2_PATH;
+	if (world->frozen) {
+		LILV_ERROR("World is frozen\n");
+		return;
+	}
+
+	const char* lv2_path = lilv_world_get_lv2_path(world);
+
+	if (world->opt.cache_path && !world->cache) {
+		world->cache = lilv_cache_new(world->opt.cache_path);
+	}
+
+	// Defer dynamic manifests until all manifests are loaded
+	LilvLoadQueue dyn_queue;
+	memset(&dyn_queue, '\0', sizeof(dyn_queue));
+	dyn_queue.world  = world;
+	world->dyn_queue = &dyn_queue;
 
 	// Discover bundles and read all manifest files into model
-	lilv_world_load_path(world, lv2_path);
+	if (world->cache || world->opt.load_threads > 1) {
+		LilvLoadQueue queue;
+		memset(&queue, '\0', sizeof(queue));
+		queue.world = world;
+		lilv_world_load_path(world, &queue, lv2_path);
+		load_queue_load(&queue);
+	} else {
+		lilv_world_load_path(world, NULL, lv2_path);
+	}
+
+	// Generate dynamic manifests, in parallel for different libraries
+	world->dyn_queue = NULL;
+	load_queue_load(&dyn_queue);
 
 	LILV_FOREACH(plugins, p, world->plugins) {
 		const LilvPlugin* plugin = (const LilvPlugin*)lilv_collection_get(
@@ -1033,9 +2502,141 @@ lilv_world_load_all(LilvWorld* world)
 		}
 	}
 
-	// Query out things to cache
-	lilv_world_load_specifications(world);
-	lilv_world_load_plugin_classes(world);
+	/* Only load the classes of lv2:Plugin's specification here.  Other
+	   specifications are only scanned for plugin classes on the first class
+	   lookup, and otherwise loaded lazily. */
+	lilv_world_load_namespaces(world, NULL, NULL, world->uris.lv2_Plugin);
+	lilv_world_add_plugin_classes(world);
+
+	if (world->cache) {
+		lilv_cache_save(world->cache);
+	}
+}
+
+/** An entry in the index of plugin bundles (world->bundle_index). */
+typedef struct {
+	LilvNode* plugin;  ///< Plugin URI
+	LilvNode* bundle;  ///< URI of the first bundle that describes plugin
+} LilvBundleIndexEntry;
+
+/** A manifest being scanned for plugins to add to the bundle index. */
+typedef struct {
+	LilvWorld*      world;
+	const LilvNode* bundle;
+} LilvBundleIndexer;
+
+static uint32_t
+bundle_index_hash(const void* value)
+{
+	const LilvBundleIndexEntry* entry = (const LilvBundleIndexEntry*)value;
+	const uint64_t              ptr   = (uintptr_t)entry->plugin->node;
+	return (uint32_t)((ptr * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+static bool
+bundle_index_equal(const void* a, const void* b)
+{
+	return (((const LilvBundleIndexEntry*)a)->plugin->node ==
+	        ((const LilvBundleIndexEntry*)b)->plugin->node);
+}
+
+static void
+bundle_index_entry_free(void* value, void* user_data)
+{
+	LilvBundleIndexEntry* entry = (LilvBundleIndexEntry*)value;
+	lilv_node_free(entry->plugin);
+	lilv_node_free(entry->bundle);
+}
+
+/** Add the subject of any `?plugin a lv2:Plugin` statement to the index. */
+static void
+bundle_index_statement(void* handle, const LilvStatement* t)
+{
+	LilvBundleIndexer* indexer = (LilvBundleIndexer*)handle;
+	LilvWorld*         world   = indexer->world;
+	if (t->s.type == SERD_URI &&
+	    !strcmp((const char*)t->p.buf, LILV_NS_RDF "type") &&
+	    !strcmp((const char*)t->o.buf, LV2_CORE__Plugin)) {
+		LilvBundleIndexEntry entry = {
+			lilv_new_uri(world, (const char*)t->s.buf),
+			lilv_node_duplicate(indexer->bundle)
+		};
+
+		// The first bundle in LV2_PATH wins, as in lilv_world_add_plugin()
+		if (zix_hash_insert(world->bundle_index, &entry, NULL)) {
+			bundle_index_entry_free(&entry, NULL);
+		}
+	}
+}
+
+/** Build the index of plugin bundles from the manifests in LV2_PATH. */
+static void
+lilv_world_index_bundles(LilvWorld* world)
+{
+	const char* lv2_path = lilv_world_get_lv2_path(world);
+
+	if (world->opt.cache_path && !world->cache) {
+		world->cache = lilv_cache_new(world->opt.cache_path);
+	}
+
+	world->bundle_index = zix_hash_new(
+		bundle_index_hash, bundle_index_equal, sizeof(LilvBundleIndexEntry));
+
+	LilvLoadQueue queue;
+	memset(&queue, '\0', sizeof(queue));
+	queue.world = world;
+	lilv_world_load_path(world, &queue, lv2_path);
+	load_queue_parse(&queue);
+
+	for (size_t i = 0; i < queue.n_jobs; ++i) {
+		LilvLoadJob*      job     = &queue.jobs[i];
+		LilvBundleIndexer indexer = { world, job->bundle };
+		if (job->cached) {
+			lilv_cache_read(
+				job->cached, job->prefix, bundle_index_statement, &indexer);
+		} else if (job->st > SERD_FAILURE) {
+			LILV_ERRORF("Error reading %s\n", lilv_node_as_string(job->uri));
+		} else {
+			for (size_t s = 0; s < job->n_statements; ++s) {
+				bundle_index_statement(&indexer, &job->statements[s]);
+			}
+			if (world->cache && job->path) {
+				lilv_cache_set(world->cache, job->path, "",
+				               job->statements, job->n_statements, job->prefix);
+			}
+		}
+		load_job_free(job);
+	}
+	free(queue.jobs);
+}
+
+LILV_API const LilvPlugin*
+lilv_world_load_plugin(LilvWorld* world, const LilvNode* uri)
+{
+	if (!lilv_node_is_uri(uri)) {
+		return NULL;
+	}
+
+	const LilvPlugin* plugin = lilv_plugins_get_by_uri(world->plugins, uri);
+	if (plugin) {
+		return plugin;
+	}
+
+	if (world->frozen) {
+		return NULL;
+	} else if (!world->bundle_index) {
+		lilv_world_index_bundles(world);
+	}
+
+	const LilvBundleIndexEntry  key   = { (LilvNode*)uri, NULL };
+	const LilvBundleIndexEntry* entry = (const LilvBundleIndexEntry*)
+		zix_hash_find(world->bundle_index, &key);
+	if (!entry) {
+		return NULL;
+	}
+
+	lilv_world_load_bundle(world, entry->bundle);
+	return lilv_plugins_get_by_uri(world->plugins, uri);
 }
 
 SerdStatus
@@ -1046,9 +2647,15 @@ lilv_world_load_file(LilvWorld* world, SerdReader* reader, const LilvNode* uri)
 		return SERD_FAILURE;  // File has already been loaded
 	}
 
+	const uint64_t begin   = lilv_trace_begin(world);
+	const size_t   n_quads = sord_num_quads(world->model);
+
 	serd_reader_add_blank_prefix(reader, lilv_world_blank_node_prefix(world));
+	lilv_world_model_changed(world);
 	const SerdStatus st = serd_reader_read_file(
 		reader, sord_node_get_string(uri->node));
+	lilv_trace_end(world, LILV_TRACE_LOAD_FILE, lilv_node_as_string(uri),
+	               begin, sord_num_quads(world->model) - n_quads);
 	if (st) {
 		LILV_ERRORF("Error loading file `%s'\n", lilv_node_as_string(uri));
 		return st;
@@ -1064,6 +2671,11 @@ LILV_API int
 lilv_world_load_resource(LilvWorld*      world,
                          const LilvNode* resource)
 {
+	if (world->frozen) {
+		LILV_ERROR("World is frozen\n");
+		return -1;
+	}
+
 	if (!lilv_node_is_uri(resource) && !lilv_node_is_blank(resource)) {
 		LILV_ERRORF("Node `%s' is not a resource\n",
 		            sord_node_get_string(resource->node));
@@ -1099,6 +2711,11 @@ LILV_API int
 lilv_world_unload_resource(LilvWorld*      world,
                            const LilvNode* resource)
 {
+	if (world->frozen) {
+		LILV_ERROR("World is frozen\n");
+		return -1;
+	}
+
 	if (!lilv_node_is_uri(resource) && !lilv_node_is_blank(resource)) {
 		LILV_ERRORF("Node `%s' is not a resource\n",
 		            sord_node_get_string(resource->node));
@@ -1131,6 +2748,98 @@ lilv_world_unload_resource(LilvWorld*      world,
 	return n_dropped;
 }
 
+/** Add every statement about `node`, and blank nodes it refers to, to `kept`. */
+static void
+lilv_world_keep_description(LilvWorld*      world,
+                            SordModel*      kept,
+                            const SordNode* node)
+{
+	SordIter* i = sord_search(world->model, node, NULL, NULL, NULL);
+	FOREACH_MATCH(i) {
+		SordQuad quad;
+		sord_iter_get(i, quad);
+		sord_add(kept, quad);
+
+		const SordNode* o = quad[SORD_OBJECT];
+		if (sord_node_get_type(o) == SORD_BLANK &&
+		    !sord_ask(kept, o, NULL, NULL, NULL)) {
+			lilv_world_keep_description(world, kept, o);
+		}
+	}
+	sord_iter_free(i);
+}
+
+static int
+node_ptr_cmp(const void* a, const void* b)
+{
+	const uintptr_t ia = (uintptr_t)*(const SordNode* const*)a;
+	const uintptr_t ib = (uintptr_t)*(const SordNode* const*)b;
+	return (ia > ib) - (ia < ib);
+}
+
+LILV_API int
+lilv_world_compact(LilvWorld* world, const LilvNode* const* predicates)
+{
+	if (world->frozen) {
+		LILV_ERROR("World is frozen\n");
+		return -1;
+	}
+
+	size_t n_predicates = 0;
+	while (predicates && predicates[n_predicates]) {
+		++n_predicates;
+	}
+
+	// Build a sorted array of every predicate to keep
+	const size_t     n_uris = sizeof(world->uris) / sizeof(SordNode*) - 1;
+	const SordNode** keep   = (const SordNode**)malloc(
+		(n_uris + n_predicates) * sizeof(const SordNode*));
+
+	size_t n = 0;
+	for (SordNode** u = (SordNode**)&world->uris; *u; ++u) {
+		keep[n++] = *u;
+	}
+	for (size_t i = 0; i < n_predicates; ++i) {
+		keep[n++] = predicates[i]->node;
+	}
+	qsort(keep, n, sizeof(const SordNode*), node_ptr_cmp);
+
+	/* Presets are read with arbitrary plugin property predicates, so keep
+	   their whole description, including the blank nodes of their state. */
+	SordModel* kept    = sord_new(world->world, SORD_SPO, true);
+	SordIter*  presets = sord_search(
+		world->model, NULL, world->uris.rdf_a, world->uris.pset_Preset, NULL);
+	FOREACH_MATCH(presets) {
+		lilv_world_keep_description(
+			world, kept, sord_iter_get_node(presets, SORD_SUBJECT));
+	}
+	sord_iter_free(presets);
+
+	// Erase every other statement
+	lilv_world_model_changed(world);
+	int       n_removed = 0;
+	SordIter* i         = sord_begin(world->model);
+	while (!sord_iter_end(i)) {
+		SordQuad quad;
+		sord_iter_get(i, quad);
+		const SordNode* p = quad[SORD_PREDICATE];
+		if (bsearch(&p, keep, n, sizeof(const SordNode*), node_ptr_cmp) ||
+		    sord_contains(kept, quad)) {
+			sord_iter_next(i);
+		} else if (sord_erase(world->model, i)) {
+			LILV_ERROR("Error removing statement during compaction\n");
+			break;
+		} else {
+			++n_removed;
+		}
+	}
+	sord_iter_free(i);
+
+	sord_free(kept);
+	free(keep);
+	return n_removed;
+}
+
 LILV_API const LilvPluginClass*
 lilv_world_get_plugin_class(const LilvWorld* world)
 {
@@ -1140,6 +2849,7 @@ lilv_world_get_plugin_class(const LilvWorld* world)
 LILV_API const LilvPluginClasses*
 lilv_world_get_plugin_classes(const LilvWorld* world)
 {
+	lilv_world_load_plugin_classes_if_necessary((LilvWorld*)world);
 	return world->plugin_classes;
 }
 
@@ -1153,14 +2863,17 @@ LILV_API LilvNode*
 lilv_world_get_symbol(LilvWorld* world, const LilvNode* subject)
 {
 	// Check for explicitly given symbol
+	lilv_world_lock(world);
 	SordNode* snode = sord_get(
 		world->model, subject->node, world->uris.lv2_symbol, NULL, NULL);
 
 	if (snode) {
 		LilvNode* ret = lilv_node_new_from_node(world, snode);
 		sord_node_free(world->world, snode);
+		lilv_world_unlock(world);
 		return ret;
 	}
+	lilv_world_unlock(world);
 
 	if (!lilv_node_is_uri(subject)) {
 		return NULL;
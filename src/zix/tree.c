@@ -32,6 +32,8 @@ struct ZixTreeImpl {
 	void*          cmp_data;
 	size_t         size;
 	bool           allow_duplicates;
+	ZixTreeNode*   block;       ///< Nodes allocated with the tree, or NULL
+	size_t         block_size;  ///< Number of nodes in block
 };
 
 struct ZixTreeNodeImpl {
@@ -79,9 +81,75 @@ zix_tree_new(bool           allow_duplicates,
 	t->cmp_data         = cmp_data;
 	t->size             = 0;
 	t->allow_duplicates = allow_duplicates;
+	t->block            = NULL;
+	t->block_size       = 0;
 	return t;
 }
 
+/** Build a balanced subtree from nodes[begin..end), return its root. */
+ZIX_PRIVATE ZixTreeNode*
+zix_tree_build(ZixTreeNode* nodes,
+               void* const* values,
+               size_t       begin,
+               size_t       end,
+               ZixTreeNode* parent,
+               int*         height)
+{
+	if (begin == end) {
+		*height = 0;
+		return NULL;
+	}
+
+	const size_t mid          = begin + (end - begin) / 2;
+	ZixTreeNode* n            = &nodes[mid];
+	int          left_height  = 0;
+	int          right_height = 0;
+
+	n->data    = values[mid];
+	n->parent  = parent;
+	n->left    = zix_tree_build(nodes, values, begin, mid, n, &left_height);
+	n->right   = zix_tree_build(nodes, values, mid + 1, end, n, &right_height);
+	n->balance = (int_fast8_t)(right_height - left_height);
+
+	*height = 1 + MAX(left_height, right_height);
+	return n;
+}
+
+ZIX_API ZixTree*
+zix_tree_new_sorted(bool           allow_duplicates,
+                    ZixComparator  cmp,
+                    void*          cmp_data,
+                    ZixDestroyFunc destroy,
+                    void* const*   values,
+                    size_t         n_values)
+{
+	ZixTree* t = (ZixTree*)malloc(sizeof(ZixTree) +
+	                              n_values * sizeof(ZixTreeNode));
+	int height = 0;
+	t->destroy          = destroy;
+	t->cmp              = cmp;
+	t->cmp_data         = cmp_data;
+	t->size             = n_values;
+	t->allow_duplicates = allow_duplicates;
+	t->block            = n_values ? (ZixTreeNode*)(t + 1) : NULL;
+	t->block_size       = n_values;
+	t->root             = zix_tree_build(
+		t->block, values, 0, n_values, NULL, &height);
+	return t;
+}
+
+/** Free a node, unless it is part of the block allocated with the tree. */
+ZIX_PRIVATE void
+zix_tree_free_node(ZixTree* t, ZixTreeNode* n)
+{
+	const uintptr_t addr  = (uintptr_t)n;
+	const uintptr_t begin = (uintptr_t)t->block;
+	const uintptr_t end   = (uintptr_t)(t->block + t->block_size);
+	if (addr < begin || addr >= end) {
+		free(n);
+	}
+}
+
 ZIX_PRIVATE void
 zix_tree_free_rec(ZixTree* t, ZixTreeNode* n)
 {
@@ -91,7 +159,7 @@ zix_tree_free_rec(ZixTree* t, ZixTreeNode* n)
 		if (t->destroy) {
 			t->destroy(n->data);
 		}
-		free(n);
+		zix_tree_free_node(t, n);
 	}
 }
 
@@ -450,7 +518,7 @@ zix_tree_remove(ZixTree* t, ZixTreeIter* ti)
 		if (t->destroy) {
 			t->destroy(n->data);
 		}
-		free(n);
+		zix_tree_free_node(t, n);
 		--t->size;
 		assert(t->size == 0);
 		return ZIX_STATUS_SUCCESS;
@@ -579,7 +647,7 @@ zix_tree_remove(ZixTree* t, ZixTreeIter* ti)
 	if (t->destroy) {
 		t->destroy(n->data);
 	}
-	free(n);
+	zix_tree_free_node(t, n);
 
 	--t->size;
 
@@ -51,6 +51,22 @@ zix_tree_new(bool           allow_duplicates,
              void*          cmp_data,
              ZixDestroyFunc destroy);
 
+/**
+   Create a new tree from an array of sorted values.
+
+   The values must be sorted by `cmp`, and unique unless `allow_duplicates`
+   is true.  The tree is built in linear time, and its nodes are allocated in
+   a single block with the tree, in order, so iterating over it reads memory
+   sequentially.  The tree may be modified afterwards like any other.
+*/
+ZIX_API ZixTree*
+zix_tree_new_sorted(bool           allow_duplicates,
+                    ZixComparator  cmp,
+                    void*          cmp_data,
+                    ZixDestroyFunc destroy,
+                    void* const*   values,
+                    size_t         n_values);
+
 /**
    Free `t`.
 */
@@ -0,0 +1,94 @@
+/*
+  Lilv Test Plugin - Crashing plugin
+  Copyright 2011-2016 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdlib.h>
+
+#include "lv2/lv2plug.in/ns/lv2core/lv2.h"
+
+#define PLUGIN_URI "http://example.org/crashing-plugin"
+
+enum {
+	TEST_IN  = 0,
+	TEST_OUT = 1
+};
+
+typedef struct {
+	const float* in;
+	float*       out;
+} Test;
+
+static void
+cleanup(LV2_Handle instance)
+{
+	free(instance);
+}
+
+static void
+connect_port(LV2_Handle instance, uint32_t port, void* data)
+{
+	Test* test = (Test*)instance;
+	switch (port) {
+	case TEST_IN:
+		test->in = (const float*)data;
+		break;
+	case TEST_OUT:
+		test->out = (float*)data;
+		break;
+	default:
+		break;
+	}
+}
+
+static LV2_Handle
+instantiate(const LV2_Descriptor*     descriptor,
+            double                    rate,
+            const char*               path,
+            const LV2_Feature* const* features)
+{
+	return (LV2_Handle)calloc(1, sizeof(Test));
+}
+
+/** Copy input to output, or crash if the first input sample is negative. */
+static void
+run(LV2_Handle instance, uint32_t sample_count)
+{
+	Test* test = (Test*)instance;
+	if (sample_count > 0 && test->in[0] < 0.0f) {
+		abort();
+	}
+
+	for (uint32_t i = 0; i < sample_count; ++i) {
+		test->out[i] = test->in[i];
+	}
+}
+
+static const LV2_Descriptor descriptor = {
+	PLUGIN_URI,
+	instantiate,
+	connect_port,
+	NULL, // activate,
+	run,
+	NULL, // deactivate,
+	cleanup,
+	NULL  // extension_data
+};
+
+LV2_SYMBOL_EXPORT
+const LV2_Descriptor* lv2_descriptor(uint32_t index)
+{
+	return (index == 0) ? &descriptor : NULL;
+}
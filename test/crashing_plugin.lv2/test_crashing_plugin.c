@@ -0,0 +1,76 @@
+#include "lilv/lilv.h"
+#include "../src/lilv_internal.h"
+
+#define PLUGIN_URI "http://example.org/crashing-plugin"
+
+#define TEST_ASSERT(check) do {\
+	if (!(check)) {\
+		fprintf(stderr, "%s:%d: failed test: %s\n", __FILE__, __LINE__, #check);\
+		return 1;\
+	}\
+} while (0)
+
+int
+main(int argc, char** argv)
+{
+	if (argc != 2) {
+		fprintf(stderr, "USAGE: %s BUNDLE\n", argv[0]);
+		return 1;
+	}
+
+	const char* bundle_path = argv[1];
+	LilvWorld*  world       = lilv_world_new();
+
+	// Load test plugin bundle
+	uint8_t*  abs_bundle = (uint8_t*)lilv_path_absolute(bundle_path);
+	SerdNode  bundle     = serd_node_new_file_uri(abs_bundle, 0, 0, true);
+	LilvNode* bundle_uri = lilv_new_uri(world, (const char*)bundle.buf);
+	lilv_world_load_bundle(world, bundle_uri);
+	free(abs_bundle);
+	serd_node_free(&bundle);
+	lilv_node_free(bundle_uri);
+
+	LilvNode*          plugin_uri = lilv_new_uri(world, PLUGIN_URI);
+	const LilvPlugins* plugins    = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plugin     = lilv_plugins_get_by_uri(plugins, plugin_uri);
+	TEST_ASSERT(plugin);
+
+	LilvInstance* instance = lilv_plugin_instantiate_isolated(
+		plugin, 48000, NULL, 4);
+	if (!instance) {
+		// Isolation is not supported on this system
+		lilv_node_free(plugin_uri);
+		lilv_world_free(world);
+		return 0;
+	}
+
+	float in[4]  = { 1.0f, 2.0f, 3.0f, 4.0f };
+	float out[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	lilv_instance_connect_port(instance, 0, in);
+	lilv_instance_connect_port(instance, 1, out);
+	lilv_instance_activate(instance);
+
+	// Runs normally until the plugin crashes
+	lilv_instance_run(instance, 4);
+	TEST_ASSERT(!lilv_instance_has_crashed(instance));
+	TEST_ASSERT(out[0] == 1.0f && out[3] == 4.0f);
+
+	// Crashing silences the output, and the instance stays crashed
+	in[0] = -1.0f;
+	lilv_instance_run(instance, 4);
+	TEST_ASSERT(lilv_instance_has_crashed(instance));
+	TEST_ASSERT(out[0] == 0.0f && out[3] == 0.0f);
+
+	in[0] = 1.0f;
+	out[0] = out[3] = 1.0f;
+	lilv_instance_run(instance, 4);
+	TEST_ASSERT(lilv_instance_has_crashed(instance));
+	TEST_ASSERT(out[0] == 0.0f && out[3] == 0.0f);
+
+	lilv_instance_deactivate(instance);
+	lilv_instance_free(instance);
+	lilv_node_free(plugin_uri);
+	lilv_world_free(world);
+
+	return 0;
+}
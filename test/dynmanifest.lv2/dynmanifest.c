@@ -0,0 +1,69 @@
+/*
+  Lilv Test Plugin - Dynamic manifest
+  Copyright 2011-2016 David Robillard <d@drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lv2/lv2plug.in/ns/ext/dynmanifest/dynmanifest.h"
+#include "lv2/lv2plug.in/ns/lv2core/lv2.h"
+
+#define PLUGIN_URI "http://example.org/dyn-plugin"
+
+#define PREFIXES \
+	"@prefix doap: <http://usefulinc.com/ns/doap#> .\n" \
+	"@prefix lv2: <http://lv2plug.in/ns/lv2core#> .\n"
+
+LV2_SYMBOL_EXPORT int
+lv2_dyn_manifest_open(LV2_Dyn_Manifest_Handle*  handle,
+                      const LV2_Feature* const* features)
+{
+	*handle = NULL;
+	return 0;
+}
+
+LV2_SYMBOL_EXPORT int
+lv2_dyn_manifest_get_subjects(LV2_Dyn_Manifest_Handle handle, FILE* fp)
+{
+	fprintf(fp, PREFIXES "<" PLUGIN_URI "> a lv2:Plugin .\n");
+	return 0;
+}
+
+LV2_SYMBOL_EXPORT int
+lv2_dyn_manifest_get_data(LV2_Dyn_Manifest_Handle handle,
+                          FILE*                   fp,
+                          const char*             uri)
+{
+	if (strcmp(uri, PLUGIN_URI)) {
+		return 1;
+	}
+
+	fprintf(fp, PREFIXES
+	        "<" PLUGIN_URI "> a lv2:Plugin ;\n"
+	        "	doap:name \"Dynamic plugin\" ;\n"
+	        "	doap:license <http://opensource.org/licenses/isc> ;\n"
+	        "	lv2:port [\n"
+	        "		a lv2:InputPort , lv2:ControlPort ;\n"
+	        "		lv2:index 0 ;\n"
+	        "		lv2:symbol \"input\" ;\n"
+	        "		lv2:name \"Input\"\n"
+	        "	] .\n");
+	return 0;
+}
+
+LV2_SYMBOL_EXPORT void
+lv2_dyn_manifest_close(LV2_Dyn_Manifest_Handle handle)
+{}
@@ -0,0 +1,154 @@
+/*
+  Copyright 2007-2016 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   Build and run basic usage of the C++ API, against the test plugin.
+*/
+
+#include "lilv/lilv.hpp"
+
+#include "lv2/lv2plug.in/ns/ext/urid/urid.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+static int test_count  = 0;
+static int error_count = 0;
+
+#define TEST_ASSERT(check) do {\
+	++test_count;\
+	if (!(check)) {\
+		++error_count;\
+		fprintf(stderr, "lilv_cxx_test.cpp:%d: error: %s\n", __LINE__, #check);\
+	}\
+} while (0)
+
+static std::vector<std::string> uris;
+
+static LV2_URID
+map_uri(LV2_URID_Map_Handle, const char* uri)
+{
+	for (size_t i = 0; i < uris.size(); ++i) {
+		if (uris[i] == uri) {
+			return static_cast<LV2_URID>(i + 1);
+		}
+	}
+
+	uris.emplace_back(uri);
+	return static_cast<LV2_URID>(uris.size());
+}
+
+int
+main()
+{
+	lilv::World world;
+	TEST_ASSERT(world.c_obj());
+
+	lilv::Node bundle_uri = world.new_file_uri(nullptr, LILV_TEST_BUNDLE);
+	TEST_ASSERT(bundle_uri.is_uri());
+	world.load_bundle(bundle_uri);
+
+	// Nodes
+	lilv::Node plugin_uri = world.new_uri("http://example.org/lilv-test-plugin");
+	lilv::Node copy       = lilv::Node::duplicate(plugin_uri);
+	TEST_ASSERT(copy == plugin_uri);
+	TEST_ASSERT(copy.as_uri() == "http://example.org/lilv-test-plugin");
+
+	lilv::Node moved = std::move(copy);
+	TEST_ASSERT(!copy);
+	TEST_ASSERT(moved == plugin_uri);
+
+	lilv::Node num = world.new_int(42);
+	TEST_ASSERT(num.is_int() && num.as_int() == 42);
+
+	// Plugins
+	const lilv::Plugins plugins = world.all_plugins();
+	TEST_ASSERT(!plugins.empty());
+
+	unsigned n_plugins = 0;
+	for (const lilv::Plugin p : plugins) {
+		TEST_ASSERT(p.uri().is_uri());
+		++n_plugins;
+	}
+	TEST_ASSERT(n_plugins == plugins.size());
+
+	const lilv::Plugin plugin = plugins.get_by_uri(plugin_uri);
+	TEST_ASSERT(plugin);
+	if (!plugin) {
+		return 1;
+	}
+
+	TEST_ASSERT(plugin.verify());
+	TEST_ASSERT(plugin.uri() == plugin_uri);
+	TEST_ASSERT(plugin.name().as_string() == "Lilv Test");
+	TEST_ASSERT(!plugin.data_uris().empty());
+	TEST_ASSERT(plugin.required_features().size() == 1);
+
+	// Ports
+	TEST_ASSERT(plugin.num_ports() == 3);
+
+	uint32_t index = 0;
+	for (const lilv::Port port : plugin.ports()) {
+		TEST_ASSERT(port.index() == index++);
+	}
+	TEST_ASSERT(index == 3);
+
+	lilv::Node       control_sym = world.new_string("control");
+	const lilv::Port control     = plugin.port_by_symbol(control_sym);
+	TEST_ASSERT(control && control.index() == 2);
+	TEST_ASSERT(control.symbol().as_string() == "control");
+	TEST_ASSERT(control.name().as_string() == "Control");
+	TEST_ASSERT(!control.range().def);
+	TEST_ASSERT(plugin.ports()[1].symbol() == world.new_string("output"));
+
+	// Instance
+	LV2_URID_Map       map         = { nullptr, map_uri };
+	LV2_Feature        map_feature = { LV2_URID_MAP_URI, &map };
+	const LV2_Feature* features[]  = { &map_feature, nullptr };
+
+	lilv::Instance instance = plugin.instantiate(48000.0, features);
+	TEST_ASSERT(instance);
+	if (instance) {
+		float in  = 1.0f;
+		float out = 0.0f;
+		instance.connect_port(0, &in);
+		instance.connect_port(1, &out);
+		instance.activate();
+		instance.run(1);
+		TEST_ASSERT(out == 1.0f);
+		instance.deactivate();
+
+		TEST_ASSERT(instance.descriptor());
+		TEST_ASSERT(!strcmp(instance.descriptor()->URI,
+		                    "http://example.org/lilv-test-plugin"));
+	}
+
+	// An instance can change hands without being freed twice
+	lilv::Instance other(instance.release());
+	TEST_ASSERT(!instance);
+	TEST_ASSERT(other);
+
+	if (error_count > 0) {
+		fprintf(stderr, "*** %d/%d C++ tests failed\n", error_count, test_count);
+		return 1;
+	}
+
+	printf("*** All %d C++ tests passed\n", test_count);
+	return 0;
+}
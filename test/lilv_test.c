@@ -325,6 +325,11 @@ test_value(void)
 	LilvNode* uval_dup = lilv_node_duplicate(uval);
 	TEST_ASSERT(lilv_node_equals(uval, uval_dup));
 
+	// Equal nodes are shared
+	TEST_ASSERT(uval_e == uval);
+	TEST_ASSERT(uval_dup == uval);
+	TEST_ASSERT(sval_e == sval);
+
 	LilvNode* ifval = lilv_new_float(world, 42.0);
 	TEST_ASSERT(!lilv_node_equals(ival, ifval));
 	lilv_node_free(ifval);
@@ -338,6 +343,7 @@ test_value(void)
 	TEST_ASSERT(lilv_node_equals(nil, nil2));
 
 	lilv_node_free(uval);
+	TEST_ASSERT(!strcmp(lilv_node_as_uri(uval_e), "http://example.org"));
 	lilv_node_free(sval);
 	lilv_node_free(ival);
 	lilv_node_free(fval);
@@ -453,6 +459,261 @@ test_discovery(void)
 
 /*****************************************************************************/
 
+static int
+test_parallel_load(void)
+{
+	create_bundle(MANIFEST_PREFIXES
+	              ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	              BUNDLE_PREFIXES
+	              ":plug a lv2:Plugin ;"
+	              PLUGIN_NAME("Test plugin") " ; "
+	              LICENSE_GPL " ; "
+	              "lv2:port [ a lv2:ControlPort ; a lv2:InputPort ;"
+	              " lv2:index 0 ; lv2:symbol \"foo\" ; lv2:name \"bar\" ; ] .");
+
+	// Load serially to get the expected plugin count
+	if (!load_all_bundles()) {
+		return 0;
+	}
+	const unsigned n_serial = lilv_plugins_size(
+		lilv_world_get_all_plugins(world));
+	lilv_world_free(world);
+
+	if (!init_world()) {
+		return 0;
+	}
+
+	LilvNode* threads = lilv_new_int(world, 4);
+	lilv_world_set_option(world, LILV_OPTION_LOAD_THREADS, threads);
+	lilv_node_free(threads);
+	lilv_world_load_all(world);
+
+	init_uris();
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	TEST_ASSERT(lilv_plugins_size(plugins) == n_serial);
+
+	const LilvPlugin* plug = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+	TEST_ASSERT(plug);
+	if (plug) {
+		LilvNode* name = lilv_plugin_get_name(plug);
+		TEST_ASSERT(!strcmp(lilv_node_as_string(name), "Test plugin"));
+		TEST_ASSERT(lilv_plugin_get_num_ports(plug) == 1);
+		lilv_node_free(name);
+	}
+
+	cleanup_uris();
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_load_plugin(void)
+{
+	create_bundle(MANIFEST_PREFIXES
+	              ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	              BUNDLE_PREFIXES
+	              ":plug a lv2:Plugin ;"
+	              PLUGIN_NAME("Test plugin") " ; "
+	              LICENSE_GPL " ; "
+	              "lv2:port [ a lv2:ControlPort ; a lv2:InputPort ;"
+	              " lv2:index 0 ; lv2:symbol \"foo\" ; lv2:name \"bar\" ; ] .");
+
+	if (!init_world()) {
+		return 0;
+	}
+
+	init_uris();
+
+	// Nothing is loaded until a plugin is requested
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	TEST_ASSERT(lilv_plugins_size(plugins) == 0);
+
+	const LilvPlugin* plug = lilv_world_load_plugin(world, plugin_uri_value);
+	TEST_ASSERT(plug);
+	TEST_ASSERT(lilv_plugins_size(plugins) == 1);
+	TEST_ASSERT(lilv_plugins_get_by_uri(plugins, plugin_uri_value) == plug);
+	TEST_ASSERT(lilv_plugin_get_num_ports(plug) == 1);
+
+	LilvNode* name = lilv_plugin_get_name(plug);
+	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "Test plugin"));
+	lilv_node_free(name);
+
+	// Loading again returns the same plugin
+	TEST_ASSERT(lilv_world_load_plugin(world, plugin_uri_value) == plug);
+
+	LilvNode* missing = lilv_new_uri(world, "http://example.org/missing");
+	TEST_ASSERT(!lilv_world_load_plugin(world, missing));
+	lilv_node_free(missing);
+
+	cleanup_uris();
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_freeze(void)
+{
+	if (!start_bundle(MANIFEST_PREFIXES
+	                  ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	                  BUNDLE_PREFIXES
+	                  ":plug a lv2:Plugin ;"
+	                  PLUGIN_NAME("Test plugin") " ; "
+	                  LICENSE_GPL " ; "
+	                  "lv2:port [ a lv2:ControlPort ; a lv2:InputPort ;"
+	                  " lv2:index 0 ; lv2:symbol \"foo\" ; lv2:name \"bar\" ; ] ."))
+		return 0;
+
+	init_uris();
+
+	lilv_world_freeze(world);
+
+	// Queries still work
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plug    = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+	TEST_ASSERT(plug);
+	TEST_ASSERT(lilv_plugin_get_num_ports(plug) == 1);
+
+	LilvNode* name = lilv_plugin_get_name(plug);
+	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "Test plugin"));
+	lilv_node_free(name);
+
+	LilvNode* sym = lilv_new_string(world, "foo");
+	TEST_ASSERT(lilv_plugin_get_port_by_symbol(plug, sym));
+	lilv_node_free(sym);
+
+	// Preloading a missing library fails, in the background or not
+	TEST_ASSERT(lilv_plugin_preload(plug, NULL));
+	lilv_world_preload_libraries(world, NULL);
+	TEST_ASSERT(!lilv_plugin_instantiate(plug, 48000.0, NULL));
+
+	// Loading and unloading is refused
+	LilvNode* bundle = lilv_new_uri(world, bundle_dir_uri);
+	TEST_ASSERT(lilv_world_unload_bundle(world, bundle) == -1);
+	lilv_world_load_bundle(world, bundle);
+	TEST_ASSERT(lilv_plugins_size(plugins) == 1);
+	TEST_ASSERT(lilv_plugins_get_by_uri(plugins, plugin_uri_value) == plug);
+	lilv_node_free(bundle);
+
+	cleanup_uris();
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_cache(void)
+{
+	create_bundle(MANIFEST_PREFIXES
+	              ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	              BUNDLE_PREFIXES
+	              ":plug a lv2:Plugin ;"
+	              PLUGIN_NAME("Test plugin") " ; "
+	              LICENSE_GPL " ; "
+	              "lv2:port [ a lv2:ControlPort ; a lv2:InputPort ;"
+	              " lv2:index 0 ; lv2:symbol \"foo\" ; lv2:name \"bar\" ; ] .");
+
+	char* cache_path = lilv_strjoin(LILV_TEST_DIR, "discovery.cache", NULL);
+	unlink(cache_path);
+
+	// Load twice, so the second load uses the cache written by the first
+	for (unsigned i = 0; i < 2; ++i) {
+		if (!init_world()) {
+			return 0;
+		}
+
+		LilvNode* path = lilv_new_string(world, cache_path);
+		lilv_world_set_option(world, LILV_OPTION_CACHE, path);
+		lilv_node_free(path);
+		lilv_world_load_all(world);
+
+		init_uris();
+
+		const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+		const LilvPlugin*  plug    = lilv_plugins_get_by_uri(
+			plugins, plugin_uri_value);
+		TEST_ASSERT(plug);
+		if (plug) {
+			LilvNode* name = lilv_plugin_get_name(plug);
+			TEST_ASSERT(!strcmp(lilv_node_as_string(name), "Test plugin"));
+			TEST_ASSERT(lilv_plugin_get_num_ports(plug) == 1);
+			lilv_node_free(name);
+		}
+
+		cleanup_uris();
+		lilv_world_free(world);
+		world = NULL;
+
+		TEST_ASSERT(lilv_path_exists(cache_path, NULL));
+	}
+
+	unlink(cache_path);
+	free(cache_path);
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_dyn_manifest(void)
+{
+#ifdef LILV_DYN_MANIFEST
+	char* manifest = lilv_strjoin(
+		MANIFEST_PREFIXES
+		"@prefix dman: <http://lv2plug.in/ns/ext/dynmanifest#> .\n"
+		":dman a dman:DynManifest ; lv2:binary <file://",
+		LILV_TEST_DIR, "dynmanifest.lv2/dynmanifest" SHLIB_EXT "> .\n",
+		NULL);
+	create_bundle(manifest, BUNDLE_PREFIXES);
+	free(manifest);
+
+	char* cache_path = lilv_strjoin(LILV_TEST_DIR, "dynmanifest.cache", NULL);
+	unlink(cache_path);
+
+	// Load without the cache, then twice with it so the last load uses it
+	for (unsigned i = 0; i < 3; ++i) {
+		if (!init_world()) {
+			return 0;
+		}
+
+		if (i > 0) {
+			LilvNode* path = lilv_new_string(world, cache_path);
+			lilv_world_set_option(world, LILV_OPTION_CACHE, path);
+			lilv_node_free(path);
+		}
+		lilv_world_load_all(world);
+
+		LilvNode* plugin_uri = lilv_new_uri(world,
+		                                    "http://example.org/dyn-plugin");
+		const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+		const LilvPlugin*  plug    = lilv_plugins_get_by_uri(
+			plugins, plugin_uri);
+		TEST_ASSERT(plug);
+		if (plug) {
+			LilvNode* name = lilv_plugin_get_name(plug);
+			TEST_ASSERT(name &&
+			            !strcmp(lilv_node_as_string(name), "Dynamic plugin"));
+			TEST_ASSERT(lilv_plugin_get_num_ports(plug) == 1);
+			lilv_node_free(name);
+		}
+
+		lilv_node_free(plugin_uri);
+		lilv_world_free(world);
+		world = NULL;
+
+		TEST_ASSERT(i == 0 || lilv_path_exists(cache_path, NULL));
+	}
+
+	unlink(cache_path);
+	free(cache_path);
+#endif
+	return 1;
+}
+
+/*****************************************************************************/
+
 static int
 test_lv2_path(void)
 {
@@ -560,11 +821,30 @@ test_classes(void)
 	                    "http://lv2plug.in/ns/lv2core#Plugin"));
 
 	LILV_FOREACH(plugin_classes, i, children) {
+		const LilvPluginClass* child = lilv_plugin_classes_get(children, i);
 		TEST_ASSERT(lilv_node_equals(
-				lilv_plugin_class_get_parent_uri(lilv_plugin_classes_get(children, i)),
+				lilv_plugin_class_get_parent_uri(child),
 				lilv_plugin_class_get_uri(plugin)));
+		TEST_ASSERT(lilv_plugin_class_get_depth(child) == 1);
+		TEST_ASSERT(lilv_plugin_class_is_subclass_of(child, plugin));
+		TEST_ASSERT(!lilv_plugin_class_is_subclass_of(plugin, child));
 	}
 
+	// Ancestry of the plugin's class
+	const LilvPlugin* plug = lilv_plugins_get_by_uri(
+		lilv_world_get_all_plugins(world), plugin_uri_value);
+	const LilvPluginClass* compressor = lilv_plugin_get_class(plug);
+	LilvNode* dynamics_uri = lilv_new_uri(world, LILV_NS_LV2 "DynamicsPlugin");
+	const LilvPluginClass* dynamics = lilv_plugin_classes_get_by_uri(
+		classes, dynamics_uri);
+	TEST_ASSERT(dynamics);
+	TEST_ASSERT(lilv_plugin_class_get_depth(compressor) == 2);
+	TEST_ASSERT(lilv_plugin_class_is_subclass_of(compressor, compressor));
+	TEST_ASSERT(lilv_plugin_class_is_subclass_of(compressor, dynamics));
+	TEST_ASSERT(lilv_plugin_class_is_subclass_of(compressor, plugin));
+	TEST_ASSERT(!lilv_plugin_class_is_subclass_of(dynamics, compressor));
+	lilv_node_free(dynamics_uri);
+
 	LilvNode* some_uri = lilv_new_uri(world, "http://example.org/whatever");
 	TEST_ASSERT(lilv_plugin_classes_get_by_uri(classes, some_uri) == NULL);
 	lilv_node_free(some_uri);
@@ -697,6 +977,8 @@ test_plugin(void)
 			"http://lv2plug.in/ns/lv2core#latency");
 	const LilvPort* latency_port = lilv_plugin_get_port_by_designation(
 		plug, out_class, lv2_latency);
+	TEST_ASSERT(!lilv_plugin_get_port_by_designation(plug, in_class, lv2_latency));
+	TEST_ASSERT(!lilv_plugin_get_port_by_designation(plug, NULL, control_class));
 	lilv_node_free(lv2_latency);
 
 	TEST_ASSERT(latency_port);
@@ -991,7 +1273,10 @@ test_preset(void)
 			"] . \n"
 			"<http://example.org/preset> a pset:Preset ;"
 			"  lv2:appliesTo :plug ;"
-	                  "  rdfs:label \"some preset\" .\n"))
+	                  "  rdfs:label \"some preset\" .\n"
+			"<http://example.org/preset2> a pset:Preset ;"
+			"  lv2:appliesTo :plug ;"
+			"  pset:bank <http://example.org/bank> .\n"))
 		return 0;
 
 	init_uris();
@@ -1002,7 +1287,20 @@ test_preset(void)
 	LilvNode*  pset_Preset = lilv_new_uri(world, LV2_PRESETS__Preset);
 	LilvNodes* related     = lilv_plugin_get_related(plug, pset_Preset);
 
-	TEST_ASSERT(lilv_nodes_size(related) == 1);
+	TEST_ASSERT(lilv_nodes_size(related) == 2);
+
+	unsigned        n_presets = 0;
+	LilvPresetInfo* presets   = lilv_plugin_get_presets(plug, &n_presets);
+	TEST_ASSERT(n_presets == 2);
+	TEST_ASSERT(!strcmp(lilv_node_as_uri(presets[0].uri),
+	                    "http://example.org/preset"));
+	TEST_ASSERT(lilv_node_equals(presets[0].plugin, plugin_uri_value));
+	TEST_ASSERT(!strcmp(lilv_node_as_string(presets[0].label), "some preset"));
+	TEST_ASSERT(!presets[0].bank);
+	TEST_ASSERT(!presets[1].label);
+	TEST_ASSERT(!strcmp(lilv_node_as_uri(presets[1].bank),
+	                    "http://example.org/bank"));
+	lilv_preset_infos_free(presets, n_presets);
 
 	lilv_node_free(pset_Preset);
 	lilv_nodes_free(related);
@@ -1061,6 +1359,18 @@ test_prototype(void)
 
 /*****************************************************************************/
 
+/** Set LANG and use it as the world language, as if it was set at startup. */
+static void
+set_lang(const char* env_lang)
+{
+	setenv("LANG", env_lang, 1);
+	char*     tag  = lilv_get_lang();
+	LilvNode* lang = lilv_new_string(world, tag ? tag : "");
+	lilv_world_set_option(world, LILV_OPTION_LANG, lang);
+	lilv_node_free(lang);
+	free(tag);
+}
+
 static int
 test_port(void)
 {
@@ -1149,43 +1459,43 @@ test_port(void)
 	lilv_node_free(name);
 
 	// Exact language match
-	setenv("LANG", "fr_FR", 1);
+	set_lang("fr_FR");
 	name = lilv_port_get_name(plug, p);
 	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "épicerie"));
 	lilv_node_free(name);
 
 	// Exact language match (with charset suffix)
-	setenv("LANG", "fr_CA.utf8", 1);
+	set_lang("fr_CA.utf8");
 	name = lilv_port_get_name(plug, p);
 	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "dépanneur"));
 	lilv_node_free(name);
 
 	// Partial language match (choose value translated for different country)
-	setenv("LANG", "fr_BE", 1);
+	set_lang("fr_BE");
 	name = lilv_port_get_name(plug, p);
 	TEST_ASSERT((!strcmp(lilv_node_as_string(name), "dépanneur"))
 	            ||(!strcmp(lilv_node_as_string(name), "épicerie")));
 	lilv_node_free(name);
 
 	// Partial language match (choose country-less language tagged value)
-	setenv("LANG", "es_MX", 1);
+	set_lang("es_MX");
 	name = lilv_port_get_name(plug, p);
 	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "tienda"));
 	lilv_node_free(name);
 
 	// No language match (choose untranslated value)
-	setenv("LANG", "cn", 1);
+	set_lang("cn");
 	name = lilv_port_get_name(plug, p);
 	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "store"));
 	lilv_node_free(name);
 
 	// Invalid language
-	setenv("LANG", "1!", 1);
+	set_lang("1!");
 	name = lilv_port_get_name(plug, p);
 	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "store"));
 	lilv_node_free(name);
 
-	setenv("LANG", "en_CA.utf-8", 1);
+	set_lang("en_CA.utf-8");
 
 	// Language tagged value with no untranslated values
 	LilvNode*  rdfs_comment = lilv_new_uri(world, LILV_NS_RDFS "comment");
@@ -1197,14 +1507,14 @@ test_port(void)
 	lilv_node_free(comment);
 	lilv_nodes_free(comments);
 
-	setenv("LANG", "fr", 1);
+	set_lang("fr");
 
 	comments = lilv_port_get_value(plug, p, rdfs_comment);
 	TEST_ASSERT(!strcmp(lilv_node_as_string(lilv_nodes_get_first(comments)),
 	                    "commentaires"));
 	lilv_nodes_free(comments);
 
-	setenv("LANG", "cn", 1);
+	set_lang("cn");
 
 	comments = lilv_port_get_value(plug, p, rdfs_comment);
 	TEST_ASSERT(!comments);
@@ -1212,7 +1522,15 @@ test_port(void)
 
 	lilv_node_free(rdfs_comment);
 
-	setenv("LANG", "C", 1);  // Reset locale
+	// Language set directly
+	LilvNode* lang = lilv_new_string(world, "fr-ca");
+	lilv_world_set_option(world, LILV_OPTION_LANG, lang);
+	name = lilv_port_get_name(plug, p);
+	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "dépanneur"));
+	lilv_node_free(name);
+	lilv_node_free(lang);
+
+	set_lang("C");  // Reset locale
 
 	LilvScalePoints* points = lilv_port_get_scale_points(plug, p);
 	TEST_ASSERT(lilv_scale_points_size(points) == 2);
@@ -1237,6 +1555,21 @@ test_port(void)
 		 (!strcmp(lilv_node_as_string(lilv_scale_point_get_label(sp1)), "Sin")
 		  && lilv_node_as_float(lilv_scale_point_get_value(sp1)) == 3)));
 
+	// Compact scale points are sorted by value
+	uint32_t                  n_infos = 0;
+	const LilvScalePointInfo* infos   = lilv_port_get_scale_point_infos(
+		plug, p, &n_infos);
+	TEST_ASSERT(n_infos == 2);
+	TEST_ASSERT(infos[0].value == 3.0f && !strcmp(infos[0].label, "Sin"));
+	TEST_ASSERT(infos[1].value == 4.0f && !strcmp(infos[1].label, "Cos"));
+	TEST_ASSERT(!strcmp(lilv_port_get_scale_point_label(plug, p, 4.0f), "Cos"));
+	TEST_ASSERT(!strcmp(lilv_port_get_scale_point_label(plug, p, 3.0f), "Sin"));
+	TEST_ASSERT(!lilv_port_get_scale_point_label(plug, p, 3.5f));
+	TEST_ASSERT(!lilv_port_get_scale_point_label(plug, p, 5.0f));
+	TEST_ASSERT(!lilv_port_get_scale_point_infos(
+		            plug, lilv_plugin_get_port_by_index(plug, 2), &n_infos));
+	TEST_ASSERT(n_infos == 0);
+
 	LilvNode* homepage_p = lilv_new_uri(world, "http://usefulinc.com/ns/doap#homepage");
 	LilvNodes* homepages = lilv_plugin_get_value(plug, homepage_p);
 	TEST_ASSERT(lilv_nodes_size(homepages) == 1);
@@ -1258,6 +1591,36 @@ test_port(void)
 	TEST_ASSERT(lilv_port_has_property(plug, p, integer_prop));
 	TEST_ASSERT(!lilv_port_has_property(plug, p, toggled_prop));
 
+	const LilvPortTable* table = lilv_plugin_get_port_table(plug);
+	TEST_ASSERT(table);
+	TEST_ASSERT(table->n_ports == 4);
+	TEST_ASSERT(table->types[0] == (LILV_PORT_CONTROL | LILV_PORT_INPUT));
+	TEST_ASSERT(table->types[2] == (LILV_PORT_AUDIO | LILV_PORT_INPUT));
+	TEST_ASSERT(table->types[3] == (LILV_PORT_AUDIO | LILV_PORT_OUTPUT));
+	TEST_ASSERT(table->properties[0] == LILV_PORT_INTEGER);
+	TEST_ASSERT(table->properties[2] == 0);
+	TEST_ASSERT(table->min_values[0] == -1.0f);
+	TEST_ASSERT(table->max_values[0] == 1.0f);
+	TEST_ASSERT(table->def_values[0] == 0.5f);
+	TEST_ASSERT(isnan(table->def_values[3]));
+
+	float           mins[4];
+	const LilvNode* symbols[4];
+	const LilvNode* designations[4];
+	uint32_t        n_scale_points[4];
+	bool            reports_latency[4];
+	LilvPortMetadata metadata = { mins, NULL, NULL, symbols, designations,
+	                              NULL, n_scale_points, reports_latency };
+	lilv_plugin_get_port_metadata(plug, &metadata);
+	TEST_ASSERT(mins[0] == -1.0f);
+	TEST_ASSERT(isnan(mins[3]));
+	TEST_ASSERT(!strcmp(lilv_node_as_string(symbols[0]), "foo"));
+	TEST_ASSERT(!strcmp(lilv_node_as_string(symbols[3]), "audio_out"));
+	TEST_ASSERT(!designations[0]);
+	TEST_ASSERT(n_scale_points[0] == 2);
+	TEST_ASSERT(n_scale_points[2] == 0);
+	TEST_ASSERT(!reports_latency[0]);
+
 	const LilvPort* ep = lilv_plugin_get_port_by_index(plug, 1);
 
 	LilvNode* event_type = lilv_new_uri(world, "http://example.org/event");
@@ -1506,6 +1869,31 @@ set_port_value(const char*     port_symbol,
 	}
 }
 
+static void
+set_port_index_value(uint32_t    port_index,
+                     void*       user_data,
+                     const void* value,
+                     uint32_t    size,
+                     uint32_t    type)
+{
+	switch (port_index) {
+	case 0: in      = *(const float*)value; break;
+	case 1: out     = *(const float*)value; break;
+	case 2: control = *(const float*)value; break;
+	default:
+		fprintf(stderr, "error: set_port_index_value for nonexistent port %u\n",
+		        port_index);
+	}
+}
+
+static void
+count_saved(const LilvState* state, int status, void* user_data)
+{
+	if (!status) {
+		++*(unsigned*)user_data;
+	}
+}
+
 char** uris   = NULL;
 size_t n_uris = 0;
 
@@ -1685,6 +2073,21 @@ test_state(void)
 	TEST_ASSERT(lilv_state_equals(state, state5));  // Round trip accuracy
 	TEST_ASSERT(lilv_state_get_num_properties(state) == 8);
 
+	// Save state to a binary file and load it again
+	ret = lilv_state_save_binary(world, &unmap, state, "http://example.org/bin",
+	                             "state/state.lv2", "state.bin");
+	TEST_ASSERT(!ret);
+	LilvState* bstate = lilv_state_new_from_binary(
+		world, &map, "state/state.lv2/state.bin");
+	TEST_ASSERT(lilv_state_equals(state, bstate));  // Round trip accuracy
+	TEST_ASSERT(!strcmp(lilv_node_as_string(lilv_state_get_uri(bstate)),
+	                    "http://example.org/bin"));
+	lilv_state_free(bstate);
+
+	// Attempt to load Turtle as binary (error)
+	TEST_ASSERT(!lilv_state_new_from_binary(world, &map,
+	                                        "state/state.lv2/state.ttl"));
+
 	// Attempt to save state to nowhere (error)
 	ret = lilv_state_save(world, &map, &unmap, state, NULL, NULL, NULL);
 	TEST_ASSERT(ret);
@@ -1694,6 +2097,48 @@ test_state(void)
 	                      "state/state.lv2", "state2.ttl");
 	TEST_ASSERT(!ret);
 
+	// Copy states to a URID map that is safe to use from the saving threads
+	LilvURIDMap*    ts_urids = lilv_urid_map_new();
+	LV2_URID_Map*   ts_map   = lilv_urid_map_get_map(ts_urids);
+	LV2_URID_Unmap* ts_unmap = lilv_urid_map_get_unmap(ts_urids);
+	LilvState*      ts_states[3];
+	const LilvState* const orig_states[3] = { state3, state4, state };
+	for (unsigned i = 0; i < 3; ++i) {
+		char* str = lilv_state_to_string(world, &map, &unmap, orig_states[i],
+		                                 "http://example.org/batch", NULL);
+		ts_states[i] = lilv_state_new_from_string(world, ts_map, str);
+		TEST_ASSERT(ts_states[i]);
+		free(str);
+	}
+
+	// Save several states at once, including one that fails
+	const LilvStateSaveRequest requests[] = {
+		{ ts_states[0], NULL, "state/batch.lv2", "state3.ttl" },
+		{ ts_states[1], "http://example.org/state4", "state/batch.lv2", "state4.ttl" },
+		{ ts_states[2], NULL, "state/batch2.lv2", "state.ttl" },
+		{ ts_states[2], NULL, "state/batch2.lv2", NULL } };
+	unsigned n_saved = 0;
+	TEST_ASSERT(lilv_state_save_batch(world, ts_map, ts_unmap, requests, 4, 2,
+	                                  count_saved, &n_saved) == 1);
+	TEST_ASSERT(n_saved == 3);
+	for (unsigned i = 0; i < 3; ++i) {
+		lilv_state_free(ts_states[i]);
+	}
+	lilv_urid_map_free(ts_urids);
+
+	LilvState* bstate3 = lilv_state_new_from_file(
+		world, &map, NULL, "state/batch.lv2/state3.ttl");
+	TEST_ASSERT(lilv_state_equals(state3, bstate3));
+	lilv_state_free(bstate3);
+
+	// Both states in the same bundle should be in its manifest
+	LilvNode* batch_subject = lilv_new_uri(world, "http://example.org/state4");
+	LilvState* bstate4 = lilv_state_new_from_file(
+		world, &map, batch_subject, "state/batch.lv2/manifest.ttl");
+	TEST_ASSERT(bstate4);
+	lilv_state_free(bstate4);
+	lilv_node_free(batch_subject);
+
 	// Save state with URI to a directory
 	const char* state_uri = "http://example.org/state";
 	ret = lilv_state_save(world, &map, &unmap, state, state_uri,
@@ -1785,6 +2230,23 @@ test_state(void)
 	// Should be different
 	TEST_ASSERT(!lilv_state_equals(fstate, fstate3));
 
+	// Delta between identical states is empty
+	LilvState* delta = lilv_state_new_delta(fstate, fstate2);
+	TEST_ASSERT(lilv_state_get_num_properties(delta) == 0);
+	lilv_state_free(delta);
+
+	// Delta between different states only has the changes
+	delta = lilv_state_new_delta(fstate, fstate3);
+	TEST_ASSERT(lilv_state_get_num_properties(delta) > 0);
+	TEST_ASSERT(lilv_state_get_num_properties(delta) <
+	            lilv_state_get_num_properties(fstate3));
+
+	// Merging the delta with the original gives the changed state
+	LilvState* merged = lilv_state_new_merged(fstate, delta);
+	TEST_ASSERT(lilv_state_equals(merged, fstate3));
+	lilv_state_free(merged);
+	lilv_state_free(delta);
+
 	// Save state to a directory
 	ret = lilv_state_save(world, &map, &unmap, fstate, NULL,
 	                      "state/fstate.lv2", "fstate.ttl");
@@ -1795,9 +2257,28 @@ test_state(void)
 	                                              "state/fstate.lv2/fstate.ttl");
 	TEST_ASSERT(lilv_state_equals(fstate, fstate4));  // Round trip accuracy
 
+	// Save and load as binary, paths should match those loaded from Turtle
+	ret = lilv_state_save_binary(world, &unmap, fstate, NULL,
+	                             "state/fstate.lv2", "fstate.bin");
+	TEST_ASSERT(!ret);
+	LilvState* fbstate = lilv_state_new_from_binary(
+		world, &map, "state/fstate.lv2/fstate.bin");
+	TEST_ASSERT(lilv_state_equals(fstate4, fbstate));
+	lilv_state_free(fbstate);
+
 	// Restore instance state to loaded state
 	lilv_state_restore(fstate4, instance, set_port_value, NULL, 0, ffeatures);
 
+	// Restore the same state prepared for real-time use
+	LilvPreparedState* prepared = lilv_state_prepare(
+		fstate4, plugin, instance, ffeatures);
+	TEST_ASSERT(prepared);
+	const float restored_in = in;
+	in = restored_in + 1.0f;
+	lilv_prepared_state_apply(prepared, instance, set_port_index_value, NULL, 0);
+	TEST_ASSERT(in == restored_in);
+	lilv_prepared_state_free(prepared);
+
 	// Take a new snapshot and ensure it matches
 	LilvState* fstate5 = lilv_state_new_from_instance(
 		plugin, instance, &map,
@@ -1836,6 +2317,43 @@ test_state(void)
 	TEST_ASSERT(lilv_state_equals(fstate72, fstate7));
 	TEST_ASSERT(!lilv_state_equals(fstate6, fstate72));
 
+	// Take snapshots with the copy index enabled
+	LilvNode* true_val = lilv_new_bool(world, true);
+	lilv_world_set_option(world, LILV_OPTION_STATE_COPY_INDEX, true_val);
+	LilvState* fstate8 = lilv_state_new_from_instance(
+		plugin, instance, &map,
+		file_dir, copy_dir, link_dir, "state/fstate8.lv2",
+		get_port_value, world, 0, ffeatures);
+	TEST_ASSERT(lilv_state_equals(fstate7, fstate8));
+
+	char* index_path = lilv_path_join(copy_dir, ".lilv-copies");
+	TEST_ASSERT(lilv_path_exists(index_path, NULL));
+	free(index_path);
+
+	// Unchanged file reuses the indexed copy
+	LilvState* fstate9 = lilv_state_new_from_instance(
+		plugin, instance, &map,
+		file_dir, copy_dir, link_dir, "state/fstate9.lv2",
+		get_port_value, world, 0, ffeatures);
+	TEST_ASSERT(lilv_state_equals(fstate8, fstate9));
+
+	// Changed file gets a new copy
+	lilv_instance_run(instance, 4);
+	LilvState* fstate10 = lilv_state_new_from_instance(
+		plugin, instance, &map,
+		file_dir, copy_dir, link_dir, "state/fstate10.lv2",
+		get_port_value, world, 0, ffeatures);
+	TEST_ASSERT(!lilv_state_equals(fstate9, fstate10));
+
+	LilvNode* false_val = lilv_new_bool(world, false);
+	lilv_world_set_option(world, LILV_OPTION_STATE_COPY_INDEX, false_val);
+	lilv_node_free(false_val);
+	lilv_node_free(true_val);
+
+	lilv_state_free(fstate10);
+	lilv_state_free(fstate9);
+	lilv_state_free(fstate8);
+
 	// Delete saved state
 	lilv_state_delete(world, fstate7);
 
@@ -1865,6 +2383,7 @@ test_state(void)
 		free(uris[i]);
 	}
 	free(uris);
+	uris   = NULL;
 	n_uris = 0;
 
 	lilv_node_free(plugin_uri);
@@ -1879,6 +2398,194 @@ test_state(void)
 
 /*****************************************************************************/
 
+static long
+file_size(const char* path)
+{
+	struct stat st;
+	return stat(path, &st) ? -1 : (long)st.st_size;
+}
+
+static int
+test_state_copy_index(void)
+{
+	char* dir      = lilv_path_absolute("state/copy_index");
+	char* copy_dir = lilv_path_join(dir, "copies");
+	char* a_path   = lilv_path_join(dir, "a.txt");
+	char* b_path   = lilv_path_join(dir, "b.txt");
+	char* a_copy   = lilv_path_join(copy_dir, "a.txt");
+	char* b_copy   = lilv_path_join(copy_dir, "b.txt");
+	lilv_mkdir_p(copy_dir);
+	write_file(a_path, "Same contents\n");
+	write_file(b_path, "Same contents\n");
+
+	// Two files with the same contents share one copy
+	LilvCopyIndex* index = lilv_copy_index_new(copy_dir);
+	char*          ca    = lilv_copy_index_get_copy(index, a_path, a_copy);
+	char*          cb    = lilv_copy_index_get_copy(index, b_path, b_copy);
+	TEST_ASSERT(ca && cb && !strcmp(ca, cb));
+	TEST_ASSERT(lilv_file_equals(ca, a_path));
+	TEST_ASSERT(!lilv_path_exists(b_copy, NULL));
+	lilv_copy_index_free(index);
+
+	char*      index_path = lilv_path_join(copy_dir, ".lilv-copies");
+	const long index_size = file_size(index_path);
+	TEST_ASSERT(index_size > 0);
+
+	// Copying the same files again updates their records in place
+	index = lilv_copy_index_new(copy_dir);
+	char* ca2 = lilv_copy_index_get_copy(index, a_path, a_copy);
+	char* cb2 = lilv_copy_index_get_copy(index, b_path, b_copy);
+	TEST_ASSERT(!strcmp(ca2, ca) && !strcmp(cb2, ca));
+	lilv_copy_index_free(index);
+	TEST_ASSERT(file_size(index_path) == index_size);
+	free(cb2);
+	free(ca2);
+
+	// A modified file gets a new copy, and the other keeps the shared one
+	write_file(a_path, "Different contents\n");
+	index = lilv_copy_index_new(copy_dir);
+	ca2 = lilv_copy_index_get_copy(index, a_path, a_copy);
+	cb2 = lilv_copy_index_get_copy(index, b_path, b_copy);
+	TEST_ASSERT(ca2 && strcmp(ca2, ca));
+	TEST_ASSERT(lilv_file_equals(ca2, a_path));
+	TEST_ASSERT(!strcmp(cb2, ca));
+	TEST_ASSERT(lilv_file_equals(cb2, b_path));
+	lilv_copy_index_free(index);
+	TEST_ASSERT(file_size(index_path) > 0);
+
+	free(cb2);
+	free(ca2);
+	free(cb);
+	free(ca);
+	free(index_path);
+	free(b_copy);
+	free(a_copy);
+	free(b_path);
+	free(a_path);
+	free(copy_dir);
+	free(dir);
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_instance_group(void)
+{
+	init_world();
+
+	uint8_t*   abs_bundle = (uint8_t*)lilv_path_absolute(LILV_TEST_BUNDLE);
+	SerdNode   bundle     = serd_node_new_file_uri(abs_bundle, 0, 0, true);
+	LilvNode*  bundle_uri = lilv_new_uri(world, (const char*)bundle.buf);
+	LilvNode*  plugin_uri = lilv_new_uri(world,
+	                                     "http://example.org/lilv-test-plugin");
+	lilv_world_load_bundle(world, bundle_uri);
+	free(abs_bundle);
+	serd_node_free(&bundle);
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plugin  = lilv_plugins_get_by_uri(plugins, plugin_uri);
+	TEST_ASSERT(plugin);
+
+	LV2_URID_Map       map         = { NULL, map_uri };
+	LV2_Feature        map_feature = { LV2_URID_MAP_URI, &map };
+	const LV2_Feature* features[]  = { &map_feature, NULL };
+
+	// Preload the library, so every instance shares it
+	TEST_ASSERT(!lilv_plugin_preload(plugin, features));
+	TEST_ASSERT(!lilv_plugin_preload(plugin, features));
+
+	LilvInstanceGroup* group = lilv_instance_group_new();
+	LilvInstance*      instances[3];
+	float              ins[3]  = { 1.0f, 2.0f, 3.0f };
+	float              outs[3] = { 0.0f, 0.0f, 0.0f };
+	void*              in_locs[3];
+	void*              out_locs[3];
+	for (unsigned i = 0; i < 3; ++i) {
+		instances[i] = lilv_plugin_instantiate(plugin, 48000.0, features);
+		TEST_ASSERT(instances[i]);
+		TEST_ASSERT(!lilv_instance_group_add(group, instances[i]));
+		in_locs[i]  = &ins[i];
+		out_locs[i] = &outs[i];
+	}
+
+	TEST_ASSERT(lilv_instance_group_add(group, instances[0]));
+	TEST_ASSERT(lilv_instance_group_size(group) == 3);
+
+	lilv_instance_group_connect_port(group, 0, in_locs);
+	lilv_instance_group_connect_port(group, 1, out_locs);
+	lilv_instance_group_activate(group);
+	lilv_instance_group_run(group, 1);
+	for (unsigned i = 0; i < 3; ++i) {
+		TEST_ASSERT(outs[i] == ins[i]);
+	}
+
+	// Removing renumbers the later instances
+	TEST_ASSERT(!lilv_instance_group_remove(group, instances[0]));
+	TEST_ASSERT(lilv_instance_group_remove(group, instances[0]));
+	TEST_ASSERT(lilv_instance_group_size(group) == 2);
+
+	ins[1] = 5.0f;
+	ins[2] = 6.0f;
+	lilv_instance_group_connect_port(group, 0, in_locs + 1);
+	lilv_instance_group_connect_port(group, 1, out_locs + 1);
+	lilv_instance_group_run(group, 1);
+	TEST_ASSERT(outs[0] == 1.0f);
+	TEST_ASSERT(outs[1] == 5.0f);
+	TEST_ASSERT(outs[2] == 6.0f);
+
+	lilv_instance_group_deactivate(group);
+	lilv_instance_group_free(group);
+
+	// Run the same instances as a chain in a graph
+	LilvGraph* graph = lilv_graph_new(2, true);
+	for (unsigned i = 0; i < 3; ++i) {
+		TEST_ASSERT(lilv_graph_add(graph, plugin, instances[i]) == (int32_t)i);
+	}
+
+	float buf[2] = { 0.0f, 0.0f };
+	TEST_ASSERT(!lilv_graph_connect(graph, 1, 1, 2, 0, &buf[1]));
+	TEST_ASSERT(!lilv_graph_connect(graph, 0, 1, 1, 0, &buf[0]));
+	TEST_ASSERT(lilv_graph_connect(graph, 2, 1, 0, 0, &buf[0]));
+	TEST_ASSERT(lilv_graph_connect(graph, 0, 1, 7, 0, &buf[0]));
+	lilv_instance_connect_port(instances[0], 0, &ins[0]);
+	lilv_instance_connect_port(instances[2], 1, &outs[0]);
+
+	for (unsigned i = 0; i < 3; ++i) {
+		lilv_instance_activate(instances[i]);
+	}
+	for (unsigned i = 0; i < 4; ++i) {
+		ins[0] = (float)i;
+		lilv_graph_run(graph, 1);
+		TEST_ASSERT(outs[0] == (float)i);
+	}
+
+	// The test plugin has no latency port, so every node reports zero
+	float latencies[3] = { -1.0f, -1.0f, -1.0f };
+	lilv_graph_get_latencies(graph, latencies);
+	for (unsigned i = 0; i < 3; ++i) {
+		TEST_ASSERT(latencies[i] == 0.0f);
+	}
+
+	lilv_graph_free(graph);
+	for (unsigned i = 0; i < 3; ++i) {
+		lilv_instance_free(instances[i]);
+	}
+
+	for (size_t i = 0; i < n_uris; ++i) {
+		free(uris[i]);
+	}
+	free(uris);
+	uris   = NULL;
+	n_uris = 0;
+
+	lilv_node_free(plugin_uri);
+	lilv_node_free(bundle_uri);
+	return 1;
+}
+
+/*****************************************************************************/
+
 static int
 test_bad_port_symbol(void)
 {
@@ -1982,6 +2689,41 @@ test_string(void)
 
 /*****************************************************************************/
 
+static int
+test_urid_map(void)
+{
+	LilvURIDMap*    urids = lilv_urid_map_new();
+	LV2_URID_Map*   map   = lilv_urid_map_get_map(urids);
+	LV2_URID_Unmap* unmap = lilv_urid_map_get_unmap(urids);
+
+	TEST_ASSERT(!unmap->unmap(unmap->handle, 0));
+	TEST_ASSERT(!unmap->unmap(unmap->handle, 1));
+
+	// Map enough URIs to grow the table several times
+	char uri[32];
+	for (unsigned i = 0; i < 1000; ++i) {
+		snprintf(uri, sizeof(uri), "http://example.org/%u", i);
+		TEST_ASSERT(map->map(map->handle, uri) == i + 1);
+	}
+
+	const char* first = unmap->unmap(unmap->handle, 1);
+	TEST_ASSERT(!strcmp(first, "http://example.org/0"));
+	TEST_ASSERT(!unmap->unmap(unmap->handle, 1001));
+	for (unsigned i = 0; i < 1000; ++i) {
+		snprintf(uri, sizeof(uri), "http://example.org/%u", i);
+		TEST_ASSERT(map->map(map->handle, uri) == i + 1);
+		TEST_ASSERT(!strcmp(unmap->unmap(unmap->handle, i + 1), uri));
+	}
+
+	// Unmapped strings are stable
+	TEST_ASSERT(unmap->unmap(unmap->handle, 1) == first);
+
+	lilv_urid_map_free(urids);
+	return 1;
+}
+
+/*****************************************************************************/
+
 static int
 test_world(void)
 {
@@ -2055,6 +2797,7 @@ test_reload_bundle(void)
 
 	// Check that plugin is no longer in the world's plugin list
 	TEST_ASSERT(lilv_plugins_size(plugins) == 0);
+	TEST_ASSERT(!lilv_plugins_get_by_uri(plugins, plugin_uri_value));
 
 	// Load new bundle
 	lilv_world_load_bundle(world, bundle_uri);
@@ -2083,6 +2826,1630 @@ test_reload_bundle(void)
 
 /*****************************************************************************/
 
+static int
+test_query_cache(void)
+{
+	create_bundle(MANIFEST_PREFIXES
+	              ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	              BUNDLE_PREFIXES
+	              ":plug a lv2:Plugin ; "
+	              PLUGIN_NAME("First name") " .");
+
+	if (!init_world()) {
+		return 0;
+	}
+
+	init_uris();
+	LilvNode* enable = lilv_new_bool(world, true);
+	lilv_world_set_option(world, LILV_OPTION_QUERY_CACHE, enable);
+	lilv_node_free(enable);
+
+	LilvNode* bundle_uri = lilv_new_uri(world, bundle_dir_uri);
+	LilvNode* doap_name  = lilv_new_uri(world, "http://usefulinc.com/ns/doap#name");
+	LilvNode* first      = lilv_new_string(world, "First name");
+	lilv_world_load_bundle(world, bundle_uri);
+
+	// Load plugin data
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plug    = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+	TEST_ASSERT(plug);
+	LilvNode* name = lilv_plugin_get_name(plug);
+	lilv_node_free(name);
+
+	// Repeated queries have the same results
+	for (unsigned i = 0; i < 2; ++i) {
+		LilvNodes* names = lilv_world_find_nodes(
+			world, plugin_uri_value, doap_name, NULL);
+		TEST_ASSERT(lilv_nodes_size(names) == 1);
+		TEST_ASSERT(lilv_nodes_contains(names, first));
+		lilv_nodes_free(names);
+
+		name = lilv_world_get(world, plugin_uri_value, doap_name, NULL);
+		TEST_ASSERT(lilv_node_equals(name, first));
+		lilv_node_free(name);
+
+		TEST_ASSERT(lilv_world_ask(world, plugin_uri_value, doap_name, first));
+		TEST_ASSERT(!lilv_world_find_nodes(world, doap_name, doap_name, NULL));
+	}
+
+	// Reload bundle with a different name
+	lilv_world_unload_bundle(world, bundle_uri);
+	delete_bundle();
+	create_bundle(MANIFEST_PREFIXES
+	              ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	              BUNDLE_PREFIXES
+	              ":plug a lv2:Plugin ; "
+	              PLUGIN_NAME("Second name") " .");
+
+	TEST_ASSERT(!lilv_world_ask(world, plugin_uri_value, doap_name, first));
+	TEST_ASSERT(!lilv_world_get(world, plugin_uri_value, doap_name, NULL));
+
+	lilv_world_load_bundle(world, bundle_uri);
+	name = lilv_plugin_get_name(plug);
+	lilv_node_free(name);
+
+	// Results reflect the new data
+	LilvNode* second = lilv_new_string(world, "Second name");
+	LilvNodes* names = lilv_world_find_nodes(
+		world, plugin_uri_value, doap_name, NULL);
+	TEST_ASSERT(lilv_nodes_size(names) == 1);
+	TEST_ASSERT(lilv_nodes_contains(names, second));
+	lilv_nodes_free(names);
+
+	name = lilv_world_get(world, plugin_uri_value, doap_name, NULL);
+	TEST_ASSERT(lilv_node_equals(name, second));
+	lilv_node_free(name);
+	TEST_ASSERT(!lilv_world_ask(world, plugin_uri_value, doap_name, first));
+
+	// Disabling the cache still gives the same results
+	LilvNode* disable = lilv_new_bool(world, false);
+	lilv_world_set_option(world, LILV_OPTION_QUERY_CACHE, disable);
+	lilv_node_free(disable);
+	TEST_ASSERT(lilv_world_ask(world, plugin_uri_value, doap_name, second));
+
+	lilv_node_free(second);
+	lilv_node_free(first);
+	lilv_node_free(doap_name);
+	lilv_node_free(bundle_uri);
+	cleanup_uris();
+	lilv_world_free(world);
+	world = NULL;
+
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_selective_load(void)
+{
+	create_bundle(MANIFEST_PREFIXES
+	              ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	              BUNDLE_PREFIXES
+	              ":plug a lv2:Plugin ; "
+	              PLUGIN_NAME("Test plugin") " ; "
+	              LICENSE_GPL " ; "
+	              "lv2:port [ a lv2:ControlPort ; a lv2:InputPort ;"
+	              " lv2:index 0 ; lv2:symbol \"foo\" ; lv2:name \"bar\" ;"
+	              " lv2:default 0.5 ;"
+	              " lv2:scalePoint [ rdfs:label \"Sin\"; rdf:value 3 ] ;"
+	              " lv2:scalePoint [ rdfs:label \"Cos\"; rdf:value 4 ] ] .\n"
+	              ":preset a pset:Preset ; lv2:appliesTo :plug .");
+
+	if (!init_world()) {
+		return 0;
+	}
+
+	init_uris();
+	LilvNode* enable = lilv_new_bool(world, true);
+	lilv_world_set_option(world, LILV_OPTION_SELECTIVE_LOAD, enable);
+	lilv_world_set_option(world, LILV_OPTION_QUERY_CACHE, enable);
+	lilv_node_free(enable);
+
+	LilvNode* bundle_uri = lilv_new_uri(world, bundle_dir_uri);
+	LilvNode* preset     = lilv_new_uri(world, "http://example.org/preset");
+	LilvNode* rdf_type   = lilv_new_uri(world, LILV_NS_RDF "type");
+	LilvNode* lv2_name   = lilv_new_uri(world, LV2_CORE__name);
+	LilvNode* pset       = lilv_new_uri(world, LV2_PRESETS__Preset);
+	LilvNode* sym        = lilv_new_string(world, "foo");
+	lilv_world_load_bundle(world, bundle_uri);
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plug    = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+	TEST_ASSERT(plug);
+
+	// Description and ports come from the summary
+	LilvNode* name = lilv_plugin_get_name(plug);
+	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "Test plugin"));
+	lilv_node_free(name);
+	TEST_ASSERT(lilv_plugin_get_num_ports(plug) == 1);
+
+	const LilvPort* port = lilv_plugin_get_port_by_symbol(plug, sym);
+	TEST_ASSERT(port);
+	name = lilv_port_get_name(plug, port);
+	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "bar"));
+	lilv_node_free(name);
+
+	LilvNode* def = NULL;
+	lilv_port_get_range(plug, port, &def, NULL, NULL);
+	TEST_ASSERT(lilv_node_as_float(def) == 0.5f);
+	lilv_node_free(def);
+
+	// Other statements in the data file are not loaded yet
+	TEST_ASSERT(!lilv_world_ask(world, preset, rdf_type, pset));
+
+	// A full query loads the rest
+	LilvScalePoints* points = lilv_port_get_scale_points(plug, port);
+	TEST_ASSERT(lilv_scale_points_size(points) == 2);
+	lilv_scale_points_free(points);
+	TEST_ASSERT(lilv_world_ask(world, preset, rdf_type, pset));
+
+	// Ports are the same, and refer to the full description
+	TEST_ASSERT(lilv_plugin_get_num_ports(plug) == 1);
+	TEST_ASSERT(lilv_plugin_get_port_by_symbol(plug, sym) == port);
+	LilvNodes* names = lilv_port_get_value(plug, port, lv2_name);
+	TEST_ASSERT(lilv_nodes_size(names) == 1);
+	lilv_nodes_free(names);
+
+	lilv_node_free(sym);
+	lilv_node_free(pset);
+	lilv_node_free(lv2_name);
+	lilv_node_free(rdf_type);
+	lilv_node_free(preset);
+	lilv_node_free(bundle_uri);
+	cleanup_uris();
+	lilv_world_free(world);
+	world = NULL;
+
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_selective_load_shared(void)
+{
+	create_bundle(MANIFEST_PREFIXES
+	              ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n"
+	              ":plug2 a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	              BUNDLE_PREFIXES
+	              ":plug a lv2:Plugin ; "
+	              PLUGIN_NAME("Test plugin") " ; "
+	              LICENSE_GPL " ; "
+	              "lv2:optionalFeature lv2:hardRTCapable .\n"
+	              ":plug2 a lv2:Plugin ; "
+	              PLUGIN_NAME("Second plugin") " ; "
+	              LICENSE_GPL " ; "
+	              "lv2:optionalFeature lv2:hardRTCapable .\n");
+
+	if (!init_world()) {
+		return 0;
+	}
+
+	init_uris();
+	LilvNode* enable = lilv_new_bool(world, true);
+	lilv_world_set_option(world, LILV_OPTION_SELECTIVE_LOAD, enable);
+	lilv_node_free(enable);
+
+	LilvNode* bundle_uri = lilv_new_uri(world, bundle_dir_uri);
+	LilvNode* plug2_uri  = lilv_new_uri(world, "http://example.org/plug2");
+	LilvNode* optional   = lilv_new_uri(world, LV2_CORE__optionalFeature);
+	lilv_world_load_bundle(world, bundle_uri);
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plug    = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+	const LilvPlugin*  plug2   = lilv_plugins_get_by_uri(plugins, plug2_uri);
+	TEST_ASSERT(plug && plug2);
+
+	// Summarize the second plugin, then fully load the first
+	LilvNode* name = lilv_plugin_get_name(plug2);
+	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "Second plugin"));
+	lilv_node_free(name);
+
+	LilvNodes* features = lilv_plugin_get_value(plug, optional);
+	TEST_ASSERT(lilv_nodes_size(features) == 1);
+	lilv_nodes_free(features);
+
+	// The summary of the second plugin is replaced, not duplicated
+	features = lilv_world_find_nodes(world, plug2_uri, optional, NULL);
+	TEST_ASSERT(lilv_nodes_size(features) == 1);
+	lilv_nodes_free(features);
+
+	lilv_node_free(optional);
+	lilv_node_free(plug2_uri);
+	lilv_node_free(bundle_uri);
+	cleanup_uris();
+	lilv_world_free(world);
+	world = NULL;
+
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_compact(void)
+{
+	create_bundle(MANIFEST_PREFIXES
+	              ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	              BUNDLE_PREFIXES
+	              ":plug a lv2:Plugin ; "
+	              PLUGIN_NAME("Test plugin") " ; "
+	              LICENSE_GPL " ; "
+	              "rdfs:comment \"A plugin for testing\" ; "
+	              "doap:release [ doap:revision \"1.0\" ] ; "
+	              "lv2:port [ a lv2:ControlPort ; a lv2:InputPort ;"
+	              " lv2:index 0 ; lv2:symbol \"foo\" ; lv2:name \"bar\" ] .\n"
+	              ":preset a pset:Preset ; lv2:appliesTo :plug ; "
+	              "lv2:port [ lv2:symbol \"control\" ; pset:value "
+	              "\"0.25\"^^<http://www.w3.org/2001/XMLSchema#float> ] ; "
+	              "<http://lv2plug.in/ns/ext/state#state> [ :prop 7 ] .");
+
+	LV2_URID_Map map = { NULL, map_uri };
+	for (unsigned documentation = 0; documentation < 2; ++documentation) {
+		if (!init_world()) {
+			return 0;
+		}
+
+		init_uris();
+		LilvNode* load_docs = lilv_new_bool(world, documentation);
+		lilv_world_set_option(world, LILV_OPTION_DOCUMENTATION, load_docs);
+		lilv_node_free(load_docs);
+
+		LilvNode* bundle_uri   = lilv_new_uri(world, bundle_dir_uri);
+		LilvNode* rdfs_comment = lilv_new_uri(world, LILV_NS_RDFS "comment");
+		LilvNode* doap_license = lilv_new_uri(world, LILV_NS_DOAP "license");
+		LilvNode* doap_release = lilv_new_uri(world, LILV_NS_DOAP "release");
+		lilv_world_load_bundle(world, bundle_uri);
+
+		const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+		const LilvPlugin*  plug    = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+		TEST_ASSERT(plug);
+		TEST_ASSERT(lilv_plugin_get_num_ports(plug) == 1);
+
+		// Documentation is only loaded if enabled
+		TEST_ASSERT(lilv_world_ask(world, plugin_uri_value, rdfs_comment, NULL) ==
+		            (bool)documentation);
+		TEST_ASSERT(lilv_world_ask(world, plugin_uri_value, doap_release, NULL) ==
+		            (bool)documentation);
+		TEST_ASSERT(lilv_world_ask(world, plugin_uri_value, doap_license, NULL));
+
+		// Compaction keeps only the given and internal predicates
+		const LilvNode* keep[] = { rdfs_comment, NULL };
+		TEST_ASSERT(lilv_world_compact(world, keep) > 0);
+		TEST_ASSERT(!lilv_world_ask(world, plugin_uri_value, doap_license, NULL));
+		TEST_ASSERT(!lilv_world_ask(world, plugin_uri_value, doap_release, NULL));
+		TEST_ASSERT(lilv_world_ask(world, plugin_uri_value, rdfs_comment, NULL) ==
+		            (bool)documentation);
+
+		lilv_world_compact(world, NULL);
+		TEST_ASSERT(!lilv_world_ask(world, plugin_uri_value, rdfs_comment, NULL));
+		TEST_ASSERT(lilv_world_compact(world, NULL) == 0);
+
+		// Plugin description is intact
+		LilvNode* name = lilv_plugin_get_name(plug);
+		TEST_ASSERT(!strcmp(lilv_node_as_string(name), "Test plugin"));
+		lilv_node_free(name);
+		TEST_ASSERT(lilv_plugin_verify(plug));
+		TEST_ASSERT(lilv_plugin_get_num_ports(plug) == 1);
+
+		// Presets keep their port values and properties
+		LilvNode*  preset_uri = lilv_new_uri(world, "http://example.org/preset");
+		LilvState* preset     = lilv_state_new_from_world(world, &map, preset_uri);
+		TEST_ASSERT(preset);
+		TEST_ASSERT(lilv_state_get_num_properties(preset) == 1);
+		const float old_control = control;
+		lilv_state_emit_port_values(preset, set_port_value, NULL);
+		TEST_ASSERT(control == 0.25f);
+		control = old_control;
+		lilv_state_free(preset);
+		lilv_node_free(preset_uri);
+
+		lilv_node_free(doap_release);
+		lilv_node_free(doap_license);
+		lilv_node_free(rdfs_comment);
+		lilv_node_free(bundle_uri);
+		cleanup_uris();
+		lilv_world_free(world);
+		world = NULL;
+	}
+
+	for (size_t i = 0; i < n_uris; ++i) {
+		free(uris[i]);
+	}
+	free(uris);
+	uris   = NULL;
+	n_uris = 0;
+
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_search(void)
+{
+	if (!start_bundle(MANIFEST_PREFIXES
+	                  ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	                  BUNDLE_PREFIXES PREFIX_LV2UI
+	                  ":plug a lv2:Plugin , lv2:CompressorPlugin ; "
+	                  PLUGIN_NAME("Test Compressor") " ; "
+	                  LICENSE_GPL " ; "
+	                  "lv2:requiredFeature <http://example.org/feature> ; "
+	                  "lv2ui:ui :ui ; "
+	                  "doap:maintainer [ foaf:name \"David Robillard\" ] ; "
+	                  "lv2:port [ a lv2:AudioPort ; a lv2:InputPort ;"
+	                  " lv2:index 0 ; lv2:symbol \"in\" ; lv2:name \"In\" ] , "
+	                  "[ a lv2:AudioPort ; a lv2:OutputPort ;"
+	                  " lv2:index 1 ; lv2:symbol \"out\" ; lv2:name \"Out\" ] .\n"
+	                  ":ui a lv2ui:GtkUI ; lv2ui:binary <ui" SHLIB_EXT "> .\n"))
+		return 0;
+
+	init_uris();
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plug    = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+	TEST_ASSERT(plug);
+
+	LilvSearchIndex* index = lilv_search_index_new(world);
+	TEST_ASSERT(index);
+
+	const LilvPlugin* found[4] = { NULL, NULL, NULL, NULL };
+	LilvSearchQuery   query    = LILV_SEARCH_QUERY_INIT;
+	const unsigned    n_all    = lilv_plugins_size(plugins);
+	TEST_ASSERT(lilv_search_index_find(index, &query, found, 0) == n_all);
+
+	// Every facet matches
+	query.plugin_class  = lilv_world_get_plugin_class(world);
+	query.author_name   = "David Robillard";
+	query.name_prefix   = "test comp";
+	query.audio_inputs  = 1;
+	query.audio_outputs = 1;
+	query.has_ui        = 1;
+	TEST_ASSERT(lilv_search_index_find(index, &query, found, 4) == 1);
+	TEST_ASSERT(found[0] == plug);
+
+	query.plugin_class = lilv_plugin_get_class(plug);
+	TEST_ASSERT(lilv_search_index_find(index, &query, found, 4) == 1);
+
+	// Each facet excludes the plugin by itself
+	query.name_prefix = "compressor";
+	TEST_ASSERT(lilv_search_index_find(index, &query, found, 4) == 0);
+	query.name_prefix = "Test";
+	query.author_name = "Nobody";
+	TEST_ASSERT(lilv_search_index_find(index, &query, found, 4) == 0);
+	query.author_name  = NULL;
+	query.audio_inputs = 2;
+	TEST_ASSERT(lilv_search_index_find(index, &query, found, 4) == 0);
+	query.audio_inputs = -1;
+	query.has_ui       = 0;
+	TEST_ASSERT(lilv_search_index_find(index, &query, found, 4) == 0);
+	query.has_ui = -1;
+
+	// Only plugins with supported required features match
+	LilvNode*       feature     = lilv_new_uri(world, "http://example.org/feature");
+	const LilvNode* none[]      = { NULL };
+	const LilvNode* supported[] = { feature, NULL };
+	query.features = none;
+	TEST_ASSERT(lilv_search_index_find(index, &query, found, 4) == 0);
+	query.features = supported;
+	TEST_ASSERT(lilv_search_index_find(index, &query, found, 4) == 1);
+
+	// Unloaded plugins no longer match
+	LilvNode* bundle_uri = lilv_new_uri(world, bundle_dir_uri);
+	TEST_ASSERT(!lilv_world_unload_bundle(world, bundle_uri));
+	TEST_ASSERT(lilv_search_index_find(index, &query, found, 4) == 0);
+
+	// Reloaded plugins match again
+	lilv_world_load_bundle(world, bundle_uri);
+	TEST_ASSERT(lilv_search_index_find(index, &query, found, 4) == 1);
+
+	lilv_node_free(bundle_uri);
+	lilv_node_free(feature);
+	lilv_search_index_free(index);
+	cleanup_uris();
+	return 1;
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	unsigned n_added;
+	unsigned n_changed;
+	unsigned n_removed;
+} WatchCounts;
+
+static void
+count_bundle_change(void* handle, const LilvNode* bundle, LilvBundleChange change)
+{
+	WatchCounts* counts = (WatchCounts*)handle;
+	switch (change) {
+	case LILV_BUNDLE_ADDED: ++counts->n_added; break;
+	case LILV_BUNDLE_CHANGED: ++counts->n_changed; break;
+	case LILV_BUNDLE_REMOVED: ++counts->n_removed; break;
+	}
+}
+
+#define WATCH_MANIFEST MANIFEST_PREFIXES \
+	":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n"
+
+#define WATCH_PLUGIN(name) BUNDLE_PREFIXES \
+	":plug a lv2:Plugin ; " PLUGIN_NAME(name) " ; " LICENSE_GPL " ; " \
+	"lv2:port [ a lv2:ControlPort ; a lv2:InputPort ;" \
+	" lv2:index 0 ; lv2:symbol \"foo\" ; lv2:name \"bar\" ] ."
+
+/** Set LV2_PATH back to `orig_lv2_path`, or unset it if NULL, and free it. */
+static void
+restore_lv2_path(char* orig_lv2_path)
+{
+	if (orig_lv2_path) {
+		setenv("LV2_PATH", orig_lv2_path, 1);
+	} else {
+		unsetenv("LV2_PATH");
+	}
+	free(orig_lv2_path);
+}
+
+static int
+test_watch(void)
+{
+	char* orig_lv2_path = lilv_strdup(getenv("LV2_PATH"));
+	char* lv2_dir       = lilv_strjoin(getenv("HOME"), "/.lv2", NULL);
+	setenv("LV2_PATH", lv2_dir, 1);
+	free(lv2_dir);
+
+	delete_bundle();
+	if (!load_all_bundles()) {
+		restore_lv2_path(orig_lv2_path);
+		return 0;
+	}
+
+	init_uris();
+
+	WatchCounts  counts  = { 0, 0, 0 };
+	LilvWatcher* watcher = lilv_watcher_new(world, count_bundle_change, &counts);
+	TEST_ASSERT(watcher);
+	TEST_ASSERT(lilv_watcher_update(watcher) == 0);
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	TEST_ASSERT(!lilv_plugins_get_by_uri(plugins, plugin_uri_value));
+
+	// Adding a bundle loads it
+	create_bundle(WATCH_MANIFEST, WATCH_PLUGIN("First"));
+	TEST_ASSERT(lilv_watcher_update(watcher) == 1);
+	TEST_ASSERT(counts.n_added == 1);
+	const LilvPlugin* plug = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+	TEST_ASSERT(plug);
+	LilvNode* name = lilv_plugin_get_name(plug);
+	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "First"));
+	lilv_node_free(name);
+
+	// Modifying a file in the bundle reloads it
+	write_file(content_name, WATCH_PLUGIN("Second one"));
+	TEST_ASSERT(lilv_watcher_update(watcher) == 1);
+	TEST_ASSERT(counts.n_changed == 1);
+	plug = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+	TEST_ASSERT(plug);
+	name = lilv_plugin_get_name(plug);
+	TEST_ASSERT(!strcmp(lilv_node_as_string(name), "Second one"));
+	lilv_node_free(name);
+	TEST_ASSERT(lilv_watcher_update(watcher) == 0);
+
+	// Removing the bundle unloads it
+	delete_bundle();
+	TEST_ASSERT(lilv_watcher_update(watcher) == 1);
+	TEST_ASSERT(counts.n_removed == 1);
+	TEST_ASSERT(!lilv_plugins_get_by_uri(plugins, plugin_uri_value));
+
+	lilv_watcher_free(watcher);
+	cleanup_uris();
+
+	restore_lv2_path(orig_lv2_path);
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_scan(void)
+{
+	if (!start_bundle(MANIFEST_PREFIXES
+	                  ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n"
+	                  ":foobar a lv2:Plugin ; rdfs:seeAlso <plugin.ttl> .\n",
+	                  BUNDLE_PREFIXES
+	                  ":plug a lv2:Plugin ; "
+	                  PLUGIN_NAME("Test plugin") " ; "
+	                  LICENSE_GPL " ; "
+	                  "lv2:port [ a lv2:ControlPort ; a lv2:InputPort ;"
+	                  " lv2:index 0 ; lv2:symbol \"foo\" ; lv2:name \"bar\" ] .\n"
+	                  ":foobar a lv2:Plugin ; "
+	                  "lv2:port [ a lv2:ControlPort ; a lv2:InputPort ;"
+	                  " lv2:index 0 ; lv2:symbol \"foo\" ; lv2:name \"bar\" ] .\n"))
+		return 0;
+
+	init_uris();
+	lilv_world_freeze(world);
+
+	const LilvPlugins* plugins   = lilv_world_get_all_plugins(world);
+	const unsigned     n_plugins = lilv_plugins_size(plugins);
+	LilvScanResult*    results   = (LilvScanResult*)calloc(
+		n_plugins, sizeof(LilvScanResult));
+
+	LilvScanOptions options = { 4, false, 48000.0, NULL, 10000 };
+	TEST_ASSERT(lilv_world_scan_plugins(world, plugins, &options, results) >= 1);
+
+	const LilvScanResult* plug_result   = NULL;
+	const LilvScanResult* foobar_result = NULL;
+	for (unsigned i = 0; i < n_plugins; ++i) {
+		const LilvNode* uri = lilv_plugin_get_uri(results[i].plugin);
+		if (lilv_node_equals(uri, plugin_uri_value)) {
+			plug_result = &results[i];
+		} else if (lilv_node_equals(uri, plugin2_uri_value)) {
+			foobar_result = &results[i];
+		}
+	}
+
+	// Data checks find missing names and binaries
+	TEST_ASSERT(plug_result && foobar_result);
+	TEST_ASSERT(plug_result->status == LILV_SCAN_OK);
+	TEST_ASSERT(plug_result->errors == 0);
+	TEST_ASSERT(foobar_result->status == LILV_SCAN_INVALID);
+	TEST_ASSERT(foobar_result->errors ==
+	            (LILV_SCAN_NO_NAME | LILV_SCAN_NO_BINARY));
+	TEST_ASSERT(lilv_plugin_verify(plug_result->plugin));
+	TEST_ASSERT(!lilv_plugin_verify(foobar_result->plugin));
+
+	// Instantiating fails since the binary does not exist
+	options.instantiate = true;
+	TEST_ASSERT(lilv_world_scan_plugins(world, plugins, &options, results) >= 2);
+	TEST_ASSERT(plug_result->status == LILV_SCAN_FAILED);
+	TEST_ASSERT(!plug_result->signal);
+	TEST_ASSERT(foobar_result->status == LILV_SCAN_INVALID);
+
+	free(results);
+	cleanup_uris();
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_isolated(void)
+{
+	init_world();
+
+	uint8_t*   abs_bundle = (uint8_t*)lilv_path_absolute(LILV_TEST_BUNDLE);
+	SerdNode   bundle     = serd_node_new_file_uri(abs_bundle, 0, 0, true);
+	LilvNode*  bundle_uri = lilv_new_uri(world, (const char*)bundle.buf);
+	LilvNode*  plugin_uri = lilv_new_uri(world,
+	                                     "http://example.org/lilv-test-plugin");
+	lilv_world_load_bundle(world, bundle_uri);
+	free(abs_bundle);
+	serd_node_free(&bundle);
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plugin  = lilv_plugins_get_by_uri(plugins, plugin_uri);
+	TEST_ASSERT(plugin);
+
+	LV2_URID_Map       map         = { NULL, map_uri };
+	LV2_Feature        map_feature = { LV2_URID_MAP_URI, &map };
+	const LV2_Feature* features[]  = { &map_feature, NULL };
+
+	// Instantiating fails in the child without required features
+	TEST_ASSERT(!lilv_plugin_instantiate_isolated(plugin, 48000.0, NULL, 64));
+
+	LilvInstance* instance = lilv_plugin_instantiate_isolated(
+		plugin, 48000.0, features, 64);
+	TEST_ASSERT(instance);
+	TEST_ASSERT(lilv_instance_is_isolated(instance));
+	TEST_ASSERT(!strcmp(lilv_instance_get_uri(instance),
+	                    lilv_node_as_uri(plugin_uri)));
+
+	// Ports are copied through the child
+	float in  = 1.0f;
+	float out = 0.0f;
+	lilv_instance_connect_port(instance, 0, &in);
+	lilv_instance_connect_port(instance, 1, &out);
+	lilv_instance_activate(instance);
+	for (unsigned i = 0; i < 4; ++i) {
+		in = (float)i + 0.5f;
+		lilv_instance_run(instance, 1);
+		TEST_ASSERT(out == in);
+	}
+	lilv_instance_deactivate(instance);
+	TEST_ASSERT(!lilv_instance_has_crashed(instance));
+	TEST_ASSERT(!lilv_instance_get_extension_data(
+		            instance, "http://lv2plug.in/ns/ext/state#interface"));
+	lilv_instance_free(instance);
+
+	// Ordinary instances are not isolated
+	instance = lilv_plugin_instantiate(plugin, 48000.0, features);
+	TEST_ASSERT(instance);
+	TEST_ASSERT(!lilv_instance_is_isolated(instance));
+	TEST_ASSERT(!lilv_instance_has_crashed(instance));
+	lilv_instance_free(instance);
+
+	lilv_node_free(plugin_uri);
+	lilv_node_free(bundle_uri);
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_run_blocks(void)
+{
+	init_world();
+
+	uint8_t*   abs_bundle = (uint8_t*)lilv_path_absolute(LILV_TEST_BUNDLE);
+	SerdNode   bundle     = serd_node_new_file_uri(abs_bundle, 0, 0, true);
+	LilvNode*  bundle_uri = lilv_new_uri(world, (const char*)bundle.buf);
+	LilvNode*  plugin_uri = lilv_new_uri(world,
+	                                     "http://example.org/lilv-test-plugin");
+	lilv_world_load_bundle(world, bundle_uri);
+	free(abs_bundle);
+	serd_node_free(&bundle);
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plugin  = lilv_plugins_get_by_uri(plugins, plugin_uri);
+	TEST_ASSERT(plugin);
+
+	LV2_URID_Map       map         = { NULL, map_uri };
+	LV2_Feature        map_feature = { LV2_URID_MAP_URI, &map };
+	const LV2_Feature* features[]  = { &map_feature, NULL };
+
+	LilvInstance* instance = lilv_plugin_instantiate(plugin, 48000.0, features);
+	TEST_ASSERT(instance);
+
+	// The test plugin copies the first sample of every block
+	float          in[5]      = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f };
+	float          out[5]     = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	const uint32_t ports[2]   = { 0, 1 };
+	float* const   buffers[2] = { in, out };
+	lilv_instance_activate(instance);
+	lilv_instance_run_blocks(instance, 2, ports, buffers, 5, 2);
+	TEST_ASSERT(out[0] == 1.0f && out[2] == 3.0f && out[4] == 5.0f);
+	TEST_ASSERT(out[1] == 0.0f && out[3] == 0.0f);
+	lilv_instance_deactivate(instance);
+	lilv_instance_free(instance);
+
+	lilv_node_free(plugin_uri);
+	lilv_node_free(bundle_uri);
+	return 1;
+}
+
+/*****************************************************************************/
+
+static unsigned ui_supported_calls = 0;
+
+static unsigned
+ui_supported_counted(const char* container_type_uri,
+                     const char* ui_type_uri)
+{
+	++ui_supported_calls;
+	if (!strcmp(ui_type_uri, "http://lv2plug.in/ns/extensions/ui#X11UI")) {
+		return 1;
+	} else if (!strcmp(ui_type_uri, container_type_uri)) {
+		return 2;
+	}
+	return 0;
+}
+
+static int
+test_select_uis(void)
+{
+	if (!start_bundle(MANIFEST_PREFIXES
+			":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n"
+			":plug2 a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+			BUNDLE_PREFIXES PREFIX_LV2UI
+			":plug a lv2:Plugin ; "
+			PLUGIN_NAME("Test plugin") " ; "
+			LICENSE_GPL " ; "
+			"lv2ui:ui :ui , :ui2 , :ui3 . "
+			":plug2 a lv2:Plugin ; "
+			PLUGIN_NAME("Test plugin 2") " ; "
+			LICENSE_GPL " ; "
+			"lv2ui:ui :ui4 . "
+			":ui a lv2ui:X11UI ; lv2ui:binary <ui" SHLIB_EXT "> . "
+			":ui2 a lv2ui:GtkUI ; lv2ui:binary <ui2" SHLIB_EXT "> . "
+			":ui3 a lv2ui:X11UI ; lv2ui:binary <ui3" SHLIB_EXT "> . "
+			":ui4 a lv2ui:Qt4UI ; lv2ui:binary <ui4" SHLIB_EXT "> . "))
+		return 0;
+
+	init_uris();
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plug    = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+	TEST_ASSERT(plug);
+	TEST_ASSERT(lilv_plugins_size(plugins) == 2);
+
+	// Shared UIs are loaded once and copied by lilv_plugin_get_uis()
+	const LilvUIs* shared = lilv_plugin_get_shared_uis(plug);
+	TEST_ASSERT(lilv_uis_size(shared) == 3);
+	TEST_ASSERT(lilv_plugin_get_shared_uis(plug) == shared);
+
+	LilvUIs* uis = lilv_plugin_get_uis(plug);
+	TEST_ASSERT(uis != shared);
+	TEST_ASSERT(lilv_uis_size(uis) == 3);
+	LILV_FOREACH(uis, i, shared) {
+		const LilvUI* ui   = lilv_uis_get(shared, i);
+		const LilvUI* copy = lilv_uis_get_by_uri(uis, lilv_ui_get_uri(ui));
+		TEST_ASSERT(copy && copy != ui);
+		TEST_ASSERT(lilv_node_equals(lilv_ui_get_binary_uri(copy),
+		                             lilv_ui_get_binary_uri(ui)));
+	}
+	lilv_uis_free(uis);
+
+	// The best UI of each plugin, with one call per UI type
+	LilvNode* gtk_ui = lilv_new_uri(
+		world, "http://lv2plug.in/ns/extensions/ui#GtkUI");
+	const LilvUI*   best[2];
+	const LilvNode* types[2];
+	TEST_ASSERT(lilv_world_select_uis(world, plugins, ui_supported_counted,
+	                                  gtk_ui, best, types) == 1);
+	TEST_ASSERT(ui_supported_calls == 3);
+
+	unsigned n = 0;
+	LILV_FOREACH(plugins, i, plugins) {
+		const LilvPlugin* p = lilv_plugins_get(plugins, i);
+		if (p == plug) {
+			TEST_ASSERT(best[n]);
+			TEST_ASSERT(!strcmp(lilv_node_as_uri(lilv_ui_get_uri(best[n])),
+			                    "http://example.org/ui2"));
+			TEST_ASSERT(lilv_node_equals(types[n], gtk_ui));
+		} else {
+			TEST_ASSERT(!best[n]);
+			TEST_ASSERT(!types[n]);
+		}
+		++n;
+	}
+
+	// Results are memoized
+	const LilvNode* ui_type = NULL;
+	TEST_ASSERT(lilv_ui_is_supported(best[0] ? best[0] : best[1],
+	                                 ui_supported_counted, gtk_ui, &ui_type));
+	TEST_ASSERT(lilv_world_select_uis(world, plugins, ui_supported_counted,
+	                                  gtk_ui, best, NULL) == 1);
+	TEST_ASSERT(ui_supported_calls == 3);
+
+	// Shared UIs are reloaded after the bundle changes
+	LilvNode* bundle_uri = lilv_new_uri(world, bundle_dir_uri);
+	lilv_world_unload_bundle(world, bundle_uri);
+	delete_bundle();
+	create_bundle(MANIFEST_PREFIXES
+	              ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	              BUNDLE_PREFIXES PREFIX_LV2UI
+	              ":plug a lv2:Plugin ; "
+	              PLUGIN_NAME("Test plugin") " ; "
+	              LICENSE_GPL " ; "
+	              "lv2ui:ui :ui . "
+	              ":ui a lv2ui:X11UI ; lv2ui:binary <ui" SHLIB_EXT "> . ");
+	lilv_world_load_bundle(world, bundle_uri);
+	shared = lilv_plugin_get_shared_uis(plug);
+	TEST_ASSERT(lilv_uis_size(shared) == 1);
+	lilv_node_free(bundle_uri);
+
+	// Other queries and loading plugin data do not rebuild them
+	LilvNode* name = lilv_plugin_get_name(plug);
+	lilv_node_free(name);
+	TEST_ASSERT(lilv_plugin_get_num_ports(plug) == 0);
+	TEST_ASSERT(lilv_plugin_get_shared_uis(plug) == shared);
+
+	// Freezing keeps the same UIs, which are never rebuilt after
+	lilv_world_freeze(world);
+	TEST_ASSERT(lilv_plugin_get_shared_uis(plug) == shared);
+	TEST_ASSERT(lilv_world_select_uis(world, plugins, ui_supported_counted,
+	                                  gtk_ui, best, NULL) == 1);
+	TEST_ASSERT(best[0] == lilv_uis_get(shared, lilv_uis_begin(shared)) ||
+	            best[1] == lilv_uis_get(shared, lilv_uis_begin(shared)));
+	TEST_ASSERT(lilv_plugin_get_shared_uis(plug) == shared);
+
+	lilv_node_free(gtk_ui);
+	cleanup_uris();
+	return 1;
+}
+
+/*****************************************************************************/
+
+static unsigned n_spec_parses;
+static unsigned n_other_parses;
+
+static void
+count_spec_parse(void* handle, const LilvTraceSpan* span)
+{
+	if (span->type == LILV_TRACE_LOAD_FILE && strstr(span->uri, "/plugin.ttl")) {
+		++n_spec_parses;
+	} else if (span->type == LILV_TRACE_LOAD_FILE &&
+	           strstr(span->uri, "/other.ttl")) {
+		++n_other_parses;
+	}
+}
+
+static int
+test_lazy_specs(void)
+{
+	char other_name[TEST_PATH_MAX + 16];
+	snprintf(other_name, sizeof(other_name), "%s/other.ttl", bundle_dir_name);
+
+	create_bundle(MANIFEST_PREFIXES
+	              "<http://example.org/spec> a lv2:Specification ; "
+	              "rdfs:seeAlso <plugin.ttl> .\n"
+	              "<http://example.org/other> a lv2:Specification ; "
+	              "rdfs:seeAlso <other.ttl> .\n",
+	              BUNDLE_PREFIXES
+	              "<http://example.org/spec#ToyPlugin> a rdfs:Class ; "
+	              "rdfs:subClassOf lv2:Plugin ; rdfs:label \"Toy\" .\n"
+	              "<http://example.org/spec#ToyDelay> a rdfs:Class ; "
+	              "rdfs:subClassOf <http://example.org/spec#ToyPlugin> ; "
+	              "rdfs:label \"Toy Delay\" .");
+	write_file(other_name,
+	           BUNDLE_PREFIXES
+	           "<http://example.org/other#thing> rdfs:label \"Thing\" .");
+	if (!init_world())
+		return 0;
+
+	// No specification is parsed when everything is loaded
+	n_spec_parses = n_other_parses = 0;
+	lilv_world_set_trace_func(world, count_spec_parse, NULL);
+	lilv_world_load_all(world);
+	TEST_ASSERT(n_spec_parses == 0);
+	TEST_ASSERT(n_other_parses == 0);
+
+	// Specifications that declare plugin classes are loaded for the classes
+	const LilvPluginClasses* classes = lilv_world_get_plugin_classes(world);
+	LilvNode* toy = lilv_new_uri(world, "http://example.org/spec#ToyPlugin");
+	LilvNode* delay = lilv_new_uri(world, "http://example.org/spec#ToyDelay");
+	LilvNode* label_pred = lilv_new_uri(world, LILV_NS_RDFS "label");
+	const LilvPluginClass* toy_class = lilv_plugin_classes_get_by_uri(classes, toy);
+	const LilvPluginClass* delay_class = lilv_plugin_classes_get_by_uri(classes, delay);
+	TEST_ASSERT(toy_class);
+	TEST_ASSERT(delay_class);
+	TEST_ASSERT(lilv_node_equals(lilv_plugin_class_get_parent_uri(delay_class),
+	                             toy));
+	TEST_ASSERT(!strcmp(lilv_node_as_string(lilv_plugin_class_get_label(toy_class)),
+	                    "Toy"));
+
+	LilvNode* label = lilv_world_get(world, toy, label_pred, NULL);
+	TEST_ASSERT(label && !strcmp(lilv_node_as_string(label), "Toy"));
+	TEST_ASSERT(lilv_world_ask(world, toy, label_pred, label));
+	lilv_node_free(label);
+
+	// Classes are only looked for once
+	const unsigned n_parses = n_spec_parses + n_other_parses;
+	TEST_ASSERT(n_spec_parses > 0);
+	TEST_ASSERT(lilv_world_get_plugin_classes(world) == classes);
+	TEST_ASSERT(n_spec_parses + n_other_parses == n_parses);
+
+	// The other specification is loaded by the first query about it
+	LilvNode* thing = lilv_new_uri(world, "http://example.org/other#thing");
+	TEST_ASSERT(lilv_world_ask(world, thing, label_pred, NULL));
+	TEST_ASSERT(n_spec_parses + n_other_parses > n_parses);
+	lilv_node_free(thing);
+
+	lilv_world_set_trace_func(world, NULL, NULL);
+	unlink(other_name);
+
+	lilv_node_free(label_pred);
+	lilv_node_free(delay);
+	lilv_node_free(toy);
+	return 1;
+}
+
+/*****************************************************************************/
+
+#define FEATURE(n) "<http://example.org/feature" #n ">"
+#define FEATURES(n) FEATURE(n##0) " , " FEATURE(n##1) " , " FEATURE(n##2) " , " \
+	FEATURE(n##3) " , " FEATURE(n##4) " , " FEATURE(n##5) " , " FEATURE(n##6)
+
+static int
+test_flat_collections(void)
+{
+	// More features than fit in the local storage of a LilvArray
+	if (!start_bundle(MANIFEST_PREFIXES
+			":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+			BUNDLE_PREFIXES
+			":plug a lv2:Plugin ; "
+			PLUGIN_NAME("Test plugin") " ; "
+			LICENSE_GPL " ; "
+			"lv2:requiredFeature " FEATURES(1) " , " FEATURES(2) " , "
+			FEATURES(3) " . "))
+		return 0;
+
+	init_uris();
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plug    = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+	TEST_ASSERT(plug);
+
+	LilvNodes* features = lilv_plugin_get_required_features(plug);
+	TEST_ASSERT(lilv_nodes_size(features) == 21);
+
+	// Merged collections keep duplicates
+	LilvNodes* merged = lilv_nodes_merge(features, features);
+	TEST_ASSERT(lilv_nodes_size(merged) == 42);
+	unsigned n_found = 0;
+	LILV_FOREACH(nodes, i, features) {
+		const LilvNode* feature = lilv_nodes_get(features, i);
+		TEST_ASSERT(lilv_nodes_contains(merged, feature));
+		++n_found;
+	}
+	TEST_ASSERT(n_found == 21);
+
+	lilv_nodes_free(merged);
+	lilv_nodes_free(features);
+	cleanup_uris();
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_instance_pool(void)
+{
+	init_world();
+
+	uint8_t*   abs_bundle = (uint8_t*)lilv_path_absolute(LILV_TEST_BUNDLE);
+	SerdNode   bundle     = serd_node_new_file_uri(abs_bundle, 0, 0, true);
+	LilvNode*  bundle_uri = lilv_new_uri(world, (const char*)bundle.buf);
+	LilvNode*  plugin_uri = lilv_new_uri(world,
+	                                     "http://example.org/lilv-test-plugin");
+	lilv_world_load_bundle(world, bundle_uri);
+	free(abs_bundle);
+	serd_node_free(&bundle);
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plugin  = lilv_plugins_get_by_uri(plugins, plugin_uri);
+	TEST_ASSERT(plugin);
+
+	LV2_URID_Map       map         = { NULL, map_uri };
+	LV2_Feature        map_feature = { LV2_URID_MAP_URI, &map };
+	const LV2_Feature* features[]  = { &map_feature, NULL };
+
+	// The world is not frozen, so the pool is filled immediately
+	LilvInstancePool* pool = lilv_instance_pool_new(
+		plugin, 48000.0, features, 2, NULL);
+	TEST_ASSERT(lilv_instance_pool_get_num_ready(pool) == 2);
+
+	LilvInstance* a = lilv_instance_pool_take(pool);
+	LilvInstance* b = lilv_instance_pool_take(pool);
+	TEST_ASSERT(a && b && a != b);
+	TEST_ASSERT(!lilv_instance_pool_take(pool));
+	TEST_ASSERT(lilv_instance_pool_get_num_ready(pool) == 0);
+
+	// Returned instances are freed, and replaced by refilling
+	lilv_instance_pool_return(pool, a);
+	lilv_instance_pool_refill(pool);
+	TEST_ASSERT(lilv_instance_pool_get_num_ready(pool) == 2);
+	lilv_instance_free(b);
+	lilv_instance_pool_free(pool);
+
+	// With a state, returned instances are restored and reused
+	LilvInstance* instance = lilv_plugin_instantiate(plugin, 48000.0, features);
+	LilvState*    state    = lilv_state_new_from_instance(
+		plugin, instance, &map, NULL, NULL, NULL, NULL,
+		get_port_value, world, 0, NULL);
+	TEST_ASSERT(state);
+	lilv_instance_free(instance);
+
+	pool = lilv_instance_pool_new(plugin, 48000.0, features, 1, state);
+	a    = lilv_instance_pool_take(pool);
+	TEST_ASSERT(a);
+	lilv_instance_pool_return(pool, a);
+	lilv_instance_pool_refill(pool);
+	TEST_ASSERT(lilv_instance_pool_get_num_ready(pool) == 1);
+	TEST_ASSERT(lilv_instance_pool_take(pool) == a);
+	lilv_instance_pool_free(pool);
+	lilv_instance_free(a);
+	lilv_state_free(state);
+
+	for (size_t i = 0; i < n_uris; ++i) {
+		free(uris[i]);
+	}
+	free(uris);
+	uris   = NULL;
+	n_uris = 0;
+
+	lilv_node_free(plugin_uri);
+	lilv_node_free(bundle_uri);
+	return 1;
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	char*  buf;
+	size_t len;
+	size_t offset;
+	size_t limit;
+} StateBuffer;
+
+static size_t
+state_buffer_write(const void* buf, size_t len, void* stream)
+{
+	StateBuffer* const buffer = (StateBuffer*)stream;
+	if (buffer->len + len > buffer->limit) {
+		return 0;
+	}
+
+	buffer->buf = (char*)realloc(buffer->buf, buffer->len + len + 1);
+	memcpy(buffer->buf + buffer->len, buf, len);
+	buffer->len += len;
+	buffer->buf[buffer->len] = '\0';
+	return len;
+}
+
+static size_t
+state_buffer_read(void* buf, size_t len, void* stream)
+{
+	// Read a few bytes at a time to exercise parsing across reads
+	StateBuffer* const buffer = (StateBuffer*)stream;
+	if (buffer->offset >= buffer->limit) {
+		return LILV_STATE_SOURCE_ERROR;
+	}
+
+	size_t n = buffer->len - buffer->offset;
+	n = n < len ? n : len;
+	n = n < 7 ? n : 7;
+	memcpy(buf, buffer->buf + buffer->offset, n);
+	buffer->offset += n;
+	return n;
+}
+
+static int
+test_state_stream(void)
+{
+	init_world();
+
+	uint8_t*   abs_bundle = (uint8_t*)lilv_path_absolute(LILV_TEST_BUNDLE);
+	SerdNode   bundle     = serd_node_new_file_uri(abs_bundle, 0, 0, true);
+	LilvNode*  bundle_uri = lilv_new_uri(world, (const char*)bundle.buf);
+	LilvNode*  plugin_uri = lilv_new_uri(world,
+	                                     "http://example.org/lilv-test-plugin");
+	lilv_world_load_bundle(world, bundle_uri);
+	free(abs_bundle);
+	serd_node_free(&bundle);
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plugin  = lilv_plugins_get_by_uri(plugins, plugin_uri);
+	TEST_ASSERT(plugin);
+
+	LV2_URID_Map       map         = { NULL, map_uri };
+	LV2_Feature        map_feature = { LV2_URID_MAP_URI, &map };
+	LV2_URID_Unmap     unmap       = { NULL, unmap_uri };
+	const LV2_Feature* features[]  = { &map_feature, NULL };
+
+	LilvInstance* instance = lilv_plugin_instantiate(plugin, 48000.0, features);
+	LilvState*    state    = lilv_state_new_from_instance(
+		plugin, instance, &map, NULL, NULL, NULL, NULL,
+		get_port_value, world, 0, NULL);
+	TEST_ASSERT(state);
+
+	// Streamed state is the same document as a state string
+	StateBuffer buffer = { NULL, 0, 0, SIZE_MAX };
+	TEST_ASSERT(!lilv_state_write_stream(
+		            world, &map, &unmap, state, "http://example.org/state1",
+		            NULL, state_buffer_write, &buffer));
+	char* str = lilv_state_to_string(
+		world, &map, &unmap, state, "http://example.org/state1", NULL);
+	TEST_ASSERT(buffer.buf && !strcmp(buffer.buf, str));
+	free(str);
+
+	// Restore from stream
+	LilvState* from_stream = lilv_state_new_from_stream(
+		world, &map, state_buffer_read, &buffer);
+	TEST_ASSERT(from_stream);
+	TEST_ASSERT(lilv_state_equals(state, from_stream));
+	lilv_state_free(from_stream);
+
+	// A source that fails part way through loads nothing
+	buffer.offset = 0;
+	buffer.limit  = buffer.len / 2;
+	TEST_ASSERT(!lilv_state_new_from_stream(
+		            world, &map, state_buffer_read, &buffer));
+
+	// A stream that ends in the middle of a statement loads nothing
+	const size_t full_len = buffer.len;
+	buffer.offset = 0;
+	buffer.limit  = SIZE_MAX;
+	buffer.len    = (size_t)(strstr(buffer.buf, "pset:Preset") - buffer.buf +
+	                         strlen("pset:Preset"));
+	TEST_ASSERT(!lilv_state_new_from_stream(
+		            world, &map, state_buffer_read, &buffer));
+	buffer.len = full_len;
+	free(buffer.buf);
+
+	// A sink that fails is reported
+	StateBuffer small = { NULL, 0, 0, 16 };
+	TEST_ASSERT(lilv_state_write_stream(
+		            world, &map, &unmap, state, "http://example.org/state1",
+		            NULL, state_buffer_write, &small));
+	TEST_ASSERT(small.len <= 16);
+	free(small.buf);
+
+	// A state with no URI can not be written
+	StateBuffer none = { NULL, 0, 0, SIZE_MAX };
+	TEST_ASSERT(lilv_state_write_stream(
+		            world, &map, &unmap, state, NULL, NULL,
+		            state_buffer_write, &none));
+	TEST_ASSERT(!none.buf);
+
+	lilv_state_free(state);
+	lilv_instance_free(instance);
+
+	for (size_t i = 0; i < n_uris; ++i) {
+		free(uris[i]);
+	}
+	free(uris);
+	uris   = NULL;
+	n_uris = 0;
+
+	lilv_node_free(plugin_uri);
+	lilv_node_free(bundle_uri);
+	return 1;
+}
+
+/*****************************************************************************/
+
+static unsigned n_trace_spans[LILV_TRACE_RESTORE_STATE + 1];
+static size_t   n_traced_statements;
+
+static void
+count_trace_span(void* handle, const LilvTraceSpan* span)
+{
+	TEST_ASSERT(span->end >= span->begin);
+	++n_trace_spans[span->type];
+	n_traced_statements += span->n_statements;
+}
+
+static int
+test_trace(void)
+{
+	init_world();
+	lilv_world_set_trace_func(world, count_trace_span, NULL);
+
+	uint8_t*   abs_bundle = (uint8_t*)lilv_path_absolute(LILV_TEST_BUNDLE);
+	SerdNode   bundle     = serd_node_new_file_uri(abs_bundle, 0, 0, true);
+	LilvNode*  bundle_uri = lilv_new_uri(world, (const char*)bundle.buf);
+	LilvNode*  plugin_uri = lilv_new_uri(world,
+	                                     "http://example.org/lilv-test-plugin");
+	lilv_world_load_bundle(world, bundle_uri);
+	free(abs_bundle);
+	serd_node_free(&bundle);
+
+	TEST_ASSERT(n_trace_spans[LILV_TRACE_LOAD_BUNDLE] == 1);
+	TEST_ASSERT(n_trace_spans[LILV_TRACE_LOAD_FILE] == 1);
+	TEST_ASSERT(n_traced_statements > 0);
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plugin  = lilv_plugins_get_by_uri(plugins, plugin_uri);
+	TEST_ASSERT(plugin);
+
+	LV2_URID_Map       map         = { NULL, map_uri };
+	LV2_Feature        map_feature = { LV2_URID_MAP_URI, &map };
+	const LV2_Feature* features[]  = { &map_feature, NULL };
+
+	LilvInstance* instance = lilv_plugin_instantiate(plugin, 48000.0, features);
+	TEST_ASSERT(instance);
+	TEST_ASSERT(n_trace_spans[LILV_TRACE_LOAD_PLUGIN] == 1);
+	TEST_ASSERT(n_trace_spans[LILV_TRACE_OPEN_LIBRARY] == 1);
+	TEST_ASSERT(n_trace_spans[LILV_TRACE_INSTANTIATE] == 1);
+
+	LilvState* state = lilv_state_new_from_instance(
+		plugin, instance, &map, NULL, NULL, NULL, NULL,
+		get_port_value, world, 0, NULL);
+	lilv_state_restore(state, instance, NULL, NULL, 0, NULL);
+	TEST_ASSERT(n_trace_spans[LILV_TRACE_RESTORE_STATE] == 1);
+
+	// Nothing is reported once the function is cleared
+	lilv_world_set_trace_func(world, NULL, NULL);
+	lilv_state_restore(state, instance, NULL, NULL, 0, NULL);
+	TEST_ASSERT(n_trace_spans[LILV_TRACE_RESTORE_STATE] == 1);
+
+	lilv_state_free(state);
+	lilv_instance_free(instance);
+
+	for (size_t i = 0; i < n_uris; ++i) {
+		free(uris[i]);
+	}
+	free(uris);
+	uris   = NULL;
+	n_uris = 0;
+
+	lilv_node_free(plugin_uri);
+	lilv_node_free(bundle_uri);
+	return 1;
+}
+
+static int
+test_trace_parallel_load(void)
+{
+	create_bundle(MANIFEST_PREFIXES
+	              ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	              BUNDLE_PREFIXES
+	              ":plug a lv2:Plugin ;"
+	              PLUGIN_NAME("Test plugin") " ; "
+	              LICENSE_GPL " ; "
+	              "lv2:port [ a lv2:ControlPort ; a lv2:InputPort ;"
+	              " lv2:index 0 ; lv2:symbol \"foo\" ; lv2:name \"bar\" ; ] .");
+
+	if (!init_world()) {
+		return 0;
+	}
+
+	memset(n_trace_spans, 0, sizeof(n_trace_spans));
+	n_traced_statements = 0;
+	lilv_world_set_trace_func(world, count_trace_span, NULL);
+
+	LilvNode* threads = lilv_new_int(world, 4);
+	LilvNode* enable  = lilv_new_bool(world, true);
+	lilv_world_set_option(world, LILV_OPTION_LOAD_THREADS, threads);
+	lilv_world_set_option(world, LILV_OPTION_SELECTIVE_LOAD, enable);
+	lilv_node_free(enable);
+	lilv_node_free(threads);
+	lilv_world_load_all(world);
+
+	// Manifests parsed by the load queue are traced
+	TEST_ASSERT(n_trace_spans[LILV_TRACE_LOAD_BUNDLE] > 0);
+	TEST_ASSERT(n_trace_spans[LILV_TRACE_LOAD_FILE] >=
+	            n_trace_spans[LILV_TRACE_LOAD_BUNDLE]);
+	TEST_ASSERT(n_traced_statements > 0);
+
+	init_uris();
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plug    = lilv_plugins_get_by_uri(plugins, plugin_uri_value);
+	TEST_ASSERT(plug);
+
+	// Reading the summary of a plugin is traced
+	const unsigned n_files = n_trace_spans[LILV_TRACE_LOAD_FILE];
+	TEST_ASSERT(lilv_plugin_get_num_ports(plug) == 1);
+	TEST_ASSERT(n_trace_spans[LILV_TRACE_LOAD_PLUGIN] == 1);
+	TEST_ASSERT(n_trace_spans[LILV_TRACE_LOAD_FILE] > n_files);
+
+	cleanup_uris();
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_memory_stats(void)
+{
+	init_world();
+
+	LilvMemoryStats stats;
+	lilv_world_get_memory_stats(world, &stats);
+	TEST_ASSERT(stats.n_plugins == 0);
+	TEST_ASSERT(stats.n_libraries == 0);
+
+	uint8_t*  abs_bundle = (uint8_t*)lilv_path_absolute(LILV_TEST_BUNDLE);
+	SerdNode  bundle     = serd_node_new_file_uri(abs_bundle, 0, 0, true);
+	LilvNode* bundle_uri = lilv_new_uri(world, (const char*)bundle.buf);
+	lilv_world_load_bundle(world, bundle_uri);
+	free(abs_bundle);
+	serd_node_free(&bundle);
+
+	const size_t n_statements = stats.n_statements;
+	lilv_world_get_memory_stats(world, &stats);
+	TEST_ASSERT(stats.n_statements > n_statements);
+	TEST_ASSERT(stats.n_rdf_nodes > 0);
+	TEST_ASSERT(stats.n_nodes > 0);
+	TEST_ASSERT(stats.node_bytes > 0);
+	TEST_ASSERT(stats.n_plugins == 1);
+	TEST_ASSERT(stats.n_loaded_plugins == 0);
+	TEST_ASSERT(stats.n_files == 1);
+
+	LilvBundleStats bundle_stats;
+	TEST_ASSERT(!lilv_world_get_bundle_stats(world, bundle_uri, &bundle_stats));
+	TEST_ASSERT(bundle_stats.n_statements > 0);
+	TEST_ASSERT(bundle_stats.n_statements <= stats.n_statements);
+
+	// Loading the plugin adds its data to the bundle
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plugin  = lilv_plugins_get(plugins,
+	                                              lilv_plugins_begin(plugins));
+	TEST_ASSERT(lilv_plugin_get_name(plugin));
+	lilv_world_get_memory_stats(world, &stats);
+	TEST_ASSERT(stats.n_loaded_plugins == 1);
+
+	const size_t n_manifest_statements = bundle_stats.n_statements;
+	lilv_world_get_bundle_stats(world, bundle_uri, &bundle_stats);
+	TEST_ASSERT(bundle_stats.n_statements > n_manifest_statements);
+	TEST_ASSERT(bundle_stats.literal_bytes > 0);
+
+	// Unloading the bundle removes everything counted for it
+	lilv_world_unload_bundle(world, bundle_uri);
+	lilv_world_get_bundle_stats(world, bundle_uri, &bundle_stats);
+	TEST_ASSERT(bundle_stats.n_statements == 0);
+	TEST_ASSERT(bundle_stats.literal_bytes == 0);
+
+	LilvNode* literal = lilv_new_string(world, "not a bundle");
+	TEST_ASSERT(lilv_world_get_bundle_stats(world, literal, &bundle_stats));
+	lilv_node_free(literal);
+	TEST_ASSERT(lilv_world_get_bundle_stats(world, NULL, &bundle_stats));
+
+	lilv_node_free(bundle_uri);
+	return 1;
+}
+
+/*****************************************************************************/
+
+/** Write the catalogue of `world` to a string. */
+static char*
+write_catalogue(unsigned n_threads)
+{
+	FILE* fd = tmpfile();
+	TEST_ASSERT(!lilv_world_write_catalogue(
+		            world, lilv_world_get_all_plugins(world), n_threads, fd));
+
+	const long len = ftell(fd);
+	char*      str = (char*)calloc(1, (size_t)len + 1);
+	rewind(fd);
+	TEST_ASSERT(fread(str, 1, (size_t)len, fd) == (size_t)len);
+	fclose(fd);
+	return str;
+}
+
+static int
+test_catalogue(void)
+{
+	init_world();
+
+	char* empty = write_catalogue(1);
+	TEST_ASSERT(!strcmp(empty, "{\"plugins\":[]}\n"));
+	free(empty);
+
+	uint8_t*  abs_bundle = (uint8_t*)lilv_path_absolute(LILV_TEST_BUNDLE);
+	SerdNode  bundle     = serd_node_new_file_uri(abs_bundle, 0, 0, true);
+	LilvNode* bundle_uri = lilv_new_uri(world, (const char*)bundle.buf);
+	lilv_world_load_bundle(world, bundle_uri);
+	free(abs_bundle);
+	serd_node_free(&bundle);
+
+	char* serial = write_catalogue(1);
+	const char* const prefix =
+		"{\"plugins\":[{\"uri\":\"http://example.org/lilv-test-plugin\",";
+	TEST_ASSERT(!strncmp(serial, prefix, strlen(prefix)));
+	TEST_ASSERT(strstr(serial, "\"ports\":[{\"index\":0,"));
+	TEST_ASSERT(strstr(serial, "\"required_features\":["));
+	TEST_ASSERT(strstr(serial, "\"uis\":["));
+	TEST_ASSERT(strstr(serial, "\"presets\":["));
+
+	// Writing in parallel from a frozen world gives the same catalogue
+	lilv_world_freeze(world);
+	char* parallel = write_catalogue(4);
+	TEST_ASSERT(!strcmp(serial, parallel));
+	free(parallel);
+	free(serial);
+	lilv_node_free(bundle_uri);
+	lilv_world_free(world);
+
+	// Strings are escaped
+	create_bundle(MANIFEST_PREFIXES
+	              ":plug a lv2:Plugin ; lv2:binary <foo" SHLIB_EXT "> ; rdfs:seeAlso <plugin.ttl> .\n",
+	              BUNDLE_PREFIXES
+	              ":plug a lv2:Plugin ; "
+	              "doap:name \"Say \\\"hi\\\"\\t\\\\ \\u0001 ok\" .");
+
+	init_world();
+	bundle_uri = lilv_new_uri(world, bundle_dir_uri);
+	lilv_world_load_bundle(world, bundle_uri);
+
+	char* escaped = write_catalogue(1);
+	TEST_ASSERT(strstr(escaped,
+	                   "\"name\":\"Say \\\"hi\\\"\\t\\\\ \\u0001 ok\""));
+	free(escaped);
+
+	lilv_node_free(bundle_uri);
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_port_buffers(void)
+{
+	init_world();
+
+	uint8_t*   abs_bundle = (uint8_t*)lilv_path_absolute(LILV_TEST_BUNDLE);
+	SerdNode   bundle     = serd_node_new_file_uri(abs_bundle, 0, 0, true);
+	LilvNode*  bundle_uri = lilv_new_uri(world, (const char*)bundle.buf);
+	LilvNode*  plugin_uri = lilv_new_uri(world,
+	                                     "http://example.org/lilv-test-plugin");
+	lilv_world_load_bundle(world, bundle_uri);
+	free(abs_bundle);
+	serd_node_free(&bundle);
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plugin  = lilv_plugins_get_by_uri(plugins, plugin_uri);
+	TEST_ASSERT(plugin);
+
+	// Every control port has its own aligned buffer, set to zero
+	LilvPortBuffers* buffers = lilv_port_buffers_new(plugin, 512, 4096);
+	TEST_ASSERT(buffers);
+	for (uint32_t i = 0; i < 3; ++i) {
+		float* buf = (float*)lilv_port_buffers_get(buffers, i);
+		TEST_ASSERT(buf);
+		TEST_ASSERT((uintptr_t)buf % LILV_PORT_BUFFER_ALIGNMENT == 0);
+		TEST_ASSERT(*buf == 0.0f);
+		if (i > 0) {
+			const uint8_t* prev = (const uint8_t*)lilv_port_buffers_get(
+				buffers, i - 1);
+			TEST_ASSERT((const uint8_t*)buf - prev >= LILV_PORT_BUFFER_ALIGNMENT);
+		}
+	}
+	TEST_ASSERT(!lilv_port_buffers_get(buffers, 3));
+
+	LV2_URID_Map       map         = { NULL, map_uri };
+	LV2_Feature        map_feature = { LV2_URID_MAP_URI, &map };
+	const LV2_Feature* features[]  = { &map_feature, NULL };
+
+	LilvInstance* instance = lilv_plugin_instantiate(plugin, 48000.0, features);
+	TEST_ASSERT(instance);
+	lilv_port_buffers_connect(buffers, instance);
+
+	// The test plugin writes its output to whichever of ports 1 and 2 was
+	// connected last, so reconnect the output port to run it normally
+	lilv_instance_connect_port(instance, 0, lilv_port_buffers_get(buffers, 0));
+	lilv_instance_connect_port(instance, 1, lilv_port_buffers_get(buffers, 1));
+	*(float*)lilv_port_buffers_get(buffers, 0) = 42.0f;
+	lilv_instance_run(instance, 1);
+	TEST_ASSERT(*(float*)lilv_port_buffers_get(buffers, 1) == 42.0f);
+	TEST_ASSERT(*(float*)lilv_port_buffers_get(buffers, 2) == 0.0f);
+	lilv_instance_free(instance);
+	lilv_port_buffers_free(buffers);
+
+	// Interleaving and deinterleaving are inverses
+	float        a[5] = { 1, 2, 3, 4, 5 };
+	float        b[5] = { 6, 7, 8, 9, 10 };
+	float        c[5] = { 11, 12, 13, 14, 15 };
+	const float* src[3] = { a, b, c };
+	float        interleaved[15];
+	float        out[3][5];
+	float*       dst[3] = { out[0], out[1], out[2] };
+	for (uint32_t n = 1; n <= 3; ++n) {
+		lilv_buffer_interleave(interleaved, src, n, 5);
+		TEST_ASSERT(interleaved[0] == 1.0f);
+		TEST_ASSERT(n == 1 || interleaved[1] == 6.0f);
+		TEST_ASSERT(interleaved[n] == 2.0f);
+		lilv_buffer_deinterleave(dst, interleaved, n, 5);
+		for (uint32_t i = 0; i < n; ++i) {
+			TEST_ASSERT(!memcmp(dst[i], src[i], sizeof(a)));
+		}
+	}
+
+	// Only denormals are flushed, keeping their sign
+	float samples[5] = { 1.0e-39f, -1.0e-39f, FLT_MIN, 0.5f, -2.0f };
+	lilv_buffer_flush_denormals(samples, 5);
+	TEST_ASSERT(samples[0] == 0.0f && !signbit(samples[0]));
+	TEST_ASSERT(samples[1] == 0.0f && signbit(samples[1]));
+	TEST_ASSERT(samples[2] == FLT_MIN);
+	TEST_ASSERT(samples[3] == 0.5f);
+	TEST_ASSERT(samples[4] == -2.0f);
+
+	for (size_t i = 0; i < n_uris; ++i) {
+		free(uris[i]);
+	}
+	free(uris);
+	uris   = NULL;
+	n_uris = 0;
+
+	lilv_node_free(plugin_uri);
+	lilv_node_free(bundle_uri);
+	return 1;
+}
+
+/*****************************************************************************/
+
+static int
+test_graph_latency(void)
+{
+	// Describe the test plugin with a latency port, using its binary
+	char* abs_bundle = lilv_path_absolute(LILV_TEST_BUNDLE);
+	char* binary     = (char*)malloc(TEST_PATH_MAX);
+	char* manifest   = (char*)malloc(TEST_PATH_MAX);
+	snprintf(binary, TEST_PATH_MAX, "%s/test%s", abs_bundle, SHLIB_EXT);
+	SerdNode binary_uri = serd_node_new_file_uri(
+		(const uint8_t*)binary, 0, 0, true);
+	snprintf(manifest, TEST_PATH_MAX, MANIFEST_PREFIXES
+	         "<http://example.org/lilv-test-plugin> a lv2:Plugin ; "
+	         "lv2:binary <%s> ; rdfs:seeAlso <plugin.ttl> .\n",
+	         (const char*)binary_uri.buf);
+	create_bundle(manifest,
+	              BUNDLE_PREFIXES
+	              "<http://example.org/lilv-test-plugin> a lv2:Plugin ; "
+	              PLUGIN_NAME("Latent") " ; "
+	              LICENSE_GPL " ; "
+	              "lv2:port [ a lv2:ControlPort ; a lv2:InputPort ;"
+	              " lv2:index 0 ; lv2:symbol \"input\" ; lv2:name \"Input\" ] , "
+	              "[ a lv2:ControlPort ; a lv2:OutputPort ;"
+	              " lv2:index 1 ; lv2:symbol \"latency\" ; lv2:name \"Latency\" ;"
+	              " lv2:portProperty lv2:reportsLatency ] .");
+	serd_node_free(&binary_uri);
+	free(manifest);
+	free(binary);
+	free(abs_bundle);
+
+	init_world();
+	LilvNode* bundle_uri = lilv_new_uri(world, bundle_dir_uri);
+	LilvNode* plugin_uri = lilv_new_uri(world,
+	                                    "http://example.org/lilv-test-plugin");
+	lilv_world_load_bundle(world, bundle_uri);
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+	const LilvPlugin*  plugin  = lilv_plugins_get_by_uri(plugins, plugin_uri);
+	TEST_ASSERT(plugin);
+	TEST_ASSERT(lilv_plugin_has_latency(plugin));
+	TEST_ASSERT(lilv_plugin_get_latency_port_index(plugin) == 1);
+
+	LV2_URID_Map       map         = { NULL, map_uri };
+	LV2_Feature        map_feature = { LV2_URID_MAP_URI, &map };
+	const LV2_Feature* features[]  = { &map_feature, NULL };
+
+	LilvInstance* instances[2];
+	float         ins[2] = { 5.0f, 3.0f };
+	for (unsigned i = 0; i < 2; ++i) {
+		instances[i] = lilv_plugin_instantiate(plugin, 48000.0, features);
+		TEST_ASSERT(instances[i]);
+	}
+
+	// The host connects the latency port of the first node before adding more
+	float      host_latency = 0.0f;
+	LilvGraph* graph        = lilv_graph_new(0, false);
+	TEST_ASSERT(lilv_graph_add(graph, plugin, instances[0]) == 0);
+	TEST_ASSERT(!lilv_graph_connect_port(graph, 0, 0, &ins[0]));
+	TEST_ASSERT(!lilv_graph_connect_port(graph, 0, 1, &host_latency));
+	TEST_ASSERT(lilv_graph_connect_port(graph, 2, 0, &ins[1]));
+	TEST_ASSERT(lilv_graph_add(graph, plugin, instances[1]) == 1);
+	TEST_ASSERT(!lilv_graph_connect_port(graph, 1, 0, &ins[1]));
+
+	float latencies[2] = { -1.0f, -1.0f };
+	lilv_graph_run(graph, 1);
+	lilv_graph_get_latencies(graph, latencies);
+	TEST_ASSERT(host_latency == 5.0f);
+	TEST_ASSERT(latencies[0] == 5.0f);
+	TEST_ASSERT(latencies[1] == 3.0f);
+
+	ins[1] = 9.0f;
+	lilv_graph_run(graph, 1);
+	lilv_graph_get_latencies(graph, latencies);
+	TEST_ASSERT(latencies[1] == 9.0f);
+	lilv_graph_free(graph);
+
+	// Latency can be read from the port buffers of instances outside a graph
+	LilvPortBuffers* buffers[2];
+	for (unsigned i = 0; i < 2; ++i) {
+		buffers[i] = lilv_port_buffers_new(plugin, 1, 0);
+		TEST_ASSERT(buffers[i]);
+		lilv_port_buffers_connect(buffers[i], instances[i]);
+		*(float*)lilv_port_buffers_get(buffers[i], 0) = (float)(i + 2);
+		lilv_instance_run(instances[i], 1);
+	}
+
+	lilv_port_buffers_get_latencies(
+		(const LilvPortBuffers* const*)buffers, 2, latencies);
+	TEST_ASSERT(latencies[0] == 2.0f);
+	TEST_ASSERT(latencies[1] == 3.0f);
+
+	for (unsigned i = 0; i < 2; ++i) {
+		lilv_port_buffers_free(buffers[i]);
+		lilv_instance_free(instances[i]);
+	}
+
+	for (size_t i = 0; i < n_uris; ++i) {
+		free(uris[i]);
+	}
+	free(uris);
+	uris   = NULL;
+	n_uris = 0;
+
+	lilv_node_free(plugin_uri);
+	lilv_node_free(bundle_uri);
+	lilv_world_free(world);
+	world = NULL;
+	return 1;
+}
+
+/*****************************************************************************/
+
 static int
 test_replace_version(void)
 {
@@ -2221,6 +4588,11 @@ static struct TestCase tests[] = {
 	TEST_CASE(verify),
 	TEST_CASE(no_verify),
 	TEST_CASE(discovery),
+	TEST_CASE(parallel_load),
+	TEST_CASE(cache),
+	TEST_CASE(dyn_manifest),
+	TEST_CASE(load_plugin),
+	TEST_CASE(freeze),
 	TEST_CASE(lv2_path),
 	TEST_CASE(classes),
 	TEST_CASE(plugin),
@@ -2235,9 +4607,32 @@ static struct TestCase tests[] = {
 	TEST_CASE(bad_port_index),
 	TEST_CASE(bad_port_index),
 	TEST_CASE(string),
+	TEST_CASE(urid_map),
 	TEST_CASE(world),
 	TEST_CASE(state),
+	TEST_CASE(state_copy_index),
+	TEST_CASE(instance_group),
 	TEST_CASE(reload_bundle),
+	TEST_CASE(query_cache),
+	TEST_CASE(selective_load),
+	TEST_CASE(selective_load_shared),
+	TEST_CASE(compact),
+	TEST_CASE(search),
+	TEST_CASE(watch),
+	TEST_CASE(scan),
+	TEST_CASE(isolated),
+	TEST_CASE(run_blocks),
+	TEST_CASE(select_uis),
+	TEST_CASE(lazy_specs),
+	TEST_CASE(flat_collections),
+	TEST_CASE(instance_pool),
+	TEST_CASE(state_stream),
+	TEST_CASE(trace),
+	TEST_CASE(trace_parallel_load),
+	TEST_CASE(memory_stats),
+	TEST_CASE(catalogue),
+	TEST_CASE(port_buffers),
+	TEST_CASE(graph_latency),
 	TEST_CASE(replace_version),
 	TEST_CASE(get_symbol),
 	{ NULL, NULL }
@@ -23,9 +23,19 @@
 
 #define _POSIX_C_SOURCE 200809L
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 #include <time.h>
 #include <sys/time.h>
 
+#ifdef __linux__
+#    include <linux/perf_event.h>
+#    include <sys/ioctl.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
 static inline double
 bench_elapsed_s(const struct timespec* start, const struct timespec* end)
 {
@@ -49,4 +59,150 @@ bench_end(const struct timespec* start_t)
 	return bench_elapsed_s(start_t, &end_t);
 }
 
+/** Return the current monotonic time in nanoseconds, for timing short spans. */
+static inline uint64_t
+bench_now_ns(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+/** Hardware and software event counters. */
+typedef enum {
+	BENCH_CYCLES,
+	BENCH_INSTRUCTIONS,
+	BENCH_CACHE_MISSES,
+	BENCH_BRANCH_MISSES,
+	BENCH_CONTEXT_SWITCHES,
+	BENCH_N_COUNTERS
+} BenchCounter;
+
+static const char* const bench_counter_names[BENCH_N_COUNTERS] = {
+	"cycles", "instructions", "cache_misses", "branch_misses",
+	"context_switches"
+};
+
+/**
+   A set of event counters for the calling thread.
+
+   Counters are only supported on Linux, and may be unavailable if the kernel
+   does not permit them (see perf_event_paranoid), in which case their value
+   is UINT64_MAX.
+*/
+typedef struct {
+	int      fds[BENCH_N_COUNTERS];     ///< Event file descriptors, or -1
+	uint64_t values[BENCH_N_COUNTERS];  ///< Counts between start and stop
+} BenchCounters;
+
+/** Open counters for the calling thread, return true if any are available. */
+static inline bool
+bench_counters_open(BenchCounters* counters)
+{
+	bool any = false;
+	for (unsigned i = 0; i < BENCH_N_COUNTERS; ++i) {
+		counters->fds[i]    = -1;
+		counters->values[i] = UINT64_MAX;
+	}
+
+#ifdef __linux__
+	static const uint32_t types[BENCH_N_COUNTERS] = {
+		PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+		PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE
+	};
+	static const uint64_t configs[BENCH_N_COUNTERS] = {
+		PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+		PERF_COUNT_SW_CONTEXT_SWITCHES
+	};
+
+	for (unsigned i = 0; i < BENCH_N_COUNTERS; ++i) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size           = sizeof(attr);
+		attr.type           = types[i];
+		attr.config         = configs[i];
+		attr.disabled       = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv     = 1;
+		attr.read_format    = (PERF_FORMAT_TOTAL_TIME_ENABLED |
+		                       PERF_FORMAT_TOTAL_TIME_RUNNING);
+		if (types[i] == PERF_TYPE_SOFTWARE) {
+			attr.exclude_kernel = 0;  // Switches are counted by the kernel
+		}
+
+		counters->fds[i] = (int)syscall(
+			SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		any = any || counters->fds[i] >= 0;
+	}
+#endif
+
+	return any;
+}
+
+static inline void
+bench_counters_start(BenchCounters* counters)
+{
+#ifdef __linux__
+	for (unsigned i = 0; i < BENCH_N_COUNTERS; ++i) {
+		if (counters->fds[i] >= 0) {
+			ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+#endif
+}
+
+/** Stop counting and read the counts, scaled up if they were multiplexed. */
+static inline void
+bench_counters_stop(BenchCounters* counters)
+{
+#ifdef __linux__
+	for (unsigned i = 0; i < BENCH_N_COUNTERS; ++i) {
+		if (counters->fds[i] >= 0) {
+			ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+		}
+	}
+
+	for (unsigned i = 0; i < BENCH_N_COUNTERS; ++i) {
+		uint64_t data[3];  // Value, time enabled, time running
+		if (counters->fds[i] < 0 ||
+		    read(counters->fds[i], data, sizeof(data)) != sizeof(data)) {
+			counters->values[i] = UINT64_MAX;
+		} else if (data[2] && data[2] < data[1]) {
+			counters->values[i] = (uint64_t)(
+				(double)data[0] * data[1] / data[2]);
+		} else {
+			counters->values[i] = data[0];
+		}
+	}
+#endif
+}
+
+static inline void
+bench_counters_close(BenchCounters* counters)
+{
+#ifdef __linux__
+	for (unsigned i = 0; i < BENCH_N_COUNTERS; ++i) {
+		if (counters->fds[i] >= 0) {
+			close(counters->fds[i]);
+			counters->fds[i] = -1;
+		}
+	}
+#endif
+}
+
+/** Add the counts in `counters` to `totals`, where both are available. */
+static inline void
+bench_counters_add(uint64_t* totals, const BenchCounters* counters)
+{
+	for (unsigned i = 0; i < BENCH_N_COUNTERS; ++i) {
+		if (counters->values[i] == UINT64_MAX) {
+			totals[i] = UINT64_MAX;
+		} else if (totals[i] != UINT64_MAX) {
+			totals[i] += counters->values[i];
+		}
+	}
+}
+
 #endif  /* BENCH_H */
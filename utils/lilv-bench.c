@@ -14,25 +14,391 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#define _POSIX_C_SOURCE 200809L
+#ifdef __linux__
+#    define _GNU_SOURCE 1
+#endif
+
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 
 #include "lilv/lilv.h"
 
 #include "lilv_config.h"
+#include "bench.h"
+
+#if defined(__GLIBC__) && defined(__GNUC__)
+#    define COUNT_ALLOCS 1
+#endif
+
+static bool count_events = false;
+
+/** A phase of the benchmark being measured. */
+typedef struct {
+	const char*     name;
+	struct timespec start;
+	size_t          start_allocs;
+	BenchCounters   counters;
+} Phase;
+
+#ifdef COUNT_ALLOCS
+
+/*
+  Allocations are counted by defining malloc and friends here, which replaces
+  them for the whole process, including lilv and its dependencies.
+*/
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+static size_t n_allocs = 0;
+
+void*
+malloc(size_t size)
+{
+	__atomic_add_fetch(&n_allocs, 1, __ATOMIC_RELAXED);
+	return __libc_malloc(size);
+}
+
+void*
+calloc(size_t nmemb, size_t size)
+{
+	__atomic_add_fetch(&n_allocs, 1, __ATOMIC_RELAXED);
+	return __libc_calloc(nmemb, size);
+}
+
+void*
+realloc(void* ptr, size_t size)
+{
+	__atomic_add_fetch(&n_allocs, 1, __ATOMIC_RELAXED);
+	return __libc_realloc(ptr, size);
+}
+
+static size_t
+get_n_allocs(void)
+{
+	return __atomic_load_n(&n_allocs, __ATOMIC_RELAXED);
+}
+
+#else
+
+static size_t
+get_n_allocs(void)
+{
+	return 0;
+}
+
+#endif
+
+static void
+print_usage(void)
+{
+	printf("lilv-bench - Benchmark loading and querying all LV2 plugins.\n");
+	printf("Usage: lilv-bench [OPTIONS]\n");
+	printf("       lilv-bench -g DIR COUNT\n");
+	printf("\n");
+	printf("Time each phase of discovering and loading plugins in LV2_PATH.\n");
+	printf("\n");
+	printf("  -a, --all       Discover with lilv_world_load_all() in one phase\n");
+	printf("  -g DIR COUNT    Generate COUNT synthetic plugin bundles in DIR\n");
+	printf("  -h, --help      Display this help and exit.\n");
+	printf("  -P, --perf      Count CPU events like cycles and cache misses\n");
+}
+
+static void
+phase_start(Phase* phase, const char* name)
+{
+	phase->name = name;
+	if (count_events) {
+		bench_counters_open(&phase->counters);
+		bench_counters_start(&phase->counters);
+	}
+	phase->start_allocs = get_n_allocs();
+	phase->start        = bench_start();
+}
+
+static void
+phase_end(Phase* phase)
+{
+	const double elapsed = bench_end(&phase->start);
+	const size_t allocs  = get_n_allocs() - phase->start_allocs;
+	if (count_events) {
+		bench_counters_stop(&phase->counters);
+		bench_counters_close(&phase->counters);
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	printf("%-14s %10.6lf %10zu %10ld",
+	       phase->name, elapsed, allocs, (long)usage.ru_maxrss);
+	for (unsigned i = 0; count_events && i < BENCH_N_COUNTERS; ++i) {
+		const uint64_t value = phase->counters.values[i];
+		if (value == UINT64_MAX) {
+			printf(" %16s", "-");
+		} else {
+			printf(" %16llu", (unsigned long long)value);
+		}
+	}
+	printf("\n");
+}
+
+static void
+print_header(void)
+{
+	printf("# %-12s %10s %10s %10s",
+	       "Phase", "Seconds", "Allocs", "PeakRSSKiB");
+	for (unsigned i = 0; count_events && i < BENCH_N_COUNTERS; ++i) {
+		printf(" %16s", bench_counter_names[i]);
+	}
+	printf("\n");
+}
+
+/** Append a copy of `path` to a NULL-terminated array of paths. */
+static char**
+append_path(char** paths, size_t* n_paths, const char* path)
+{
+	paths = (char**)realloc(paths, (*n_paths + 2) * sizeof(char*));
+	paths[(*n_paths)++] = strdup(path);
+	paths[*n_paths]     = NULL;
+	return paths;
+}
+
+/** Find every bundle directory in LV2_PATH, like lilv_world_load_all(). */
+static char**
+scan_bundles(size_t* n_bundles)
+{
+	const char* lv2_path = getenv("LV2_PATH");
+	const char* home     = getenv("HOME");
+	char**      bundles  = NULL;
+	if (!lv2_path) {
+		lv2_path = LILV_DEFAULT_LV2_PATH;
+	}
+
+	*n_bundles = 0;
+	for (const char* p = lv2_path; *p;) {
+		const size_t len = strcspn(p, LILV_PATH_SEP);
+		char*        dir = NULL;
+		if (p[0] == '~' && home) {
+			dir = (char*)malloc(strlen(home) + len);
+			sprintf(dir, "%s%.*s", home, (int)len - 1, p + 1);
+		} else {
+			dir = (char*)malloc(len + 1);
+			sprintf(dir, "%.*s", (int)len, p);
+		}
+
+		DIR* pdir = opendir(dir);
+		for (struct dirent* e = NULL; pdir && (e = readdir(pdir));) {
+			if (e->d_name[0] == '.') {
+				continue;
+			}
+
+			char* const path = (char*)malloc(strlen(dir) + strlen(e->d_name) + 16);
+			struct stat st;
+			sprintf(path, "%s/%s/manifest.ttl", dir, e->d_name);
+			if (!stat(path, &st)) {
+				sprintf(path, "%s/%s/", dir, e->d_name);
+				bundles = append_path(bundles, n_bundles, path);
+			}
+			free(path);
+		}
+		if (pdir) {
+			closedir(pdir);
+		}
+
+		free(dir);
+		p += len;
+		p += (*p != '\0');
+	}
+
+	return bundles;
+}
+
+static void
+free_paths(char** paths)
+{
+	for (char** p = paths; p && *p; ++p) {
+		free(*p);
+	}
+	free(paths);
+}
+
+/** Write `count` plugin bundles to `dir`, return zero on success. */
+static int
+generate(const char* dir, unsigned count)
+{
+	static const char* const classes[] = {
+		"lv2:AmplifierPlugin", "lv2:CompressorPlugin", "lv2:DelayPlugin",
+		"lv2:DistortionPlugin", "lv2:EQPlugin", "lv2:FilterPlugin",
+		"lv2:ReverbPlugin", "lv2:InstrumentPlugin", "lv2:Plugin"
+	};
+
+	if (mkdir(dir, 0755) && errno != EEXIST) {
+		fprintf(stderr, "Failed to create %s (%s)\n", dir, strerror(errno));
+		return 1;
+	}
+
+	char* const path = (char*)malloc(strlen(dir) + 64);
+	for (unsigned i = 0; i < count; ++i) {
+		sprintf(path, "%s/plugin%u.lv2", dir, i);
+		if (mkdir(path, 0755) && errno != EEXIST) {
+			fprintf(stderr, "Failed to create %s (%s)\n", path, strerror(errno));
+			free(path);
+			return 1;
+		}
+
+		sprintf(path, "%s/plugin%u.lv2/manifest.ttl", dir, i);
+		FILE* fd = fopen(path, "w");
+		if (!fd) {
+			fprintf(stderr, "Failed to write %s (%s)\n", path, strerror(errno));
+			free(path);
+			return 1;
+		}
+		fprintf(fd,
+		        "@prefix lv2: <http://lv2plug.in/ns/lv2core#> .\n"
+		        "@prefix rdfs: <http://www.w3.org/2000/01/rdf-schema#> .\n\n"
+		        "<http://example.org/lilv-bench/plugin%u>\n"
+		        "\ta lv2:Plugin ;\n"
+		        "\tlv2:binary <plugin%u.so> ;\n"
+		        "\trdfs:seeAlso <plugin%u.ttl> .\n",
+		        i, i, i);
+		fclose(fd);
+
+		sprintf(path, "%s/plugin%u.lv2/plugin%u.ttl", dir, i, i);
+		if (!(fd = fopen(path, "w"))) {
+			fprintf(stderr, "Failed to write %s (%s)\n", path, strerror(errno));
+			free(path);
+			return 1;
+		}
+		fprintf(fd,
+		        "@prefix doap: <http://usefulinc.com/ns/doap#> .\n"
+		        "@prefix lv2: <http://lv2plug.in/ns/lv2core#> .\n\n"
+		        "<http://example.org/lilv-bench/plugin%u>\n"
+		        "\ta %s ;\n"
+		        "\tdoap:name \"Synthetic Plugin %u\" ;\n"
+		        "\tdoap:license <http://opensource.org/licenses/isc> ;\n"
+		        "\tlv2:optionalFeature lv2:hardRTCapable ;\n"
+		        "\tlv2:port [\n"
+		        "\t\ta lv2:InputPort , lv2:ControlPort ;\n"
+		        "\t\tlv2:index 0 ;\n"
+		        "\t\tlv2:symbol \"gain\" ;\n"
+		        "\t\tlv2:name \"Gain\" ;\n"
+		        "\t\tlv2:default 0.0 ;\n"
+		        "\t\tlv2:minimum -90.0 ;\n"
+		        "\t\tlv2:maximum 24.0\n"
+		        "\t] , [\n"
+		        "\t\ta lv2:InputPort , lv2:AudioPort ;\n"
+		        "\t\tlv2:index 1 ;\n"
+		        "\t\tlv2:symbol \"in\" ;\n"
+		        "\t\tlv2:name \"In\"\n"
+		        "\t] , [\n"
+		        "\t\ta lv2:OutputPort , lv2:AudioPort ;\n"
+		        "\t\tlv2:index 2 ;\n"
+		        "\t\tlv2:symbol \"out\" ;\n"
+		        "\t\tlv2:name \"Out\"\n"
+		        "\t] , [\n"
+		        "\t\ta lv2:OutputPort , lv2:ControlPort ;\n"
+		        "\t\tlv2:index 3 ;\n"
+		        "\t\tlv2:symbol \"level\" ;\n"
+		        "\t\tlv2:name \"Level\"\n"
+		        "\t] .\n",
+		        i, classes[i % (sizeof(classes) / sizeof(classes[0]))], i);
+		fclose(fd);
+	}
+
+	free(path);
+	return 0;
+}
 
 int
 main(int argc, char** argv)
 {
+	bool load_all = false;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-a") || !strcmp(argv[i], "--all")) {
+			load_all = true;
+		} else if (!strcmp(argv[i], "-P") || !strcmp(argv[i], "--perf")) {
+			count_events = true;
+		} else if (!strcmp(argv[i], "-g") && i + 2 < argc) {
+			const int count = atoi(argv[i + 2]);
+			return count > 0 ? generate(argv[i + 1], (unsigned)count) : 1;
+		} else if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+			print_usage();
+			return 0;
+		} else {
+			print_usage();
+			return 1;
+		}
+	}
+
+	print_header();
+
+	Phase phase;
+	phase_start(&phase, "new");
 	LilvWorld* world = lilv_world_new();
-	lilv_world_load_all(world);
+	phase_end(&phase);
+
+	if (load_all) {
+		phase_start(&phase, "load_all");
+		lilv_world_load_all(world);
+		phase_end(&phase);
+	} else {
+		size_t n_bundles = 0;
+		phase_start(&phase, "scan");
+		char** bundles = scan_bundles(&n_bundles);
+		phase_end(&phase);
+
+		phase_start(&phase, "manifests");
+		for (size_t i = 0; i < n_bundles; ++i) {
+			LilvNode* bundle = lilv_new_file_uri(world, NULL, bundles[i]);
+			lilv_world_load_bundle(world, bundle);
+			lilv_node_free(bundle);
+		}
+		phase_end(&phase);
+		free_paths(bundles);
+
+		phase_start(&phase, "specifications");
+		lilv_world_load_specifications(world);
+		phase_end(&phase);
+
+		phase_start(&phase, "classes");
+		lilv_world_load_plugin_classes(world);
+		phase_end(&phase);
+	}
 
 	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+
+	phase_start(&phase, "data");
+	LILV_FOREACH(plugins, p, plugins) {
+		lilv_plugin_get_class(lilv_plugins_get(plugins, p));
+	}
+	phase_end(&phase);
+
+	phase_start(&phase, "names");
+	LILV_FOREACH(plugins, p, plugins) {
+		lilv_node_free(lilv_plugin_get_name(lilv_plugins_get(plugins, p)));
+	}
+	phase_end(&phase);
+
+	phase_start(&phase, "ports");
 	LILV_FOREACH(plugins, p, plugins) {
-		const LilvPlugin* plugin = lilv_plugins_get(plugins, p);
-		lilv_plugin_get_class(plugin);
+		lilv_plugin_get_num_ports(lilv_plugins_get(plugins, p));
 	}
+	phase_end(&phase);
 
+	const unsigned n_plugins = lilv_plugins_size(plugins);
+	phase_start(&phase, "free");
 	lilv_world_free(world);
+	phase_end(&phase);
 
+	printf("# %u plugins\n", n_plugins);
 	return 0;
 }
@@ -14,7 +14,10 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <ctype.h>
 #include <math.h>
 #include <sndfile.h>
 #include <stdarg.h>
@@ -22,20 +25,57 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/urid/urid.h"
+
 #include "lilv/lilv.h"
 
+#include "lilv_config.h"
+
+#ifdef HAVE_PTHREAD
+#    include <pthread.h>
+#    include <unistd.h>
+#endif
+
+#define DEFAULT_BLOCK_SIZE 4096
+#define N_BLOCKS           4
+
 /** Control port value set from the command line */
 typedef struct Param {
+	unsigned    stage;  ///< Index of plugin in chain
 	const char* sym;    ///< Port symbol
 	float       value;  ///< Control value
 } Param;
 
+/** Connection given in a chain file */
+typedef struct {
+	unsigned    stage;  ///< Index of plugin in chain
+	const char* sym;    ///< Input port symbol, or NULL for an output channel
+	const char* from;   ///< Source, "in:N", "NAME:SYMBOL", or "silence"
+} Route;
+
 /** Port type (only float ports are supported) */
 typedef enum {
+	TYPE_NONE,
 	TYPE_CONTROL,
 	TYPE_AUDIO
 } PortType;
 
+/** Kind of signal connected to an audio input or output channel */
+typedef enum {
+	SOURCE_SILENCE,  ///< Silence
+	SOURCE_INPUT,    ///< Channel of the input file
+	SOURCE_PLUGIN    ///< Audio output of a plugin in the chain
+} SourceType;
+
+/** Signal connected to an audio input or output channel */
+typedef struct {
+	SourceType type;
+	unsigned   stage;  ///< Index of plugin (for SOURCE_PLUGIN)
+	uint32_t   index;  ///< Input channel, or index of plugin output port
+	bool       wrap;   ///< True iff input channels are used round-robin
+} Source;
+
 /** Runtime port information */
 typedef struct {
 	const LilvPort* lilv_port;  ///< Port description
@@ -44,76 +84,184 @@ typedef struct {
 	float           value;      ///< Control value (if applicable)
 	bool            is_input;   ///< True iff an input port
 	bool            optional;   ///< True iff connection optional
+	bool            is_set;     ///< True iff value given on command line
+	Source          source;     ///< Signal connected to an audio input
+	unsigned        buffer;     ///< Index of an audio output buffer
 } Port;
 
-/** Application state */
+/** A plugin in the processing chain */
 typedef struct {
-	LilvWorld*        world;
+	const char*       uri;            ///< Plugin URI
+	const char*       name;           ///< Name for referring to outputs
+	const char*       state_path;     ///< State file to restore, or NULL
 	const LilvPlugin* plugin;
-	LilvInstance*     instance;
-	const char*       in_path;
-	const char*       out_path;
-	SNDFILE*          in_file;
-	SNDFILE*          out_file;
-	unsigned          n_params;
-	Param*            params;
+	LilvState*        state;
 	unsigned          n_ports;
 	unsigned          n_audio_in;
 	unsigned          n_audio_out;
 	Port*             ports;
+	unsigned          first_control;  ///< Index of first control in a job
+	unsigned          first_buffer;   ///< Index of first output in a job
+	bool              routed;         ///< True iff inputs set in chain file
+} Stage;
+
+/** Application state */
+typedef struct {
+	LilvWorld*         world;
+	LilvURIDMap*       urid_map;
+	LV2_Feature        map_feature;
+	LV2_Feature        unmap_feature;
+	const LV2_Feature* features[3];
+	LV2_URID           atom_Float;
+	const char*        out_path;    ///< Output file, or directory for a batch
+	unsigned           n_inputs;
+	const char**       in_paths;
+	unsigned           n_params;
+	Param*             params;
+	unsigned           n_routes;
+	Route*             routes;
+	unsigned           n_stages;
+	Stage*             stages;        ///< Plugins in processing order
+	unsigned           n_outputs;
+	Source*            outputs;       ///< Signal of each output channel
+	unsigned           n_controls;    ///< Total number of ports of all plugins
+	unsigned           n_buffers;     ///< Total audio outputs of all plugins
+	unsigned           n_strings;
+	char**             strings;       ///< Strings read from chain files
+	uint32_t           block_size;    ///< Frames processed per run() call
+	unsigned           n_jobs;        ///< Number of files processed at once
+	unsigned           next_input;    ///< Index of next batch input to process
+	int                status;        ///< Status of first failed batch job
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t    mutex;         ///< Protects instances and batch state
+#endif
 } LV2Apply;
 
+/** State of a block in the processing pipeline */
+typedef enum {
+	BLOCK_EMPTY,      ///< Free for the reader
+	BLOCK_READ,       ///< Read, ready to be processed
+	BLOCK_PROCESSED   ///< Processed, ready to be written
+} BlockState;
+
+/** A block of interleaved input and output frames */
+typedef struct {
+	float*     in;        ///< Interleaved input frames
+	float*     out;       ///< Interleaved output frames
+	sf_count_t n_frames;  ///< Number of frames in block
+	BlockState state;
+} Block;
+
+/** Processing of one input file to one output file */
+typedef struct {
+	LV2Apply*       app;
+	const char*     in_path;
+	const char*     out_path;
+	SNDFILE*        in_file;
+	SNDFILE*        out_file;
+	unsigned        in_chans;     ///< Number of channels in input file
+	LilvInstance**  instances;    ///< Instance of each plugin in the chain
+	LilvGraph*      graph;        ///< Graph of instances
+	float*          controls;     ///< Control value of each port
+	float*          audio;        ///< Non-interleaved audio buffers
+	Block           blocks[N_BLOCKS];
+	unsigned        n_blocks;     ///< Number of blocks in the ring
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t mutex;        ///< Protects block states and flags
+	pthread_cond_t  cond;         ///< Signalled when a block state changes
+#endif
+	uint64_t        n_read;       ///< Number of blocks read so far
+	bool            eof;          ///< True when all input has been read
+	int             status;       ///< Non-zero if processing failed
+} Job;
+
+/** Plugin controls to restore state to */
+typedef struct {
+	const LV2Apply* app;
+	const Stage*    stage;
+	float*          controls;
+} StateTarget;
+
 static int fatal(LV2Apply* self, int status, const char* fmt, ...);
 
+/** Print an error message. */
+static int
+print_error(int status, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	fprintf(stderr, "error: ");
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	return status;
+}
+
 /** Open a sound file with error handling. */
 static SNDFILE*
-sopen(LV2Apply* self, const char* path, int mode, SF_INFO* fmt)
+sopen(const char* path, int mode, SF_INFO* fmt)
 {
 	SNDFILE*  file = sf_open(path, mode, fmt);
 	const int st   = sf_error(file);
 	if (st) {
-		fatal(self, 1, "Failed to open %s (%s)\n", path, sf_error_number(st));
+		print_error(1, "Failed to open %s (%s)\n", path, sf_error_number(st));
+		if (file) {
+			sf_close(file);
+		}
 		return NULL;
 	}
 	return file;
 }
 
 /** Close a sound file with error handling. */
-static void
+static int
 sclose(const char* path, SNDFILE* file)
 {
 	int st;
 	if (file && (st = sf_close(file))) {
-		fatal(NULL, 1, "Failed to close %s (%s)\n", path, sf_error_number(st));
+		return print_error(
+			1, "Failed to close %s (%s)\n", path, sf_error_number(st));
 	}
+	return 0;
 }
 
-/**
-   Read a single frame from a file into an interleaved buffer.
+static void
+lock(LV2Apply* self)
+{
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&self->mutex);
+#endif
+}
 
-   If more channels are required than are available in the file, the remaining
-   channels are distributed in a round-robin fashion (LRLRL).
-*/
-static bool
-sread(SNDFILE* file, unsigned file_chans, float* buf, unsigned buf_chans)
+static void
+unlock(LV2Apply* self)
 {
-	const sf_count_t n_read = sf_readf_float(file, buf, 1);
-	for (unsigned i = file_chans - 1; i < buf_chans; ++i) {
-		buf[i] = buf[i % file_chans];
-	}
-	return n_read == 1;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&self->mutex);
+#endif
 }
 
 /** Clean up all resources. */
 static int
 cleanup(int status, LV2Apply* self)
 {
-	sclose(self->in_path, self->in_file);
-	sclose(self->out_path, self->out_file);
-	lilv_instance_free(self->instance);
+#ifdef HAVE_PTHREAD
+	pthread_mutex_destroy(&self->mutex);
+#endif
+	for (unsigned i = 0; i < self->n_stages; ++i) {
+		lilv_state_free(self->stages[i].state);
+		free(self->stages[i].ports);
+	}
+	for (unsigned i = 0; i < self->n_strings; ++i) {
+		free(self->strings[i]);
+	}
 	lilv_world_free(self->world);
-	free(self->ports);
+	lilv_urid_map_free(self->urid_map);
+	free(self->stages);
+	free(self->outputs);
+	free(self->strings);
+	free(self->routes);
 	free(self->params);
+	free(self->in_paths);
 	return status;
 }
 
@@ -129,71 +277,909 @@ fatal(LV2Apply* self, int status, const char* fmt, ...)
 	return self ? cleanup(status, self) : status;
 }
 
+/** Return a copy of `str` that is freed with the application. */
+static const char*
+keep(LV2Apply* self, const char* str)
+{
+	char* const copy = (char*)malloc(strlen(str) + 1);
+	memcpy(copy, str, strlen(str) + 1);
+	self->strings = (char**)realloc(
+		self->strings, ++self->n_strings * sizeof(char*));
+	self->strings[self->n_strings - 1] = copy;
+	return copy;
+}
+
+/** Return the index of the plugin most recently added to the chain. */
+static unsigned
+current_stage(const LV2Apply* self)
+{
+	return self->n_stages ? self->n_stages - 1 : 0;
+}
+
 /**
-   Create port structures from data (via create_port()) for all ports.
+   Add a plugin to the end of the chain.
+
+   Options given before the first plugin create an empty first stage, which
+   is then used by the first plugin added.
+*/
+static Stage*
+add_stage(LV2Apply* self, const char* uri, const char* name)
+{
+	Stage* stage = NULL;
+	if (self->n_stages == 1 && !self->stages[0].uri) {
+		stage = &self->stages[0];
+	} else {
+		self->stages = (Stage*)realloc(
+			self->stages, ++self->n_stages * sizeof(Stage));
+		stage = &self->stages[self->n_stages - 1];
+		memset(stage, '\0', sizeof(Stage));
+	}
+
+	if (!name) {
+		char num[16];
+		snprintf(num, sizeof(num), "%u", (unsigned)(stage - self->stages) + 1);
+		name = keep(self, num);
+	}
+
+	stage->uri  = uri;
+	stage->name = name;
+	return stage;
+}
+
+/** Return the stage that options apply to, creating an empty one if needed. */
+static Stage*
+option_stage(LV2Apply* self)
+{
+	if (!self->n_stages) {
+		add_stage(self, NULL, NULL);
+	}
+	return &self->stages[current_stage(self)];
+}
+
+static void
+add_param(LV2Apply* self, const char* sym, float value)
+{
+	option_stage(self);
+	self->params = (Param*)realloc(self->params,
+	                               ++self->n_params * sizeof(Param));
+	self->params[self->n_params - 1].stage = current_stage(self);
+	self->params[self->n_params - 1].sym   = sym;
+	self->params[self->n_params - 1].value = value;
+}
+
+static void
+add_route(LV2Apply* self, const char* sym, const char* from)
+{
+	self->routes = (Route*)realloc(self->routes,
+	                               ++self->n_routes * sizeof(Route));
+	self->routes[self->n_routes - 1].stage = current_stage(self);
+	self->routes[self->n_routes - 1].sym   = sym;
+	self->routes[self->n_routes - 1].from  = from;
+	if (sym) {
+		self->stages[current_stage(self)].routed = true;
+	}
+}
+
+/** Return `rel` relative to the directory of the chain file at `path`. */
+static const char*
+chain_path(LV2Apply* self, const char* path, const char* rel)
+{
+	const char* const slash = strrchr(path, '/');
+	if (rel[0] == '/' || !slash) {
+		return rel;
+	}
+
+	const size_t dir_len = (size_t)(slash - path) + 1;
+	char* const  joined  = (char*)malloc(dir_len + strlen(rel) + 1);
+	memcpy(joined, path, dir_len);
+	strcpy(joined + dir_len, rel);
+
+	const char* const result = keep(self, joined);
+	free(joined);
+	return result;
+}
+
+/**
+   Load a chain file.
+
+   Each line is a command followed by whitespace separated arguments, and
+   everything from a word that starts with `#` is ignored:
+
+   plugin URI [NAME]     Add a plugin to the chain
+   control SYM VAL       Set a control of the last plugin
+   state PATH            Restore the last plugin from a state file
+                         (relative to the chain file)
+   input SYM SOURCE      Connect an audio input of the last plugin
+   output SOURCE         Add an output channel
+
+   A source is "in:N" for channel N of the input file (from 1), "NAME:SYM" for
+   an audio output of an earlier plugin, or "silence".
 */
 static int
-create_ports(LV2Apply* self)
+load_chain(LV2Apply* self, const char* path)
 {
-	LilvWorld*     world   = self->world;
-	const uint32_t n_ports = lilv_plugin_get_num_ports(self->plugin);
+	FILE* fd = fopen(path, "r");
+	if (!fd) {
+		return print_error(1, "Failed to open chain file %s\n", path);
+	}
 
-	self->n_ports = n_ports;
-	self->ports   = (Port*)calloc(self->n_ports, sizeof(Port));
+	char     line[4096];
+	unsigned line_num = 0;
+	int      st       = 0;
+	while (!st && fgets(line, sizeof(line), fd)) {
+		++line_num;
 
-	/* Get default values for all ports */
-	float* values = (float*)calloc(n_ports, sizeof(float));
-	lilv_plugin_get_port_ranges_float(self->plugin, NULL, NULL, values);
+		/* Strip comment, which must start a word since URIs contain '#' */
+		for (char* c = line; *c; ++c) {
+			if (*c == '#' && (c == line || isspace((unsigned char)c[-1]))) {
+				*c = '\0';
+				break;
+			}
+		}
 
-	LilvNode* lv2_InputPort          = lilv_new_uri(world, LV2_CORE__InputPort);
-	LilvNode* lv2_OutputPort         = lilv_new_uri(world, LV2_CORE__OutputPort);
-	LilvNode* lv2_AudioPort          = lilv_new_uri(world, LV2_CORE__AudioPort);
-	LilvNode* lv2_ControlPort        = lilv_new_uri(world, LV2_CORE__ControlPort);
-	LilvNode* lv2_connectionOptional = lilv_new_uri(world, LV2_CORE__connectionOptional);
+		char*       save    = NULL;
+		const char* args[4] = { NULL, NULL, NULL, NULL };
+		unsigned    n_args  = 0;
+		for (char* tok = strtok_r(line, " \t\r\n", &save); tok;
+		     tok = strtok_r(NULL, " \t\r\n", &save)) {
+			if (n_args == 4) {
+				st = print_error(1, "%s:%u: Too many arguments\n",
+				                 path, line_num);
+				break;
+			}
+			args[n_args++] = keep(self, tok);
+		}
 
-	for (uint32_t i = 0; i < n_ports; ++i) {
-		Port*           port  = &self->ports[i];
-		const LilvPort* lport = lilv_plugin_get_port_by_index(self->plugin, i);
+		const char* const cmd = args[0];
+		if (st || !cmd) {
+			continue;
+		} else if (!strcmp(cmd, "plugin") && (n_args == 2 || n_args == 3)) {
+			add_stage(self, args[1], args[2]);
+		} else if (!self->n_stages || !self->stages[0].uri) {
+			st = print_error(1, "%s:%u: `%s' before any plugin\n",
+			                 path, line_num, cmd);
+		} else if (!strcmp(cmd, "control") && n_args == 3) {
+			add_param(self, args[1], (float)atof(args[2]));
+		} else if (!strcmp(cmd, "state") && n_args == 2) {
+			self->stages[current_stage(self)].state_path =
+				chain_path(self, path, args[1]);
+		} else if (!strcmp(cmd, "input") && n_args == 3) {
+			add_route(self, args[1], args[2]);
+		} else if (!strcmp(cmd, "output") && n_args == 2) {
+			add_route(self, NULL, args[1]);
+		} else {
+			st = print_error(1, "%s:%u: Invalid command `%s'\n",
+			                 path, line_num, cmd);
+		}
+	}
+
+	fclose(fd);
+	return st;
+}
+
+/**
+   Create port structures from data (via create_port()) for all ports.
+*/
+static int
+create_ports(LV2Apply* self, Stage* stage)
+{
+	const LilvPortTable* table = lilv_plugin_get_port_table(stage->plugin);
+	if (!table) {
+		return fatal(self, 1, "Plugin <%s> has invalid ports\n", stage->uri);
+	}
+
+	stage->n_ports = table->n_ports;
+	stage->ports   = (Port*)calloc(stage->n_ports, sizeof(Port));
+
+	for (uint32_t i = 0; i < table->n_ports; ++i) {
+		Port*          port  = &stage->ports[i];
+		const uint32_t types = table->types[i];
 
-		port->lilv_port = lport;
+		port->lilv_port = lilv_plugin_get_port_by_index(stage->plugin, i);
 		port->index     = i;
-		port->value     = isnan(values[i]) ? values[i] : 0.0f;
-		port->optional  = lilv_port_has_property(
-			self->plugin, lport, lv2_connectionOptional);
+		port->value     = isnan(table->def_values[i]) ? 0.0f : table->def_values[i];
+		port->optional  = table->properties[i] & LILV_PORT_CONNECTION_OPTIONAL;
 
 		/* Check if port is an input or output */
-		if (lilv_port_is_a(self->plugin, lport, lv2_InputPort)) {
+		if (types & LILV_PORT_INPUT) {
 			port->is_input = true;
-		} else if (!lilv_port_is_a(self->plugin, lport, lv2_OutputPort) &&
-		           !port->optional) {
+		} else if (!(types & LILV_PORT_OUTPUT) && !port->optional) {
 			return fatal(self, 1, "Port %d is neither input nor output\n", i);
 		}
 
 		/* Check if port is an audio or control port */
-		if (lilv_port_is_a(self->plugin, lport, lv2_ControlPort)) {
+		if (types & LILV_PORT_CONTROL) {
 			port->type = TYPE_CONTROL;
-		} else if (lilv_port_is_a(self->plugin, lport, lv2_AudioPort)) {
+		} else if (types & LILV_PORT_AUDIO) {
 			port->type = TYPE_AUDIO;
 			if (port->is_input) {
-				++self->n_audio_in;
+				++stage->n_audio_in;
 			} else {
-				++self->n_audio_out;
+				port->buffer = stage->n_audio_out++;
 			}
 		} else if (!port->optional) {
 			return fatal(self, 1, "Port %d has unsupported type\n", i);
 		}
 	}
 
-	lilv_node_free(lv2_connectionOptional);
-	lilv_node_free(lv2_ControlPort);
-	lilv_node_free(lv2_AudioPort);
-	lilv_node_free(lv2_OutputPort);
-	lilv_node_free(lv2_InputPort);
-	free(values);
+	return 0;
+}
+
+/** Return the port of a stage with the given symbol, or NULL. */
+static Port*
+find_port(LV2Apply* self, const Stage* stage, const char* sym)
+{
+	LilvNode*       node = lilv_new_string(self->world, sym);
+	const LilvPort* port = lilv_plugin_get_port_by_symbol(stage->plugin, node);
+	lilv_node_free(node);
+	return port ? &stage->ports[lilv_port_get_index(stage->plugin, port)] : NULL;
+}
+
+/** Return the index of the `n`th audio output port of a stage. */
+static uint32_t
+audio_output(const Stage* stage, unsigned n)
+{
+	for (uint32_t p = 0; p < stage->n_ports; ++p) {
+		const Port* const port = &stage->ports[p];
+		if (port->type == TYPE_AUDIO && !port->is_input && port->buffer == n) {
+			return p;
+		}
+	}
+	return 0;
+}
+
+/** Parse a chain file source, which may use plugins before `n_stages`. */
+static int
+parse_source(LV2Apply* self, const char* from, unsigned n_stages,
+             Source* source)
+{
+	const char* const colon = strrchr(from, ':');
+	if (!strcmp(from, "silence")) {
+		source->type = SOURCE_SILENCE;
+		return 0;
+	} else if (!colon) {
+		return print_error(1, "Invalid source `%s'\n", from);
+	}
+
+	const size_t name_len = (size_t)(colon - from);
+	if (name_len == 2 && !strncmp(from, "in", 2)) {
+		const int chan = atoi(colon + 1);
+		if (chan <= 0) {
+			return print_error(1, "Invalid input channel `%s'\n", from);
+		}
+		source->type  = SOURCE_INPUT;
+		source->index = (uint32_t)chan - 1;
+		return 0;
+	}
+
+	for (unsigned s = 0; s < n_stages; ++s) {
+		const Stage* const stage = &self->stages[s];
+		if (strlen(stage->name) == name_len &&
+		    !strncmp(from, stage->name, name_len)) {
+			const Port* const port = find_port(self, stage, colon + 1);
+			if (!port || port->type != TYPE_AUDIO || port->is_input) {
+				return print_error(
+					7, "No audio output `%s' on `%s'\n", colon + 1, stage->name);
+			}
+			source->type  = SOURCE_PLUGIN;
+			source->stage = s;
+			source->index = port->index;
+			return 0;
+		}
+	}
+
+	return print_error(1, "No earlier plugin for source `%s'\n", from);
+}
+
+/** Find the plugin of a stage, set its controls, and connect its inputs. */
+static int
+setup_stage(LV2Apply* self, unsigned s)
+{
+	Stage* const stage = &self->stages[s];
+
+	/* Get plugin */
+	LilvNode* uri = lilv_new_uri(self->world, stage->uri);
+	if (!uri) {
+		return fatal(self, 2, "Invalid plugin URI <%s>\n", stage->uri);
+	}
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(self->world);
+	stage->plugin = lilv_plugins_get_by_uri(plugins, uri);
+	lilv_node_free(uri);
+	if (!stage->plugin) {
+		return fatal(self, 3, "Plugin <%s> not found\n", stage->uri);
+	}
+
+	/* Create port structures */
+	if (create_ports(self, stage)) {
+		return 5;
+	}
+
+	stage->first_control = self->n_controls;
+	stage->first_buffer  = self->n_buffers;
+	self->n_controls += stage->n_ports;
+	self->n_buffers  += stage->n_audio_out;
+
+	/* Set control values */
+	for (unsigned i = 0; i < self->n_params; ++i) {
+		const Param* param = &self->params[i];
+		if (param->stage == s) {
+			Port* const port = find_port(self, stage, param->sym);
+			if (!port) {
+				return fatal(self, 7, "Unknown port `%s'\n", param->sym);
+			}
+			port->value  = param->value;
+			port->is_set = true;
+		}
+	}
+
+	/* Connect audio inputs to the previous plugin by default */
+	const Stage* const prev = s ? &self->stages[s - 1] : NULL;
+	for (uint32_t p = 0, i = 0; p < stage->n_ports && !stage->routed; ++p) {
+		Port* const port = &stage->ports[p];
+		if (port->type != TYPE_AUDIO || !port->is_input) {
+			continue;
+		} else if (!prev) {
+			port->source.type  = SOURCE_INPUT;
+			port->source.index = i;
+			port->source.wrap  = true;
+		} else if (prev->n_audio_out) {
+			port->source.type  = SOURCE_PLUGIN;
+			port->source.stage = s - 1;
+			port->source.index = audio_output(prev, i % prev->n_audio_out);
+		}
+		++i;
+	}
+
+	/* Connect audio inputs given in a chain file */
+	for (unsigned i = 0; i < self->n_routes; ++i) {
+		const Route* route = &self->routes[i];
+		if (route->stage == s && route->sym) {
+			Port* const port = find_port(self, stage, route->sym);
+			if (!port || port->type != TYPE_AUDIO || !port->is_input) {
+				return fatal(self, 7, "No audio input `%s' on `%s'\n",
+				             route->sym, stage->name);
+			} else if (parse_source(self, route->from, s, &port->source)) {
+				return cleanup(1, self);
+			}
+		}
+	}
+
+	/* Load state */
+	if (stage->state_path) {
+		LV2_URID_Map* map = lilv_urid_map_get_map(self->urid_map);
+		stage->state = lilv_state_new_from_file(
+			self->world, map, NULL, stage->state_path);
+		if (!stage->state) {
+			return fatal(self, 13, "Failed to load state from %s\n",
+			             stage->state_path);
+		} else if (!lilv_node_equals(lilv_state_get_plugin_uri(stage->state),
+		                             lilv_plugin_get_uri(stage->plugin))) {
+			return fatal(self, 13, "State %s is not for <%s>\n",
+			             stage->state_path, stage->uri);
+		}
+	}
+
+	return 0;
+}
+
+/** Set the output channels to the chain file outputs or the last plugin. */
+static int
+setup_outputs(LV2Apply* self)
+{
+	for (unsigned i = 0; i < self->n_routes; ++i) {
+		const Route* route = &self->routes[i];
+		if (!route->sym) {
+			self->outputs = (Source*)realloc(
+				self->outputs, ++self->n_outputs * sizeof(Source));
+			Source* const source = &self->outputs[self->n_outputs - 1];
+			memset(source, '\0', sizeof(Source));
+			if (parse_source(self, route->from, self->n_stages, source)) {
+				return cleanup(1, self);
+			}
+		}
+	}
+
+	if (!self->n_outputs) {
+		const unsigned     last  = self->n_stages - 1;
+		const Stage* const stage = &self->stages[last];
+		self->n_outputs = stage->n_audio_out;
+		self->outputs   = (Source*)calloc(self->n_outputs, sizeof(Source));
+		for (unsigned i = 0; i < self->n_outputs; ++i) {
+			self->outputs[i].type  = SOURCE_PLUGIN;
+			self->outputs[i].stage = last;
+			self->outputs[i].index = audio_output(stage, i);
+		}
+	}
 
 	return 0;
 }
 
+/** Return the buffer of a job for a source. */
+static float*
+job_buffer(const Job* job, const Source* source)
+{
+	const LV2Apply* const app  = job->app;
+	const size_t          size = app->block_size;
+	switch (source->type) {
+	case SOURCE_SILENCE:
+		break;
+	case SOURCE_INPUT:
+		return job->audio + size * (source->index % job->in_chans);
+	case SOURCE_PLUGIN: {
+		const Stage* const stage = &app->stages[source->stage];
+		const Port* const  port  = &stage->ports[source->index];
+		return job->audio +
+			size * (job->in_chans + stage->first_buffer + port->buffer);
+	}
+	}
+	return job->audio + size * (job->in_chans + app->n_buffers);
+}
+
+/** Return an error if a source needs an input channel the job lacks. */
+static int
+job_check_source(const Job* job, const Source* source)
+{
+	if (source->type == SOURCE_INPUT && !source->wrap &&
+	    source->index >= job->in_chans) {
+		return print_error(6, "No channel %u in %s\n",
+		                   source->index + 1, job->in_path);
+	}
+	return 0;
+}
+
+/** Set a control port from restored state. */
+static void
+set_port_value(const char* port_symbol,
+               void*       user_data,
+               const void* value,
+               uint32_t    size,
+               uint32_t    type)
+{
+	StateTarget* const target = (StateTarget*)user_data;
+	const Port* const  port   = find_port(
+		(LV2Apply*)target->app, target->stage, port_symbol);
+	if (!port || port->type != TYPE_CONTROL) {
+		fprintf(stderr, "warning: Ignoring state of port `%s'\n", port_symbol);
+	} else if (type != target->app->atom_Float || size != sizeof(float)) {
+		fprintf(stderr, "warning: Ignoring non-float port `%s'\n", port_symbol);
+	} else {
+		target->controls[port->index] = *(const float*)value;
+	}
+}
+
+/** Free all resources used by a job and return its status. */
+static int
+job_cleanup(Job* job)
+{
+	if (sclose(job->in_path, job->in_file) && !job->status) {
+		job->status = 1;
+	}
+	if (sclose(job->out_path, job->out_file) && !job->status) {
+		job->status = 9;
+	}
+	lilv_graph_free(job->graph);
+	for (unsigned s = 0; job->instances && s < job->app->n_stages; ++s) {
+		if (job->instances[s]) {
+			lilv_instance_deactivate(job->instances[s]);
+			lock(job->app);
+			lilv_instance_free(job->instances[s]);
+			unlock(job->app);
+		}
+	}
+	for (unsigned i = 0; i < job->n_blocks; ++i) {
+		free(job->blocks[i].in);
+		free(job->blocks[i].out);
+	}
+	free(job->instances);
+	free(job->audio);
+	free(job->controls);
+	return job->status;
+}
+
+/** Instantiate a plugin in the chain and connect its ports. */
+static int
+job_init_stage(Job* job, unsigned s, double rate)
+{
+	LV2Apply* const    app      = job->app;
+	const Stage* const stage    = &app->stages[s];
+	float* const       controls = job->controls + stage->first_control;
+
+	for (uint32_t p = 0; p < stage->n_ports; ++p) {
+		controls[p] = stage->ports[p].value;
+	}
+
+	/* Instantiate plugin and restore state (which lilv does not allow
+	   concurrently) */
+	lock(app);
+	LilvInstance* const instance = job->instances[s] =
+		lilv_plugin_instantiate(stage->plugin, rate, app->features);
+	if (instance && stage->state) {
+		StateTarget target = { app, stage, controls };
+		lilv_state_restore(stage->state, instance, set_port_value, &target,
+		                   0, app->features);
+	}
+	unlock(app);
+	if (!instance) {
+		return print_error(11, "Failed to instantiate <%s>\n", stage->uri);
+	} else if (lilv_graph_add(job->graph, stage->plugin, instance) != (int)s) {
+		return print_error(11, "Failed to add <%s> to graph\n", stage->uri);
+	}
+
+	/* Connect ports, sharing buffers with earlier plugins where possible */
+	for (uint32_t p = 0; p < stage->n_ports; ++p) {
+		const Port* const port = &stage->ports[p];
+		if (port->type == TYPE_CONTROL) {
+			if (port->is_set) {
+				controls[p] = port->value;
+			}
+			lilv_graph_connect_port(job->graph, s, p, &controls[p]);
+		} else if (port->type == TYPE_AUDIO && port->is_input) {
+			const Source* const source = &port->source;
+			float* const        buf    = job_buffer(job, source);
+			int                 st     = job_check_source(job, source);
+			if (!st && source->type == SOURCE_PLUGIN) {
+				st = lilv_graph_connect(job->graph, source->stage,
+				                        source->index, s, p, buf) ? 11 : 0;
+			} else if (!st) {
+				lilv_graph_connect_port(job->graph, s, p, buf);
+			}
+			if (st) {
+				return st;
+			}
+		} else if (port->type == TYPE_AUDIO) {
+			Source source = { SOURCE_PLUGIN, s, p, false };
+			lilv_graph_connect_port(job->graph, s, p, job_buffer(job, &source));
+		} else {
+			lilv_graph_connect_port(job->graph, s, p, NULL);
+		}
+	}
+
+	lilv_instance_activate(instance);
+	return 0;
+}
+
+/** Open files, instantiate the plugins, and connect ports for a job. */
+static int
+job_init(Job* job, LV2Apply* app, const char* in_path,
+         const char* out_path, unsigned n_blocks)
+{
+	const uint32_t block_size = app->block_size;
+
+	memset(job, '\0', sizeof(Job));
+	job->app      = app;
+	job->in_path  = in_path;
+	job->out_path = out_path;
+	job->n_blocks = n_blocks;
+
+	/* Open input file */
+	SF_INFO in_fmt = { 0, 0, 0, 0, 0, 0 };
+	if (!(job->in_file = sopen(in_path, SFM_READ, &in_fmt))) {
+		return (job->status = 4);
+	}
+
+	const Stage* const first = &app->stages[0];
+	job->in_chans = (unsigned)in_fmt.channels;
+	if (!first->routed &&
+	    in_fmt.channels != (int)first->n_audio_in && in_fmt.channels != 1) {
+		return (job->status = print_error(6, "Unable to map %d inputs to %d ports\n",
+		                            in_fmt.channels, first->n_audio_in));
+	}
+	for (unsigned i = 0; i < app->n_outputs; ++i) {
+		if ((job->status = job_check_source(job, &app->outputs[i]))) {
+			return job->status;
+		}
+	}
+
+	/* Open output file */
+	SF_INFO out_fmt = in_fmt;
+	out_fmt.channels = app->n_outputs;
+	if (!(job->out_file = sopen(out_path, SFM_WRITE, &out_fmt))) {
+		return (job->status = 8);
+	}
+
+	/* Allocate buffers for input channels, plugin outputs, and silence */
+	job->instances = (LilvInstance**)calloc(app->n_stages,
+	                                        sizeof(LilvInstance*));
+	job->controls  = (float*)calloc(app->n_controls + 1, sizeof(float));
+	job->audio     = (float*)calloc(
+		(size_t)(job->in_chans + app->n_buffers + 1) * block_size,
+		sizeof(float));
+	for (unsigned i = 0; i < n_blocks; ++i) {
+		job->blocks[i].in = (float*)calloc(
+			(size_t)job->in_chans * block_size, sizeof(float));
+		job->blocks[i].out = (float*)calloc(
+			(size_t)app->n_outputs * block_size + 1, sizeof(float));
+		if (!job->blocks[i].in || !job->blocks[i].out) {
+			return (job->status = print_error(10, "Out of memory\n"));
+		}
+	}
+	if (!job->instances || !job->controls || !job->audio) {
+		return (job->status = print_error(10, "Out of memory\n"));
+	}
+
+	/* Instantiate plugins, which run in order on the processing thread */
+	job->graph = lilv_graph_new(0, false);
+	for (unsigned s = 0; s < app->n_stages; ++s) {
+		if ((job->status = job_init_stage(job, s, in_fmt.samplerate))) {
+			return job->status;
+		}
+	}
+
+	return 0;
+}
+
+/**
+   Read a block of frames from the input file.
+
+   Returns the number of frames read, which is zero at the end of the file.
+*/
+static sf_count_t
+job_read(Job* job, Block* block)
+{
+	block->n_frames = sf_readf_float(
+		job->in_file, block->in, job->app->block_size);
+	return block->n_frames > 0 ? block->n_frames : 0;
+}
+
+/**
+   Run the plugin chain on a block of frames.
+
+   The interleaved input is split into a buffer for every channel, which
+   plugin inputs are connected to directly.  If the first plugin requires more
+   channels than are available in the file, the remaining channels are
+   distributed in a round-robin fashion (LRLRL).
+*/
+static void
+job_process(Job* job, Block* block)
+{
+	const LV2Apply* const app        = job->app;
+	const uint32_t        block_size = app->block_size;
+	const unsigned        in_chans   = job->in_chans;
+	const sf_count_t      n_frames   = block->n_frames;
+
+	for (unsigned c = 0; c < in_chans; ++c) {
+		const float* const src = block->in + c;
+		float* const       dst = job->audio + (size_t)block_size * c;
+		for (sf_count_t f = 0; f < n_frames; ++f) {
+			dst[f] = src[f * in_chans];
+		}
+	}
+
+	lilv_graph_run(job->graph, (uint32_t)n_frames);
+
+	for (unsigned c = 0; c < app->n_outputs; ++c) {
+		const float* const src = job_buffer(job, &app->outputs[c]);
+		float* const       dst = block->out + c;
+		for (sf_count_t f = 0; f < n_frames; ++f) {
+			dst[f * app->n_outputs] = src[f];
+		}
+	}
+}
+
+/** Write a processed block to the output file, return zero on success. */
+static int
+job_write(Job* job, const Block* block)
+{
+	if (sf_writef_float(job->out_file, block->out, block->n_frames) !=
+	    block->n_frames) {
+		return print_error(9, "Failed to write to %s\n", job->out_path);
+	}
+	return 0;
+}
+
+/** Read, process, and write every block of a job in turn. */
+static int
+job_run_serial(Job* job)
+{
+	Block* const block = &job->blocks[0];
+	while (!job->status && job_read(job, block)) {
+		job_process(job, block);
+		job->status = job_write(job, block);
+	}
+	return job->status;
+}
+
+#ifdef HAVE_PTHREAD
+
+/*
+  A pipelined job reads, processes, and writes blocks at the same time on
+  three threads.  Blocks are used in order as a ring, so each thread waits
+  for the next block to reach the state it handles, then passes it on.
+*/
+
+/** Wait for block `n` to be in `state`, return false if the job is over. */
+static bool
+job_wait(Job* job, uint64_t n, BlockState state)
+{
+	Block* const block = &job->blocks[n % job->n_blocks];
+	pthread_mutex_lock(&job->mutex);
+	while (block->state != state && !job->status &&
+	       !(job->eof && n >= job->n_read)) {
+		pthread_cond_wait(&job->cond, &job->mutex);
+	}
+	const bool ready = block->state == state && !job->status;
+	pthread_mutex_unlock(&job->mutex);
+	return ready;
+}
+
+/** Set the state of block `n` and wake the other threads. */
+static void
+job_pass(Job* job, uint64_t n, BlockState state)
+{
+	pthread_mutex_lock(&job->mutex);
+	job->blocks[n % job->n_blocks].state = state;
+	pthread_cond_broadcast(&job->cond);
+	pthread_mutex_unlock(&job->mutex);
+}
+
+static void*
+job_reader(void* data)
+{
+	Job* const job = (Job*)data;
+	for (uint64_t n = 0; job_wait(job, n, BLOCK_EMPTY); ++n) {
+		Block* const block = &job->blocks[n % job->n_blocks];
+		if (!job_read(job, block)) {
+			break;
+		}
+
+		pthread_mutex_lock(&job->mutex);
+		block->state = BLOCK_READ;
+		job->n_read  = n + 1;
+		pthread_cond_broadcast(&job->cond);
+		pthread_mutex_unlock(&job->mutex);
+	}
+
+	pthread_mutex_lock(&job->mutex);
+	job->eof = true;
+	pthread_cond_broadcast(&job->cond);
+	pthread_mutex_unlock(&job->mutex);
+	return NULL;
+}
+
+static void*
+job_writer(void* data)
+{
+	Job* const job = (Job*)data;
+	for (uint64_t n = 0; job_wait(job, n, BLOCK_PROCESSED); ++n) {
+		const int st = job_write(job, &job->blocks[n % job->n_blocks]);
+		if (st) {
+			pthread_mutex_lock(&job->mutex);
+			job->status = st;
+			pthread_cond_broadcast(&job->cond);
+			pthread_mutex_unlock(&job->mutex);
+			break;
+		}
+		job_pass(job, n, BLOCK_EMPTY);
+	}
+	return NULL;
+}
+
+/** Process a job with reading and writing on separate threads. */
+static int
+job_run_pipelined(Job* job)
+{
+	pthread_t reader;
+	pthread_t writer;
+	pthread_mutex_init(&job->mutex, NULL);
+	pthread_cond_init(&job->cond, NULL);
+	if (pthread_create(&reader, NULL, job_reader, job)) {
+		pthread_cond_destroy(&job->cond);
+		pthread_mutex_destroy(&job->mutex);
+		return job_run_serial(job);
+	} else if (pthread_create(&writer, NULL, job_writer, job)) {
+		pthread_mutex_lock(&job->mutex);
+		job->status = print_error(12, "Failed to create writer thread\n");
+		pthread_cond_broadcast(&job->cond);
+		pthread_mutex_unlock(&job->mutex);
+		pthread_join(reader, NULL);
+		pthread_cond_destroy(&job->cond);
+		pthread_mutex_destroy(&job->mutex);
+		return job->status;
+	}
+
+	for (uint64_t n = 0; job_wait(job, n, BLOCK_READ); ++n) {
+		job_process(job, &job->blocks[n % job->n_blocks]);
+		job_pass(job, n, BLOCK_PROCESSED);
+	}
+
+	pthread_join(reader, NULL);
+	pthread_join(writer, NULL);
+	pthread_cond_destroy(&job->cond);
+	pthread_mutex_destroy(&job->mutex);
+	return job->status;
+}
+
+#endif
+
+/** Process one input file to one output file, return zero on success. */
+static int
+apply(LV2Apply* app, const char* in_path, const char* out_path,
+      bool pipelined)
+{
+	Job job;
+#ifdef HAVE_PTHREAD
+	if (!job_init(&job, app, in_path, out_path, pipelined ? N_BLOCKS : 1)) {
+		if (pipelined) {
+			job_run_pipelined(&job);
+		} else {
+			job_run_serial(&job);
+		}
+	}
+#else
+	(void)pipelined;
+	if (!job_init(&job, app, in_path, out_path, 1)) {
+		job_run_serial(&job);
+	}
+#endif
+	return job_cleanup(&job);
+}
+
+/** Return the path of the output file for a batch input. */
+static char*
+batch_out_path(const LV2Apply* app, const char* in_path)
+{
+	const char* base = strrchr(in_path, '/');
+	base = base ? base + 1 : in_path;
+
+	char* path = (char*)malloc(strlen(app->out_path) + strlen(base) + 2);
+	sprintf(path, "%s/%s", app->out_path, base);
+	return path;
+}
+
+/** Process batch inputs until there are none left. */
+static void*
+batch_worker(void* data)
+{
+	LV2Apply* const app = (LV2Apply*)data;
+	for (;;) {
+		lock(app);
+		const unsigned i = app->next_input++;
+		unlock(app);
+		if (i >= app->n_inputs) {
+			break;
+		}
+
+		char* const out_path = batch_out_path(app, app->in_paths[i]);
+		const int   st       = apply(app, app->in_paths[i], out_path, false);
+		free(out_path);
+		if (st) {
+			lock(app);
+			app->status = app->status ? app->status : st;
+			unlock(app);
+		}
+	}
+	return NULL;
+}
+
+/** Process all batch inputs with `app->n_jobs` at a time. */
+static int
+batch(LV2Apply* app)
+{
+#ifdef HAVE_PTHREAD
+	const unsigned n_threads = (app->n_jobs < app->n_inputs
+	                            ? app->n_jobs : app->n_inputs);
+	pthread_t* const threads = (pthread_t*)calloc(n_threads, sizeof(pthread_t));
+	unsigned         n       = 0;
+
+	for (; n + 1 < n_threads; ++n) {
+		if (pthread_create(&threads[n], NULL, batch_worker, app)) {
+			break;
+		}
+	}
+
+	batch_worker(app);
+	for (unsigned i = 0; i < n; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+
+	free(threads);
+#else
+	batch_worker(app);
+#endif
+	return app->status;
+}
+
 static void
 print_version(void)
 {
@@ -209,22 +1195,34 @@ static int
 print_usage(int status)
 {
 	fprintf(status ? stderr : stdout,
-	        "Usage: lv2apply [OPTION]... PLUGIN_URI\n"
-	        "Apply an LV2 plugin to an audio file.\n\n"
-	        "  -i IN_FILE   Input file\n"
-	        "  -o OUT_FILE  Output file\n"
-	        "  -c SYM VAL   Control value\n"
+	        "Usage: lv2apply [OPTION]... [PLUGIN_URI]\n"
+	        "Apply a chain of LV2 plugins to an audio file.\n\n"
+	        "  -i IN_FILE   Input file, may be given several times for a batch\n"
+	        "  -o OUT_FILE  Output file, or directory for a batch\n"
+	        "  -p URI       Add a plugin to the chain\n"
+	        "  -C FILE      Add the plugins and connections in a chain file\n"
+	        "  -c SYM VAL   Control value of the last plugin\n"
+	        "  -s FILE      Restore the last plugin from a state file\n"
+	        "  -b FRAMES    Block size in frames (default: %d)\n"
+	        "  -j JOBS      Number of batch files processed at once\n"
 	        "  --help       Display this help and exit\n"
-	        "  --version    Display version information and exit\n");
+	        "  --version    Display version information and exit\n",
+	        DEFAULT_BLOCK_SIZE);
 	return status;
 }
 
 int
 main(int argc, char** argv)
 {
-	LV2Apply self = {
-		NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0, NULL, 0, 0, 0, NULL
-	};
+	LV2Apply self;
+	memset(&self, '\0', sizeof(self));
+	self.block_size = DEFAULT_BLOCK_SIZE;
+	self.n_jobs     = 1;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_init(&self.mutex, NULL);
+	const long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	self.n_jobs = n_cpus > 0 ? (unsigned)n_cpus : 1;
+#endif
 
 	/* Parse command line arguments */
 	const char* plugin_uri = NULL;
@@ -234,116 +1232,86 @@ main(int argc, char** argv)
 			return 0;
 		} else if (!strcmp(argv[i], "--help")) {
 			return print_usage(0);
-		} else if (!strcmp(argv[i], "-i")) {
-			self.in_path = argv[++i];
-		} else if (!strcmp(argv[i], "-o")) {
+		} else if (!strcmp(argv[i], "-i") && i + 1 < argc) {
+			self.in_paths = (const char**)realloc(
+				self.in_paths, ++self.n_inputs * sizeof(const char*));
+			self.in_paths[self.n_inputs - 1] = argv[++i];
+		} else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
 			self.out_path = argv[++i];
+		} else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+			add_stage(&self, argv[++i], NULL);
+		} else if (!strcmp(argv[i], "-C") && i + 1 < argc) {
+			if (load_chain(&self, argv[++i])) {
+				return cleanup(1, &self);
+			}
+		} else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+			option_stage(&self)->state_path = argv[++i];
+		} else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+			const int size = atoi(argv[++i]);
+			if (size <= 0) {
+				return fatal(&self, 1, "Invalid block size `%s'\n", argv[i]);
+			}
+			self.block_size = (uint32_t)size;
+		} else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+			const int n_jobs = atoi(argv[++i]);
+			if (n_jobs <= 0) {
+				return fatal(&self, 1, "Invalid job count `%s'\n", argv[i]);
+			}
+			self.n_jobs = (unsigned)n_jobs;
 		} else if (!strcmp(argv[i], "-c")) {
 			if (argc < i + 3) {
 				return fatal(&self, 1, "Missing argument for -c\n");
 			}
-			self.params = (Param*)realloc(self.params,
-			                              ++self.n_params * sizeof(Param));
-			self.params[self.n_params - 1].sym   = argv[++i];
-			self.params[self.n_params - 1].value = atof(argv[++i]);
+			const char* sym = argv[++i];
+			add_param(&self, sym, (float)atof(argv[++i]));
 		} else if (argv[i][0] == '-') {
-			free(self.params);
-			return print_usage(1);
+			return cleanup(print_usage(1), &self);
 		} else if (i == argc - 1) {
 			plugin_uri = argv[i];
 		}
 	}
 
-	/* Check that required arguments are given */
-	if (!self.in_path || !self.out_path || !plugin_uri) {
-		free(self.params);
-		return print_usage(1);
+	if (plugin_uri) {
+		add_stage(&self, plugin_uri, NULL);
 	}
 
-	/* Create world and plugin URI */
-	self.world = lilv_world_new();
-	LilvNode* uri = lilv_new_uri(self.world, plugin_uri);
-	if (!uri) {
-		return fatal(&self, 2, "Invalid plugin URI <%s>\n", plugin_uri);
-	}
-
-	/* Discover world */
-	lilv_world_load_all(self.world);
-
-	/* Get plugin */
-	const LilvPlugins* plugins = lilv_world_get_all_plugins(self.world);
-	const LilvPlugin*  plugin  = lilv_plugins_get_by_uri(plugins, uri);
-	lilv_node_free(uri);
-	if (!(self.plugin = plugin)) {
-		return fatal(&self, 3, "Plugin <%s> not found\n", plugin_uri);
+	/* Check that required arguments are given */
+	if (!self.n_inputs || !self.out_path ||
+	    !self.n_stages || !self.stages[0].uri) {
+		return cleanup(print_usage(1), &self);
 	}
 
-	/* Open input file */
-	SF_INFO in_fmt = { 0, 0, 0, 0, 0, 0 };
-	if (!(self.in_file = sopen(&self, self.in_path, SFM_READ, &in_fmt))) {
-		return 4;
-	}
+	/* Create world and features */
+	self.world    = lilv_world_new();
+	self.urid_map = lilv_urid_map_new();
 
-	/* Create port structures */
-	if (create_ports(&self)) {
-		return 5;
-	}
+	LV2_URID_Map* const map = lilv_urid_map_get_map(self.urid_map);
+	self.map_feature.URI    = LV2_URID__map;
+	self.map_feature.data   = map;
+	self.unmap_feature.URI  = LV2_URID__unmap;
+	self.unmap_feature.data = lilv_urid_map_get_unmap(self.urid_map);
+	self.features[0]        = &self.map_feature;
+	self.features[1]        = &self.unmap_feature;
+	self.features[2]        = NULL;
+	self.atom_Float         = map->map(map->handle, LV2_ATOM__Float);
 
-	if (in_fmt.channels != (int)self.n_audio_in && in_fmt.channels != 1) {
-		return fatal(&self, 6, "Unable to map %d inputs to %d ports\n",
-		             in_fmt.channels, self.n_audio_in);
-	}
+	/* Discover world */
+	lilv_world_load_all(self.world);
 
-	/* Set control values */
-	for (unsigned i = 0; i < self.n_params; ++i) {
-		const Param*    param = &self.params[i];
-		LilvNode*       sym   = lilv_new_string(self.world, param->sym);
-		const LilvPort* port  = lilv_plugin_get_port_by_symbol(plugin, sym);
-		lilv_node_free(sym);
-		if (!port) {
-			return fatal(&self, 7, "Unknown port `%s'\n", param->sym);
+	/* Set up plugins and their connections */
+	for (unsigned s = 0; s < self.n_stages; ++s) {
+		const int st = setup_stage(&self, s);
+		if (st) {
+			return st;
 		}
-
-		self.ports[lilv_port_get_index(plugin, port)].value = param->value;
 	}
-
-	/* Open output file */
-	SF_INFO out_fmt = in_fmt;
-	out_fmt.channels = self.n_audio_out;
-	if (!(self.out_file = sopen(&self, self.out_path, SFM_WRITE, &out_fmt))) {
-		return 8;
-	}
-
-	/* Instantiate plugin and connect ports */
-	const uint32_t n_ports = lilv_plugin_get_num_ports(plugin);
-	float          in_buf[self.n_audio_in];
-	float          out_buf[self.n_audio_out];
-	self.instance = lilv_plugin_instantiate(
-		self.plugin, in_fmt.samplerate, NULL);
-	for (uint32_t p = 0, i = 0, o = 0; p < n_ports; ++p) {
-		if (self.ports[p].type == TYPE_CONTROL) {
-			lilv_instance_connect_port(self.instance, p, &self.ports[p].value);
-		} else if (self.ports[p].type == TYPE_AUDIO) {
-			if (self.ports[p].is_input) {
-				lilv_instance_connect_port(self.instance, p, in_buf + i++);
-			} else {
-				lilv_instance_connect_port(self.instance, p, out_buf + o++);
-			}
-		} else {
-			lilv_instance_connect_port(self.instance, p, NULL);
-		}
+	if (setup_outputs(&self)) {
+		return 1;
 	}
 
-	/* Ports are now connected to buffers in interleaved format, so we can run
-	   a single frame at a time and avoid having to interleave buffers to
-	   read/write from/to sndfile. */
-
-	while (sread(self.in_file, in_fmt.channels, in_buf, self.n_audio_in)) {
-		lilv_instance_run(self.instance, 1);
-		if (sf_writef_float(self.out_file, out_buf, 1) != 1) {
-			return fatal(&self, 9, "Failed to write to output file\n");
-		}
-	}
+	const int st = (self.n_inputs == 1
+	                ? apply(&self, self.in_paths[0], self.out_path, true)
+	                : batch(&self));
 
-	return cleanup(0, &self);
+	return cleanup(st, &self);
 }
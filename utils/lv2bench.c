@@ -15,28 +15,148 @@
 */
 
 #define _POSIX_C_SOURCE 200809L
+#ifdef __linux__
+#    define _GNU_SOURCE 1
+#endif
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "lilv/lilv.h"
 #include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/midi/midi.h"
 
 #include "lilv_config.h"
 #include "bench.h"
-#include "uri_table.h"
 
-static LilvNode* atom_AtomPort   = NULL;
-static LilvNode* atom_Sequence   = NULL;
-static LilvNode* lv2_AudioPort   = NULL;
-static LilvNode* lv2_CVPort      = NULL;
-static LilvNode* lv2_ControlPort = NULL;
-static LilvNode* lv2_InputPort   = NULL;
-static LilvNode* lv2_OutputPort  = NULL;
-static LilvNode* urid_map        = NULL;
+#ifdef HAVE_PTHREAD
+#    include <pthread.h>
+#    include <unistd.h>
+#endif
 
-static bool full_output = false;
+#define MAX_THREAD_COUNTS 64
+#define MAX_BLOCK_SIZES   64
+#define MIDI_EVENT_SIZE   (sizeof(LV2_Atom_Event) + 8)
+#define ATOM_OUT_CAPACITY 8192
+
+#ifndef M_PI
+#    define M_PI 3.14159265358979323846
+#endif
+
+typedef enum {
+	FORMAT_TEXT,
+	FORMAT_CSV,
+	FORMAT_JSON
+} OutputFormat;
+
+typedef enum {
+	STIMULUS_SILENCE,
+	STIMULUS_NOISE,     ///< Uniform white noise
+	STIMULUS_SWEEP,     ///< Logarithmic sine sweep from 20 Hz to Nyquist
+	STIMULUS_IMPULSE,   ///< One unit impulse per second
+	STIMULUS_DENORMAL,  ///< Noise of only subnormal values
+	STIMULUS_FILE       ///< Looped samples read from a file
+} Stimulus;
+
+static const char* const stimulus_names[] = {
+	"silence", "noise", "sweep", "impulse", "denormal"
+};
+
+/** Statistics of the run times of individual blocks, in nanoseconds. */
+typedef struct {
+	uint32_t n_blocks;   ///< Number of measured blocks
+	uint64_t min;
+	uint64_t median;
+	uint64_t p99;        ///< 99th percentile
+	uint64_t p999;       ///< 99.9th percentile
+	uint64_t max;
+	double   mean;
+	double   load;       ///< Mean time as a percentage of the block deadline
+	double   peak_load;  ///< Maximum time as a percentage of the deadline
+	uint32_t outliers;   ///< Blocks far slower than the median
+	uint32_t overruns;   ///< Blocks slower than the deadline
+} BlockStats;
+
+/** The result of running some instances of a plugin concurrently. */
+typedef struct {
+	const char*       uri;
+	uint32_t          block_size;
+	unsigned          n_threads;
+	uint32_t          n_blocks;    ///< Number of blocks run by each instance
+	double            seconds;     ///< Mean run time of an instance
+	double            throughput;  ///< Frames processed per second in total
+	double            scaling;     ///< Instance speed relative to first run
+	const BlockStats* stats;       ///< Block statistics if profiling
+	const uint64_t*   counters;    ///< Total of all instances if counting
+} BenchResult;
+
+/** Shared parameters of the instances in a run. */
+typedef struct {
+	uint32_t block_size;
+	uint32_t n_blocks;
+	unsigned n_cpus;
+	LV2_URID atom_Chunk;
+	LV2_URID atom_Sequence;
+	LV2_URID midi_MidiEvent;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+	unsigned        n_ready;  ///< Number of threads waiting to start
+	bool            go;       ///< True when threads may start running
+#endif
+} BenchRun;
+
+/**
+   An input port connected to a different part of a buffer every block.
+
+   Input signals and events are generated for the whole run in advance, so
+   generating them is not measured with the plugin.
+*/
+typedef struct {
+	uint32_t index;   ///< Port index
+	uint8_t* data;    ///< Data for the first block
+	size_t   stride;  ///< Size of the data for one block in bytes
+} BenchFeed;
+
+/** A plugin instance and the buffers connected to it. */
+typedef struct {
+	BenchRun*           run;
+	LilvInstance*       instance;
+	void**              buffers;   ///< Buffer of each port
+	float*              controls;  ///< Control port values
+	BenchFeed*          feeds;     ///< Ports reconnected every block
+	uint32_t            n_feeds;
+	LV2_Atom_Sequence** sinks;     ///< Atom outputs reset every block
+	uint32_t            n_sinks;
+	uint64_t*           times;     ///< Run time of each block when profiling
+	BenchCounters       counters;  ///< Event counts of the whole run
+	double              elapsed;   ///< Total run time in seconds
+	unsigned            cpu;       ///< CPU this instance runs on
+#ifdef HAVE_PTHREAD
+	pthread_t           thread;
+#endif
+} BenchJob;
+
+static LilvWorld*  world        = NULL;
+static LilvNode*   urid_map     = NULL;
+static LilvNode*   urid_unmap   = NULL;
+static double      sample_rate  = 48000.0;
+static const char* uri_filter   = NULL;
+static const char* class_filter = NULL;
+
+static Stimulus stimulus      = STIMULUS_NOISE;
+static float*   input_samples = NULL;  ///< Samples read for STIMULUS_FILE
+static size_t   n_input       = 0;
+static double   event_rate    = 0.0;   ///< MIDI events per second
+
+static bool         full_output   = false;
+static bool         profile       = false;
+static bool         count_events  = false;
+static uint32_t     warmup_blocks = 16;
+static OutputFormat format        = FORMAT_TEXT;
+static unsigned     n_reported    = 0;
 
 static void
 print_version(void)
@@ -55,125 +175,885 @@ print_usage(void)
 	printf("lv2bench - Benchmark all installed and supported LV2 plugins.\n");
 	printf("Usage: lv2bench [OPTIONS]\n");
 	printf("\n");
-	printf("  -b BLOCK_SIZE  Specify block size, in audio frames.\n");
-	printf("  -f, --full     Full plottable output.\n");
-	printf("  -h, --help     Display this help and exit.\n");
-	printf("  -n FRAMES      Total number of audio frames to process\n");
-	printf("  --version      Display version information and exit\n");
+	printf("  -b SIZES        Block sizes in audio frames, like 64,256,1024.\n");
+	printf("  -c CLASS        Only benchmark plugins of a class URI or label\n");
+	printf("  -e RATE         MIDI events per second sent to atom inputs\n");
+	printf("  -f, --full      Full plottable output.\n");
+	printf("  -h, --help      Display this help and exit.\n");
+	printf("  -i FILE         Loop raw native 32-bit float samples as input\n");
+	printf("  -j THREADS      Concurrent instance counts, like 1,2,4,8\n");
+	printf("  -n FRAMES       Total number of audio frames to process\n");
+	printf("  -o FORMAT       Output format: text, csv, or json\n");
+	printf("  -p, --profile   Profile the latency of every block\n");
+	printf("  -P, --perf      Count CPU events like cycles and cache misses\n");
+	printf("  -r RATE         Sample rate in Hz (default: 48000)\n");
+	printf("  -s STIMULUS     Audio input: silence, noise (default), sweep,\n");
+	printf("                  impulse, or denormal\n");
+	printf("  -u STRING       Only benchmark plugins with URIs containing STRING\n");
+	printf("  -w BLOCKS       Number of warm-up blocks to discard when profiling\n");
+	printf("  --version       Display version information and exit\n");
+	printf("\n");
+	printf("With several thread counts, each instance is pinned to a CPU where\n");
+	printf("supported, and scaling is the speed of an instance relative to the\n");
+	printf("first thread count.  Every port has a separate buffer.\n");
+}
+
+/** Read a whole file of native 32-bit float samples, return zero on success. */
+static int
+read_samples(const char* path)
+{
+	FILE* fd = fopen(path, "rb");
+	if (!fd) {
+		fprintf(stderr, "Failed to open %s\n", path);
+		return 1;
+	}
+
+	size_t capacity = 0;
+	for (size_t n_read = 1; n_read > 0; n_input += n_read) {
+		if (n_input == capacity) {
+			capacity      = capacity ? capacity * 2 : 65536;
+			input_samples = (float*)realloc(input_samples,
+			                                capacity * sizeof(float));
+		}
+		n_read = fread(input_samples + n_input, sizeof(float),
+		               capacity - n_input, fd);
+	}
+
+	fclose(fd);
+	if (n_input == 0) {
+		fprintf(stderr, "No samples in %s\n", path);
+		return 1;
+	}
+	return 0;
+}
+
+/** Return the next value of a xorshift random number generator. */
+static uint32_t
+next_random(uint32_t* state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return (*state = x);
+}
+
+/** Return a random number in [-0.5, 0.5). */
+static float
+random_sample(uint32_t* state)
+{
+	return (float)(next_random(state) >> 8) / 16777216.0f - 0.5f;
+}
+
+/** Generate `n_frames` of the stimulus signal, varied by `seed`. */
+static void
+generate_signal(float* buf, size_t n_frames, uint32_t seed)
+{
+	const size_t every = (size_t)sample_rate;
+	const double ratio = pow(sample_rate / 2.0 / 20.0, 1.0 / n_frames);
+	uint32_t     rng   = 2463534242u ^ (seed * 2654435761u);
+	double       freq  = 20.0;
+	double       phase = 0.0;
+
+	for (size_t i = 0; i < n_frames; ++i) {
+		switch (stimulus) {
+		case STIMULUS_SILENCE:
+			buf[i] = 0.0f;
+			break;
+		case STIMULUS_NOISE:
+			buf[i] = random_sample(&rng);
+			break;
+		case STIMULUS_SWEEP:
+			buf[i] = (float)(0.5 * sin(phase));
+			phase += 2.0 * M_PI * freq / sample_rate;
+			freq  *= ratio;
+			break;
+		case STIMULUS_IMPULSE:
+			buf[i] = (every && i % every == 0) ? 1.0f : 0.0f;
+			break;
+		case STIMULUS_DENORMAL:
+			buf[i] = random_sample(&rng) * 1.0e-38f;
+			break;
+		case STIMULUS_FILE:
+			buf[i] = input_samples[(i + seed) % n_input];
+			break;
+		}
+	}
+}
+
+/** Generate a sequence of random MIDI notes and controls for every block. */
+static void
+generate_events(const BenchRun* run, uint8_t* data, size_t stride, uint32_t seed)
+{
+	const double per_block = event_rate * run->block_size / sample_rate;
+	uint32_t     rng       = 2463534242u ^ (seed * 2654435761u);
+	uint8_t      note      = 60;
+	double       pending   = 0.0;
+	uint32_t     count     = 0;
+
+	for (uint32_t b = 0; b < run->n_blocks; ++b) {
+		LV2_Atom_Sequence* seq = (LV2_Atom_Sequence*)(data + b * stride);
+		seq->atom.type = run->atom_Sequence;
+		seq->atom.size = sizeof(LV2_Atom_Sequence_Body);
+		seq->body.unit = 0;
+		seq->body.pad  = 0;
+
+		pending += per_block;
+		const uint32_t n_events = (uint32_t)pending;
+		pending -= n_events;
+
+		uint8_t* ptr = (uint8_t*)(seq + 1);
+		for (uint32_t e = 0; e < n_events; ++e, ++count) {
+			LV2_Atom_Event* ev = (LV2_Atom_Event*)ptr;
+			uint8_t* const  msg = (uint8_t*)(ev + 1);
+			ev->time.frames = (int64_t)e * run->block_size / n_events;
+			ev->body.type   = run->midi_MidiEvent;
+			ev->body.size   = 3;
+			switch (count % 3) {
+			case 0:
+				note   = (uint8_t)(36 + next_random(&rng) % 60);
+				msg[0] = LV2_MIDI_MSG_NOTE_ON;
+				msg[1] = note;
+				msg[2] = (uint8_t)(1 + next_random(&rng) % 127);
+				break;
+			case 1:
+				msg[0] = LV2_MIDI_MSG_CONTROLLER;
+				msg[1] = 1;
+				msg[2] = (uint8_t)(next_random(&rng) % 128);
+				break;
+			default:
+				msg[0] = LV2_MIDI_MSG_NOTE_OFF;
+				msg[1] = note;
+				msg[2] = 0;
+			}
+			ptr            += MIDI_EVENT_SIZE;
+			seq->atom.size += MIDI_EVENT_SIZE;
+		}
+	}
+}
+
+/** Parse a comma-separated list of positive integers, return the count. */
+static unsigned
+parse_list(const char* str, uint32_t* values, unsigned max)
+{
+	unsigned n = 0;
+	for (const char* s = str; *s;) {
+		char*               end   = NULL;
+		const unsigned long value = strtoul(s, &end, 10);
+		if (end == s || value == 0 || value > UINT32_MAX || n == max ||
+		    (*end && *end != ',')) {
+			return 0;
+		}
+		values[n++] = (uint32_t)value;
+		s           = *end ? end + 1 : end;
+	}
+	return n;
+}
+
+static int
+compare_times(const void* a, const void* b)
+{
+	const uint64_t ta = *(const uint64_t*)a;
+	const uint64_t tb = *(const uint64_t*)b;
+	return ta < tb ? -1 : ta > tb ? 1 : 0;
+}
+
+/** Return the nearest-rank percentile `num / den` of sorted `times`. */
+static uint64_t
+percentile(const uint64_t* times, uint32_t n, uint64_t num, uint64_t den)
+{
+	const uint64_t rank = (n * num + den - 1) / den;
+	return times[rank ? rank - 1 : 0];
+}
+
+/**
+   Calculate statistics of block run times, sorting `times` in place.
+
+   Outliers are blocks slower than the median by more than ten times the
+   median absolute deviation, which unlike the standard deviation is not
+   itself skewed by the outliers it is meant to detect.
+*/
+static BlockStats
+block_stats(uint64_t* times, uint32_t n, uint32_t block_size)
+{
+	BlockStats stats;
+	memset(&stats, '\0', sizeof(stats));
+	if (n == 0) {
+		return stats;
+	}
+
+	qsort(times, n, sizeof(uint64_t), compare_times);
+
+	const double deadline = block_size / sample_rate * 1000000000.0;
+	double       total    = 0.0;
+	for (uint32_t i = 0; i < n; ++i) {
+		total += (double)times[i];
+		if (times[i] > deadline) {
+			++stats.overruns;
+		}
+	}
+
+	stats.n_blocks  = n;
+	stats.min       = times[0];
+	stats.median    = percentile(times, n, 50, 100);
+	stats.p99       = percentile(times, n, 99, 100);
+	stats.p999      = percentile(times, n, 999, 1000);
+	stats.max       = times[n - 1];
+	stats.mean      = total / n;
+	stats.load      = stats.mean / deadline * 100.0;
+	stats.peak_load = stats.max / deadline * 100.0;
+
+	uint64_t* const deviations = (uint64_t*)malloc(n * sizeof(uint64_t));
+	for (uint32_t i = 0; i < n; ++i) {
+		deviations[i] = (times[i] > stats.median ? times[i] - stats.median
+		                                         : stats.median - times[i]);
+	}
+	qsort(deviations, n, sizeof(uint64_t), compare_times);
+
+	const uint64_t mad = percentile(deviations, n, 50, 100);
+	for (uint32_t i = 0; i < n; ++i) {
+		if (times[i] > stats.median + 10 * mad) {
+			++stats.outliers;
+		}
+	}
+
+	free(deviations);
+	return stats;
 }
 
+static void
+print_json_string(const char* str)
+{
+	putchar('"');
+	for (const char* c = str; *c; ++c) {
+		if (*c == '"' || *c == '\\') {
+			printf("\\%c", *c);
+		} else if ((unsigned char)*c < 0x20) {
+			printf("\\u%04x", (unsigned)*c);
+		} else {
+			putchar(*c);
+		}
+	}
+	putchar('"');
+}
+
+static void
+print_header(void)
+{
+	if (format == FORMAT_CSV) {
+		printf("plugin,block_size,threads,blocks,seconds,frames_per_second,"
+		       "scaling_pct");
+		if (profile) {
+			printf(",min_ns,median_ns,p99_ns,p999_ns,max_ns,mean_ns,"
+			       "load_pct,peak_load_pct,outliers,overruns");
+		}
+		if (count_events) {
+			for (unsigned i = 0; i < BENCH_N_COUNTERS; ++i) {
+				printf(",%s", bench_counter_names[i]);
+			}
+			printf(",cycles_per_sample,ipc");
+		}
+		printf("\n");
+	} else if (format == FORMAT_JSON) {
+		printf("[");
+	} else if (full_output && !profile) {
+		printf("# Block Samples Threads Time Scaling %sPlugin\n",
+		       count_events ? "CyclesPerSample IPC " : "");
+	}
+}
+
+static void
+print_footer(void)
+{
+	if (format == FORMAT_JSON) {
+		printf("\n]\n");
+	}
+}
+
+/** Return cycles per sample if available, or a negative number. */
 static double
-bench(const LilvPlugin* p, uint32_t sample_count, uint32_t block_size)
+cycles_per_sample(const BenchResult* r)
 {
-	URITable uri_table;
-	uri_table_init(&uri_table);
+	const uint64_t cycles = r->counters[BENCH_CYCLES];
+	const double   frames = (double)r->n_threads * r->n_blocks * r->block_size;
+	return (cycles == UINT64_MAX || frames == 0.0) ? -1.0 : cycles / frames;
+}
 
-	LV2_URID_Map       map           = { &uri_table, uri_table_map };
-	LV2_Feature        map_feature   = { LV2_URID_MAP_URI, &map };
-	LV2_URID_Unmap     unmap         = { &uri_table, uri_table_unmap };
-	LV2_Feature        unmap_feature = { LV2_URID_UNMAP_URI, &unmap };
-	const LV2_Feature* features[]    = { &map_feature, &unmap_feature, NULL };
+/** Return instructions per cycle if available, or a negative number. */
+static double
+instructions_per_cycle(const BenchResult* r)
+{
+	const uint64_t cycles       = r->counters[BENCH_CYCLES];
+	const uint64_t instructions = r->counters[BENCH_INSTRUCTIONS];
+	return (cycles == UINT64_MAX || instructions == UINT64_MAX || !cycles)
+		? -1.0 : (double)instructions / cycles;
+}
 
-	float* const buf = (float*)calloc(block_size * 2, sizeof(float));
-	float* const in  = buf;
-	float* const out = buf + block_size;
-	if (!buf) {
-		fprintf(stderr, "Out of memory\n");
-		return 0.0;
+/** Print event counts as CSV or JSON fields, with "null" if unavailable. */
+static void
+print_counters(const BenchResult* r, bool json)
+{
+	const char* const none = json ? "null" : "";
+	for (unsigned i = 0; i < BENCH_N_COUNTERS; ++i) {
+		if (json) {
+			printf("%s\"%s\": ", i ? ", " : "", bench_counter_names[i]);
+		} else {
+			printf(",");
+		}
+
+		if (r->counters[i] == UINT64_MAX) {
+			printf("%s", none);
+		} else {
+			printf("%llu", (unsigned long long)r->counters[i]);
+		}
+	}
+
+	const double cps = cycles_per_sample(r);
+	const double ipc = instructions_per_cycle(r);
+	printf(json ? ",\n   \"cycles_per_sample\": " : ",");
+	if (cps < 0.0) {
+		printf("%s", none);
+	} else {
+		printf("%.3f", cps);
+	}
+
+	printf(json ? ", \"ipc\": " : ",");
+	if (ipc < 0.0) {
+		printf("%s", none);
+	} else {
+		printf("%.3f", ipc);
+	}
+}
+
+static void
+print_text_counters(const BenchResult* r)
+{
+	const double cps = cycles_per_sample(r);
+	const double ipc = instructions_per_cycle(r);
+	if (cps < 0.0) {
+		printf("  cycles/sample -");
+	} else {
+		printf("  cycles/sample %.2f", cps);
+	}
+	if (ipc < 0.0) {
+		printf("  IPC -");
+	} else {
+		printf("  IPC %.2f", ipc);
+	}
+	for (unsigned i = BENCH_CACHE_MISSES; i < BENCH_N_COUNTERS; ++i) {
+		if (r->counters[i] == UINT64_MAX) {
+			printf("  %s -", bench_counter_names[i]);
+		} else {
+			printf("  %s %llu", bench_counter_names[i],
+			       (unsigned long long)r->counters[i]);
+		}
 	}
+	printf("\n");
+}
 
-	LV2_Atom_Sequence seq = {
-		{ sizeof(LV2_Atom_Sequence_Body),
-		  uri_table_map(&uri_table, LV2_ATOM__Sequence) },
-		{ 0, 0 } };
+static void
+print_text_result(const BenchResult* r)
+{
+	const BlockStats* s = r->stats;
+	if (s) {
+		printf("%s\n", r->uri);
+		if (r->n_threads > 1) {
+			printf("  threads %u  scaling %.1f%%\n", r->n_threads, r->scaling);
+		}
+		printf("  blocks %u  min %.3f  median %.3f  p99 %.3f  p99.9 %.3f"
+		       "  max %.3f  mean %.3f us\n"
+		       "  load %.2f%%  peak %.2f%%  outliers %u  overruns %u\n",
+		       s->n_blocks,
+		       s->min / 1000.0, s->median / 1000.0, s->p99 / 1000.0,
+		       s->p999 / 1000.0, s->max / 1000.0, s->mean / 1000.0,
+		       s->load, s->peak_load, s->outliers, s->overruns);
+	} else if (full_output) {
+		printf("%u %u %u %lf %.1f ",
+		       r->block_size, r->n_blocks * r->block_size, r->n_threads,
+		       r->seconds, r->scaling);
+		if (r->counters) {
+			// Unavailable counts are printed as NaN which plots as missing
+			const double cps = cycles_per_sample(r);
+			const double ipc = instructions_per_cycle(r);
+			printf("%.3f %.3f ", cps < 0.0 ? NAN : cps, ipc < 0.0 ? NAN : ipc);
+		}
+		printf("%s\n", r->uri);
+		return;
+	} else if (r->n_threads > 1) {
+		printf("%lf %s (%u threads, %.1f%% scaling)\n",
+		       r->seconds, r->uri, r->n_threads, r->scaling);
+	} else {
+		printf("%lf %s\n", r->seconds, r->uri);
+	}
 
-	const char* uri      = lilv_node_as_string(lilv_plugin_get_uri(p));
-	LilvNodes*  required = lilv_plugin_get_required_features(p);
+	if (r->counters) {
+		print_text_counters(r);
+	}
+}
+
+static void
+print_result(const BenchResult* r)
+{
+	const BlockStats* s = r->stats;
+	switch (format) {
+	case FORMAT_TEXT:
+		print_text_result(r);
+		break;
+	case FORMAT_CSV:
+		printf("%s,%u,%u,%u,%f,%.1f,%.1f",
+		       r->uri, r->block_size, r->n_threads, r->n_blocks,
+		       r->seconds, r->throughput, r->scaling);
+		if (s) {
+			printf(",%llu,%llu,%llu,%llu,%llu,%.1f,%.3f,%.3f,%u,%u",
+			       (unsigned long long)s->min, (unsigned long long)s->median,
+			       (unsigned long long)s->p99, (unsigned long long)s->p999,
+			       (unsigned long long)s->max, s->mean,
+			       s->load, s->peak_load, s->outliers, s->overruns);
+		}
+		if (r->counters) {
+			print_counters(r, false);
+		}
+		printf("\n");
+		break;
+	case FORMAT_JSON:
+		printf("%s\n  {\"plugin\": ", n_reported ? "," : "");
+		print_json_string(r->uri);
+		printf(", \"block_size\": %u, \"threads\": %u, \"blocks\": %u,\n"
+		       "   \"seconds\": %f, \"frames_per_second\": %.1f,"
+		       " \"scaling_pct\": %.1f",
+		       r->block_size, r->n_threads, r->n_blocks,
+		       r->seconds, r->throughput, r->scaling);
+		if (s) {
+			printf(",\n"
+			       "   \"min_ns\": %llu, \"median_ns\": %llu, \"p99_ns\": %llu,"
+			       " \"p999_ns\": %llu, \"max_ns\": %llu, \"mean_ns\": %.1f,\n"
+			       "   \"load_pct\": %.3f, \"peak_load_pct\": %.3f,"
+			       " \"outliers\": %u, \"overruns\": %u",
+			       (unsigned long long)s->min, (unsigned long long)s->median,
+			       (unsigned long long)s->p99, (unsigned long long)s->p999,
+			       (unsigned long long)s->max, s->mean,
+			       s->load, s->peak_load, s->outliers, s->overruns);
+		}
+		if (r->counters) {
+			printf(",\n   ");
+			print_counters(r, true);
+		}
+		printf("}");
+		break;
+	}
+	++n_reported;
+}
+
+/** Return true iff `p` matches the URI and class filters. */
+static bool
+plugin_matches(const LilvPlugin* p)
+{
+	const char* uri = lilv_node_as_uri(lilv_plugin_get_uri(p));
+	if (uri_filter && !strstr(uri, uri_filter)) {
+		return false;
+	} else if (!class_filter) {
+		return true;
+	}
+
+	// Check the class of the plugin and all its ancestors
+	const LilvPluginClasses* classes = lilv_world_get_plugin_classes(world);
+	const LilvPluginClass*   cls     = lilv_plugin_get_class(p);
+	for (unsigned depth = 0; cls && depth < 32; ++depth) {
+		const LilvNode* cls_uri = lilv_plugin_class_get_uri(cls);
+		const LilvNode* label   = lilv_plugin_class_get_label(cls);
+		if (!strcmp(lilv_node_as_uri(cls_uri), class_filter) ||
+		    (label && !strcmp(lilv_node_as_string(label), class_filter))) {
+			return true;
+		}
+
+		const LilvNode* parent = lilv_plugin_class_get_parent_uri(cls);
+		cls = parent ? lilv_plugin_classes_get_by_uri(classes, parent) : NULL;
+	}
+	return false;
+}
+
+/** Return true iff `p` can be benchmarked, that is, requires no features. */
+static bool
+plugin_supported(const LilvPlugin* p)
+{
+	const char* uri       = lilv_node_as_uri(lilv_plugin_get_uri(p));
+	LilvNodes*  required  = lilv_plugin_get_required_features(p);
+	bool        supported = true;
 	LILV_FOREACH(nodes, i, required) {
 		const LilvNode* feature = lilv_nodes_get(required, i);
-		if (!lilv_node_equals(feature, urid_map)) {
+		if (!lilv_node_equals(feature, urid_map) &&
+		    !lilv_node_equals(feature, urid_unmap)) {
 			fprintf(stderr, "<%s> requires feature <%s>, skipping\n",
 			        uri, lilv_node_as_uri(feature));
-			free(buf);
-			uri_table_destroy(&uri_table);
-			return 0.0;
+			supported = false;
+			break;
 		}
 	}
+	lilv_nodes_free(required);
+
+	if (supported && !lilv_plugin_get_port_table(p)) {
+		fprintf(stderr, "<%s> has invalid ports, skipping\n", uri);
+		supported = false;
+	}
+
+	return supported;
+}
 
-	LilvInstance* instance = lilv_plugin_instantiate(p, 48000.0, features);
-	if (!instance) {
-		fprintf(stderr, "Failed to instantiate <%s>\n",
-		        lilv_node_as_uri(lilv_plugin_get_uri(p)));
-		free(buf);
-		uri_table_destroy(&uri_table);
-		return 0.0;
+static void
+job_free(BenchJob* job, uint32_t n_ports)
+{
+	if (job->instance) {
+		lilv_instance_free(job->instance);
+	}
+	for (uint32_t i = 0; job->buffers && i < n_ports; ++i) {
+		free(job->buffers[i]);
 	}
+	free(job->buffers);
+	free(job->feeds);
+	free(job->sinks);
+	free(job->times);
+	free(job->controls);
+}
+
+/** Instantiate a plugin and connect its ports, return zero on success. */
+static int
+job_init(BenchJob*                 job,
+         BenchRun*                 run,
+         const LilvPlugin*         p,
+         unsigned                  seed,
+         const LV2_Feature* const* features)
+{
+	const char*          uri        = lilv_node_as_uri(lilv_plugin_get_uri(p));
+	const LilvPortTable* table      = lilv_plugin_get_port_table(p);
+	const uint32_t       n_ports    = table->n_ports;
+	const uint32_t       block_size = run->block_size;
+	const size_t         n_frames   = (size_t)run->n_blocks * block_size;
+
+	// Size of the events for one block, a multiple of 8 to keep them aligned
+	const size_t max_events = (size_t)ceil(
+		event_rate * block_size / sample_rate);
+	const size_t event_stride = sizeof(LV2_Atom_Sequence) +
+		max_events * MIDI_EVENT_SIZE;
 
-	float* controls = (float*)calloc(
-		lilv_plugin_get_num_ports(p), sizeof(float));
-	lilv_plugin_get_port_ranges_float(p, NULL, NULL, controls);
+	memset(job, '\0', sizeof(BenchJob));
+	job->run      = run;
+	job->buffers  = (void**)calloc(n_ports, sizeof(void*));
+	job->controls = (float*)calloc(n_ports, sizeof(float));
+	job->feeds    = (BenchFeed*)calloc(n_ports, sizeof(BenchFeed));
+	job->sinks    = (LV2_Atom_Sequence**)calloc(n_ports, sizeof(void*));
+	job->times    = profile
+		? (uint64_t*)calloc(run->n_blocks, sizeof(uint64_t)) : NULL;
+	if ((n_ports && (!job->buffers || !job->controls || !job->feeds ||
+	                 !job->sinks)) ||
+	    (profile && run->n_blocks && !job->times)) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	if (!(job->instance = lilv_plugin_instantiate(p, sample_rate, features))) {
+		fprintf(stderr, "Failed to instantiate <%s>\n", uri);
+		return 1;
+	}
+
+	memcpy(job->controls, table->def_values, n_ports * sizeof(float));
 
-	const uint32_t n_ports = lilv_plugin_get_num_ports(p);
 	for (uint32_t index = 0; index < n_ports; ++index) {
-		const LilvPort* port = lilv_plugin_get_port_by_index(p, index);
-		if (lilv_port_is_a(p, port, lv2_ControlPort)) {
-			lilv_instance_connect_port(instance, index, &controls[index]);
-		} else if (lilv_port_is_a(p, port, lv2_AudioPort) ||
-		           lilv_port_is_a(p, port, lv2_CVPort)) {
-			if (lilv_port_is_a(p, port, lv2_InputPort)) {
-				lilv_instance_connect_port(instance, index, in);
-			} else if (lilv_port_is_a(p, port, lv2_OutputPort)) {
-				lilv_instance_connect_port(instance, index, out);
-			} else {
-				fprintf(stderr, "<%s> port %d neither input nor output, skipping\n",
-				        uri, index);
-				lilv_instance_free(instance);
-				free(buf);
-				free(controls);
-				uri_table_destroy(&uri_table);
-				return 0.0;
-			}
-		} else if (lilv_port_is_a(p, port, atom_AtomPort)) {
-			lilv_instance_connect_port(instance, index, &seq);
-		} else {
+		const uint32_t types  = table->types[index];
+		const bool     input  = types & LILV_PORT_INPUT;
+		const bool     output = types & LILV_PORT_OUTPUT;
+		if (types & LILV_PORT_CONTROL) {
+			lilv_instance_connect_port(job->instance, index, &job->controls[index]);
+			continue;
+		} else if (!(types & (LILV_PORT_AUDIO | LILV_PORT_CV | LILV_PORT_ATOM))) {
 			fprintf(stderr, "<%s> port %d has unknown type, skipping\n",
 			        uri, index);
-			lilv_instance_free(instance);
-			free(buf);
-			free(controls);
-			uri_table_destroy(&uri_table);
-			return 0.0;
+			return 1;
+		} else if (!input && !output) {
+			fprintf(stderr, "<%s> port %d neither input nor output, skipping\n",
+			        uri, index);
+			return 1;
+		}
+
+		const bool   atom = types & LILV_PORT_ATOM;
+		const size_t size =
+			atom ? (input ? run->n_blocks * event_stride : ATOM_OUT_CAPACITY)
+			     : (input ? n_frames : block_size) * sizeof(float);
+
+		uint8_t* const buf = (uint8_t*)calloc(1, size);
+		if (!(job->buffers[index] = buf)) {
+			fprintf(stderr, "Out of memory\n");
+			return 1;
+		}
+
+		if (atom && input) {
+			generate_events(run, buf, event_stride, seed * n_ports + index);
+		} else if (input) {
+			generate_signal((float*)buf, n_frames, seed * n_ports + index);
+		} else if (atom) {
+			job->sinks[job->n_sinks++] = (LV2_Atom_Sequence*)buf;
+		}
+
+		if (input) {
+			BenchFeed* const feed = &job->feeds[job->n_feeds++];
+			feed->index  = index;
+			feed->data   = buf;
+			feed->stride = atom ? event_stride : block_size * sizeof(float);
 		}
+
+		lilv_instance_connect_port(job->instance, index, buf);
 	}
 
-	lilv_instance_activate(instance);
+	return 0;
+}
 
-	struct timespec ts = bench_start();
-	for (uint32_t i = 0; i < (sample_count / block_size); ++i) {
-		lilv_instance_run(instance, block_size);
+/** Connect inputs to the data for `block` and reset outputs. */
+static inline void
+job_prepare(BenchJob* job, uint32_t block)
+{
+	const uint32_t b = block % job->run->n_blocks;
+	for (uint32_t i = 0; i < job->n_feeds; ++i) {
+		const BenchFeed* const feed = &job->feeds[i];
+		lilv_instance_connect_port(
+			job->instance, feed->index, feed->data + b * feed->stride);
+	}
+	for (uint32_t i = 0; i < job->n_sinks; ++i) {
+		job->sinks[i]->atom.type = job->run->atom_Chunk;
+		job->sinks[i]->atom.size = ATOM_OUT_CAPACITY - sizeof(LV2_Atom);
 	}
-	const double elapsed = bench_end(&ts);
+}
+
+static void
+job_run(BenchJob* job)
+{
+	LilvInstance* const instance   = job->instance;
+	const uint32_t      block_size = job->run->block_size;
+	const uint32_t      n_blocks   = job->run->n_blocks;
 
-	lilv_instance_deactivate(instance);
-	lilv_instance_free(instance);
+	if (count_events) {
+		// Counters count the calling thread, so must be opened here
+		bench_counters_open(&job->counters);
+		bench_counters_start(&job->counters);
+	}
 
-	uri_table_destroy(&uri_table);
+	if (profile) {
+		for (uint32_t i = 0; n_blocks && i < warmup_blocks; ++i) {
+			job_prepare(job, i);
+			lilv_instance_run(instance, block_size);
+		}
 
-	if (full_output) {
-		printf("%d %d ", block_size, sample_count);
+		uint64_t total = 0;
+		for (uint32_t i = 0; i < n_blocks; ++i) {
+			job_prepare(job, i);
+			const uint64_t begin = bench_now_ns();
+			lilv_instance_run(instance, block_size);
+			total += (job->times[i] = bench_now_ns() - begin);
+		}
+		job->elapsed = total * 0.000000001;
+	} else {
+		struct timespec ts = bench_start();
+		for (uint32_t i = 0; i < n_blocks; ++i) {
+			job_prepare(job, i);
+			lilv_instance_run(instance, block_size);
+		}
+		job->elapsed = bench_end(&ts);
 	}
-	printf("%lf %s\n", elapsed, uri);
 
-	free(buf);
-	free(controls);
+	if (count_events) {
+		bench_counters_stop(&job->counters);
+		bench_counters_close(&job->counters);
+	}
+}
+
+#ifdef HAVE_PTHREAD
+static void*
+job_thread(void* data)
+{
+	BenchJob* const job = (BenchJob*)data;
+	BenchRun* const run = job->run;
+
+#ifdef __linux__
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(job->cpu, &cpus);
+	pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+
+	// Wait until every instance is ready so they all run concurrently
+	pthread_mutex_lock(&run->mutex);
+	++run->n_ready;
+	pthread_cond_broadcast(&run->cond);
+	while (!run->go) {
+		pthread_cond_wait(&run->cond, &run->mutex);
+	}
+	pthread_mutex_unlock(&run->mutex);
+
+	job_run(job);
+	return NULL;
+}
+#endif
+
+/** Run all jobs concurrently, return zero on success. */
+static int
+run_jobs(BenchRun* run, BenchJob* jobs, unsigned n_jobs)
+{
+	if (n_jobs == 1) {
+		job_run(&jobs[0]);
+		return 0;
+	}
+
+#ifdef HAVE_PTHREAD
+	int st = 0;
+	pthread_mutex_init(&run->mutex, NULL);
+	pthread_cond_init(&run->cond, NULL);
+	run->n_ready = 0;
+	run->go      = false;
+
+	unsigned n_started = 0;
+	for (; n_started < n_jobs; ++n_started) {
+		jobs[n_started].cpu = n_started % run->n_cpus;
+		if (pthread_create(&jobs[n_started].thread, NULL,
+		                   job_thread, &jobs[n_started])) {
+			fprintf(stderr, "Failed to create thread %u\n", n_started);
+			st = 1;
+			break;
+		}
+	}
+
+	pthread_mutex_lock(&run->mutex);
+	while (run->n_ready < n_started) {
+		pthread_cond_wait(&run->cond, &run->mutex);
+	}
+	run->go = true;
+	pthread_cond_broadcast(&run->cond);
+	pthread_mutex_unlock(&run->mutex);
+
+	for (unsigned i = 0; i < n_started; ++i) {
+		pthread_join(jobs[i].thread, NULL);
+	}
+
+	pthread_cond_destroy(&run->cond);
+	pthread_mutex_destroy(&run->mutex);
+	return st;
+#else
+	fprintf(stderr, "Threads not supported, can not run %u instances\n",
+	        n_jobs);
+	return 1;
+#endif
+}
+
+/**
+   Benchmark `n_threads` instances of `p` running concurrently.
+
+   The first call for a plugin and block size sets `baseline` to the mean run
+   time of an instance, which later calls use to calculate scaling.
+*/
+static double
+bench(const LilvPlugin* p,
+      uint32_t          sample_count,
+      uint32_t          block_size,
+      unsigned          n_threads,
+      unsigned          n_cpus,
+      double*           baseline)
+{
+	LilvURIDMap* const urids = lilv_urid_map_new();
+
+	LV2_URID_Map* const map           = lilv_urid_map_get_map(urids);
+	LV2_Feature         map_feature   = { LV2_URID_MAP_URI, map };
+	LV2_URID_Unmap*     unmap         = lilv_urid_map_get_unmap(urids);
+	LV2_Feature         unmap_feature = { LV2_URID_UNMAP_URI, unmap };
+	const LV2_Feature*  features[]    = { &map_feature, &unmap_feature, NULL };
+
+	BenchRun run;
+	memset(&run, '\0', sizeof(run));
+	run.block_size     = block_size;
+	run.n_blocks       = sample_count / block_size;
+	run.n_cpus         = n_cpus;
+	run.atom_Chunk     = map->map(map->handle, LV2_ATOM__Chunk);
+	run.atom_Sequence  = map->map(map->handle, LV2_ATOM__Sequence);
+	run.midi_MidiEvent = map->map(map->handle, LV2_MIDI__MidiEvent);
+
+	const uint32_t  n_ports = lilv_plugin_get_port_table(p)->n_ports;
+	BenchJob* const jobs    = (BenchJob*)calloc(n_threads, sizeof(BenchJob));
+	int             st      = jobs ? 0 : 1;
+	unsigned        n       = 0;
+	for (; !st && n < n_threads; ++n) {
+		st = job_init(&jobs[n], &run, p, n, features);
+	}
+
+	const bool active = !st;
+	for (unsigned i = 0; active && i < n_threads; ++i) {
+		lilv_instance_activate(jobs[i].instance);
+	}
+
+	double elapsed = 0.0;
+	if (active && !(st = run_jobs(&run, jobs, n_threads))) {
+		double   max_elapsed = 0.0;
+		uint64_t counts[BENCH_N_COUNTERS];
+		memset(counts, 0, sizeof(counts));
+		for (unsigned i = 0; i < n_threads; ++i) {
+			bench_counters_add(counts, &jobs[i].counters);
+			elapsed += jobs[i].elapsed / n_threads;
+			if (jobs[i].elapsed > max_elapsed) {
+				max_elapsed = jobs[i].elapsed;
+			}
+		}
+
+		if (*baseline == 0.0) {
+			*baseline = elapsed;
+		}
+
+		BenchResult result = {
+			lilv_node_as_uri(lilv_plugin_get_uri(p)),
+			block_size,
+			n_threads,
+			run.n_blocks,
+			elapsed,
+			(max_elapsed > 0.0
+			 ? (double)n_threads * run.n_blocks * block_size / max_elapsed
+			 : 0.0),
+			elapsed > 0.0 ? *baseline / elapsed * 100.0 : 0.0,
+			NULL,
+			count_events ? counts : NULL
+		};
+
+		if (profile) {
+			// Calculate statistics of the blocks of every instance together
+			const uint32_t  n_times = run.n_blocks * n_threads;
+			uint64_t* const times   = (uint64_t*)malloc(
+				((size_t)n_times + 1) * sizeof(uint64_t));
+			for (unsigned i = 0; i < n_threads; ++i) {
+				memcpy(times + (size_t)i * run.n_blocks, jobs[i].times,
+				       run.n_blocks * sizeof(uint64_t));
+			}
+
+			const BlockStats stats = block_stats(times, n_times, block_size);
+			result.stats = &stats;
+			print_result(&result);
+			free(times);
+		} else {
+			print_result(&result);
+		}
+	}
+
+	for (unsigned i = 0; active && i < n_threads; ++i) {
+		lilv_instance_deactivate(jobs[i].instance);
+	}
+	for (unsigned i = 0; i < n; ++i) {
+		job_free(&jobs[i], n_ports);
+	}
+	free(jobs);
+	lilv_urid_map_free(urids);
 	return elapsed;
 }
 
 int
 main(int argc, char** argv)
 {
-	uint32_t block_size   = 512;
-	uint32_t sample_count = (1 << 19);
+	uint32_t block_sizes[MAX_BLOCK_SIZES]     = { 512 };
+	unsigned n_block_sizes                    = 1;
+	uint32_t thread_counts[MAX_THREAD_COUNTS] = { 1 };
+	unsigned n_thread_counts                  = 1;
+	uint32_t sample_count                     = (1 << 19);
 
 	for (int i = 1; i < argc; ++i) {
 		if (!strcmp(argv[i], "--version")) {
@@ -187,44 +1067,114 @@ main(int argc, char** argv)
 		} else if (!strcmp(argv[i], "-n") && (i + 1 < argc)) {
 			sample_count = atoi(argv[++i]);
 		} else if (!strcmp(argv[i], "-b") && (i + 1 < argc)) {
-			block_size = atoi(argv[++i]);
+			if (!(n_block_sizes = parse_list(
+				      argv[++i], block_sizes, MAX_BLOCK_SIZES))) {
+				fprintf(stderr, "Invalid block sizes `%s'\n", argv[i]);
+				return 1;
+			}
+		} else if (!strcmp(argv[i], "-j") && (i + 1 < argc)) {
+			if (!(n_thread_counts = parse_list(
+				      argv[++i], thread_counts, MAX_THREAD_COUNTS))) {
+				fprintf(stderr, "Invalid thread counts `%s'\n", argv[i]);
+				return 1;
+			}
+		} else if (!strcmp(argv[i], "-r") && (i + 1 < argc)) {
+			if ((sample_rate = atof(argv[++i])) <= 0.0) {
+				fprintf(stderr, "Invalid sample rate `%s'\n", argv[i]);
+				return 1;
+			}
+		} else if (!strcmp(argv[i], "-u") && (i + 1 < argc)) {
+			uri_filter = argv[++i];
+		} else if (!strcmp(argv[i], "-c") && (i + 1 < argc)) {
+			class_filter = argv[++i];
+		} else if (!strcmp(argv[i], "-e") && (i + 1 < argc)) {
+			if ((event_rate = atof(argv[++i])) < 0.0) {
+				fprintf(stderr, "Invalid event rate `%s'\n", argv[i]);
+				return 1;
+			}
+		} else if (!strcmp(argv[i], "-i") && (i + 1 < argc)) {
+			if (read_samples(argv[++i])) {
+				return 1;
+			}
+			stimulus = STIMULUS_FILE;
+		} else if (!strcmp(argv[i], "-s") && (i + 1 < argc)) {
+			const char* name = argv[++i];
+			unsigned    s    = 0;
+			for (; s < STIMULUS_FILE && strcmp(name, stimulus_names[s]); ++s) {}
+			if (s == STIMULUS_FILE) {
+				fprintf(stderr, "Unknown stimulus `%s'\n", name);
+				return 1;
+			}
+			stimulus = (Stimulus)s;
+		} else if (!strcmp(argv[i], "-p") || !strcmp(argv[i], "--profile")) {
+			profile = true;
+		} else if (!strcmp(argv[i], "-P") || !strcmp(argv[i], "--perf")) {
+			count_events = true;
+		} else if (!strcmp(argv[i], "-w") && (i + 1 < argc)) {
+			warmup_blocks = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-o") && (i + 1 < argc)) {
+			const char* name = argv[++i];
+			if (!strcmp(name, "text")) {
+				format = FORMAT_TEXT;
+			} else if (!strcmp(name, "csv")) {
+				format = FORMAT_CSV;
+			} else if (!strcmp(name, "json")) {
+				format = FORMAT_JSON;
+			} else {
+				fprintf(stderr, "Unknown output format `%s'\n", name);
+				return 1;
+			}
 		} else {
 			print_usage();
 			return 1;
 		}
 	}
 
-	LilvWorld* world = lilv_world_new();
+	unsigned n_cpus = 1;
+#ifdef HAVE_PTHREAD
+	const long n_online = sysconf(_SC_NPROCESSORS_ONLN);
+	n_cpus = n_online > 0 ? (unsigned)n_online : 1;
+#endif
+
+	if (count_events) {
+		BenchCounters counters;
+		if (!bench_counters_open(&counters)) {
+			fprintf(stderr, "warning: CPU event counters are unavailable\n");
+		}
+		bench_counters_close(&counters);
+	}
+
+	world = lilv_world_new();
 	lilv_world_load_all(world);
 
-	atom_AtomPort   = lilv_new_uri(world, LV2_ATOM__AtomPort);
-	atom_Sequence   = lilv_new_uri(world, LV2_ATOM__Sequence);
-	lv2_AudioPort   = lilv_new_uri(world, LV2_CORE__AudioPort);
-	lv2_CVPort      = lilv_new_uri(world, LV2_CORE__CVPort);
-	lv2_ControlPort = lilv_new_uri(world, LV2_CORE__ControlPort);
-	lv2_InputPort   = lilv_new_uri(world, LV2_CORE__InputPort);
-	lv2_OutputPort  = lilv_new_uri(world, LV2_CORE__OutputPort);
-	urid_map        = lilv_new_uri(world, LV2_URID__map);
+	urid_map   = lilv_new_uri(world, LV2_URID__map);
+	urid_unmap = lilv_new_uri(world, LV2_URID__unmap);
 
-	if (full_output) {
-		printf("# Block Samples Time Plugin\n");
-	}
+	print_header();
 
 	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
 	LILV_FOREACH(plugins, i, plugins) {
-		bench(lilv_plugins_get(plugins, i), sample_count, block_size);
+		const LilvPlugin* p = lilv_plugins_get(plugins, i);
+		if (!plugin_matches(p) || !plugin_supported(p)) {
+			continue;
+		}
+
+		for (unsigned b = 0; b < n_block_sizes; ++b) {
+			double baseline = 0.0;
+			for (unsigned t = 0; t < n_thread_counts; ++t) {
+				bench(p, sample_count, block_sizes[b], thread_counts[t],
+				      n_cpus, &baseline);
+			}
+		}
 	}
 
+	print_footer();
+
+	lilv_node_free(urid_unmap);
 	lilv_node_free(urid_map);
-	lilv_node_free(lv2_OutputPort);
-	lilv_node_free(lv2_InputPort);
-	lilv_node_free(lv2_ControlPort);
-	lilv_node_free(lv2_CVPort);
-	lilv_node_free(lv2_AudioPort);
-	lilv_node_free(atom_Sequence);
-	lilv_node_free(atom_AtomPort);
 
 	lilv_world_free(world);
+	free(input_samples);
 
 	return 0;
 }
@@ -21,6 +21,10 @@
 
 #include "lilv_config.h"
 
+#ifdef HAVE_PTHREAD
+#    include <unistd.h>
+#endif
+
 static void
 list_plugins(const LilvPlugins* list, bool show_names)
 {
@@ -54,6 +58,7 @@ print_usage(void)
 	printf("List all installed LV2 plugins.\n");
 	printf("\n");
 	printf("  -n, --names    Show names instead of URIs\n");
+	printf("  -j, --json     Write a JSON catalogue of all plugins\n");
 	printf("  --help         Display this help and exit\n");
 	printf("  --version      Display version information and exit\n");
 	printf("\n");
@@ -65,9 +70,12 @@ int
 main(int argc, char** argv)
 {
 	bool show_names = false;
+	bool json       = false;
 	for (int i = 1; i < argc; ++i) {
 		if (!strcmp(argv[i], "--names") || !strcmp(argv[i], "-n")) {
 			show_names = true;
+		} else if (!strcmp(argv[i], "--json") || !strcmp(argv[i], "-j")) {
+			json = true;
 		} else if (!strcmp(argv[i], "--version")) {
 			print_version();
 			return 0;
@@ -85,9 +93,21 @@ main(int argc, char** argv)
 
 	const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
 
-	list_plugins(plugins, show_names);
+	int ret = 0;
+	if (json) {
+		// Freeze the world so plugins can be queried on every CPU at once
+		unsigned n_threads = 1;
+#ifdef HAVE_PTHREAD
+		const long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		n_threads = n_cpus > 0 ? (unsigned)n_cpus : 1;
+#endif
+		lilv_world_freeze(world);
+		ret = lilv_world_write_catalogue(world, plugins, n_threads, stdout);
+	} else {
+		list_plugins(plugins, show_names);
+	}
 
 	lilv_world_free(world);
 
-	return 0;
+	return ret;
 }